@@ -0,0 +1,231 @@
+/*
+ * Copyright 2024 JC-Lab (joseph@jc-lab.net)
+ *
+ * COMMERCIAL LICENSE.
+ * For use only by licensed user/company.
+ */
+
+// Coverage-guided trimming of the pseudo-browser bundles.
+//
+// 1. PSEUDO_BROWSER_COVERAGE=instrument
+//    Every function body gets `__sys_host.coverage_hit(N)`. The mapping
+//    N -> "<chunk name>#<function index>" is written to
+//    dist/coverage-manifest.json.
+// 2. Run the corpus against that build and collect `engine.coverageDump()`.
+//    `node coverage.mjs profile <manifest> <dump.json>... > profile.json`
+//    merges the dumps into a list of function keys.
+// 3. PSEUDO_BROWSER_COVERAGE=trim PSEUDO_BROWSER_COVERAGE_PROFILE=profile.json
+//    Bodies of functions that never ran are moved to
+//    dist/pseudo-browser-cold.js. The remaining stub evaluates the original
+//    body on first call (direct eval keeps the closure scope), so unprofiled
+//    paths still work, only slower.
+
+import fs from 'node:fs';
+import path from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+const MANIFEST_FILE = 'coverage-manifest.json';
+const COLD_FILE = 'pseudo-browser-cold.js';
+
+// 이보다 짧은 body 는 stub 과 크기 차이가 없다
+const MIN_TRIM_LENGTH = 160;
+
+const COLD_HELPER = `
+function __pb_cold(id) {
+    const cache = globalThis.__pb_cold_sources || (globalThis.__pb_cold_sources = globalThis.require('sysfs:///${COLD_FILE}'));
+    return cache[id];
+}
+`;
+
+function isFunctionNode(node) {
+    return node.type === 'FunctionDeclaration' ||
+        node.type === 'FunctionExpression' ||
+        node.type === 'ArrowFunctionExpression';
+}
+
+// 함수 노드를 소스 순서대로 방문. visit 가 false 를 반환하면 하위 노드는 건너뛴다.
+function walkFunctions(node, visit) {
+    if (!node || typeof node.type !== 'string') {
+        return;
+    }
+    if (isFunctionNode(node) && node.body && node.body.type === 'BlockStatement') {
+        if (visit(node) === false) {
+            return;
+        }
+    }
+    for (const key of Object.keys(node)) {
+        if (key === 'parent') continue;
+        const child = node[key];
+        if (Array.isArray(child)) {
+            for (const item of child) {
+                if (item && typeof item === 'object') walkFunctions(item, visit);
+            }
+        } else if (child && typeof child === 'object') {
+            walkFunctions(child, visit);
+        }
+    }
+}
+
+// "use strict" 등 directive 뒤에 삽입해야 directive 가 유지된다
+function bodyInsertPosition(body) {
+    let pos = body.start + 1;
+    for (const stmt of body.body) {
+        if (stmt.type !== 'ExpressionStatement' || typeof stmt.directive !== 'string') {
+            break;
+        }
+        pos = stmt.end;
+    }
+    return pos;
+}
+
+// eval 로 옮길 수 없는 body
+function canTrim(node, bodySource) {
+    if (node.generator || node.async) {
+        return false;
+    }
+    if (bodySource.length < MIN_TRIM_LENGTH) {
+        return false;
+    }
+    return !/\bsuper\b|\bnew\.target\b|\barguments\.callee\b/.test(bodySource);
+}
+
+function applyEdits(code, edits) {
+    edits.sort((a, b) => b.start - a.start);
+    let out = code;
+    for (const edit of edits) {
+        out = out.slice(0, edit.start) + edit.text + out.slice(edit.end);
+    }
+    return out;
+}
+
+function loadProfile(profilePath) {
+    const keys = JSON.parse(fs.readFileSync(profilePath, 'utf8'));
+    if (!Array.isArray(keys)) {
+        throw new Error(`coverage profile must be an array of function keys: ${profilePath}`);
+    }
+    return new Set(keys);
+}
+
+/**
+ * @param {{ mode?: string, profile?: string }} options
+ * @returns {import('rolldown').Plugin}
+ */
+export function coverage(options = {}) {
+    const mode = options.mode || '';
+    if (!mode) {
+        return { name: 'pseudo-browser-coverage' };
+    }
+    if (mode !== 'instrument' && mode !== 'trim') {
+        throw new Error(`unknown PSEUDO_BROWSER_COVERAGE mode: ${mode}`);
+    }
+
+    let hitKeys = null;
+    if (mode === 'trim') {
+        if (!options.profile) {
+            throw new Error('PSEUDO_BROWSER_COVERAGE=trim requires PSEUDO_BROWSER_COVERAGE_PROFILE');
+        }
+        hitKeys = loadProfile(options.profile);
+    }
+
+    // instrument: id -> key, trim: id -> cold source
+    let entries = [];
+
+    return {
+        name: 'pseudo-browser-coverage',
+
+        buildStart() {
+            entries = [];
+        },
+
+        renderChunk(code, chunk) {
+            const program = this.parse(code);
+            const edits = [];
+
+            // key 는 trim 여부와 무관하게 모든 함수의 순서로 정한다
+            const keys = new Map();
+            walkFunctions(program, (node) => {
+                keys.set(node, `${chunk.name}#${keys.size}`);
+            });
+
+            walkFunctions(program, (node) => {
+                const key = keys.get(node);
+                const body = node.body;
+
+                if (mode === 'instrument') {
+                    const id = entries.length;
+                    entries.push(key);
+                    const pos = bodyInsertPosition(body);
+                    edits.push({ start: pos, end: pos, text: `__sys_host.coverage_hit(${id});` });
+                    return true;
+                }
+
+                if (hitKeys.has(key)) {
+                    return true;
+                }
+                const inner = code.slice(body.start + 1, body.end - 1);
+                if (!canTrim(node, inner)) {
+                    return true;
+                }
+
+                // arrow 는 this/arguments 를 그대로 물려받는다
+                const source = node.type === 'ArrowFunctionExpression'
+                    ? `(() => {${inner}\n})()`
+                    : `(function () {${inner}\n}).apply(this, arguments)`;
+                const id = entries.length;
+                entries.push(source);
+                edits.push({ start: body.start, end: body.end, text: `{ return eval(__pb_cold(${id})); }` });
+                // 하위 함수는 cold source 에 함께 포함된다
+                return false;
+            });
+
+            if (!edits.length) {
+                return null;
+            }
+            let out = applyEdits(code, edits);
+            if (mode === 'trim') {
+                out += COLD_HELPER;
+            }
+            return { code: out, map: null };
+        },
+
+        generateBundle() {
+            if (mode === 'instrument') {
+                this.emitFile({
+                    type: 'asset',
+                    fileName: MANIFEST_FILE,
+                    source: JSON.stringify(entries),
+                });
+            } else {
+                this.emitFile({
+                    type: 'asset',
+                    fileName: COLD_FILE,
+                    source: `module.exports = ${JSON.stringify(entries)};\n`,
+                });
+            }
+        },
+    };
+}
+
+// node coverage.mjs profile <manifest> <dump.json>...
+//   dump.json: engine.coverageDump() 결과 (hit id 배열)
+function main(argv) {
+    const [command, manifestPath, ...dumpPaths] = argv;
+    if (command !== 'profile' || !manifestPath || !dumpPaths.length) {
+        console.error('usage: node coverage.mjs profile <coverage-manifest.json> <dump.json>...');
+        process.exit(1);
+    }
+    const manifest = JSON.parse(fs.readFileSync(manifestPath, 'utf8'));
+    const keys = new Set();
+    for (const dumpPath of dumpPaths) {
+        for (const id of JSON.parse(fs.readFileSync(dumpPath, 'utf8'))) {
+            if (manifest[id] !== undefined) {
+                keys.add(manifest[id]);
+            }
+        }
+    }
+    process.stdout.write(JSON.stringify([...keys].sort()) + '\n');
+}
+
+if (process.argv[1] && path.resolve(process.argv[1]) === fileURLToPath(import.meta.url)) {
+    main(process.argv.slice(2));
+}
@@ -7,6 +7,8 @@ import nodePolyfills from '@rolldown/plugin-node-polyfills';
 import alias from '@rollup/plugin-alias';
 import resolve from '@rollup/plugin-node-resolve';
 
+import { coverage } from './coverage.mjs';
+
 const customResolver = resolve({
     extensions: ['.mjs', '.js', '.jsx', '.json', '.sass', '.scss']
 });
@@ -158,6 +160,10 @@ const options = [
         input: {
             'pseudo-browser-full': path.join(__dirname, 'src/pseudo-browser/full.js'),
             'pseudo-browser-mini': path.join(__dirname, 'src/pseudo-browser/mini.js'),
+            // full 에서 처음 사용할 때 로드 (__sys.loadModule)
+            'pseudo-browser-jsdom': path.join(__dirname, 'src/pseudo-browser/jsdom.js'),
+            'pseudo-browser-jquery': path.join(__dirname, 'src/pseudo-browser/jquery.js'),
+            'pseudo-browser-dom-parser': path.join(__dirname, 'src/pseudo-browser/dom-parser.js'),
         },
         output: {
             format: 'cjs',
@@ -166,6 +172,10 @@ const options = [
         },
         plugins: [
             nodePolyfills(),
+            coverage({
+                mode: process.env.PSEUDO_BROWSER_COVERAGE,
+                profile: process.env.PSEUDO_BROWSER_COVERAGE_PROFILE,
+            }),
             alias({
                 entries: [
                     {
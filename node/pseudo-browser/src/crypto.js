@@ -1,5 +1,133 @@
 module.exports = require('crypto');
 
+const { Buffer } = require('buffer');
+const { StringDecoder } = require('string_decoder');
+
+// createHash/createHmac/createCipheriv 는 가능하면 __sys_host 의 native context 사용
+// (crypto_stream.cc). 지원하지 않는 알고리즘은 crypto-browserify 로 처리한다.
+const jsCreateHash = module.exports.createHash;
+const jsCreateHmac = module.exports.createHmac;
+const jsCreateCipheriv = module.exports.createCipheriv;
+const jsCreateDecipheriv = module.exports.createDecipheriv;
+
+function toNativeInput(data, encoding) {
+    if (typeof data === 'string' && encoding && encoding !== 'utf8' && encoding !== 'utf-8') {
+        return Buffer.from(data, encoding);
+    }
+    return data;
+}
+
+function toBuffer(value) {
+    return value instanceof ArrayBuffer
+        ? Buffer.from(value)
+        : Buffer.from(value.buffer, value.byteOffset, value.byteLength);
+}
+
+class NativeDigest {
+    constructor(stream) {
+        this._stream = stream;
+    }
+
+    update(data, encoding) {
+        this._stream.update(toNativeInput(data, encoding));
+        return this;
+    }
+
+    digest(encoding) {
+        const out = toBuffer(this._stream.final());
+        return encoding ? out.toString(encoding) : out;
+    }
+
+    copy() {
+        return new NativeDigest(this._stream.copy());
+    }
+}
+
+const NATIVE_CIPHERS = /^aes-(128|192|256)-(cbc|ctr)$/i;
+
+// node 는 key/iv 길이를 createCipheriv 에서 바로 검사한다
+function checkLength(value, expected, ErrorType, message, code) {
+    const length = typeof value === 'string' ? Buffer.byteLength(value) : value && value.byteLength;
+    if (length !== expected) {
+        const err = new ErrorType(message);
+        err.code = code;
+        throw err;
+    }
+}
+
+class NativeCipher {
+    constructor(algorithm, key, iv, decrypt) {
+        this._args = [algorithm, toNativeInput(key), toNativeInput(iv), decrypt];
+        this._autoPadding = true;
+        this._stream = null;
+        this._decoder = null;
+    }
+
+    // setAutoPadding() 이 첫 update() 전에 호출될 수 있으므로 native context 는 늦게 만든다
+    static create(algorithm, key, iv, decrypt) {
+        const match = NATIVE_CIPHERS.exec(algorithm);
+        if (!match) {
+            return null;
+        }
+        checkLength(key, Number(match[1]) / 8, RangeError, 'Invalid key length', 'ERR_CRYPTO_INVALID_KEYLEN');
+        checkLength(iv, 16, TypeError, 'Invalid initialization vector', 'ERR_CRYPTO_INVALID_IV');
+        return new NativeCipher(algorithm, key, iv, decrypt);
+    }
+
+    _native() {
+        if (!this._stream) {
+            this._stream = __sys_host.crypto_createCipher(...this._args, this._autoPadding);
+        }
+        return this._stream;
+    }
+
+    _output(chunk, encoding) {
+        const out = toBuffer(chunk);
+        if (!encoding || encoding === 'buffer') {
+            return out;
+        }
+        // base64 등은 chunk 경계에서 잘리지 않도록 decoder 사용
+        if (!this._decoder) {
+            this._decoder = new StringDecoder(encoding);
+        }
+        return this._decoder.write(out);
+    }
+
+    setAutoPadding(autoPadding) {
+        this._autoPadding = autoPadding !== false;
+        return this;
+    }
+
+    update(data, inputEncoding, outputEncoding) {
+        return this._output(this._native().update(toNativeInput(data, inputEncoding)), outputEncoding);
+    }
+
+    final(outputEncoding) {
+        const out = this._output(this._native().final(), outputEncoding);
+        return this._decoder ? out + this._decoder.end() : out;
+    }
+}
+
+module.exports.createHash = function createHash(algorithm, options) {
+    const stream = typeof algorithm === 'string' ? __sys_host.crypto_createHash(algorithm) : undefined;
+    return stream ? new NativeDigest(stream) : jsCreateHash(algorithm, options);
+};
+
+module.exports.createHmac = function createHmac(algorithm, key, options) {
+    const stream = typeof algorithm === 'string' ? __sys_host.crypto_createHmac(algorithm, toNativeInput(key)) : undefined;
+    return stream ? new NativeDigest(stream) : jsCreateHmac(algorithm, key, options);
+};
+
+module.exports.createCipheriv = function createCipheriv(algorithm, key, iv, options) {
+    return (typeof algorithm === 'string' && NativeCipher.create(algorithm, key, iv, false)) ||
+        jsCreateCipheriv(algorithm, key, iv, options);
+};
+
+module.exports.createDecipheriv = function createDecipheriv(algorithm, key, iv, options) {
+    return (typeof algorithm === 'string' && NativeCipher.create(algorithm, key, iv, true)) ||
+        jsCreateDecipheriv(algorithm, key, iv, options);
+};
+
 function actualFill(buf, offset, size, cb) {
     const ourBuf = buf.buffer;
     const uint = new Uint8Array(ourBuf, offset, size);
@@ -6,7 +6,18 @@
  */
 
 import {
- DOMParser
+ DOMParser as XmlDOMParser
 } from 'xmldom';
 
+// text/html 은 native parser (native-dom.js), 그 외 XML 은 xmldom
+class DOMParser {
+    parseFromString(source, mimeType) {
+        if (mimeType === 'text/html') {
+            return __sys.parseHTML(source);
+        }
+        return new XmlDOMParser().parseFromString(source, mimeType);
+    }
+}
+
+__sys.DOMParser = DOMParser;
 // __sys.overrideWindow.DOMParser = DOMParser;
@@ -9,15 +9,66 @@ import './sys';
 import './text-encoder';
 import './node-polyfill';
 import './msgpack';
-import './dom-parser';
 import './early-window';
+import { createNativeWindow, windowUsesNativeDom } from './native-window';
 // import 'rrweb-cssom';
-import './jsdom';
 // import './load-document'
-import './jquery';
 // import 'jquery-ui/dist/jquery-ui.js';
 // import './jquery.dynatree';
 // import './form-submit';
 // import './lodash';
 //
 // eval.call(global, global.__sys_document_script);
+
+// jsdom / jquery / DOMParser 는 처음 사용할 때 로드한다.
+// 각 모듈은 별도 sysfs 파일(pseudo-browser-<name>.js)이며 native require
+// (Engine::LoadCjsModule)가 module cache 를 관리한다.
+__sys.loadModule = function (name) {
+    return globalThis.require(`sysfs:///pseudo-browser-${name}.js`);
+};
+
+// 모듈이 __sys[key] 를 실제 구현으로 교체한다.
+function lazyFunction(name, key) {
+    const stub = function () {
+        __sys.loadModule(name);
+        if (__sys[key] === stub) {
+            throw new Error(`pseudo-browser-${name}: __sys.${key} is not provided`);
+        }
+        return __sys[key].apply(this, arguments);
+    };
+    __sys[key] = stub;
+}
+
+lazyFunction('jsdom', 'createJsdomWindow');
+lazyFunction('jquery', 'useJQuery');
+
+// windowOptions.dom === 'native' 이면 jsdom 을 로드하지 않고 native DOM 으로,
+// 'stub' 이면 파싱하지 않는 빈 document 로 만든다.
+// script 실행, event, DOM 변경이 필요한 경우에만 jsdom (기본값) 을 쓴다.
+// engine_window_begin 이 content 를 받는 방법을 정할 때도 사용
+__sys.windowUsesNativeDom = windowUsesNativeDom;
+
+__sys.createWindow = function (content, windowOptions) {
+    if (windowOptions && (windowOptions.dom === 'native' || windowOptions.dom === 'stub')) {
+        return createNativeWindow(content, windowOptions);
+    }
+    return __sys.createJsdomWindow(content, windowOptions);
+};
+
+Object.defineProperty(__sys, 'DOMParser', {
+    configurable: true,
+    enumerable: true,
+    get() {
+        delete __sys.DOMParser;
+        __sys.loadModule('dom-parser');
+        return __sys.DOMParser;
+    },
+    set(value) {
+        Object.defineProperty(__sys, 'DOMParser', {
+            configurable: true,
+            enumerable: true,
+            writable: true,
+            value,
+        });
+    },
+});
@@ -7,10 +7,18 @@
 
 import { JSDOM } from 'jsdom';
 __sys.JSDOM = JSDOM;
-__sys.createWindow = function(content, windowOptions) {
-    const result = new JSDOM(content || '', windowOptions);
+__sys.createJsdomWindow = function(content, windowOptions) {
+    const { dom, ...jsdomOptions } = windowOptions || {};
+    const result = new JSDOM(content || '', jsdomOptions);
     // 'crypto' override not working
     Object.assign(result.window, __sys.overrideWindow);
+    // jsdom 의 crypto 에는 subtle 이 없으므로 native 구현을 붙인다
+    if (result.window.crypto && !result.window.crypto.subtle) {
+        Object.defineProperty(result.window.crypto, 'subtle', {
+            value: global.crypto.subtle,
+            configurable: true,
+        });
+    }
     return new Proxy(result.window, {
         set(target, p, newValue, receiver) {
             target[p] = newValue;
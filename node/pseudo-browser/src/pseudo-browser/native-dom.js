@@ -0,0 +1,554 @@
+/*
+ * Copyright 2024 JC-Lab (joseph@jc-lab.net)
+ *
+ * COMMERCIAL LICENSE.
+ * For use only by licensed user/company.
+ */
+
+// __sys_host.html_parse (html_binding.cc) 의 arena DOM 위에 얹은 읽기 전용 DOM.
+// 파싱/검색은 native 에서 하고 JS 객체는 접근한 node 에 대해서만 만든다.
+// 변경 (appendChild, innerHTML 대입 등), event, script 실행이 필요하면 jsdom 을 쓴다.
+
+const ELEMENT_NODE = 1;
+const TEXT_NODE = 3;
+const COMMENT_NODE = 8;
+const DOCUMENT_NODE = 9;
+const DOCUMENT_TYPE_NODE = 10;
+
+function notSupported(name) {
+    const error = new Error(`${name} is not supported by the native DOM (use dom: 'jsdom')`);
+    error.name = 'NotSupportedError';
+    throw error;
+}
+
+class NativeNode {
+    constructor(document, id) {
+        this._document = document;
+        this._id = id;
+    }
+
+    get _native() {
+        return this._document._handle;
+    }
+
+    _wrap(id) {
+        return this._document._wrap(id);
+    }
+
+    get nodeType() {
+        return this._native.nodeType(this._id);
+    }
+
+    get ownerDocument() {
+        return this._document;
+    }
+
+    get parentNode() {
+        return this._wrap(this._native.parent(this._id));
+    }
+
+    get parentElement() {
+        const parent = this.parentNode;
+        return parent && parent.nodeType === ELEMENT_NODE ? parent : null;
+    }
+
+    get childNodes() {
+        return this._native.childNodes(this._id).map((id) => this._wrap(id));
+    }
+
+    get firstChild() {
+        return this._wrap(this._native.firstChild(this._id));
+    }
+
+    get lastChild() {
+        return this._wrap(this._native.lastChild(this._id));
+    }
+
+    get previousSibling() {
+        return this._wrap(this._native.previousSibling(this._id));
+    }
+
+    get nextSibling() {
+        return this._wrap(this._native.nextSibling(this._id));
+    }
+
+    get nodeValue() {
+        return null;
+    }
+
+    get textContent() {
+        return this._native.textContent(this._id);
+    }
+
+    set textContent(value) {
+        notSupported('textContent');
+    }
+
+    hasChildNodes() {
+        return this._native.firstChild(this._id) >= 0;
+    }
+
+    contains(other) {
+        for (let node = other; node; node = node.parentNode) {
+            if (node === this) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    appendChild() {
+        notSupported('appendChild');
+    }
+
+    removeChild() {
+        notSupported('removeChild');
+    }
+
+    insertBefore() {
+        notSupported('insertBefore');
+    }
+
+    addEventListener() {}
+
+    removeEventListener() {}
+}
+
+NativeNode.ELEMENT_NODE = ELEMENT_NODE;
+NativeNode.TEXT_NODE = TEXT_NODE;
+NativeNode.COMMENT_NODE = COMMENT_NODE;
+NativeNode.DOCUMENT_NODE = DOCUMENT_NODE;
+NativeNode.DOCUMENT_TYPE_NODE = DOCUMENT_TYPE_NODE;
+
+class NativeCharacterData extends NativeNode {
+    get data() {
+        return this._native.data(this._id);
+    }
+
+    get nodeValue() {
+        return this.data;
+    }
+
+    get length() {
+        return this.data.length;
+    }
+}
+
+class NativeText extends NativeCharacterData {
+    get nodeName() {
+        return '#text';
+    }
+
+    get wholeText() {
+        return this.data;
+    }
+}
+
+class NativeComment extends NativeCharacterData {
+    get nodeName() {
+        return '#comment';
+    }
+
+    get textContent() {
+        return this.data;
+    }
+}
+
+class NativeDocumentType extends NativeNode {
+    get name() {
+        return this._native.data(this._id).split(/\s/)[0].toLowerCase();
+    }
+
+    get nodeName() {
+        return this.name;
+    }
+
+    get textContent() {
+        return null;
+    }
+}
+
+// querySelector 등 element/document 공통
+class NativeParentNode extends NativeNode {
+    get children() {
+        return this.childNodes.filter((node) => node.nodeType === ELEMENT_NODE);
+    }
+
+    get childElementCount() {
+        return this.children.length;
+    }
+
+    get firstElementChild() {
+        return this.children[0] || null;
+    }
+
+    get lastElementChild() {
+        const children = this.children;
+        return children[children.length - 1] || null;
+    }
+
+    querySelector(selector) {
+        return this._wrap(this._native.querySelector(this._id, String(selector)));
+    }
+
+    querySelectorAll(selector) {
+        return this._native.querySelectorAll(this._id, String(selector)).map((id) => this._wrap(id));
+    }
+
+    getElementsByTagName(name) {
+        return this._native.getElementsByTagName(this._id, String(name).toLowerCase()).map((id) => this._wrap(id));
+    }
+
+    getElementsByClassName(names) {
+        return this._native.getElementsByClassName(this._id, String(names).trim().replace(/\s+/g, ' ')).map((id) => this._wrap(id));
+    }
+}
+
+class NativeClassList {
+    constructor(element) {
+        this._tokens = (element.getAttribute('class') || '').split(/\s+/).filter(Boolean);
+    }
+
+    get length() {
+        return this._tokens.length;
+    }
+
+    item(index) {
+        return this._tokens[index] === undefined ? null : this._tokens[index];
+    }
+
+    contains(token) {
+        return this._tokens.includes(token);
+    }
+
+    toString() {
+        return this._tokens.join(' ');
+    }
+
+    [Symbol.iterator]() {
+        return this._tokens[Symbol.iterator]();
+    }
+}
+
+class NativeElement extends NativeParentNode {
+    get nodeName() {
+        return this.tagName;
+    }
+
+    get tagName() {
+        return this.localName.toUpperCase();
+    }
+
+    get localName() {
+        return this._native.nodeName(this._id);
+    }
+
+    get namespaceURI() {
+        return 'http://www.w3.org/1999/xhtml';
+    }
+
+    get attributes() {
+        const flat = this._native.attributes(this._id);
+        const attributes = [];
+        for (let i = 0; i < flat.length; i += 2) {
+            attributes.push({ name: flat[i], localName: flat[i], value: flat[i + 1], nodeValue: flat[i + 1] });
+        }
+        return attributes;
+    }
+
+    getAttributeNames() {
+        return this.attributes.map((attr) => attr.name);
+    }
+
+    getAttribute(name) {
+        return this._native.getAttribute(this._id, String(name).toLowerCase());
+    }
+
+    hasAttribute(name) {
+        return this.getAttribute(name) !== null;
+    }
+
+    hasAttributes() {
+        return this._native.attributes(this._id).length > 0;
+    }
+
+    setAttribute() {
+        notSupported('setAttribute');
+    }
+
+    removeAttribute() {
+        notSupported('removeAttribute');
+    }
+
+    get id() {
+        return this.getAttribute('id') || '';
+    }
+
+    get className() {
+        return this.getAttribute('class') || '';
+    }
+
+    get classList() {
+        return new NativeClassList(this);
+    }
+
+    get dataset() {
+        const dataset = {};
+        for (const { name, value } of this.attributes) {
+            if (name.startsWith('data-')) {
+                dataset[name.slice(5).replace(/-([a-z])/g, (_, c) => c.toUpperCase())] = value;
+            }
+        }
+        return dataset;
+    }
+
+    get previousElementSibling() {
+        for (let node = this.previousSibling; node; node = node.previousSibling) {
+            if (node.nodeType === ELEMENT_NODE) {
+                return node;
+            }
+        }
+        return null;
+    }
+
+    get nextElementSibling() {
+        for (let node = this.nextSibling; node; node = node.nextSibling) {
+            if (node.nodeType === ELEMENT_NODE) {
+                return node;
+            }
+        }
+        return null;
+    }
+
+    get innerHTML() {
+        return this._native.innerHTML(this._id);
+    }
+
+    set innerHTML(value) {
+        notSupported('innerHTML');
+    }
+
+    get outerHTML() {
+        return this._native.outerHTML(this._id);
+    }
+
+    get innerText() {
+        return this.textContent;
+    }
+
+    matches(selector) {
+        return this._native.matches(this._id, String(selector));
+    }
+
+    closest(selector) {
+        for (let node = this; node && node.nodeType === ELEMENT_NODE; node = node.parentNode) {
+            if (node.matches(selector)) {
+                return node;
+            }
+        }
+        return null;
+    }
+
+    // 자주 쓰이는 reflected attribute
+    get name() {
+        return this.getAttribute('name') || '';
+    }
+
+    get type() {
+        const type = this.getAttribute('type');
+        if (this.localName === 'input') {
+            return type ? type.toLowerCase() : 'text';
+        }
+        if (this.localName === 'button') {
+            return type ? type.toLowerCase() : 'submit';
+        }
+        return type || '';
+    }
+
+    get href() {
+        return this.getAttribute('href') || '';
+    }
+
+    get src() {
+        return this.getAttribute('src') || '';
+    }
+
+    get action() {
+        return this.getAttribute('action') || '';
+    }
+
+    get method() {
+        return (this.getAttribute('method') || 'get').toLowerCase();
+    }
+
+    get checked() {
+        return this.hasAttribute('checked');
+    }
+
+    get selected() {
+        return this.hasAttribute('selected');
+    }
+
+    get disabled() {
+        return this.hasAttribute('disabled');
+    }
+
+    get value() {
+        switch (this.localName) {
+            case 'textarea':
+                return this.textContent;
+            case 'option': {
+                const value = this.getAttribute('value');
+                return value !== null ? value : this.textContent.replace(/\s+/g, ' ').trim();
+            }
+            case 'select': {
+                const options = this.getElementsByTagName('option');
+                const selected = options.find((option) => option.selected) || options[0];
+                return selected ? selected.value : '';
+            }
+            default: {
+                const value = this.getAttribute('value');
+                if (value !== null) {
+                    return value;
+                }
+                return this.localName === 'input' && (this.type === 'checkbox' || this.type === 'radio') ? 'on' : '';
+            }
+        }
+    }
+
+    get elements() {
+        if (this.localName !== 'form') {
+            return undefined;
+        }
+        return this.querySelectorAll('input, select, textarea, button');
+    }
+}
+
+// handle: __sys_host.html_parse 결과 또는 engine_window_end 가 파싱한 NativeHtmlDocument
+export class NativeDocument extends NativeParentNode {
+    constructor(handle) {
+        super(null, 0);
+        this._document = this;
+        this._handle = handle;
+        this._nodes = [this];
+        this.defaultView = null;
+    }
+
+    _wrap(id) {
+        if (id < 0) {
+            return null;
+        }
+        let node = this._nodes[id];
+        if (!node) {
+            switch (this._handle.nodeType(id)) {
+                case ELEMENT_NODE:
+                    node = new NativeElement(this, id);
+                    break;
+                case TEXT_NODE:
+                    node = new NativeText(this, id);
+                    break;
+                case COMMENT_NODE:
+                    node = new NativeComment(this, id);
+                    break;
+                default:
+                    node = new NativeDocumentType(this, id);
+                    break;
+            }
+            this._nodes[id] = node;
+        }
+        return node;
+    }
+
+    get nodeName() {
+        return '#document';
+    }
+
+    get ownerDocument() {
+        return null;
+    }
+
+    get textContent() {
+        return null;
+    }
+
+    get contentType() {
+        return 'text/html';
+    }
+
+    get readyState() {
+        return 'complete';
+    }
+
+    get doctype() {
+        return this.childNodes.find((node) => node.nodeType === DOCUMENT_TYPE_NODE) || null;
+    }
+
+    get documentElement() {
+        return this._wrap(this._handle.documentElement());
+    }
+
+    get head() {
+        return this._wrap(this._handle.head());
+    }
+
+    get body() {
+        return this._wrap(this._handle.body());
+    }
+
+    get title() {
+        const title = this.querySelector('title');
+        return title ? title.textContent.replace(/\s+/g, ' ').trim() : '';
+    }
+
+    get forms() {
+        return this.getElementsByTagName('form');
+    }
+
+    get scripts() {
+        return this.getElementsByTagName('script');
+    }
+
+    get images() {
+        return this.getElementsByTagName('img');
+    }
+
+    get links() {
+        return this.querySelectorAll('a[href], area[href]');
+    }
+
+    getElementById(id) {
+        return this._wrap(this._handle.getElementById(0, String(id)));
+    }
+
+    createElement() {
+        notSupported('createElement');
+    }
+
+    createTextNode() {
+        notSupported('createTextNode');
+    }
+
+    // mini window 의 document.write 와 같이 무시
+    write() {}
+
+    writeln() {}
+}
+
+export function parseHTML(source) {
+    return new NativeDocument(__sys_host.html_parse(source == null ? '' : String(source)));
+}
+
+export function adoptHTMLDocument(handle) {
+    return new NativeDocument(handle);
+}
+
+// DOM 을 만들지 않고 inline script, form, meta 등만 뽑는다 (html_extract.h 참고)
+export function extractDocument(source, options) {
+    const raw = __sys_host.html_extract(source == null ? '' : String(source), options || {});
+    return __sys.munpack(new Uint8Array(raw));
+}
+
+__sys.parseHTML = parseHTML;
+__sys.adoptHTMLDocument = adoptHTMLDocument;
+__sys.extractDocument = extractDocument;
+__sys.NativeDocument = NativeDocument;
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 JC-Lab (joseph@jc-lab.net)
+ *
+ * COMMERCIAL LICENSE.
+ * For use only by licensed user/company.
+ */
+
+import { NativeDocument, parseHTML } from './native-dom';
+
+export function randomUUID() {
+    const bytes = new Uint8Array(16);
+    global.crypto.getRandomValues(bytes);
+
+    // 2) 버전(v4) 및 변형(RFC 4122) 비트 설정
+    bytes[6] = (bytes[6] & 0x0f) | 0x40; // 0100xxxx
+    bytes[8] = (bytes[8] & 0x3f) | 0x80; // 10xxxxxx
+
+    // 3) 바이트를 16진수 문자열로 변환 (lookup 테이블로 빠르게)
+    const lut = [];
+    for (let i = 0; i < 256; i++) lut[i] = (i + 0x100).toString(16).slice(1);
+
+    return (
+        lut[bytes[0]] + lut[bytes[1]] + lut[bytes[2]] + lut[bytes[3]] + '-' +
+        lut[bytes[4]] + lut[bytes[5]] + '-' +
+        lut[bytes[6]] + lut[bytes[7]] + '-' +
+        lut[bytes[8]] + lut[bytes[9]] + '-' +
+        lut[bytes[10]] + lut[bytes[11]] + lut[bytes[12]] +
+        lut[bytes[13]] + lut[bytes[14]] + lut[bytes[15]]
+    );
+}
+
+// 파싱하지 않는 빈 document (dom: 'stub', native DOM 이전의 mini window 동작)
+function createStubDocument() {
+    return {
+        nodeType: 9,
+        write: function() {},
+    };
+}
+
+function createDocument(content, windowOptions) {
+    if (windowOptions && windowOptions.dom === 'stub') {
+        return createStubDocument();
+    }
+    // 읽기 전용 native DOM (native-dom.js). streaming window 는 이미 파싱된 문서를 넘긴다
+    return content instanceof NativeDocument ? content : parseHTML(content);
+}
+
+// 'native' 는 content 를 html_parse 로 받고, 'stub' 은 content 를 쓰지 않는다
+export function windowUsesNativeDom(windowOptions) {
+    return !!windowOptions && windowOptions.dom === 'native';
+}
+
+// jsdom 없이 native DOM 만으로 구성한 window (mini 기본, full 은 dom: 'native' 또는 'stub')
+export function createNativeWindow(content, windowOptions) {
+    const w = {
+        crypto: {
+            getRandomValues: global.crypto.getRandomValues.bind(global.crypto),
+            randomUUID: randomUUID,
+            subtle: global.crypto.subtle,
+        },
+        document: createDocument(content, windowOptions),
+    };
+    w.ownerDocument = w.document;
+    Object.assign(w, __sys.overrideWindow);
+
+    const jQuery = function (target) {
+        if (typeof target === 'function') {
+            return ;
+        }
+        return {
+            ready: function (fn) {},
+        };
+    }
+    jQuery.ready = function (fn) {}
+    w.jQuery = jQuery;
+    w.$ = jQuery;
+
+    const proxy = new Proxy(w, {
+        set(target, p, newValue, receiver) {
+            // console.log(`window : SET (${p}) : `, newValue);
+            target[p] = newValue;
+            // window 마다 별도 context 이므로 global 도 이 window 전용
+            global[p] = newValue;
+        }
+    });
+    if (w.document instanceof NativeDocument) {
+        w.document.defaultView = proxy;
+    }
+    return proxy;
+}
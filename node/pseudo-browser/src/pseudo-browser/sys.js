@@ -157,6 +157,7 @@ const __sys = {
         };
 
         onreadystatechange = null;
+        onerror = null;
         readyState = 0;
         responseText = null;
         status = null;
@@ -194,20 +195,18 @@ const __sys = {
                 headers[key.toLowerCase()] = this._options.requestHeaders[key];
             });
 
-            const result = __xhr_transfer(JSON.stringify({
-                    method: this._options.method,
-                    url: this._options.url,
-                    responseType: this._options.responseType,
-                    requestType: requestType,
-                    headers: {
-                        referer: __sys_document_url,
-                        'user-agent': navigator.userAgent,
-                        ...headers,
-                    },
-                }),
-                data
-            );
-            const done = () => {
+            const request = JSON.stringify({
+                method: this._options.method,
+                url: this._options.url,
+                responseType: this._options.responseType,
+                requestType: requestType,
+                headers: {
+                    referer: __sys_document_url,
+                    'user-agent': navigator.userAgent,
+                    ...headers,
+                },
+            });
+            const done = (result) => {
                 this.readyState = 4;
                 this.status = result.status;
                 this.statusText = (result.status === 200) ? 'OK' : 'ERROR';
@@ -234,9 +233,27 @@ const __sys = {
                 }
             };
             if (this._options.sync) {
-                done();
+                done(__xhr_transfer(request, data));
             } else {
-                process.nextTick(() => done());
+                // 호스트가 engine_complete_io 로 완료할 때까지 엔진은 다른 작업을 계속한다
+                // 호스트 오류와 결과 decode 실패는 reject 로 온다
+                const fail = (error) => {
+                    this.readyState = 4;
+                    this.status = 0;
+                    this.statusText = String(error && error.message || error);
+                    if (this.onerror) {
+                        this.onerror(error);
+                    }
+                    if (this.onreadystatechange) {
+                        this.onreadystatechange();
+                    }
+                };
+                __sys_host.io_submit('xhr', request, data)
+                    .then(done, fail)
+                    .catch((error) => {
+                        // page 의 onreadystatechange / onerror 에서 던진 예외
+                        console.error('XMLHttpRequest callback error:', error);
+                    });
             }
         }
 
@@ -261,6 +278,13 @@ const __sys = {
     __sys.overrideWindow.XMLHttpRequest = XMLHttpRequest;
 })();
 
+// fn 실행을 trace span 으로 기록 (호스트가 tracing 을 켰을 때만)
+//   __sys.trace('decode-payload', () => decode(payload))
+__sys.trace = __sys_host.trace;
+
+// host ResultCache 에 이번 실행 결과를 저장하지 않도록 표시
+__sys.markUncacheable = __sys_host.mark_uncacheable;
+
 Object.assign(global, {
     __sys: __sys,
     performance: {
@@ -1 +1,181 @@
 module.exports = require('zlib');
+
+const { Buffer } = require('buffer');
+const { Transform } = require('stream');
+
+// inflate/deflate/gzip 는 __sys_host 의 native z_stream 사용 (zlib_stream.cc).
+// dictionary/info 옵션은 browserify-zlib 로 처리한다.
+const js = Object.assign({}, module.exports);
+
+const Z_NO_FLUSH = 0;
+const Z_FINISH = 4;
+
+// node src/node_zlib.cc 의 mode
+const MODES = {
+    Deflate: 1,
+    Inflate: 2,
+    Gzip: 3,
+    Gunzip: 4,
+    DeflateRaw: 5,
+    InflateRaw: 6,
+    Unzip: 7,
+};
+
+const kFlushFlag = Symbol('kFlushFlag');
+
+function isNativeOptions(opts) {
+    return !opts || (opts.dictionary === undefined && !opts.info);
+}
+
+// node 의 kMaxLength 와 같은 상한
+const kMaxLength = 2 ** 32;
+
+function checkMaxOutputLength(value) {
+    if (value === undefined) {
+        return;
+    }
+    if (!Number.isInteger(value) || value < 1 || value > kMaxLength) {
+        const err = new RangeError(`The value of "options.maxOutputLength" is out of range. It must be >= 1 && <= ${kMaxLength}. Received ${value}`);
+        err.code = 'ERR_OUT_OF_RANGE';
+        throw err;
+    }
+}
+
+// maxOutputLength 는 node 처럼 convenience method (processSync) 에만 적용한다
+function createNative(mode, opts, maxOutputLength) {
+    opts = opts || {};
+    return __sys_host.zlib_create(
+        mode,
+        opts.level ?? -1,
+        opts.windowBits ?? 15,
+        opts.memLevel ?? 8,
+        opts.strategy ?? 0,
+        maxOutputLength,
+    );
+}
+
+function toNativeInput(buffer) {
+    // native 쪽 (js_bytes.h) 은 DataView 를 읽지 못한다
+    if (buffer instanceof DataView) {
+        return new Uint8Array(buffer.buffer, buffer.byteOffset, buffer.byteLength);
+    }
+    if (typeof buffer === 'string' || ArrayBuffer.isView(buffer) || buffer instanceof ArrayBuffer) {
+        return buffer;
+    }
+    throw new TypeError('The "buffer" argument must be of type string or an instance of Buffer, TypedArray, DataView, or ArrayBuffer');
+}
+
+function toBuffer(value) {
+    return Buffer.from(value.buffer, value.byteOffset, value.byteLength);
+}
+
+function processSync(mode, buffer, opts) {
+    const maxOutputLength = opts ? opts.maxOutputLength : undefined;
+    checkMaxOutputLength(maxOutputLength);
+    const stream = createNative(mode, opts, maxOutputLength);
+    try {
+        return toBuffer(stream.process(toNativeInput(buffer), (opts && opts.finishFlush) || Z_FINISH));
+    } finally {
+        stream.close();
+    }
+}
+
+class NativeZlib extends Transform {
+    constructor(mode, opts) {
+        super(opts);
+        this._handle = createNative(mode, opts);
+        this._flushFlag = (opts && opts.flush) || Z_NO_FLUSH;
+        this._finishFlushFlag = (opts && opts.finishFlush) || Z_FINISH;
+        this.bytesWritten = 0;
+    }
+
+    _process(chunk, flushFlag, callback) {
+        let out;
+        try {
+            out = this._handle.process(chunk, flushFlag);
+        } catch (e) {
+            this._handle.close();
+            callback(e);
+            return;
+        }
+        if (out.byteLength > 0) {
+            this.push(toBuffer(out));
+        }
+        callback();
+    }
+
+    _transform(chunk, encoding, callback) {
+        const flushFlag = chunk[kFlushFlag] !== undefined ? chunk[kFlushFlag] : this._flushFlag;
+        if (typeof chunk === 'string') {
+            chunk = Buffer.from(chunk, encoding);
+        }
+        this.bytesWritten += chunk.byteLength;
+        this._process(chunk, flushFlag, callback);
+    }
+
+    _flush(callback) {
+        this._process(undefined, this._finishFlushFlag, (err) => {
+            if (!err) {
+                this._handle.close();
+            }
+            callback(err);
+        });
+    }
+
+    // 대기 중인 write 뒤에서 처리되도록 빈 chunk 에 flush flag 를 붙인다 (node 와 동일)
+    flush(kind, callback) {
+        if (typeof kind === 'function' || kind === undefined) {
+            callback = kind;
+            kind = 3; // Z_FULL_FLUSH
+        }
+        const chunk = Buffer.alloc(0);
+        chunk[kFlushFlag] = kind;
+        this.write(chunk, callback);
+    }
+
+    reset() {
+        this._handle.reset();
+    }
+
+    close(callback) {
+        if (callback) {
+            process.nextTick(callback);
+        }
+        this._handle.close();
+        this.destroy();
+    }
+}
+
+for (const name of Object.keys(MODES)) {
+    const mode = MODES[name];
+    const lower = name[0].toLowerCase() + name.slice(1);
+    const jsSync = js[lower + 'Sync'];
+    const jsAsync = js[lower];
+    const jsCreate = js['create' + name];
+
+    module.exports[lower + 'Sync'] = function (buffer, opts) {
+        return isNativeOptions(opts) ? processSync(mode, buffer, opts) : jsSync(buffer, opts);
+    };
+
+    module.exports[lower] = function (buffer, opts, callback) {
+        if (typeof opts === 'function') {
+            callback = opts;
+            opts = {};
+        }
+        if (!isNativeOptions(opts)) {
+            return jsAsync(buffer, opts, callback);
+        }
+        let result;
+        let error = null;
+        try {
+            result = processSync(mode, buffer, opts);
+        } catch (e) {
+            error = e;
+        }
+        process.nextTick(() => callback(error, result));
+    };
+
+    module.exports['create' + name] = function (opts) {
+        return isNativeOptions(opts) ? new NativeZlib(mode, opts) : jsCreate(opts);
+    };
+}
@@ -0,0 +1,140 @@
+// Per-flavor benchmark
+//
+//   REQUEST_UNRAVER_LICENSE=... pnpm bench [dist dir]
+//
+// Runs the same workload on every flavor found in the dist directory
+// (see REQUEST_UNRAVER_WASM_FLAVOR in CMakeLists.txt) and prints the
+// median per phase relative to the debug build.
+import * as fs from 'fs';
+import * as path from 'path';
+import {Runtime, WASM_FLAVOR_FILES, WasmFlavor, supportedWasmFlavors} from './runtime';
+import type {Engine} from './engine';
+
+const ENGINE_MODE_FULL = 22448265;
+const ITERATIONS = 5;
+
+const PAGE = '<!DOCTYPE html><html><head><title>bench</title></head><body>' +
+    Array.from({length: 200}, (_, i) => `<div class="row" id="r${i}"><a href="/item/${i}">item ${i}</a></div>`).join('') +
+    '</body></html>';
+
+// 흔한 unraver 스크립트 형태: 문자열 조작, JSON, DOM 질의
+const SCRIPT = `
+let acc = 0;
+for (let i = 0; i < 20000; i++) {
+    const s = btoa(String(i * 7919)).split('').reverse().join('');
+    acc = (acc + s.charCodeAt(i % s.length)) | 0;
+}
+const rows = Array.from(document.querySelectorAll('.row a')).map((a) => a.getAttribute('href'));
+return JSON.stringify({ acc, rows: rows.length, parsed: JSON.parse(JSON.stringify(rows)).length });
+`;
+
+interface Phase {
+    name: string;
+    run: (runtime: Runtime) => Promise<void>;
+}
+
+// long-lived engine for the per-window phase
+const warmEngines = new Map<Runtime, Engine>();
+
+async function warmEngine(runtime: Runtime): Promise<Engine> {
+    let engine = warmEngines.get(runtime);
+    if (!engine) {
+        engine = await runtime.newEngine(ENGINE_MODE_FULL);
+        warmEngines.set(runtime, engine);
+    }
+    return engine;
+}
+
+const PHASES: Phase[] = [
+    {
+        name: 'engine+window',
+        run: async (runtime) => {
+            const engine = await runtime.newEngine(ENGINE_MODE_FULL);
+            engine.createWindow(PAGE, { url: 'https://bench.local/' });
+            await engine.cleanup();
+        },
+    },
+    {
+        // one more window on a warm engine: what a window context costs
+        // compared to engine+window above
+        name: 'window',
+        run: async (runtime) => {
+            const engine = await warmEngine(runtime);
+            engine.destroyWindow(engine.createWindow(PAGE, { url: 'https://bench.local/' }));
+        },
+    },
+    {
+        name: 'script',
+        run: async (runtime) => {
+            const engine = await runtime.newEngine(ENGINE_MODE_FULL);
+            const window = engine.createWindow(PAGE, { url: 'https://bench.local/' });
+            for (let i = 0; i < 10; i++) {
+                engine.browserEval(window, SCRIPT);
+            }
+            await engine.cleanup();
+        },
+    },
+];
+
+function median(values: number[]): number {
+    const sorted = [...values].sort((a, b) => a - b);
+    return sorted[Math.floor(sorted.length / 2)];
+}
+
+async function benchFlavor(file: string, license: string): Promise<Record<string, number>> {
+    const runtime = await Runtime.fromFile(file, license, undefined, false);
+    const result: Record<string, number> = {};
+    for (const phase of PHASES) {
+        // warm-up (bytecode cache, lazy modules)
+        await phase.run(runtime);
+        const samples: number[] = [];
+        for (let i = 0; i < ITERATIONS; i++) {
+            const start = performance.now();
+            await phase.run(runtime);
+            samples.push(performance.now() - start);
+        }
+        result[phase.name] = median(samples);
+    }
+    const engine = warmEngines.get(runtime);
+    if (engine) {
+        const {contexts} = engine.stats();
+        if (contexts.created) {
+            console.log(`${path.basename(file)}: window context init ${(contexts.totalInitMs / contexts.created).toFixed(2)} ms, ` +
+                `${Math.round(contexts.totalBytes / contexts.created / 1024)} KiB on average`);
+        }
+        await engine.cleanup();
+        warmEngines.delete(runtime);
+    }
+    return result;
+}
+
+(async () => {
+    const distDir = process.argv[2] || '../../cmake-build-release/dist';
+    const license = process.env.REQUEST_UNRAVER_LICENSE || '';
+    const supported = new Set<WasmFlavor>(supportedWasmFlavors());
+
+    const results: Partial<Record<WasmFlavor, Record<string, number>>> = {};
+    for (const flavor of ['debug', 'release', 'simd'] as WasmFlavor[]) {
+        const file = path.join(distDir, WASM_FLAVOR_FILES[flavor]);
+        if (!fs.existsSync(file)) {
+            console.log(`${flavor}: ${file} not found, skipped`);
+            continue;
+        }
+        if (flavor !== 'debug' && !supported.has(flavor)) {
+            console.log(`${flavor}: not supported by this host, skipped`);
+            continue;
+        }
+        results[flavor] = await benchFlavor(file, license);
+    }
+
+    const baseline = results.debug;
+    for (const [flavor, phases] of Object.entries(results)) {
+        for (const [phase, ms] of Object.entries(phases!)) {
+            const ratio = baseline ? ` (x${(baseline[phase] / ms).toFixed(2)} vs debug)` : '';
+            console.log(`${flavor.padEnd(8)} ${phase.padEnd(14)} ${ms.toFixed(2)} ms${ratio}`);
+        }
+    }
+})().catch((e) => {
+    console.error(e);
+    process.exit(1);
+});
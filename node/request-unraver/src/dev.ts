@@ -1,10 +1,16 @@
-import {Runtime, Engine} from './';
+import {Runtime, Engine, LogLevel} from './';
 import * as fs from 'fs';
 
 (async () => {
     try {
         const runtime = await Runtime.fromFile('../../cmake-build-debug/dist/request-unraver-wasm.wasm');
         const engine = await runtime.newEngine(14587050);
+        engine.setLogLevel(LogLevel.Debug);
+        const printGuestLogs = () => {
+            for (const line of engine.drainLogs().lines) {
+                console.log(`[guest:${LogLevel[line.level]}]`, line.text);
+            }
+        };
 
         const wlWindow = engine.createWindow('', {
             url: 'https://www.google.com',
@@ -21,9 +27,11 @@ import * as fs from 'fs';
             fs.readFileSync('./samples/cryptoJS.js', { encoding: 'utf-8' }) +
             '\n} catch(e) { console.log("error:", e, e.stack); }\n'
             );
+        printGuestLogs();
 
         console.log('vestobj');
         engine.browserEval(wlWindow, fs.readFileSync('./samples/vestobj.js', { encoding: 'utf-8' }));
+        printGuestLogs();
         // engine.browserEval(wlWindow, 'Array.prototype.toString = Object.prototype.toString; console.log("test-a"); const a = new ArrayBuffer(64); __sys.overrideWindow.crypto.getRandomValues(a); console.log("a : ", a[0]);');
         // engine.browserEval(wlWindow, 'console.log("test-b"); const a = new Uint8Array(64); __sys.overrideWindow.crypto.getRandomValues(a); console.log("b : ", a);');
         console.log('httpajax');
@@ -32,10 +40,12 @@ import * as fs from 'fs';
             fs.readFileSync('./samples/httpAjax.js', { encoding: 'utf-8' }) +
             '\n} catch(e) { console.log("error:", e, e.stack); }\n'
         );
+        printGuestLogs();
 
 
         // const out = engine.browserEval(wlWindow, 'console.log("VestAjaxJson : ", JSON.stringify(window.VestAjaxJson(\'{"hello": "world"}\')));');
         const out = engine.browserEval(wlWindow, 'return window.VestAjaxJson(\'{"hello": "world"}\')');
+        printGuestLogs();
         console.log('out : ', out);
     } catch (e) {
         console.error(e);
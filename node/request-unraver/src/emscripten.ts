@@ -1,4 +1,5 @@
 import {isArgumentsObject} from 'util/types';
+import {utf8Decoder, utf8Encoder, utf8Length} from './utf8';
 
 const _emscripten_get_now = () => performance.now();
 const _emscripten_date_now = () => Date.now();
@@ -365,21 +366,20 @@ export class EmscriptenRuntime {
             endPtr = ptr + maxBytesToRead;
         }
 
-        // TextDecoder is generally available in modern environments
         const subArray = this.HEAPU8.subarray(ptr, endPtr);
-        return new TextDecoder('utf-8').decode(subArray);
+        return utf8Decoder.decode(subArray);
     }
 
     private stringToUTF8(str: string, outPtr: number, maxBytesToWrite: number): number {
-        const u8 = new TextEncoder().encode(str);
-        const numBytes = Math.min(u8.length, maxBytesToWrite - 1); // reserve 1 for null terminator
-        this.HEAPU8.set(u8.subarray(0, numBytes), outPtr);
-        this.HEAPU8[outPtr + numBytes] = 0;
-        return numBytes;
+        // encode directly into linear memory (reserve 1 for null terminator)
+        const end = Math.min(this.HEAPU8.length, outPtr + maxBytesToWrite - 1);
+        const {written} = utf8Encoder.encodeInto(str, this.HEAPU8.subarray(outPtr, end));
+        this.HEAPU8[outPtr + written] = 0;
+        return written;
     }
 
     private lengthBytesUTF8(str: string): number {
-        return new TextEncoder().encode(str).length;
+        return utf8Length(str);
     }
 
     // --- WASM Imports Implementations ---
@@ -7,135 +7,922 @@ import {
 import {
     ConstructorOptions as JSDOMConstructorOptions
 } from 'jsdom';
+import { createHash, type Hash } from 'crypto';
+import { pack, unpack } from 'msgpackr';
+import { ResultCache } from './result-cache';
+import { Tracer, type EngineTraceBatch } from './tracer';
+import type { Recorder, RecordedStep } from './recorder';
+import { utf8Encoder, utf8Length } from './utf8';
+
+type WasmFn = (...args: any[]) => any;
+
+// `dom: 'native'` builds the window on the native read-only DOM (html_parse)
+// instead of jsdom. MINI mode uses the native DOM unless `dom: 'stub'` is set.
+// `dom: 'stub'` skips parsing entirely: the document is an empty placeholder
+// with only nodeType and write(), as MINI windows had before the native DOM.
+export type WindowOptions = JSDOMConstructorOptions & {
+    dom?: 'jsdom' | 'native' | 'stub';
+};
+
+export function requireExport(exports: Record<string, any>, name: string): WasmFn {
+    const fn = exports[name];
+    if (typeof fn !== 'function') {
+        throw new Error(`wasm export ${name} not found`);
+    }
+    return fn;
+}
+
+// wasm exports used by Engine, resolved once per engine instead of per call
+function bindEngineExports(exports: Record<string, any>) {
+    return {
+        engineNew: requireExport(exports, 'engine_new'),
+        engineCleanup: requireExport(exports, 'engine_cleanup'),
+        hasTimers: requireExport(exports, 'engine_has_timers'),
+        hasPendingJobs: requireExport(exports, 'engine_has_pending_jobs'),
+        hasPendingIo: requireExport(exports, 'engine_has_pending_io'),
+        loopStep: requireExport(exports, 'engine_loop_step'),
+        completeIo: requireExport(exports, 'engine_complete_io'),
+        jsEval: requireExport(exports, 'engine_js_eval'),
+        createWindowArena: requireExport(exports, 'engine_create_window_arena'),
+        windowBegin: requireExport(exports, 'engine_window_begin'),
+        windowWrite: requireExport(exports, 'engine_window_write'),
+        windowEnd: requireExport(exports, 'engine_window_end'),
+        windowAbort: requireExport(exports, 'engine_window_abort'),
+        destroyWindow: requireExport(exports, 'engine_destroy_window'),
+        releaseAllWindows: requireExport(exports, 'engine_release_all_windows'),
+        windowMemory: requireExport(exports, 'engine_window_memory'),
+        leakReport: requireExport(exports, 'engine_leak_report'),
+        gc: requireExport(exports, 'engine_gc'),
+        gcHeadroom: requireExport(exports, 'engine_gc_headroom'),
+        stats: requireExport(exports, 'engine_stats'),
+        coverageDump: requireExport(exports, 'engine_coverage_dump'),
+        takeUncacheable: requireExport(exports, 'engine_take_uncacheable'),
+        traceEnable: requireExport(exports, 'engine_trace_enable'),
+        traceSetRequest: requireExport(exports, 'engine_trace_set_request'),
+        traceDrain: requireExport(exports, 'engine_trace_drain'),
+        profileStart: requireExport(exports, 'engine_profile_start'),
+        profileStop: requireExport(exports, 'engine_profile_stop'),
+        setLogLevel: requireExport(exports, 'engine_set_log_level'),
+        drainLogs: requireExport(exports, 'engine_drain_logs'),
+        useJquery: requireExport(exports, 'engine_use_jquery'),
+        browserEvalArena: requireExport(exports, 'engine_browser_eval_arena'),
+        browserEvalBatch: requireExport(exports, 'engine_browser_eval_batch'),
+        arenaReserve: requireExport(exports, 'engine_arena_reserve'),
+        extractDocument: requireExport(exports, 'engine_extract_document'),
+    };
+}
+
+type EngineExports = ReturnType<typeof bindEngineExports>;
+
+// trace-event pid of each Engine
+let nextTracePid = 1;
+
+export interface IoRequest {
+    kind: string;
+    id: number;
+    // xhr: JSON ({ method, url, responseType, requestType, headers })
+    request: string;
+    body: string | Uint8Array | null;
+    // Window whose scripts submitted the request. null for the engine context;
+    // requests sent while the window is still being built (its inline
+    // scripts) get it once createWindow()/endWindow() returns.
+    window: WlValue | null;
+}
+
+// 호스트 I/O 핸들러. 반환값은 msgpack 으로 게스트에 전달된다.
+// (xhr: { status, url, contentType, responseType, data })
+export type IoHandler = (request: IoRequest) => Promise<any>;
+
+// engine_window_memory (src/window_memory.h). JS heap bytes charged to one
+// window: its context setup plus window creation and evals run against it.
+export interface WindowMemory {
+    contextBytes: number;
+    // Net change across charged calls; GC during a call can make it negative.
+    chargedBytes: number;
+    heldBytes: number;
+    peakBytes: number;
+    calls: number;
+}
+
+// engine_leak_report. Each destroyed window is reported until it is collected.
+export interface LeakReport {
+    // JS_ComputeMemoryUsage after a full GC
+    heap: {
+        mallocSize: number;
+        mallocCount: number;
+        memoryUsedSize: number;
+        objCount: number;
+        strCount: number;
+        jsFuncCount: number;
+    };
+    windows: {
+        handle: number;
+        heldBytes: number;
+        // Released right away by refcounting; cycles are only freed by GC.
+        freedBytes: number;
+        // The window's global is still reachable after destroyWindow().
+        retained: boolean;
+        // Object-valued globals the page added, listed when retained.
+        globals: { name: string; type: 'object' | 'function' | 'accessor' }[];
+    }[];
+}
+
+export interface EngineStats {
+    handles: {
+        live: number;
+        windows: number;
+    };
+    // QuickJS runtime allocator (src/engine_allocator.h)
+    allocator: {
+        arenaChunks: number;
+        // Chunks handed back to malloc once every block in them was freed.
+        arenaChunksReleased: number;
+        arenaReserved: number;
+        arenaUsed: number;
+        smallCount: number;
+        smallBytes: number;
+        largeCount: number;
+        largeBytes: number;
+        peakBytes: number;
+        allocCalls: number;
+        freeCalls: number;
+    };
+    // Host-scheduled collections (gc() and pool idle GC). Collections QuickJS
+    // triggers on its own threshold are not counted or timed.
+    gc: {
+        collections: number;
+        // Budget requests that found too little growth to collect.
+        skipped: number;
+        // Requests that ran with automatic collection held off by the headroom.
+        deferredRequests: number;
+        freedBytes: number;
+        totalPauseMs: number;
+        maxPauseMs: number;
+        lastPauseMs: number;
+        headroom: number;
+        // Current QuickJS automatic GC threshold (bytes).
+        threshold: number;
+    };
+    // Window contexts: globals plus the pseudo-browser bundle run per window.
+    contexts: {
+        created: number;
+        totalInitMs: number;
+        maxInitMs: number;
+        totalBytes: number;
+    };
+}
+
+// engine_gc mode (src/engine.h GcMode)
+export enum GcMode {
+    Full = 0,
+    // Collect only once the heap has grown a quarter (at least 256 KiB) past
+    // the last collection. QuickJS has no incremental GC, so this bounds how
+    // often a pause happens, not how long it takes.
+    Budget = 1,
+}
+
+export interface GcResult {
+    collected: boolean;
+    pauseMs: number;
+    freedBytes: number;
+    liveBytes: number;
+}
+
+// Minimum console level buffered by the engine (src/log_buffer.h).
+// Release builds start at Off.
+export enum LogLevel {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+    Off = 4,
+}
+
+export interface LogBatch {
+    // Lines overwritten because the ring buffer was full since the last drain.
+    dropped: number;
+    lines: { level: LogLevel; text: string }[];
+}
+
+// engine_profile_stop (src/profiler.h)
+export interface ProfileResult {
+    // Weighted sample count; a tick that covered n intervals counts n times.
+    samples: number;
+    intervalMs: number;
+    durationMs: number;
+    // Collapsed stacks ("root;...;leaf count" per line) for flamegraph.pl / speedscope.
+    stacks: string;
+}
+
+export interface EvalCacheOptions {
+    // The caller asserts that the script only reads window state. Only pure
+    // evaluations are looked up in and stored to the result cache; any other
+    // evaluation always runs and is chained into the window's state key.
+    pure?: boolean;
+    // Overrides the cache's default ttl (ms) for this result.
+    ttl?: number;
+}
+
+export interface BatchEvalResult {
+    value?: any;
+    error?: string;
+}
+
+// Sections to collect with extractDocument (all default to true).
+export interface ExtractOptions {
+    title?: boolean;
+    scripts?: boolean;
+    forms?: boolean;
+    meta?: boolean;
+    // Extra attributes as "tag[attr]" or "[attr]" (any tag), e.g. "a[href]".
+    attributes?: string[];
+}
+
+export interface ExtractedFormField {
+    tag: string;
+    name: string;
+    type: string;
+    value: string;
+    checked?: boolean;
+}
+
+export interface ExtractedDocument {
+    title?: string;
+    // Inline scripts (no src) in document order.
+    scripts?: { type: string; text: string }[];
+    scriptSources?: string[];
+    forms?: { attributes: Record<string, string>; fields: ExtractedFormField[] }[];
+    meta?: Record<string, string>[];
+    attributes?: { tag: string; name: string; value: string }[];
+}
 
 export class Engine {
     protected walink!: Walink;
+    protected fns!: EngineExports;
     protected engineHandle: WlValue | null = null;
+    protected ioHandler: IoHandler | null = null;
+    protected readonly pendingIo = new Map<number, Promise<void>>();
+    protected mode = 0;
+    protected resultCache: ResultCache | null = null;
+    // state key of windows created while a result cache was set: the content
+    // key chained with every step run on the window since (advanceWindowKey)
+    protected readonly windowKeys = new Map<WlValue, string>();
+    // content hash of window streams begun while a result cache was set
+    protected tracer: Tracer | null = null;
+    protected traceRequestId = 0;
+    protected readonly tracePid = nextTracePid++;
+    protected readonly streamHashes = new Map<number, { hash: Hash; options: Uint8Array | string }>();
+    protected recorder: Recorder | null = null;
+    // window being built by createWindow()/endWindow() (see buildWindow)
+    protected windowBuild: { window: WlValue | null } | null = null;
+    protected idleGc: { delayMs: number; mode: GcMode; timer: ReturnType<typeof setTimeout> | null } | null = null;
 
     constructor(
         protected readonly runtime: EmscriptenRuntime,
+        protected readonly onCleanup?: (handle: bigint) => void,
     ) {
     }
 
+    public get handle(): bigint | null {
+        return this.engineHandle as bigint | null;
+    }
+
+    public setIoHandler(handler: IoHandler | null): void {
+        this.ioHandler = handler;
+    }
+
+    // Record spans of this engine into `tracer` (null turns tracing off).
+    public setTracer(tracer: Tracer | null): void {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        if (this.tracer) {
+            this.drainTrace();
+        }
+        this.tracer = tracer;
+        this.fns.traceEnable(this.engineHandle, this.walink.toWlUint32(tracer ? 1 : 0));
+        if (tracer) {
+            this.fns.traceSetRequest(this.engineHandle, this.walink.toWlUint32(this.traceRequestId));
+        }
+    }
+
+    // Request id (trace-event tid) attached to every span that follows,
+    // host, native and guest alike.
+    public setTraceRequest(requestId: number): void {
+        this.traceRequestId = requestId >>> 0;
+        if (this.tracer && this.engineHandle) {
+            this.fns.traceSetRequest(this.engineHandle, this.walink.toWlUint32(this.traceRequestId));
+        }
+    }
+
+    // Move the spans recorded inside the engine into the tracer.
+    public drainTrace(): void {
+        if (!this.tracer || !this.engineHandle) return;
+        const raw = this.fns.traceDrain(this.engineHandle);
+        this.tracer.addEngineEvents(this.tracePid, this.walink.decode(raw) as EngineTraceBatch);
+    }
+
+    protected traced<T>(name: string, fn: () => T): T {
+        this.armIdleGc();
+        const tracer = this.tracer;
+        if (!tracer) {
+            return fn();
+        }
+        try {
+            return tracer.span(this.tracePid, this.traceRequestId, 'host', name, fn);
+        } finally {
+            this.drainTrace();
+        }
+    }
+
+    // Capture windows, evaluations and host I/O of this engine for offline
+    // replay (see recorder.ts / replay.ts).
+    public setRecorder(recorder: Recorder | null): void {
+        this.recorder?.engineReleased(this);
+        this.recorder = recorder;
+    }
+
+    protected recorded<T>(window: WlValue, step: (durationMs: number) => RecordedStep, fn: () => T): T {
+        const recorder = this.recorder;
+        if (!recorder) {
+            return fn();
+        }
+        const begin = performance.now();
+        try {
+            return fn();
+        } finally {
+            recorder.stepDone(this, window, step(performance.now() - begin));
+        }
+    }
+
+    // Opt-in browserEval result cache. Only windows created after this call
+    // are keyed, since the key needs the window content.
+    public setResultCache(cache: ResultCache | null): void {
+        this.resultCache = cache;
+        if (!cache) {
+            this.windowKeys.clear();
+        }
+    }
+
+    // Chains a step that ran on the window into its state key, so later pure
+    // evaluations are keyed by everything that was done to the window. A step
+    // whose effect cannot be reproduced (it failed, or used the clock, random
+    // numbers or host I/O) ends caching for the window.
+    protected advanceWindowKey(window: WlValue, reproducible: boolean, ...step: (string | Uint8Array)[]): void {
+        const key = this.windowKeys.get(window);
+        if (key === undefined) return;
+        if (reproducible) {
+            this.windowKeys.set(window, ResultCache.key(key, ...step));
+        } else {
+            this.windowKeys.delete(window);
+        }
+    }
+
+    // Guest code run outside browserEval/useJquery/browserEvalBatch (jsEval,
+    // promise jobs, timers, I/O callbacks) can change any window without a
+    // step to chain, so the windows that exist at that point stop being cached.
+    protected forgetWindowKeys(): void {
+        this.windowKeys.clear();
+    }
+
     // Initialize walink helper and create Engine instance inside WASM.
     public async init(mode: number): Promise<void> {
         // Build walink helper bound to instantiated WASM instance
         this.walink = createWalinkFromInstance(this.runtime.instance);
+        this.fns = bindEngineExports(this.runtime.exports);
 
-        const v = (this.runtime.exports['engine_new'] as any)(this.walink.toWlUint32(mode));
+        const v = this.fns.engineNew(this.walink.toWlUint32(mode));
         this.walink.decode(v);
         this.engineHandle = v as bigint;
+        this.mode = mode;
     }
 
     public async cleanup(): Promise<boolean> {
         if (!this.engineHandle) return false;
-        if (typeof this.runtime.exports['engine_cleanup'] !== 'function') {
-            throw new Error('wasm export engine_cleanup not found');
-        }
-        const res = (this.runtime.exports['engine_cleanup'] as any)(this.engineHandle);
+        const handle = this.engineHandle as bigint;
+        this.drainTrace();
+        const res = this.fns.engineCleanup(handle);
+        this.engineHandle = null;
+        this.setIdleGc(null);
+        this.pendingIo.clear();
+        this.windowKeys.clear();
+        this.streamHashes.clear();
+        this.recorder?.engineReleased(this);
+        this.onCleanup?.(handle);
         // decode boolean
         return this.walink.fromWlBool(res);
     }
 
     public hasTimers(): boolean {
         if (!this.engineHandle) return false;
-        const fn = this.runtime.exports['engine_has_timers'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_has_timers not found');
-        }
-        const res = (fn as any)(this.engineHandle);
+        const fn = this.fns.hasTimers;
+        const res = fn(this.engineHandle);
         return this.walink.fromWlBool(res);
     }
 
     public hasPendingJobs(): boolean {
         if (!this.engineHandle) return false;
-        const fn = this.runtime.exports['engine_has_pending_jobs'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_has_pending_jobs not found');
+        const fn = this.fns.hasPendingJobs;
+        const res = fn(this.engineHandle);
+        return this.walink.fromWlBool(res);
+    }
+
+    public hasPendingIo(): boolean {
+        if (!this.engineHandle) return false;
+        const fn = this.fns.hasPendingIo;
+        const res = fn(this.engineHandle);
+        return this.walink.fromWlBool(res);
+    }
+
+    // Run pending jobs (including completed I/O) and expired timers once.
+    // Returns true if more work is immediately runnable.
+    public loopStep(): boolean {
+        if (!this.engineHandle) return false;
+        if (this.windowKeys.size > 0 && (this.hasPendingJobs() || this.hasTimers())) {
+            this.forgetWindowKeys();
         }
-        const res = (fn as any)(this.engineHandle);
+        const fn = this.fns.loopStep;
+        const res = fn(this.engineHandle);
+        this.walink.decode(res);
         return this.walink.fromWlBool(res);
     }
 
+    // Drive the event loop until no job is runnable and no host I/O is in flight.
+    // Awaiting I/O yields to the host event loop, so other engines on the same
+    // instance keep working while this engine's requests are outstanding.
+    // Pending (not yet expired) timers do not keep this loop alive.
+    public async runUntilIdle(): Promise<void> {
+        for (;;) {
+            while (this.loopStep()) {
+                // drain runnable jobs
+            }
+            if (this.pendingIo.size === 0) {
+                return;
+            }
+            await Promise.race(this.pendingIo.values());
+        }
+    }
+
+    // Called by Runtime when the guest submits host I/O (ru_io_submit).
+    public dispatchIo(ioId: number, raw: Uint8Array, window: bigint = 0n): void {
+        const request = unpack(raw) as IoRequest;
+        request.window = window !== 0n ? window as WlValue : null;
+        const build = request.window === null ? this.windowBuild : null;
+        const handler = this.ioHandler;
+        const task = (async () => {
+            // never re-enter wasm from inside the ru_io_submit import
+            await Promise.resolve();
+            if (build) {
+                request.window = build.window;
+            }
+            let result: any;
+            const begin = performance.now();
+            try {
+                if (!handler) {
+                    throw new Error(`no io handler for ${request.kind}`);
+                }
+                const tracer = this.tracer;
+                result = tracer
+                    ? await tracer.spanAsync(this.tracePid, this.traceRequestId, 'io', request.kind, () => handler(request))
+                    : await handler(request);
+            } catch (e: any) {
+                result = { error: String(e?.message ?? e) };
+            }
+            this.recorder?.ioDone(this, request, result, performance.now() - begin);
+            this.completeIo(ioId, result);
+        })().finally(() => {
+            this.pendingIo.delete(ioId);
+        });
+        this.pendingIo.set(ioId, task);
+    }
+
+    protected completeIo(ioId: number, result: any): void {
+        if (!this.engineHandle) return;
+        const fn = this.fns.completeIo;
+        const res = fn(
+            this.engineHandle,
+            this.walink.toWlUint32(ioId),
+            this.walink.toWlMsgpack(result ?? null),
+        );
+        this.walink.fromWlBool(res);
+    }
+
     // Evaluate JS code inside the engine.
     // Returns decoded result (object/string/primitive) or throws on error.
     public jsEval(code: string): any {
         if (!this.engineHandle) throw new Error('engine not initialized');
-        const fn = this.runtime.exports['engine_js_eval'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_js_eval not found');
+
+        return this.traced('jsEval', () => {
+            this.forgetWindowKeys();
+            const fn = this.fns.jsEval;
+
+            const raw = fn(this.engineHandle, this.walink.toWlString(code));
+
+            // raw === 0 indicates undefined/null as per wasm binding; handle early
+            if (!raw) return undefined;
+
+            // Decode using walink. If result is an error tag, walink.decode will throw.
+            return this.walink.decode(raw);
+        });
+    }
+
+    // Write `str` as UTF-8 straight into the engine's transfer arena in linear
+    // memory. Returns the number of bytes written.
+    protected writeArena(str: string): number {
+        const size = utf8Length(str);
+        const ptr = this.fns.arenaReserve(this.engineHandle, size) >>> 0;
+        if (!ptr) {
+            throw new Error('engine_arena_reserve failed');
         }
+        // reserve may grow memory; HEAPU8 is refreshed by the runtime
+        const {written} = utf8Encoder.encodeInto(str, this.runtime.HEAPU8.subarray(ptr, ptr + size));
+        return written;
+    }
 
-        const raw = (fn as any)(this.engineHandle, this.walink.toWlString(code));
+    protected writeArenaBytes(data: Uint8Array): number {
+        const ptr = this.fns.arenaReserve(this.engineHandle, data.length) >>> 0;
+        if (!ptr) {
+            throw new Error('engine_arena_reserve failed');
+        }
+        this.runtime.HEAPU8.set(data, ptr);
+        return data.length;
+    }
 
-        // raw === 0 indicates undefined/null as per wasm binding; handle early
-        if (!raw) return undefined;
+    public createWindow(content?: string | null, windowOptions?: WindowOptions | null): WlValue {
+        if (!this.engineHandle) throw new Error('engine not initialized');
 
-        // Decode using walink. If result is an error tag, walink.decode will throw.
-        return this.walink.decode(raw);
+        return this.traced('createWindow', () => {
+            const contentLen = content ? this.writeArena(content) : 0;
+            const raw = this.buildWindow(() => this.fns.createWindowArena(
+                this.engineHandle,
+                this.walink.toWlUint32(contentLen),
+                windowOptions ? this.walink.toWlMsgpack(windowOptions) : 0n,
+            ) as WlValue);
+            if (this.resultCache) {
+                const digest = createHash('sha256').update(content ?? '').digest('hex');
+                this.windowKeys.set(raw, ResultCache.key(digest, windowOptions ? pack(windowOptions) : ''));
+            }
+            this.recorder?.windowCreated(this, raw, this.mode, content ?? '', windowOptions ?? null);
+            return raw;
+        });
     }
 
-    public createWindow(content?: string | null, windowOptions?: JSDOMConstructorOptions | null): WlValue {
+    // Streaming createWindow: feed the content as it arrives with writeWindow()
+    // and get the window from endWindow(). With the native DOM each chunk is
+    // parsed immediately, so the full document is never held as one string.
+    // sizeHint is the expected content size in bytes (e.g. Content-Length).
+    public beginWindow(windowOptions?: WindowOptions | null, sizeHint: number = 0): number {
         if (!this.engineHandle) throw new Error('engine not initialized');
 
-        const fn = this.runtime.exports['engine_create_window'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_js_eval not found');
+        const raw = this.fns.windowBegin(
+            this.engineHandle,
+            windowOptions ? this.walink.toWlMsgpack(windowOptions) : 0n,
+            this.walink.toWlUint32(sizeHint),
+        );
+        const stream = this.walink.decode(raw) as number;
+        if (this.resultCache) {
+            this.streamHashes.set(stream, {
+                hash: createHash('sha256'),
+                options: windowOptions ? pack(windowOptions) : '',
+            });
         }
+        this.recorder?.streamBegun(this, stream, windowOptions ?? null);
+        return stream;
+    }
+
+    public writeWindow(stream: number, chunk: string | Uint8Array): void {
+        if (!this.engineHandle) throw new Error('engine not initialized');
 
-        const raw = (fn as any)(
+        const chunkLen = typeof chunk === 'string' ? this.writeArena(chunk) : this.writeArenaBytes(chunk);
+        const raw = this.fns.windowWrite(
             this.engineHandle,
-            content ? this.walink.toWlString(content) : 0n,
-            windowOptions ? this.walink.toWlMsgpack(windowOptions) : 0n,
-        ) as WlValue;
+            this.walink.toWlUint32(stream),
+            this.walink.toWlUint32(chunkLen),
+        );
         this.walink.decode(raw);
-        return raw;
+        this.streamHashes.get(stream)?.hash.update(chunk);
+        this.recorder?.streamChunk(this, stream, chunk);
     }
 
-    public destroyWindow(wlWindow: WlValue): boolean {
-        const fn = this.runtime.exports['engine_destroy_window'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_destroy_window not found');
+    public endWindow(stream: number): WlValue {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+
+        return this.traced('endWindow', () => {
+            const pending = this.streamHashes.get(stream);
+            this.streamHashes.delete(stream);
+            const raw = this.buildWindow(() => this.fns.windowEnd(this.engineHandle, this.walink.toWlUint32(stream)) as WlValue);
+            if (pending && this.resultCache) {
+                this.windowKeys.set(raw, ResultCache.key(pending.hash.digest('hex'), pending.options));
+            }
+            this.recorder?.streamEnded(this, stream, raw, this.mode);
+            return raw;
+        });
+    }
+
+    // Runs a call that creates a window and decodes its result. The guest only
+    // tags host I/O with a window once it is registered, so requests its
+    // inline scripts submit during fn are given the returned window here (a
+    // failed call leaves them without one).
+    protected buildWindow(fn: () => WlValue): WlValue {
+        const outer = this.windowBuild;
+        const build: { window: WlValue | null } = { window: null };
+        this.windowBuild = build;
+        try {
+            const raw = fn();
+            this.walink.decode(raw);
+            build.window = raw;
+            return raw;
+        } finally {
+            this.windowBuild = outer;
         }
-        const raw = fn(this.engineHandle, wlWindow);
+    }
+
+    // Drop a stream that will not be finished (e.g. the upstream failed).
+    public abortWindow(stream: number): boolean {
+        if (!this.engineHandle) return false;
+        this.streamHashes.delete(stream);
+        this.recorder?.streamEnded(this, stream, null, this.mode);
+        const raw = this.fns.windowAbort(this.engineHandle, this.walink.toWlUint32(stream));
         return this.walink.fromWlBool(raw);
     }
 
-    public useJquery(window: WlValue): WlValue {
+    // Create a window from a chunked body (e.g. a fetch() response body),
+    // parsing while the rest is still being received.
+    public async createWindowFromStream(
+        chunks: AsyncIterable<string | Uint8Array>,
+        windowOptions?: WindowOptions | null,
+        sizeHint: number = 0,
+    ): Promise<WlValue> {
+        const stream = this.beginWindow(windowOptions, sizeHint);
+        try {
+            for await (const chunk of chunks) {
+                this.writeWindow(stream, chunk);
+            }
+        } catch (e) {
+            this.abortWindow(stream);
+            throw e;
+        }
+        return this.endWindow(stream);
+    }
+
+    // Scans the HTML without creating a window or a DOM and returns inline
+    // scripts, form fields and the requested attributes (src/html_extract.h).
+    public extractDocument(content: string, options?: ExtractOptions | null): ExtractedDocument {
         if (!this.engineHandle) throw new Error('engine not initialized');
 
-        const fn = this.runtime.exports['engine_use_jquery'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_use_jquery not found');
-        }
+        return this.traced('extractDocument', () => {
+            const contentLen = content ? this.writeArena(content) : 0;
+            const raw = this.fns.extractDocument(
+                this.engineHandle,
+                this.walink.toWlUint32(contentLen),
+                options ? this.walink.toWlMsgpack(options) : 0n,
+            ) as WlValue;
+            return this.walink.decode(raw) as ExtractedDocument;
+        });
+    }
 
-        const ret = (fn as any)(
-            this.engineHandle,
-            window,
-        ) as WlValue;
+    // Returns false if the handle is unknown or was already destroyed.
+    public destroyWindow(wlWindow: WlValue): boolean {
+        if (!this.engineHandle) return false;
+        this.windowKeys.delete(wlWindow);
+        this.recorder?.windowDestroyed(this, wlWindow);
+        const raw = this.fns.destroyWindow(this.engineHandle, wlWindow);
+        return this.walink.fromWlBool(raw);
+    }
+
+    // Destroy every window held by the engine. Returns how many were released.
+    public releaseAllWindows(): number {
+        if (!this.engineHandle) return 0;
+        this.windowKeys.clear();
+        this.recorder?.engineReleased(this);
+        const raw = this.fns.releaseAllWindows(this.engineHandle);
+        return this.walink.decode(raw) as number;
+    }
+
+    public windowMemory(wlWindow: WlValue): WindowMemory {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.windowMemory(this.engineHandle, wlWindow);
+        return this.walink.decode(raw) as WindowMemory;
+    }
 
-        this.walink.decode(ret);
+    // Runs a full GC, so keep it off the request path.
+    public leakReport(): LeakReport {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.leakReport(this.engineHandle);
+        return this.walink.decode(raw) as LeakReport;
+    }
 
-        return ret;
+    // Collect now; meant for idle points between requests.
+    public gc(mode: GcMode = GcMode.Full): GcResult {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.gc(this.engineHandle, this.walink.toWlUint32(mode));
+        return this.walink.decode(raw) as GcResult;
     }
 
-    public browserEval(window: WlValue, content: string, params?: any): any {
+    // While a window is created or evaluated, hold automatic collection off
+    // until the heap grows `bytes` past its size at the start of the call, so
+    // the pause moves to gc() between requests. 0 turns it off. Returns the
+    // previous value.
+    public setGcHeadroom(bytes: number): number {
         if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.gcHeadroom(this.engineHandle, this.walink.toWlUint32(bytes));
+        return this.walink.decode(raw) as number;
+    }
 
-        const fn = this.runtime.exports['engine_browser_eval'];
-        if (typeof fn !== 'function') {
-            throw new Error('wasm export engine_js_eval not found');
+    // Run gc(mode) once the engine has had no calls for `delayMs` and no host
+    // I/O in flight. null turns it off.
+    public setIdleGc(delayMs: number | null, mode: GcMode = GcMode.Budget): void {
+        if (this.idleGc?.timer) {
+            clearTimeout(this.idleGc.timer);
         }
+        this.idleGc = delayMs === null ? null : { delayMs, mode, timer: null };
+    }
 
-        const raw = (fn as any)(
-            this.engineHandle,
-            window,
-            content ? this.walink.toWlString(content) : 0n,
-            params ? this.walink.toWlMsgpack(params) : 0n,
-        );
-        if (!raw) {
-            return null;
+    protected armIdleGc(): void {
+        const idle = this.idleGc;
+        if (!idle) return;
+        if (idle.timer) {
+            clearTimeout(idle.timer);
         }
-        return this.walink.decode(raw);
+        idle.timer = setTimeout(() => {
+            idle.timer = null;
+            if (this.idleGc !== idle || !this.engineHandle) return;
+            if (this.pendingIo.size > 0) {
+                this.armIdleGc();
+                return;
+            }
+            try {
+                this.gc(idle.mode);
+            } catch (e: any) {
+                // runs from a bare timer: an exception here would be uncaught
+                console.warn(`idle gc failed: ${e?.message ?? e}`);
+            }
+        }, idle.delayMs);
+        (idle.timer as any).unref?.();
+    }
+
+    public stats(): EngineStats {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.stats(this.engineHandle);
+        return this.walink.decode(raw) as EngineStats;
+    }
+
+    // Function ids hit so far. Only populated by a pseudo-browser build with
+    // PSEUDO_BROWSER_COVERAGE=instrument (see node/pseudo-browser/coverage.mjs).
+    public coverageDump(): number[] {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.coverageDump(this.engineHandle);
+        return this.walink.decode(raw) as number[];
+    }
+
+    // Returns the previous level.
+    public setLogLevel(level: LogLevel): LogLevel {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.setLogLevel(this.engineHandle, this.walink.toWlUint32(level));
+        return this.walink.decode(raw) as LogLevel;
+    }
+
+    // Takes the console output buffered since the last call.
+    public drainLogs(): LogBatch {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.drainLogs(this.engineHandle);
+        return this.walink.decode(raw) as LogBatch;
+    }
+
+    // Samples guest JS stacks every intervalMs until profileStop(). Sampling
+    // runs from the QuickJS interrupt handler, so code that stays in native
+    // calls is attributed to the JS frame that made the call.
+    public profileStart(intervalMs: number = 1): void {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const intervalUs = Math.max(1, Math.round(intervalMs * 1000));
+        this.walink.decode(this.fns.profileStart(this.engineHandle, this.walink.toWlUint32(intervalUs)));
+    }
+
+    public profileStop(): ProfileResult {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+        const raw = this.fns.profileStop(this.engineHandle);
+        return this.walink.decode(raw) as ProfileResult;
+    }
+
+    public useJquery(window: WlValue): WlValue {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+
+        return this.recorded(window, (durationMs) => ({ kind: 'jquery', durationMs }), () => this.traced('useJquery', () => {
+            const fn = this.fns.useJquery;
+            const keyed = this.windowKeys.has(window);
+            if (keyed) {
+                this.fns.takeUncacheable(this.engineHandle);
+            }
+
+            let ok = false;
+            try {
+                const ret = fn(
+                    this.engineHandle,
+                    window,
+                ) as WlValue;
+
+                this.walink.decode(ret);
+                ok = true;
+
+                return ret;
+            } finally {
+                if (keyed) {
+                    const uncacheable = this.walink.fromWlBool(this.fns.takeUncacheable(this.engineHandle));
+                    this.advanceWindowKey(window, ok && !uncacheable, 'jquery');
+                }
+            }
+        }));
+    }
+
+    // With a result cache set, a pure evaluation (cacheOptions.pure) that hits
+    // returns without entering the engine. Errors and runs whose script used
+    // the clock, random numbers or host I/O are not stored.
+    public browserEval(window: WlValue, content: string, params?: any, cacheOptions?: EvalCacheOptions): any {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+
+        const step = (durationMs: number): RecordedStep => ({ kind: 'eval', code: content, params, durationMs });
+        return this.recorded(window, step, () => this.traced('browserEval', () => {
+            const cache = this.resultCache;
+            const windowKey = cache ? this.windowKeys.get(window) : undefined;
+            const pure = cacheOptions?.pure === true;
+            const packedParams = windowKey !== undefined && params ? pack(params) : '';
+            let key: string | undefined;
+            if (cache && windowKey !== undefined) {
+                if (pure) {
+                    key = ResultCache.key(this.mode, windowKey, content ?? '', packedParams);
+                    const hit = cache.get(key);
+                    if (hit) {
+                        return hit.value;
+                    }
+                }
+                // drop whatever was recorded since the last evaluation
+                this.fns.takeUncacheable(this.engineHandle);
+            }
+
+            let ok = false;
+            let result: any = null;
+            try {
+                const codeLen = content ? this.writeArena(content) : 0;
+                const raw = this.fns.browserEvalArena(
+                    this.engineHandle,
+                    window,
+                    this.walink.toWlUint32(codeLen),
+                    params ? this.walink.toWlMsgpack(params) : 0n,
+                );
+                result = raw ? this.walink.decode(raw) : null;
+                ok = true;
+                return result;
+            } finally {
+                if (cache && windowKey !== undefined) {
+                    const uncacheable = this.walink.fromWlBool(this.fns.takeUncacheable(this.engineHandle));
+                    if (!pure) {
+                        this.advanceWindowKey(window, ok && !uncacheable, 'eval', content ?? '', packedParams, pack(result ?? null));
+                    } else if (key && ok) {
+                        if (uncacheable) {
+                            cache.markUncacheable();
+                        } else {
+                            cache.set(key, result, cacheOptions?.ttl);
+                        }
+                    }
+                }
+            }
+        }));
+    }
+
+    // Evaluate the same script against many param sets in one call.
+    // The script is compiled once; each item yields { value } or { error }.
+    public browserEvalBatch(window: WlValue, content: string, paramsList: any[]): BatchEvalResult[] {
+        if (!this.engineHandle) throw new Error('engine not initialized');
+
+        const step = (durationMs: number): RecordedStep => ({ kind: 'batch', code: content, paramsList, durationMs });
+        return this.recorded(window, step, () => this.traced('browserEvalBatch', () => {
+            if (!Array.isArray(paramsList)) {
+                throw new TypeError('browserEvalBatch: paramsList must be an array');
+            }
+            const keyed = this.windowKeys.has(window);
+            if (keyed) {
+                this.fns.takeUncacheable(this.engineHandle);
+            }
+
+            let ok = false;
+            let results: BatchEvalResult[] = [];
+            try {
+                const codeLen = content ? this.writeArena(content) : 0;
+                const raw = this.fns.browserEvalBatch(
+                    this.engineHandle,
+                    window,
+                    this.walink.toWlUint32(codeLen),
+                    this.walink.toWlMsgpack(paramsList),
+                );
+                if (raw) {
+                    results = this.walink.decode(raw) as BatchEvalResult[];
+                }
+                ok = true;
+                return results;
+            } finally {
+                if (keyed) {
+                    const uncacheable = this.walink.fromWlBool(this.fns.takeUncacheable(this.engineHandle));
+                    this.advanceWindowKey(window, ok && !uncacheable, 'batch', content ?? '', pack(paramsList), pack(results));
+                }
+            }
+        }));
     }
-}
\ No newline at end of file
+}
@@ -1,2 +1,7 @@
 export * from './runtime';
-export * from './engine';
\ No newline at end of file
+export * from './engine';
+export * from './result-cache';
+export * from './tracer';
+export * from './runtime-mt';
+export * from './recorder';
+export * from './replay';
@@ -0,0 +1,212 @@
+import * as fs from 'fs';
+import {gzipSync, gunzipSync} from 'zlib';
+import {pack, unpack} from 'msgpackr';
+import type {WlValue} from 'walink';
+import type {Engine, IoRequest, WindowOptions} from './engine';
+
+export const CORPUS_VERSION = 1;
+
+// Host I/O exchanged during a job, replayed as a mocked response.
+export interface RecordedIo {
+    kind: string;
+    request: string;
+    body: string | Uint8Array | null;
+    result: any;
+    latencyMs: number;
+}
+
+export type RecordedStep =
+    | { kind: 'eval'; code: string; params?: any; durationMs: number }
+    | { kind: 'batch'; code: string; paramsList: any[]; durationMs: number }
+    | { kind: 'jquery'; durationMs: number };
+
+// One window from creation to destroyWindow().
+export interface RecordedJob {
+    mode: number;
+    html: string;
+    windowOptions: WindowOptions | null;
+    steps: RecordedStep[];
+    io: RecordedIo[];
+    // Date.now() at window creation
+    startedAt: number;
+    durationMs: number;
+}
+
+// Stored as gzip(msgpack(Corpus)).
+export interface Corpus {
+    version: number;
+    jobs: RecordedJob[];
+}
+
+export interface RecorderOptions {
+    // Fraction of windows recorded (0..1).
+    sampleRate?: number;
+    // Windows past this count are not recorded.
+    maxJobs?: number;
+}
+
+interface EngineRecording {
+    windows: Map<WlValue, { job: RecordedJob; begin: number }>;
+    streams: Map<number, { chunks: string[]; decoder: TextDecoder; windowOptions: WindowOptions | null }>;
+}
+
+// Captures real jobs from engines attached with Engine.setRecorder() so they
+// can be replayed offline (see replay.ts). Window content, evaluated scripts,
+// params and every host I/O request/response are kept as-is, so treat corpus
+// files like the production data they contain.
+export class Recorder {
+    private readonly jobs: RecordedJob[] = [];
+    private readonly engines = new WeakMap<Engine, EngineRecording>();
+    private readonly sampleRate: number;
+    private readonly maxJobs: number;
+    private started = 0;
+
+    constructor(options: RecorderOptions = {}) {
+        this.sampleRate = options.sampleRate ?? 1;
+        this.maxJobs = options.maxJobs ?? 10_000;
+    }
+
+    public get size(): number {
+        return this.jobs.length;
+    }
+
+    public windowCreated(engine: Engine, window: WlValue, mode: number,
+                         html: string, windowOptions: WindowOptions | null): void {
+        if (this.admit()) {
+            this.addJob(engine, window, mode, html, windowOptions);
+        }
+    }
+
+    public streamBegun(engine: Engine, stream: number, windowOptions: WindowOptions | null): void {
+        if (this.admit()) {
+            this.state(engine).streams.set(stream, { chunks: [], decoder: new TextDecoder(), windowOptions });
+        }
+    }
+
+    public streamChunk(engine: Engine, stream: number, chunk: string | Uint8Array): void {
+        const pending = this.engines.get(engine)?.streams.get(stream);
+        if (pending) {
+            pending.chunks.push(typeof chunk === 'string' ? chunk : pending.decoder.decode(chunk, { stream: true }));
+        }
+    }
+
+    public streamEnded(engine: Engine, stream: number, window: WlValue | null, mode: number): void {
+        const state = this.engines.get(engine);
+        const pending = state?.streams.get(stream);
+        if (!pending) {
+            return;
+        }
+        state!.streams.delete(stream);
+        if (window !== null) {
+            this.addJob(engine, window, mode, pending.chunks.join('') + pending.decoder.decode(), pending.windowOptions);
+        }
+    }
+
+    public stepDone(engine: Engine, window: WlValue, step: RecordedStep): void {
+        const state = this.engines.get(engine);
+        const entry = state?.windows.get(window);
+        if (!entry) {
+            return;
+        }
+        entry.job.steps.push(step);
+    }
+
+    // I/O of the engine context or of windows not recorded is dropped.
+    public ioDone(engine: Engine, request: IoRequest, result: any, latencyMs: number): void {
+        const entry = request.window !== null ? this.engines.get(engine)?.windows.get(request.window) : undefined;
+        if (!entry) {
+            return;
+        }
+        entry.job.io.push({
+            kind: request.kind,
+            request: request.request,
+            body: request.body,
+            result,
+            latencyMs,
+        });
+    }
+
+    public windowDestroyed(engine: Engine, window: WlValue): void {
+        const state = this.engines.get(engine);
+        const entry = state?.windows.get(window);
+        if (!entry) {
+            return;
+        }
+        entry.job.durationMs = performance.now() - entry.begin;
+        state!.windows.delete(window);
+    }
+
+    public engineReleased(engine: Engine): void {
+        const state = this.engines.get(engine);
+        if (!state) {
+            return;
+        }
+        for (const window of [...state.windows.keys()]) {
+            this.windowDestroyed(engine, window);
+        }
+        state.streams.clear();
+    }
+
+    public toCorpus(): Corpus {
+        return { version: CORPUS_VERSION, jobs: this.jobs };
+    }
+
+    // Jobs whose window is still open are written with durationMs 0.
+    public save(file: string): void {
+        fs.writeFileSync(file, encodeCorpus(this.toCorpus()));
+    }
+
+    public clear(): void {
+        this.jobs.length = 0;
+        this.started = 0;
+    }
+
+    private admit(): boolean {
+        if (this.started >= this.maxJobs || Math.random() >= this.sampleRate) {
+            return false;
+        }
+        this.started++;
+        return true;
+    }
+
+    private addJob(engine: Engine, window: WlValue, mode: number,
+                   html: string, windowOptions: WindowOptions | null): void {
+        const job: RecordedJob = {
+            mode,
+            html,
+            windowOptions,
+            steps: [],
+            io: [],
+            startedAt: Date.now(),
+            durationMs: 0,
+        };
+        const state = this.state(engine);
+        state.windows.set(window, { job, begin: performance.now() });
+        this.jobs.push(job);
+    }
+
+    private state(engine: Engine): EngineRecording {
+        let state = this.engines.get(engine);
+        if (!state) {
+            state = { windows: new Map(), streams: new Map() };
+            this.engines.set(engine, state);
+        }
+        return state;
+    }
+}
+
+export function encodeCorpus(corpus: Corpus): Buffer {
+    return gzipSync(pack(corpus));
+}
+
+export function decodeCorpus(data: Uint8Array): Corpus {
+    const corpus = unpack(gunzipSync(data)) as Corpus;
+    if (!corpus || corpus.version !== CORPUS_VERSION || !Array.isArray(corpus.jobs)) {
+        throw new Error(`unsupported corpus (version ${corpus?.version})`);
+    }
+    return corpus;
+}
+
+export function loadCorpus(file: string): Corpus {
+    return decodeCorpus(fs.readFileSync(file));
+}
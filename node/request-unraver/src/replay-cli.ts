@@ -0,0 +1,58 @@
+// Offline replay of a recorded corpus (see recorder.ts)
+//
+//   REQUEST_UNRAVER_LICENSE=... pnpm replay <corpus> [wasm file or dist dir]
+//       [--engines N] [--iterations N] [--io-latency recorded|none]
+//
+// Host I/O is answered from the recording, so no network is needed.
+// Prints throughput and job / step latency percentiles.
+import {Runtime} from './runtime';
+import {loadCorpus} from './recorder';
+import {LatencySummary, replayCorpus} from './replay';
+
+function parseArgs(argv: string[]) {
+    const positional: string[] = [];
+    const flags: Record<string, string> = {};
+    for (let i = 0; i < argv.length; i++) {
+        if (argv[i].startsWith('--')) {
+            flags[argv[i].slice(2)] = argv[++i] ?? '';
+        } else {
+            positional.push(argv[i]);
+        }
+    }
+    return { positional, flags };
+}
+
+function formatLatency(name: string, s: LatencySummary): string {
+    const ms = (v: number) => `${v.toFixed(2)}ms`;
+    return `${name.padEnd(6)} n=${s.count} mean=${ms(s.mean)} p50=${ms(s.p50)} p90=${ms(s.p90)} p99=${ms(s.p99)} max=${ms(s.max)}`;
+}
+
+(async () => {
+    const { positional, flags } = parseArgs(process.argv.slice(2));
+    if (!positional[0]) {
+        console.error('usage: replay <corpus> [wasm file or dist dir] [--engines N] [--iterations N] [--io-latency recorded|none]');
+        process.exit(2);
+    }
+    const corpus = loadCorpus(positional[0]);
+    const wasm = positional[1] || '../../cmake-build-release/dist';
+    const license = process.env.REQUEST_UNRAVER_LICENSE || '';
+
+    const runtime = await Runtime.fromFile(wasm, license, undefined, false);
+    const ioLatency = flags['io-latency'] === 'recorded' ? 'recorded' : 'none';
+    const report = await replayCorpus(runtime, corpus, {
+        engines: Number(flags.engines ?? 1),
+        iterations: Number(flags.iterations ?? 1),
+        ioLatency,
+    });
+
+    console.log(`jobs ${report.jobs} (${corpus.jobs.length} recorded), errors ${report.errors}, io misses ${report.ioMisses}`);
+    console.log(`wall ${report.wallMs.toFixed(0)}ms, ${report.jobsPerSecond.toFixed(1)} jobs/s`);
+    console.log(formatLatency('job', report.jobLatency));
+    console.log(formatLatency('step', report.stepLatency));
+    if (report.firstError) {
+        console.log(`first error: ${report.firstError}`);
+    }
+})().catch((e) => {
+    console.error(e);
+    process.exit(1);
+});
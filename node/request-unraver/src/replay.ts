@@ -0,0 +1,201 @@
+import {pack} from 'msgpackr';
+import type {WlValue} from 'walink';
+import type {Engine, IoHandler, IoRequest} from './engine';
+import type {Runtime} from './runtime';
+import type {Corpus, RecordedIo, RecordedJob, RecordedStep} from './recorder';
+
+export interface ReplayOptions {
+    // Concurrent workers, one engine per worker and mode.
+    engines?: number;
+    // Passes over the corpus.
+    iterations?: number;
+    // Wait the recorded latency before answering host I/O (default: answer at once).
+    ioLatency?: 'recorded' | 'none';
+    // Called after each job, e.g. for progress output.
+    onJob?: (job: RecordedJob, latencyMs: number, error: unknown) => void;
+}
+
+export interface LatencySummary {
+    count: number;
+    mean: number;
+    p50: number;
+    p90: number;
+    p99: number;
+    max: number;
+}
+
+export interface ReplayReport {
+    jobs: number;
+    errors: number;
+    // host I/O requests with no recorded response
+    ioMisses: number;
+    wallMs: number;
+    jobsPerSecond: number;
+    // window creation to destroy, including host I/O waits
+    jobLatency: LatencySummary;
+    // per recorded step (browserEval, browserEvalBatch, useJquery)
+    stepLatency: LatencySummary;
+    firstError?: string;
+}
+
+export function summarize(samples: number[]): LatencySummary {
+    if (!samples.length) {
+        return { count: 0, mean: 0, p50: 0, p90: 0, p99: 0, max: 0 };
+    }
+    const sorted = [...samples].sort((a, b) => a - b);
+    const at = (q: number) => sorted[Math.min(sorted.length - 1, Math.ceil(q * sorted.length) - 1)];
+    return {
+        count: sorted.length,
+        mean: sorted.reduce((a, b) => a + b, 0) / sorted.length,
+        p50: at(0.5),
+        p90: at(0.9),
+        p99: at(0.99),
+        max: sorted[sorted.length - 1],
+    };
+}
+
+function ioKey(kind: string, request: string, body?: unknown): string {
+    const suffix = body === undefined ? '' : Buffer.from(pack(body ?? null)).toString('base64');
+    return `${kind}\0${request}\0${suffix}`;
+}
+
+// Answers host I/O from a job's recording. Requests are matched on kind,
+// request and body, then on kind and request alone; repeated requests get the
+// recorded responses in order and the last one once those run out.
+export class MockIo {
+    private readonly exact = new Map<string, RecordedIo[]>();
+    private readonly loose = new Map<string, RecordedIo[]>();
+    private readonly used = new Map<RecordedIo[], number>();
+    public misses = 0;
+
+    constructor(records: RecordedIo[], private readonly latency: 'recorded' | 'none' = 'none') {
+        for (const io of records) {
+            push(this.exact, ioKey(io.kind, io.request, io.body), io);
+            push(this.loose, ioKey(io.kind, io.request), io);
+        }
+    }
+
+    public readonly handler: IoHandler = async (request: IoRequest) => {
+        const io = this.take(this.exact.get(ioKey(request.kind, request.request, request.body)))
+            ?? this.take(this.loose.get(ioKey(request.kind, request.request)));
+        if (!io) {
+            this.misses++;
+            throw new Error(`no recorded ${request.kind} response for ${request.request}`);
+        }
+        if (this.latency === 'recorded' && io.latencyMs > 0) {
+            await new Promise((resolve) => setTimeout(resolve, io.latencyMs));
+        }
+        return io.result;
+    };
+
+    private take(list: RecordedIo[] | undefined): RecordedIo | undefined {
+        if (!list) {
+            return undefined;
+        }
+        const index = this.used.get(list) ?? 0;
+        this.used.set(list, index + 1);
+        return list[Math.min(index, list.length - 1)];
+    }
+}
+
+function push<K, V>(map: Map<K, V[]>, key: K, value: V): void {
+    const list = map.get(key);
+    if (list) {
+        list.push(value);
+    } else {
+        map.set(key, [value]);
+    }
+}
+
+function runStep(engine: Engine, window: WlValue, step: RecordedStep): void {
+    switch (step.kind) {
+        case 'eval':
+            engine.browserEval(window, step.code, step.params, { cache: false });
+            break;
+        case 'batch':
+            engine.browserEvalBatch(window, step.code, step.paramsList);
+            break;
+        case 'jquery':
+            engine.useJquery(window);
+            break;
+    }
+}
+
+// Drive engines against a recorded corpus with mocked host I/O. Needs no
+// network; only the wasm binary and the corpus file.
+export async function replayCorpus(runtime: Runtime, corpus: Corpus, options: ReplayOptions = {}): Promise<ReplayReport> {
+    const workers = Math.max(1, options.engines ?? 1);
+    const iterations = Math.max(1, options.iterations ?? 1);
+    const latency = options.ioLatency ?? 'none';
+
+    const queue: RecordedJob[] = [];
+    for (let i = 0; i < iterations; i++) {
+        queue.push(...corpus.jobs);
+    }
+
+    const jobLatencies: number[] = [];
+    const stepLatencies: number[] = [];
+    let errors = 0;
+    let ioMisses = 0;
+    let firstError: string | undefined;
+    let next = 0;
+
+    const worker = async () => {
+        const engines = new Map<number, Engine>();
+        try {
+            while (next < queue.length) {
+                const job = queue[next++];
+                let engine = engines.get(job.mode);
+                if (!engine) {
+                    engine = await runtime.newEngine(job.mode);
+                    engines.set(job.mode, engine);
+                }
+                const mock = new MockIo(job.io, latency);
+                engine.setIoHandler(mock.handler);
+
+                const begin = performance.now();
+                let error: unknown = null;
+                try {
+                    const window = engine.createWindow(job.html, job.windowOptions);
+                    try {
+                        for (const step of job.steps) {
+                            const stepBegin = performance.now();
+                            runStep(engine, window, step);
+                            await engine.runUntilIdle();
+                            stepLatencies.push(performance.now() - stepBegin);
+                        }
+                    } finally {
+                        engine.destroyWindow(window);
+                    }
+                } catch (e) {
+                    error = e;
+                    errors++;
+                    firstError ??= String((e as any)?.message ?? e);
+                }
+                const elapsed = performance.now() - begin;
+                jobLatencies.push(elapsed);
+                ioMisses += mock.misses;
+                options.onJob?.(job, elapsed, error);
+            }
+        } finally {
+            for (const engine of engines.values()) {
+                await engine.cleanup();
+            }
+        }
+    };
+
+    const start = performance.now();
+    await Promise.all(Array.from({ length: workers }, worker));
+    const wallMs = performance.now() - start;
+
+    return {
+        jobs: queue.length,
+        errors,
+        ioMisses,
+        wallMs,
+        jobsPerSecond: wallMs > 0 ? queue.length / (wallMs / 1000) : 0,
+        jobLatency: summarize(jobLatencies),
+        stepLatency: summarize(stepLatencies),
+        firstError,
+    };
+}
@@ -0,0 +1,140 @@
+import { createHash } from 'crypto';
+import { pack, unpack } from 'msgpackr';
+
+export interface ResultCacheOptions {
+    // LRU bounds; the least recently used entries are evicted first.
+    maxEntries?: number;
+    // Sum of the packed result sizes.
+    maxBytes?: number;
+    // Default time to live of an entry (ms). 0 keeps entries until evicted.
+    ttl?: number;
+}
+
+export interface ResultCacheStats {
+    hits: number;
+    misses: number;
+    // Evaluations whose result was not stored because the script used the
+    // clock, random numbers or host I/O, or called __sys.markUncacheable().
+    uncacheable: number;
+    // hits / (hits + misses), 0 before the first lookup.
+    hitRate: number;
+    evictions: number;
+    entries: number;
+    bytes: number;
+}
+
+interface CacheEntry {
+    // Stored packed so callers never share (and mutate) a cached object.
+    packed: Uint8Array;
+    expiresAt: number;
+}
+
+const DEFAULT_OPTIONS: Required<ResultCacheOptions> = {
+    maxEntries: 4096,
+    maxBytes: 64 * 1024 * 1024,
+    ttl: 0,
+};
+
+// Content-addressed cache for deterministic browserEval results.
+//
+// The key covers the engine mode, the window content and options, every step
+// run on the window before (code, params and result of each browserEval,
+// useJquery and browserEvalBatch), the script source and the params, so a hit
+// means the same script would have run on a window in the same state. Only
+// evaluations the caller marks pure are cached, since a hit skips the script
+// and with it any change it would have made to the window.
+// One cache can be shared by every engine of a Runtime.
+export class ResultCache {
+    private readonly options: Required<ResultCacheOptions>;
+    // Map keeps insertion order, which is used as the LRU order.
+    private readonly entries = new Map<string, CacheEntry>();
+    private bytes = 0;
+    private hits = 0;
+    private misses = 0;
+    private uncacheable = 0;
+    private evictions = 0;
+
+    constructor(options?: ResultCacheOptions) {
+        this.options = { ...DEFAULT_OPTIONS, ...options };
+    }
+
+    public static key(...parts: (string | number | Uint8Array)[]): string {
+        const hash = createHash('sha256');
+        for (const part of parts) {
+            const data = typeof part === 'number' ? String(part) : part;
+            // length prefix so that part boundaries are part of the key
+            const length = typeof data === 'string' ? Buffer.byteLength(data) : data.length;
+            hash.update(`${length}:`);
+            hash.update(data);
+        }
+        return hash.digest('hex');
+    }
+
+    // Returns undefined on a miss (a cached `undefined` result is stored as null).
+    public get(key: string): { value: any } | undefined {
+        const entry = this.entries.get(key);
+        if (!entry) {
+            this.misses++;
+            return undefined;
+        }
+        if (entry.expiresAt && entry.expiresAt <= Date.now()) {
+            this.delete(key, entry);
+            this.misses++;
+            return undefined;
+        }
+        // move to the most recently used end
+        this.entries.delete(key);
+        this.entries.set(key, entry);
+        this.hits++;
+        return { value: unpack(entry.packed) };
+    }
+
+    public set(key: string, value: any, ttl: number = this.options.ttl): void {
+        const packed = pack(value ?? null);
+        if (packed.length > this.options.maxBytes) {
+            return;
+        }
+        const previous = this.entries.get(key);
+        if (previous) {
+            this.delete(key, previous);
+        }
+        this.entries.set(key, {
+            packed,
+            expiresAt: ttl > 0 ? Date.now() + ttl : 0,
+        });
+        this.bytes += packed.length;
+
+        while (this.entries.size > this.options.maxEntries || this.bytes > this.options.maxBytes) {
+            const [oldestKey, oldest] = this.entries.entries().next().value as [string, CacheEntry];
+            this.delete(oldestKey, oldest);
+            this.evictions++;
+        }
+    }
+
+    // Called by Engine when an evaluation could not be stored.
+    public markUncacheable(): void {
+        this.uncacheable++;
+    }
+
+    public clear(): void {
+        this.entries.clear();
+        this.bytes = 0;
+    }
+
+    public stats(): ResultCacheStats {
+        return {
+            hits: this.hits,
+            misses: this.misses,
+            uncacheable: this.uncacheable,
+            hitRate: this.hits + this.misses > 0 ? this.hits / (this.hits + this.misses) : 0,
+            evictions: this.evictions,
+            entries: this.entries.size,
+            bytes: this.bytes,
+        };
+    }
+
+    private delete(key: string, entry: CacheEntry): void {
+        this.entries.delete(key);
+        this.bytes -= entry.packed.length;
+    }
+}
@@ -0,0 +1,221 @@
+import {
+    type WlValue,
+    Walink,
+    createWalinkFromInstance,
+} from 'walink';
+import { GcMode, requireExport, type WindowOptions } from './engine';
+
+// One unit of work for a pool worker: the window is created, the script is
+// run against it, and the window is closed again on the same thread. A script
+// may return a promise; it must settle within the job's own event loop turns
+// (microtasks and 0ms timers). Async host I/O is not available on workers and
+// rejects.
+export interface PoolJob {
+    content?: string;
+    options?: WindowOptions;
+    jquery?: boolean;
+    script: string;
+    params?: any;
+}
+
+interface PoolDrainItem {
+    id: number;
+    value?: any;
+    error?: string;
+}
+
+interface PendingJob {
+    resolve: (value: any) => void;
+    reject: (reason: Error) => void;
+}
+
+// Must match -sPTHREAD_POOL_SIZE in CMakeLists.txt.
+export function pthreadPoolSize(): number {
+    return globalThis.navigator?.hardwareConcurrency || 4;
+}
+
+// Loader for request-unraver-wasm-mt (emscripten pthread build).
+//
+// The emscripten glue owns the worker threads and the shared memory, so this
+// loader goes through the generated `createQuickJSModule` factory instead of
+// EmscriptenRuntime. Host imports come from src/wasm_imports.js.
+export class RuntimeMt {
+    protected readonly walink: Walink;
+
+    static async fromFile(name: string, license: string): Promise<RuntimeMt> {
+        const path = await import('path');
+        const glue = await import(path.resolve(name));
+        const factory = glue.default ?? glue;
+        const module = await factory({
+            locateFile: (file: string) => path.join(path.dirname(path.resolve(name)), file),
+        });
+        const runtime = new RuntimeMt(module);
+        runtime.init(license);
+        return runtime;
+    }
+
+    constructor(
+        protected readonly module: any,
+    ) {
+        // shared memory 는 import 되므로 exports 에 memory 가 없다
+        this.walink = createWalinkFromInstance({
+            exports: {
+                ...module.wasmExports,
+                memory: module.wasmMemory,
+            },
+        } as unknown as WebAssembly.Instance);
+    }
+
+    private init(licenseBase64: string): void {
+        const fn = requireExport(this.module.wasmExports, 'runtime_init');
+        this.walink.decode(fn(this.walink.toWlString(licenseBase64)));
+    }
+
+    // Start `threads` workers, each with its own engine in `mode`.
+    // Workers come from the pre-spawned emscripten pthread pool, and pool
+    // startup blocks the calling thread until they are up, so a count above
+    // PTHREAD_POOL_SIZE would never start. Reject it instead of hanging.
+    newPool(mode: number, threads?: number): EnginePool {
+        const limit = pthreadPoolSize();
+        const count = threads ?? limit;
+        if (!Number.isInteger(count) || count < 1 || count > limit) {
+            throw new RangeError(`threads must be an integer in [1, ${limit}] (got ${count})`);
+        }
+        return new EnginePool(this.module, this.walink, mode, count);
+    }
+}
+
+export class EnginePool {
+    protected readonly fns: {
+        poolNew: (...args: any[]) => any;
+        poolCleanup: (...args: any[]) => any;
+        poolSubmit: (...args: any[]) => any;
+        poolDrain: (...args: any[]) => any;
+        poolSetGc: (...args: any[]) => any;
+        poolCompletionCounter: (...args: any[]) => any;
+    };
+    protected poolHandle: WlValue | null;
+    protected readonly pending = new Map<number, PendingJob>();
+    protected counterIndex: number;
+    protected lastCounter = 0;
+    protected pumping = false;
+
+    constructor(
+        protected readonly module: any,
+        protected readonly walink: Walink,
+        mode: number,
+        threads: number,
+    ) {
+        const exports = module.wasmExports;
+        this.fns = {
+            poolNew: requireExport(exports, 'pool_new'),
+            poolCleanup: requireExport(exports, 'pool_cleanup'),
+            poolSubmit: requireExport(exports, 'pool_submit'),
+            poolDrain: requireExport(exports, 'pool_drain'),
+            poolSetGc: requireExport(exports, 'pool_set_gc'),
+            poolCompletionCounter: requireExport(exports, 'pool_completion_counter'),
+        };
+
+        const v = this.fns.poolNew(this.walink.toWlUint32(mode), this.walink.toWlUint32(threads));
+        this.walink.decode(v);
+        this.poolHandle = v as bigint;
+        this.counterIndex = (this.fns.poolCompletionCounter(this.poolHandle) >>> 0) >> 2;
+    }
+
+    public get size(): number {
+        return this.pending.size;
+    }
+
+    // Queue a job. Rejects immediately when the pool queue is full.
+    public submit(job: PoolJob): Promise<any> {
+        if (!this.poolHandle) {
+            return Promise.reject(new Error('pool closed'));
+        }
+        const id = this.walink.decode(
+            this.fns.poolSubmit(this.poolHandle, this.walink.toWlMsgpack(job)),
+        ) as number;
+        if (!id) {
+            return Promise.reject(new Error('pool queue full'));
+        }
+        const promise = new Promise<any>((resolve, reject) => {
+            this.pending.set(id, {resolve, reject});
+        });
+        this.pump();
+        return promise;
+    }
+
+    // Collect garbage on a worker's engine whenever its queue runs dry, so
+    // pauses land between jobs; `idle` null turns that off. While a job runs,
+    // automatic collection is held off until the heap grows `headroomBytes`
+    // past its size at the start of the job (0 keeps QuickJS's own threshold).
+    public setGc(idle: GcMode | null, headroomBytes = 0): void {
+        if (!this.poolHandle) throw new Error('pool closed');
+        this.walink.fromWlBool(this.fns.poolSetGc(
+            this.poolHandle,
+            this.walink.toWlUint32(idle ?? 0xffffffff),
+            this.walink.toWlUint32(headroomBytes),
+        ));
+    }
+
+    // Waits for in-flight jobs, then stops the workers.
+    public async close(): Promise<void> {
+        while (this.pending.size) {
+            await this.waitCompletion();
+            this.drain();
+        }
+        if (this.poolHandle) {
+            this.walink.fromWlBool(this.fns.poolCleanup(this.poolHandle));
+            this.poolHandle = null;
+        }
+    }
+
+    protected drain(): void {
+        if (!this.poolHandle) return;
+        const items = this.walink.decode(this.fns.poolDrain(this.poolHandle)) as PoolDrainItem[];
+        for (const item of items) {
+            const job = this.pending.get(item.id);
+            if (!job) continue;
+            this.pending.delete(item.id);
+            if (item.error !== undefined) {
+                job.reject(new Error(item.error));
+            } else {
+                job.resolve(item.value);
+            }
+        }
+    }
+
+    // worker 가 결과를 push 하면 completion counter 가 증가하고 notify 된다
+    protected async waitCompletion(): Promise<void> {
+        const heap: Int32Array = this.module.HEAP32;
+        const current = Atomics.load(heap, this.counterIndex);
+        if (current !== this.lastCounter) {
+            this.lastCounter = current;
+            return;
+        }
+        const waitAsync = (Atomics as any).waitAsync;
+        if (typeof waitAsync === 'function') {
+            const res = waitAsync(heap, this.counterIndex, current, 100);
+            if (res.async) {
+                await res.value;
+            }
+        } else {
+            await new Promise((resolve) => setTimeout(resolve, 1));
+        }
+        this.lastCounter = Atomics.load(heap, this.counterIndex);
+    }
+
+    protected pump(): void {
+        if (this.pumping) return;
+        this.pumping = true;
+        (async () => {
+            try {
+                while (this.pending.size && this.poolHandle) {
+                    await this.waitCompletion();
+                    this.drain();
+                }
+            } finally {
+                this.pumping = false;
+            }
+        })();
+    }
+}
@@ -1,53 +1,256 @@
 import {EmscriptenRuntime} from './emscripten';
-import { Engine } from './engine';
+import { Engine, requireExport } from './engine';
 import {
     Walink,
     createWalinkFromInstance
 } from 'walink';
 
-export class Runtime {
-    protected readonly walink!: Walink;
+// runtime_heap_stats (bytes)
+export interface HeapStats {
+    // WASM linear memory. never shrinks, so this is also the high-water mark
+    memorySize: number;
+    // malloc: obtained from sbrk / in use / free chunks
+    reserved: number;
+    used: number;
+    free: number;
+    // free space at the top of the heap
+    releasable: number;
+    peakUsed: number;
+    // Freed blocks kept for reuse by every engine allocator, per size class.
+    // Chunks return to malloc only once all of their blocks are free.
+    allocatorFreeLists: { size: number; retained: number }[];
+}
 
-    static async fromFile(name: string, license: string, customInit?: (emscriptenRuntime: EmscriptenRuntime) => Promise<void>): Promise<Runtime> {
-        const fs = await import('fs');
-        const wasmBinary = await fs.promises.readFile(name);
+// When the active instance crosses a threshold, new engines go to a fresh
+// instance and the old one is dropped once its last engine is cleaned up.
+export interface RecyclePolicy {
+    // memorySize limit
+    maxMemorySize?: number;
+    // (free - releasable) / reserved limit
+    maxFragmentation?: number;
+    // fragmentation is only considered above this reserved size
+    minReservedForFragmentation?: number;
+    // heap stats are read every N newEngine() calls
+    checkInterval?: number;
+}
 
-        const emscriptenRuntime = new EmscriptenRuntime();
-        emscriptenRuntime.logWriter = (msg) => console.log(msg);
+const DEFAULT_RECYCLE_POLICY: Required<RecyclePolicy> = {
+    maxMemorySize: 512 * 1024 * 1024,
+    maxFragmentation: 0.5,
+    minReservedForFragmentation: 64 * 1024 * 1024,
+    checkInterval: 16,
+};
 
-        Object.assign(emscriptenRuntime.wasmImports, {
-            '_ru_get_now': performance.now.bind(performance),
-            '_ru_get_random': function (ptr: number, size: number) {
-                const view = new Uint8Array(emscriptenRuntime.wasmMemory.buffer, ptr, size);
-                crypto.getRandomValues(view);
-            },
-        })
+type InstanceLoader = () => Promise<RuntimeInstance>;
 
-        if (customInit) {
-            await customInit(emscriptenRuntime);
-        }
+// CMake REQUEST_UNRAVER_WASM_FLAVOR (dist/request-unraver-wasm[-<flavor>].wasm)
+export type WasmFlavor = 'simd' | 'release' | 'debug';
+
+export const WASM_FLAVOR_FILES: Record<WasmFlavor, string> = {
+    simd: 'request-unraver-wasm-simd.wasm',
+    release: 'request-unraver-wasm.wasm',
+    debug: 'request-unraver-wasm-debug.wasm',
+};
 
-        await emscriptenRuntime.instantiate(wasmBinary);
-        const runtime = new Runtime(emscriptenRuntime);
-        await runtime.init(license);
-        return runtime;
+// (module (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt))
+const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+// Flavors this host can run, best first. debug is only picked explicitly.
+export function supportedWasmFlavors(): WasmFlavor[] {
+    const flavors: WasmFlavor[] = [];
+    if (WebAssembly.validate(SIMD_PROBE)) {
+        flavors.push('simd');
     }
+    flavors.push('release');
+    return flavors;
+}
+
+async function resolveWasmFile(name: string, flavor?: WasmFlavor): Promise<string> {
+    const fs = await import('fs');
+    const path = await import('path');
+    const stat = await fs.promises.stat(name);
+    if (!stat.isDirectory()) {
+        return name;
+    }
+    const candidates = flavor ? [flavor] : supportedWasmFlavors();
+    for (const candidate of candidates) {
+        const file = path.join(name, WASM_FLAVOR_FILES[candidate]);
+        if (fs.existsSync(file)) {
+            return file;
+        }
+    }
+    throw new Error(`no request-unraver wasm (${candidates.join(', ')}) in ${name}`);
+}
+
+// WASM instance 하나와 그 위의 engine 들
+class RuntimeInstance {
+    readonly walink: Walink;
+    // engine_new 의 WL_VALUE -> Engine (호스트 I/O 콜백 라우팅용)
+    readonly engines = new Map<bigint, Engine>();
+    retiring = false;
+
+    private readonly heapStatsFn: (...args: any[]) => any;
 
     constructor(
-        private readonly emscriptenRuntime: EmscriptenRuntime,
+        readonly emscriptenRuntime: EmscriptenRuntime,
     ) {
         // Build walink helper bound to instantiated WASM instance
         this.walink = createWalinkFromInstance(emscriptenRuntime.instance);
+        this.heapStatsFn = requireExport(emscriptenRuntime.exports, 'runtime_heap_stats');
     }
 
-    private async init(licenseBase64: string): Promise<void> {
+    init(licenseBase64: string): void {
         const v = (this.emscriptenRuntime.exports['runtime_init'] as any)(this.walink.toWlString(licenseBase64));
         this.walink.decode(v);
     }
 
+    heapStats(): HeapStats {
+        return this.walink.decode(this.heapStatsFn()) as HeapStats;
+    }
+
+    dispatchIo(engineHandle: bigint, window: bigint, ioId: number, request: Uint8Array): void {
+        const eng = this.engines.get(engineHandle);
+        if (!eng) {
+            // wasm 호출 스택 안이므로 throw 하지 않는다
+            console.warn(`io request from unknown engine: ${engineHandle}`);
+            return;
+        }
+        eng.dispatchIo(ioId, request, window);
+    }
+}
+
+export class Runtime {
+    private readonly recyclePolicy: Required<RecyclePolicy> | null;
+    // 교체되었지만 아직 engine 이 남은 instance
+    private readonly retired = new Set<RuntimeInstance>();
+    private replacing: Promise<void> | null = null;
+    private engineCount = 0;
+
+    // name: a .wasm file, or a dist directory in which case the best flavor
+    // the host supports is used (or `flavor` when given).
+    static async fromFile(name: string, license: string, customInit?: (emscriptenRuntime: EmscriptenRuntime) => Promise<void>, recyclePolicy?: RecyclePolicy | false, flavor?: WasmFlavor): Promise<Runtime> {
+        const fs = await import('fs');
+        const wasmBinary = await fs.promises.readFile(await resolveWasmFile(name, flavor));
+
+        const loader: InstanceLoader = async () => {
+            const emscriptenRuntime = new EmscriptenRuntime();
+            emscriptenRuntime.logWriter = (msg) => console.log(msg);
+
+            let instance: RuntimeInstance | null = null;
+
+            Object.assign(emscriptenRuntime.wasmImports, {
+                '_ru_get_now': performance.now.bind(performance),
+                '_ru_get_random': function (ptr: number, size: number) {
+                    const view = new Uint8Array(emscriptenRuntime.wasmMemory.buffer, ptr, size);
+                    crypto.getRandomValues(view);
+                },
+                '_ru_io_submit': function (engine: bigint, window: bigint, ioId: number, ptr: number, size: number) {
+                    // 메모리는 이후 호출에서 재사용될 수 있으므로 즉시 복사
+                    const request = emscriptenRuntime.HEAPU8.slice(ptr, ptr + size);
+                    instance?.dispatchIo(engine, window, ioId, request);
+                },
+            })
+
+            if (customInit) {
+                await customInit(emscriptenRuntime);
+            }
+
+            await emscriptenRuntime.instantiate(wasmBinary);
+            instance = new RuntimeInstance(emscriptenRuntime);
+            instance.init(license);
+            return instance;
+        };
+
+        return new Runtime(await loader(), loader, recyclePolicy);
+    }
+
+    constructor(
+        private active: RuntimeInstance,
+        private readonly loader: InstanceLoader,
+        recyclePolicy?: RecyclePolicy | false,
+    ) {
+        this.recyclePolicy = recyclePolicy === false
+            ? null
+            : { ...DEFAULT_RECYCLE_POLICY, ...recyclePolicy };
+    }
+
+    protected get walink(): Walink {
+        return this.active.walink;
+    }
+
     async newEngine(mode: number): Promise<Engine> {
-        const eng = new Engine(this.emscriptenRuntime);
+        await this.maybeRecycle();
+
+        const instance = this.active;
+        const eng = new Engine(instance.emscriptenRuntime, (handle) => this.onEngineCleanup(instance, handle));
         await eng.init(mode);
+        instance.engines.set(eng.handle!, eng);
         return eng;
     }
-}
\ No newline at end of file
+
+    // heap stats of the instance new engines are created on
+    heapStats(): HeapStats {
+        return this.active.heapStats();
+    }
+
+    // number of replaced instances still waiting for their engines to finish
+    get retiredInstances(): number {
+        return this.retired.size;
+    }
+
+    // Replace the active instance now, regardless of the policy.
+    async recycle(): Promise<void> {
+        if (!this.replacing) {
+            this.replacing = this.replaceActive().finally(() => {
+                this.replacing = null;
+            });
+        }
+        await this.replacing;
+    }
+
+    private async maybeRecycle(): Promise<void> {
+        if (this.replacing) {
+            await this.replacing;
+            return;
+        }
+        const policy = this.recyclePolicy;
+        if (!policy || ++this.engineCount % policy.checkInterval !== 0) {
+            return;
+        }
+        if (this.shouldRecycle(this.active.heapStats(), policy)) {
+            await this.recycle();
+        }
+    }
+
+    private shouldRecycle(stats: HeapStats, policy: Required<RecyclePolicy>): boolean {
+        if (stats.memorySize > policy.maxMemorySize) {
+            return true;
+        }
+        if (stats.reserved < policy.minReservedForFragmentation) {
+            return false;
+        }
+        return (stats.free - stats.releasable) / stats.reserved > policy.maxFragmentation;
+    }
+
+    private async replaceActive(): Promise<void> {
+        const next = await this.loader();
+        const previous = this.active;
+        this.active = next;
+
+        // engine 의 JS 상태는 다른 instance 로 옮길 수 없으므로 모두 끝날 때까지 유지
+        previous.retiring = true;
+        if (previous.engines.size) {
+            this.retired.add(previous);
+        }
+    }
+
+    private onEngineCleanup(instance: RuntimeInstance, handle: bigint): void {
+        instance.engines.delete(handle);
+        if (instance.retiring && !instance.engines.size) {
+            // 마지막 참조를 놓으면 WASM memory 는 GC 가 회수한다
+            this.retired.delete(instance);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+// Chrome trace-event format (chrome://tracing, Perfetto).
+// Every span is a complete ('X') event: pid is the engine, tid the request id.
+export interface TraceEvent {
+    name: string;
+    cat: string;
+    ph: 'X';
+    // microseconds, performance.now() origin (the engine's ru_get_now clock)
+    ts: number;
+    dur: number;
+    pid: number;
+    tid: number;
+    args?: Record<string, unknown>;
+}
+
+// engine_trace_drain (src/tracer.h)
+export interface EngineTraceBatch {
+    dropped: number;
+    events: { cat: string; name: string; ts: number; dur: number; tid: number }[];
+}
+
+// Collects spans from the TS Engine, the native engine and guest __sys.trace()
+// calls. Attach with Engine.setTracer(); engines without a tracer skip all of it.
+export class Tracer {
+    private readonly events: TraceEvent[] = [];
+    private dropped = 0;
+
+    constructor(private readonly maxEvents: number = 1_000_000) {
+    }
+
+    public span<T>(pid: number, tid: number, cat: string, name: string, fn: () => T): T {
+        const begin = performance.now();
+        try {
+            return fn();
+        } finally {
+            this.add(pid, tid, cat, name, begin, performance.now());
+        }
+    }
+
+    public async spanAsync<T>(pid: number, tid: number, cat: string, name: string, fn: () => Promise<T>): Promise<T> {
+        const begin = performance.now();
+        try {
+            return await fn();
+        } finally {
+            this.add(pid, tid, cat, name, begin, performance.now());
+        }
+    }
+
+    public addEngineEvents(pid: number, batch: EngineTraceBatch): void {
+        this.dropped += batch.dropped;
+        for (const event of batch.events) {
+            this.push({ name: event.name, cat: event.cat, ph: 'X', ts: event.ts, dur: event.dur, pid, tid: event.tid });
+        }
+    }
+
+    public clear(): void {
+        this.events.length = 0;
+        this.dropped = 0;
+    }
+
+    // JSON.stringify(tracer) gives a file chrome://tracing can open.
+    public toJSON(): { traceEvents: TraceEvent[]; displayTimeUnit: 'ms'; otherData: { dropped: number } } {
+        return {
+            traceEvents: this.events,
+            displayTimeUnit: 'ms',
+            otherData: { dropped: this.dropped },
+        };
+    }
+
+    private add(pid: number, tid: number, cat: string, name: string, beginMs: number, endMs: number): void {
+        this.push({ name, cat, ph: 'X', ts: beginMs * 1000, dur: (endMs - beginMs) * 1000, pid, tid });
+    }
+
+    private push(event: TraceEvent): void {
+        if (this.events.length >= this.maxEvents) {
+            this.dropped++;
+            return;
+        }
+        this.events.push(event);
+    }
+}
@@ -0,0 +1,29 @@
+// Shared UTF-8 codecs.
+// TextEncoder/TextDecoder construction is not free, so create them once.
+export const utf8Encoder = new TextEncoder();
+export const utf8Decoder = new TextDecoder('utf-8');
+
+// Number of bytes `str` occupies when encoded as UTF-8, without encoding it.
+export function utf8Length(str: string): number {
+    let len = 0;
+    for (let i = 0; i < str.length; i++) {
+        const c = str.charCodeAt(i);
+        if (c < 0x80) {
+            len += 1;
+        } else if (c < 0x800) {
+            len += 2;
+        } else if (c >= 0xd800 && c <= 0xdbff && i + 1 < str.length) {
+            const next = str.charCodeAt(i + 1);
+            if (next >= 0xdc00 && next <= 0xdfff) {
+                // surrogate pair -> 4 bytes
+                len += 4;
+                i++;
+            } else {
+                len += 3;
+            }
+        } else {
+            len += 3;
+        }
+    }
+    return len;
+}
@@ -0,0 +1,431 @@
+#include "crypto_stream.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include <psa/crypto.h>
+
+#include "crypto_subtle.h"
+#include "js_bytes.h"
+
+namespace request_unraver {
+
+namespace {
+
+enum StreamKind {
+  kStreamHash = 0,
+  kStreamHmac,
+  kStreamCipher,
+};
+
+struct CryptoStream {
+  StreamKind kind;
+  bool finished = false;
+  psa_hash_operation_t hash = PSA_HASH_OPERATION_INIT;
+  psa_mac_operation_t mac = PSA_MAC_OPERATION_INIT;
+  psa_cipher_operation_t cipher = PSA_CIPHER_OPERATION_INIT;
+  psa_key_id_t key = 0;
+};
+
+JSClassID crypto_stream_class_id = 0;
+std::once_flag crypto_stream_class_once;
+
+// operation 을 끝내고 key slot 을 돌려준다. final() 은 성공/실패와 관계없이 바로 호출해
+// GC 전까지 slot 을 잡고 있지 않게 한다
+void ReleaseStream(CryptoStream* stream) {
+  psa_hash_abort(&stream->hash);
+  psa_mac_abort(&stream->mac);
+  psa_cipher_abort(&stream->cipher);
+  if (stream->key) {
+    std::lock_guard<std::mutex> lock(PsaKeyMutex());
+    psa_destroy_key(stream->key);
+    stream->key = 0;
+  }
+}
+
+void FreeCryptoStream(CryptoStream* stream) {
+  ReleaseStream(stream);
+  delete stream;
+}
+
+void CryptoStreamFinalizer(JSRuntime* rt, JSValue val) {
+  CryptoStream* stream = static_cast<CryptoStream*>(JS_GetOpaque(val, crypto_stream_class_id));
+  if (stream) {
+    FreeCryptoStream(stream);
+  }
+}
+
+const JSClassDef kCryptoStreamClass = {
+  "NativeCryptoStream",
+  CryptoStreamFinalizer,
+};
+
+// node 의 hash 이름 (대소문자 무시)
+psa_algorithm_t HashAlgorithm(const char* name) {
+  std::string lower(name);
+  for (char& c : lower) {
+    if (c >= 'A' && c <= 'Z') {
+      c = (char)(c - 'A' + 'a');
+    }
+  }
+  if (lower == "md5") return PSA_ALG_MD5;
+  if (lower == "sha1") return PSA_ALG_SHA_1;
+  if (lower == "sha224") return PSA_ALG_SHA_224;
+  if (lower == "sha256") return PSA_ALG_SHA_256;
+  if (lower == "sha384") return PSA_ALG_SHA_384;
+  if (lower == "sha512") return PSA_ALG_SHA_512;
+  return PSA_ALG_NONE;
+}
+
+void FreeOutputBuffer(JSRuntime* rt, void* opaque, void* ptr) {
+  js_free_rt(rt, ptr);
+}
+
+// cipher 출력 (len 바이트만 노출, 할당은 cap)
+JSValue NewOutput(JSContext* ctx, uint8_t* buf, size_t len) {
+  return JS_NewUint8Array(ctx, buf, len, FreeOutputBuffer, nullptr, false);
+}
+
+JSValue NewStreamObject(JSContext* ctx, CryptoStream* stream) {
+  JSValue obj = JS_NewObjectClass(ctx, crypto_stream_class_id);
+  if (JS_IsException(obj)) {
+    FreeCryptoStream(stream);
+    return obj;
+  }
+  JS_SetOpaque(obj, stream);
+  return obj;
+}
+
+psa_key_id_t ImportKey(psa_key_type_t type, psa_algorithm_t alg, psa_key_usage_t usage,
+                       const uint8_t* data, size_t len, psa_status_t* status) {
+  psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
+  psa_set_key_type(&attributes, type);
+  psa_set_key_algorithm(&attributes, alg);
+  psa_set_key_usage_flags(&attributes, usage);
+  psa_key_id_t key = 0;
+  *status = psa_import_key(&attributes, data, len, &key);
+  psa_reset_key_attributes(&attributes);
+  return *status == PSA_SUCCESS ? key : 0;
+}
+
+JSValue ThrowStatus(JSContext* ctx, const char* what, psa_status_t status) {
+  return JS_ThrowInternalError(ctx, "%s failed (psa status %d)", what, (int) status);
+}
+
+//
+// crypto_createHash(name)
+//
+JSValue JsCreateHash(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  const char* name = argc > 0 ? JS_ToCString(ctx, argv[0]) : nullptr;
+  if (!name) {
+    return JS_EXCEPTION;
+  }
+  psa_algorithm_t alg = HashAlgorithm(name);
+  JS_FreeCString(ctx, name);
+  if (alg == PSA_ALG_NONE) {
+    return JS_UNDEFINED;
+  }
+
+  CryptoStream* stream = new CryptoStream();
+  stream->kind = kStreamHash;
+  if (psa_hash_setup(&stream->hash, alg) != PSA_SUCCESS) {
+    // mbedtls 설정에서 빠진 알고리즘 (예: MD5) 은 JS 구현 사용
+    FreeCryptoStream(stream);
+    return JS_UNDEFINED;
+  }
+  return NewStreamObject(ctx, stream);
+}
+
+//
+// crypto_createHmac(name, key)
+//
+JSValue JsCreateHmac(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  if (argc < 2) {
+    return JS_ThrowTypeError(ctx, "crypto_createHmac(name, key) expected");
+  }
+  const char* name = JS_ToCString(ctx, argv[0]);
+  if (!name) {
+    return JS_EXCEPTION;
+  }
+  psa_algorithm_t hash = HashAlgorithm(name);
+  JS_FreeCString(ctx, name);
+  if (hash == PSA_ALG_NONE) {
+    return JS_UNDEFINED;
+  }
+
+  JsBytes key_input;
+  if (!key_input.Get(ctx, argv[1])) {
+    return JS_EXCEPTION;
+  }
+  // HMAC 은 key 를 block 크기까지 0 으로 채우므로 빈 key 는 "\0" 과 같다
+  static const uint8_t kZeroKey[1] = {0};
+  const uint8_t* key_data = key_input.len ? key_input.data : kZeroKey;
+  size_t key_len = key_input.len ? key_input.len : 1;
+
+  psa_status_t status;
+  psa_algorithm_t alg = PSA_ALG_HMAC(hash);
+  CryptoStream* stream = new CryptoStream();
+  stream->kind = kStreamHmac;
+  {
+    std::lock_guard<std::mutex> lock(PsaKeyMutex());
+    stream->key = ImportKey(PSA_KEY_TYPE_HMAC, alg, PSA_KEY_USAGE_SIGN_MESSAGE, key_data, key_len, &status);
+    if (status == PSA_SUCCESS) {
+      status = psa_mac_sign_setup(&stream->mac, stream->key, alg);
+    }
+  }
+  key_input.Free(ctx);
+  if (status != PSA_SUCCESS) {
+    FreeCryptoStream(stream);
+    return status == PSA_ERROR_NOT_SUPPORTED ? JS_UNDEFINED : ThrowStatus(ctx, "createHmac", status);
+  }
+  return NewStreamObject(ctx, stream);
+}
+
+//
+// crypto_createCipher(name, key, iv, decrypt, auto_padding)
+//   - aes-{128,192,256}-{cbc,ctr}
+//   - key/iv 길이는 key 를 import 하기 전에 검사한다 (node 와 같은 오류)
+//
+JSValue JsCreateCipher(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  if (argc < 5) {
+    return JS_ThrowTypeError(ctx, "crypto_createCipher(name, key, iv, decrypt, auto_padding) expected");
+  }
+  const char* name = JS_ToCString(ctx, argv[0]);
+  if (!name) {
+    return JS_EXCEPTION;
+  }
+  std::string lower(name);
+  JS_FreeCString(ctx, name);
+  for (char& c : lower) {
+    if (c >= 'A' && c <= 'Z') {
+      c = (char)(c - 'A' + 'a');
+    }
+  }
+
+  size_t key_bits = 0;
+  std::string mode;
+  if (lower.size() == 11 && lower.compare(0, 4, "aes-") == 0 && lower[7] == '-') {
+    key_bits = (size_t) atoi(lower.c_str() + 4);
+    mode = lower.substr(8);
+  }
+  bool decrypt = JS_ToBool(ctx, argv[3]);
+  bool auto_padding = JS_ToBool(ctx, argv[4]);
+
+  psa_algorithm_t alg;
+  if (mode == "cbc") {
+    alg = auto_padding ? PSA_ALG_CBC_PKCS7 : PSA_ALG_CBC_NO_PADDING;
+  } else if (mode == "ctr") {
+    alg = PSA_ALG_CTR;
+  } else {
+    return JS_UNDEFINED;
+  }
+  if (key_bits != 128 && key_bits != 192 && key_bits != 256) {
+    return JS_UNDEFINED;
+  }
+
+  JsBytes key_input;
+  if (!key_input.Get(ctx, argv[1])) {
+    return JS_EXCEPTION;
+  }
+  if (key_input.len * 8 != key_bits) {
+    key_input.Free(ctx);
+    return JS_ThrowRangeError(ctx, "Invalid key length");
+  }
+  JsBytes iv_input;
+  if (!iv_input.Get(ctx, argv[2])) {
+    key_input.Free(ctx);
+    return JS_EXCEPTION;
+  }
+  if (iv_input.len != 16) {
+    key_input.Free(ctx);
+    iv_input.Free(ctx);
+    return JS_ThrowTypeError(ctx, "Invalid initialization vector");
+  }
+
+  psa_status_t status;
+  CryptoStream* stream = new CryptoStream();
+  stream->kind = kStreamCipher;
+  {
+    std::lock_guard<std::mutex> lock(PsaKeyMutex());
+    stream->key = ImportKey(PSA_KEY_TYPE_AES, alg, decrypt ? PSA_KEY_USAGE_DECRYPT : PSA_KEY_USAGE_ENCRYPT,
+                            key_input.data, key_input.len, &status);
+    if (status == PSA_SUCCESS) {
+      status = decrypt
+        ? psa_cipher_decrypt_setup(&stream->cipher, stream->key, alg)
+        : psa_cipher_encrypt_setup(&stream->cipher, stream->key, alg);
+    }
+  }
+  key_input.Free(ctx);
+  if (status == PSA_SUCCESS) {
+    status = psa_cipher_set_iv(&stream->cipher, iv_input.data, iv_input.len);
+  }
+  iv_input.Free(ctx);
+  if (status != PSA_SUCCESS) {
+    FreeCryptoStream(stream);
+    return status == PSA_ERROR_NOT_SUPPORTED ? JS_UNDEFINED : ThrowStatus(ctx, "createCipheriv", status);
+  }
+  return NewStreamObject(ctx, stream);
+}
+
+CryptoStream* GetStream(JSContext* ctx, JSValueConst this_val) {
+  CryptoStream* stream = static_cast<CryptoStream*>(JS_GetOpaque2(ctx, this_val, crypto_stream_class_id));
+  if (stream && stream->finished) {
+    JS_ThrowTypeError(ctx, "Digest already called");
+    return nullptr;
+  }
+  return stream;
+}
+
+//
+// update(data)
+//   - hash/hmac: undefined, cipher: Uint8Array
+//
+JSValue JsStreamUpdate(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  CryptoStream* stream = GetStream(ctx, this_val);
+  if (!stream) {
+    return JS_EXCEPTION;
+  }
+  JsBytes input;
+  if (!input.Get(ctx, argc > 0 ? argv[0] : JS_UNDEFINED)) {
+    return JS_EXCEPTION;
+  }
+
+  JSValue ret = JS_UNDEFINED;
+  psa_status_t status = PSA_SUCCESS;
+  if (stream->kind == kStreamHash) {
+    status = psa_hash_update(&stream->hash, input.data, input.len);
+  } else if (stream->kind == kStreamHmac) {
+    status = psa_mac_update(&stream->mac, input.data, input.len);
+  } else {
+    // CBC 는 이전에 남은 block 을 포함해 최대 len + block 크기
+    size_t cap = input.len + PSA_BLOCK_CIPHER_BLOCK_MAX_SIZE;
+    uint8_t* out = static_cast<uint8_t*>(js_malloc(ctx, cap));
+    size_t out_len = 0;
+    if (!out) {
+      input.Free(ctx);
+      return JS_EXCEPTION;
+    }
+    status = psa_cipher_update(&stream->cipher, input.data, input.len, out, cap, &out_len);
+    if (status == PSA_SUCCESS) {
+      ret = NewOutput(ctx, out, out_len);
+    } else {
+      js_free(ctx, out);
+    }
+  }
+  input.Free(ctx);
+
+  if (status != PSA_SUCCESS) {
+    // 실패한 operation 은 더 쓸 수 없다
+    stream->finished = true;
+    ReleaseStream(stream);
+    return ThrowStatus(ctx, "update", status);
+  }
+  return ret;
+}
+
+//
+// final()
+//   - hash/hmac: digest (ArrayBuffer), cipher: 남은 block (Uint8Array)
+//   - 결과와 관계없이 operation 을 abort 하고 key 를 destroy 한다
+//
+JSValue JsStreamFinal(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  CryptoStream* stream = GetStream(ctx, this_val);
+  if (!stream) {
+    return JS_EXCEPTION;
+  }
+  stream->finished = true;
+
+  psa_status_t status;
+  if (stream->kind == kStreamCipher) {
+    uint8_t* out = static_cast<uint8_t*>(js_malloc(ctx, PSA_BLOCK_CIPHER_BLOCK_MAX_SIZE));
+    size_t out_len = 0;
+    if (!out) {
+      ReleaseStream(stream);
+      return JS_EXCEPTION;
+    }
+    status = psa_cipher_finish(&stream->cipher, out, PSA_BLOCK_CIPHER_BLOCK_MAX_SIZE, &out_len);
+    ReleaseStream(stream);
+    if (status != PSA_SUCCESS) {
+      js_free(ctx, out);
+      if (status == PSA_ERROR_INVALID_PADDING) {
+        return JS_ThrowTypeError(ctx, "bad decrypt");
+      }
+      if (status == PSA_ERROR_INVALID_ARGUMENT) {
+        return JS_ThrowRangeError(ctx, "wrong final block length");
+      }
+      return ThrowStatus(ctx, "final", status);
+    }
+    return NewOutput(ctx, out, out_len);
+  }
+
+  uint8_t digest[PSA_HASH_MAX_SIZE];
+  size_t digest_len = 0;
+  if (stream->kind == kStreamHash) {
+    status = psa_hash_finish(&stream->hash, digest, sizeof(digest), &digest_len);
+  } else {
+    status = psa_mac_sign_finish(&stream->mac, digest, sizeof(digest), &digest_len);
+  }
+  ReleaseStream(stream);
+  if (status != PSA_SUCCESS) {
+    return ThrowStatus(ctx, "digest", status);
+  }
+  return JS_NewArrayBufferCopy(ctx, digest, digest_len);
+}
+
+//
+// copy()
+//   - hash 만 지원 (node Hash.prototype.copy)
+//
+JSValue JsStreamCopy(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  CryptoStream* stream = GetStream(ctx, this_val);
+  if (!stream) {
+    return JS_EXCEPTION;
+  }
+  if (stream->kind != kStreamHash) {
+    return JS_ThrowTypeError(ctx, "copy() is only supported for hashes");
+  }
+  CryptoStream* clone = new CryptoStream();
+  clone->kind = kStreamHash;
+  psa_status_t status = psa_hash_clone(&stream->hash, &clone->hash);
+  if (status != PSA_SUCCESS) {
+    FreeCryptoStream(clone);
+    return ThrowStatus(ctx, "copy", status);
+  }
+  return NewStreamObject(ctx, clone);
+}
+
+const JSCFunctionListEntry kCryptoStreamProto[] = {
+  JS_CFUNC_DEF("update", 1, JsStreamUpdate),
+  JS_CFUNC_DEF("final", 0, JsStreamFinal),
+  JS_CFUNC_DEF("copy", 0, JsStreamCopy),
+};
+
+}  // anonymous
+
+void RegisterCryptoStream(JSContext* ctx, JSValueConst sys_host) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  // class id 는 모든 runtime 에서 같은 값 (pthread 빌드에서 worker 가 동시에 초기화)
+  std::call_once(crypto_stream_class_once, [rt] {
+    JS_NewClassID(rt, &crypto_stream_class_id);
+  });
+  if (!JS_IsRegisteredClass(rt, crypto_stream_class_id)) {
+    JS_NewClass(rt, crypto_stream_class_id, &kCryptoStreamClass);
+  }
+
+  // prototype 은 context (window) 별
+  JSValue proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, kCryptoStreamProto,
+                             sizeof(kCryptoStreamProto) / sizeof(kCryptoStreamProto[0]));
+  JS_SetClassProto(ctx, crypto_stream_class_id, proto);
+
+  JS_SetPropertyStr(ctx, sys_host, "crypto_createHash",
+    JS_NewCFunction(ctx, JsCreateHash, "crypto_createHash", 1));
+  JS_SetPropertyStr(ctx, sys_host, "crypto_createHmac",
+    JS_NewCFunction(ctx, JsCreateHmac, "crypto_createHmac", 2));
+  JS_SetPropertyStr(ctx, sys_host, "crypto_createCipher",
+    JS_NewCFunction(ctx, JsCreateCipher, "crypto_createCipher", 5));
+}
+
+}  // namespace request_unraver
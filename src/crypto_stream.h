@@ -0,0 +1,25 @@
+#ifndef REQUEST_UNRAVER_CRYPTO_STREAM_H_
+#define REQUEST_UNRAVER_CRYPTO_STREAM_H_
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// node:crypto 의 createHash/createHmac/createCipheriv 용 native streaming context
+//
+// __sys_host 에 다음 함수를 등록한다. 지원하지 않는 알고리즘은 undefined 를
+// 반환하므로 polyfill (crypto.js) 은 crypto-browserify 로 대체할 수 있다.
+//
+//   crypto_createHash(name)
+//   crypto_createHmac(name, key)
+//   crypto_createCipher(name, key, iv, decrypt, auto_padding)
+//
+// 반환된 객체는 update(data) / final() 을 가진다. data 는 string (UTF-8) 또는
+// ArrayBuffer/TypedArray 이며 복사 없이 mbedtls 에 전달된다.
+void RegisterCryptoStream(JSContext* ctx, JSValueConst sys_host);
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_CRYPTO_STREAM_H_
@@ -0,0 +1,763 @@
+#include "crypto_subtle.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <mbedtls/platform_util.h>
+#include <psa/crypto.h>
+
+namespace request_unraver {
+
+namespace {
+
+enum CryptoAlgo {
+  kAlgoNone = 0,
+  kAlgoHmac,
+  kAlgoAesCbc,
+  kAlgoAesCtr,
+  kAlgoAesGcm,
+};
+
+// PSA key slot 은 연산 동안만 잡는다. CryptoKey 마다 slot 을 잡아 두면 GC 전까지
+// MBEDTLS_PSA_KEY_SLOT_COUNT 를 넘어 importKey 가 실패한다
+struct CryptoKeyData {
+  CryptoAlgo algo;
+  // HMAC 의 hash
+  psa_algorithm_t hash;
+  size_t bits;
+  psa_key_type_t type;
+  psa_algorithm_t alg;
+  psa_key_usage_t usage;
+  std::vector<uint8_t> raw;
+};
+
+JSClassID crypto_key_class_id = 0;
+std::once_flag crypto_key_class_once;
+
+void CryptoKeyFinalizer(JSRuntime* rt, JSValue val) {
+  CryptoKeyData* key = static_cast<CryptoKeyData*>(JS_GetOpaque(val, crypto_key_class_id));
+  if (key) {
+    mbedtls_platform_zeroize(key->raw.data(), key->raw.size());
+    delete key;
+  }
+}
+
+// 연산 동안 raw key 를 PSA key store 에 import 하고 끝나면 destroy
+class ScopedPsaKey {
+ public:
+  explicit ScopedPsaKey(const CryptoKeyData* key) : lock_(PsaKeyMutex()) {
+    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_type(&attributes, key->type);
+    psa_set_key_algorithm(&attributes, key->alg);
+    psa_set_key_usage_flags(&attributes, key->usage);
+    psa_set_key_bits(&attributes, key->bits);
+    status_ = psa_import_key(&attributes, key->raw.data(), key->raw.size(), &id_);
+    psa_reset_key_attributes(&attributes);
+  }
+
+  ~ScopedPsaKey() {
+    if (status_ == PSA_SUCCESS) {
+      psa_destroy_key(id_);
+    }
+  }
+
+  ScopedPsaKey(const ScopedPsaKey&) = delete;
+  ScopedPsaKey& operator=(const ScopedPsaKey&) = delete;
+
+  psa_status_t status() const { return status_; }
+  psa_key_id_t id() const { return id_; }
+
+ private:
+  // key store 는 import 부터 destroy 까지 잠근다 (lock_ 은 id_ 보다 먼저 잡히고 나중에 풀림)
+  std::lock_guard<std::mutex> lock_;
+  psa_key_id_t id_ = 0;
+  psa_status_t status_;
+};
+
+const JSClassDef kCryptoKeyClass = {
+  "CryptoKey",
+  CryptoKeyFinalizer,
+};
+
+// WebCrypto 는 오류를 DOMException 이름으로 구분한다
+JSValue ThrowCryptoError(JSContext* ctx, const char* name, const char* message) {
+  JSValue error = JS_NewError(ctx);
+  JS_SetPropertyStr(ctx, error, "name", JS_NewString(ctx, name));
+  JS_SetPropertyStr(ctx, error, "message", JS_NewString(ctx, message));
+  return JS_Throw(ctx, error);
+}
+
+JSValue ThrowPsaError(JSContext* ctx, psa_status_t status) {
+  switch (status) {
+    case PSA_ERROR_NOT_PERMITTED:
+      return ThrowCryptoError(ctx, "InvalidAccessError", "key usage does not permit this operation");
+    case PSA_ERROR_NOT_SUPPORTED:
+      return ThrowCryptoError(ctx, "NotSupportedError", "algorithm is not supported");
+    case PSA_ERROR_INVALID_ARGUMENT:
+      return ThrowCryptoError(ctx, "DataError", "invalid key or parameter");
+    default:
+      return ThrowCryptoError(ctx, "OperationError", "operation failed");
+  }
+}
+
+// BufferSource (ArrayBuffer, TypedArray, DataView). 반환된 포인터는 호출 동안만 유효
+bool GetBufferSource(JSContext* ctx, JSValueConst value, const uint8_t** data, size_t* len) {
+  if (JS_IsArrayBuffer(value)) {
+    *data = JS_GetArrayBuffer(ctx, len, value);
+    return *data != nullptr || *len == 0;
+  }
+
+  JSValue buffer = JS_GetPropertyStr(ctx, value, "buffer");
+  if (!JS_IsArrayBuffer(buffer)) {
+    JS_FreeValue(ctx, buffer);
+    JS_ThrowTypeError(ctx, "BufferSource expected");
+    return false;
+  }
+  uint32_t offset = 0;
+  uint32_t length = 0;
+  JSValue offset_val = JS_GetPropertyStr(ctx, value, "byteOffset");
+  JSValue length_val = JS_GetPropertyStr(ctx, value, "byteLength");
+  bool ok = !JS_ToUint32(ctx, &offset, offset_val) && !JS_ToUint32(ctx, &length, length_val);
+  JS_FreeValue(ctx, offset_val);
+  JS_FreeValue(ctx, length_val);
+
+  size_t size = 0;
+  uint8_t* base = ok ? JS_GetArrayBuffer(ctx, &size, buffer) : nullptr;
+  // buffer 는 value 가 참조하고 있으므로 해제 후에도 유효
+  JS_FreeValue(ctx, buffer);
+  if (!ok) {
+    return false;
+  }
+  if ((size_t) offset + length > size) {
+    JS_ThrowRangeError(ctx, "BufferSource out of range");
+    return false;
+  }
+  *data = base ? base + offset : nullptr;
+  *len = length;
+  return true;
+}
+
+bool GetBufferProperty(JSContext* ctx, JSValueConst obj, const char* name,
+                       std::vector<uint8_t>* out, bool required) {
+  JSValue value = JS_GetPropertyStr(ctx, obj, name);
+  if (JS_IsUndefined(value)) {
+    if (required) {
+      JS_ThrowTypeError(ctx, "algorithm.%s is required", name);
+      return false;
+    }
+    return true;
+  }
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  bool ok = GetBufferSource(ctx, value, &data, &len);
+  if (ok) {
+    out->assign(data, data + len);
+  }
+  JS_FreeValue(ctx, value);
+  return ok;
+}
+
+bool GetUint32Property(JSContext* ctx, JSValueConst obj, const char* name, uint32_t* out) {
+  JSValue value = JS_GetPropertyStr(ctx, obj, name);
+  if (JS_IsUndefined(value)) {
+    return true;
+  }
+  bool ok = !JS_ToUint32(ctx, out, value);
+  JS_FreeValue(ctx, value);
+  return ok;
+}
+
+// algorithm: "NAME" 또는 { name: "NAME", ... }
+bool GetAlgorithmName(JSContext* ctx, JSValueConst algorithm, std::string* name) {
+  JSValue name_val = JS_IsString(algorithm)
+    ? JS_DupValue(ctx, algorithm)
+    : JS_GetPropertyStr(ctx, algorithm, "name");
+  const char* str = JS_ToCString(ctx, name_val);
+  JS_FreeValue(ctx, name_val);
+  if (!str) {
+    return false;
+  }
+  *name = str;
+  JS_FreeCString(ctx, str);
+  for (char& c : *name) {
+    if (c >= 'a' && c <= 'z') {
+      c = (char)(c - 'a' + 'A');
+    }
+  }
+  return true;
+}
+
+psa_algorithm_t HashAlgorithm(const std::string& name) {
+  if (name == "SHA-1") return PSA_ALG_SHA_1;
+  if (name == "SHA-256") return PSA_ALG_SHA_256;
+  if (name == "SHA-384") return PSA_ALG_SHA_384;
+  if (name == "SHA-512") return PSA_ALG_SHA_512;
+  return PSA_ALG_NONE;
+}
+
+CryptoAlgo KeyAlgorithm(const std::string& name) {
+  if (name == "HMAC") return kAlgoHmac;
+  if (name == "AES-CBC") return kAlgoAesCbc;
+  if (name == "AES-CTR") return kAlgoAesCtr;
+  if (name == "AES-GCM") return kAlgoAesGcm;
+  return kAlgoNone;
+}
+
+const char* KeyAlgorithmName(CryptoAlgo algo) {
+  switch (algo) {
+    case kAlgoHmac: return "HMAC";
+    case kAlgoAesCbc: return "AES-CBC";
+    case kAlgoAesCtr: return "AES-CTR";
+    case kAlgoAesGcm: return "AES-GCM";
+    default: return "";
+  }
+}
+
+const char* HashName(psa_algorithm_t hash) {
+  switch (hash) {
+    case PSA_ALG_SHA_1: return "SHA-1";
+    case PSA_ALG_SHA_256: return "SHA-256";
+    case PSA_ALG_SHA_384: return "SHA-384";
+    case PSA_ALG_SHA_512: return "SHA-512";
+    default: return "";
+  }
+}
+
+CryptoKeyData* GetKey(JSContext* ctx, JSValueConst value, CryptoAlgo algo) {
+  CryptoKeyData* key = static_cast<CryptoKeyData*>(JS_GetOpaque(value, crypto_key_class_id));
+  if (!key) {
+    JS_ThrowTypeError(ctx, "CryptoKey expected");
+    return nullptr;
+  }
+  if (key->algo != algo) {
+    ThrowCryptoError(ctx, "InvalidAccessError", "key algorithm does not match");
+    return nullptr;
+  }
+  return key;
+}
+
+// 결과(또는 pending exception)를 job queue 에서 settle 되는 Promise 로 변환
+JSValue SettleJob(JSContext* ctx, int argc, JSValueConst* argv) {
+  // argv: [resolve | reject, value]
+  return JS_Call(ctx, argv[0], JS_UNDEFINED, 1, &argv[1]);
+}
+
+JSValue ToPromise(JSContext* ctx, JSValue result) {
+  bool failed = JS_IsException(result);
+  JSValue value = failed ? JS_GetException(ctx) : result;
+  // interrupt (timeout/abort) 같은 uncatchable 예외는 reject 로 바꾸지 않고 그대로 전파
+  if (failed && JS_IsUncatchableError(ctx, value)) {
+    return JS_Throw(ctx, value);
+  }
+
+  JSValue resolving_funcs[2];
+  JSValue promise = JS_NewPromiseCapability(ctx, resolving_funcs);
+  if (JS_IsException(promise)) {
+    JS_FreeValue(ctx, value);
+    return promise;
+  }
+
+  JSValueConst args[2] = {
+    resolving_funcs[failed ? 1 : 0],
+    value,
+  };
+  if (JS_EnqueueJob(ctx, SettleJob, 2, args) < 0) {
+    JS_FreeValue(ctx, promise);
+    promise = JS_EXCEPTION;
+  }
+  JS_FreeValue(ctx, value);
+  JS_FreeValue(ctx, resolving_funcs[0]);
+  JS_FreeValue(ctx, resolving_funcs[1]);
+  return promise;
+}
+
+JSValue NewArrayBuffer(JSContext* ctx, const std::vector<uint8_t>& data, size_t len) {
+  return JS_NewArrayBufferCopy(ctx, data.data(), len);
+}
+
+//
+// digest(algorithm, data)
+//
+JSValue Digest(JSContext* ctx, int argc, JSValueConst* argv) {
+  if (argc < 2) {
+    return JS_ThrowTypeError(ctx, "digest(algorithm, data) expected");
+  }
+  std::string name;
+  if (!GetAlgorithmName(ctx, argv[0], &name)) {
+    return JS_EXCEPTION;
+  }
+  psa_algorithm_t alg = HashAlgorithm(name);
+  if (alg == PSA_ALG_NONE) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "unsupported digest algorithm");
+  }
+
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  if (!GetBufferSource(ctx, argv[1], &data, &len)) {
+    return JS_EXCEPTION;
+  }
+
+  uint8_t hash[PSA_HASH_MAX_SIZE];
+  size_t hash_len = 0;
+  psa_status_t status = psa_hash_compute(alg, data, len, hash, sizeof(hash), &hash_len);
+  if (status != PSA_SUCCESS) {
+    return ThrowPsaError(ctx, status);
+  }
+  return JS_NewArrayBufferCopy(ctx, hash, hash_len);
+}
+
+bool ParseUsages(JSContext* ctx, JSValueConst usages, psa_key_usage_t* out) {
+  int64_t count = 0;
+  if (JS_GetLength(ctx, usages, &count) < 0) {
+    return false;
+  }
+  psa_key_usage_t flags = 0;
+  for (int64_t i = 0; i < count; i++) {
+    JSValue item = JS_GetPropertyInt64(ctx, usages, i);
+    const char* usage = JS_ToCString(ctx, item);
+    JS_FreeValue(ctx, item);
+    if (!usage) {
+      return false;
+    }
+    if (!strcmp(usage, "encrypt")) {
+      flags |= PSA_KEY_USAGE_ENCRYPT;
+    } else if (!strcmp(usage, "decrypt")) {
+      flags |= PSA_KEY_USAGE_DECRYPT;
+    } else if (!strcmp(usage, "sign")) {
+      flags |= PSA_KEY_USAGE_SIGN_MESSAGE;
+    } else if (!strcmp(usage, "verify")) {
+      flags |= PSA_KEY_USAGE_VERIFY_MESSAGE;
+    }
+    // wrapKey/unwrapKey/derive* 는 지원하지 않으므로 무시
+    JS_FreeCString(ctx, usage);
+  }
+  *out = flags;
+  return true;
+}
+
+//
+// importKey("raw", keyData, algorithm, extractable, usages)
+//
+JSValue ImportKey(JSContext* ctx, int argc, JSValueConst* argv) {
+  if (argc < 5) {
+    return JS_ThrowTypeError(ctx, "importKey(format, keyData, algorithm, extractable, keyUsages) expected");
+  }
+  const char* format = JS_ToCString(ctx, argv[0]);
+  if (!format) {
+    return JS_EXCEPTION;
+  }
+  bool raw_format = !strcmp(format, "raw");
+  JS_FreeCString(ctx, format);
+  if (!raw_format) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "only raw key format is supported");
+  }
+
+  std::string name;
+  if (!GetAlgorithmName(ctx, argv[2], &name)) {
+    return JS_EXCEPTION;
+  }
+  CryptoAlgo algo = KeyAlgorithm(name);
+  if (algo == kAlgoNone) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "unsupported key algorithm");
+  }
+
+  const uint8_t* key_data = nullptr;
+  size_t key_len = 0;
+  if (!GetBufferSource(ctx, argv[1], &key_data, &key_len)) {
+    return JS_EXCEPTION;
+  }
+
+  psa_key_usage_t usage = 0;
+  if (!ParseUsages(ctx, argv[4], &usage)) {
+    return JS_EXCEPTION;
+  }
+  bool extractable = JS_ToBool(ctx, argv[3]);
+  if (extractable) {
+    usage |= PSA_KEY_USAGE_EXPORT;
+  }
+
+  psa_algorithm_t hash = PSA_ALG_NONE;
+  psa_key_type_t type;
+  psa_algorithm_t alg;
+  if (algo == kAlgoHmac) {
+    std::string hash_name;
+    JSValue hash_val = JS_GetPropertyStr(ctx, argv[2], "hash");
+    bool ok = GetAlgorithmName(ctx, hash_val, &hash_name);
+    JS_FreeValue(ctx, hash_val);
+    if (!ok) {
+      return JS_EXCEPTION;
+    }
+    hash = HashAlgorithm(hash_name);
+    if (hash == PSA_ALG_NONE) {
+      return ThrowCryptoError(ctx, "NotSupportedError", "unsupported HMAC hash");
+    }
+    if (key_len == 0) {
+      return ThrowCryptoError(ctx, "DataError", "HMAC key must not be empty");
+    }
+    type = PSA_KEY_TYPE_HMAC;
+    alg = PSA_ALG_HMAC(hash);
+  } else {
+    if (key_len != 16 && key_len != 24 && key_len != 32) {
+      return ThrowCryptoError(ctx, "DataError", "AES key must be 128, 192 or 256 bits");
+    }
+    type = PSA_KEY_TYPE_AES;
+    if (algo == kAlgoAesCbc) {
+      alg = PSA_ALG_CBC_PKCS7;
+    } else if (algo == kAlgoAesCtr) {
+      alg = PSA_ALG_CTR;
+    } else {
+      // tagLength 는 연산마다 다를 수 있다
+      alg = PSA_ALG_AEAD_WITH_AT_LEAST_THIS_LENGTH_TAG(PSA_ALG_GCM, 4);
+    }
+  }
+
+  CryptoKeyData* key = new CryptoKeyData();
+  key->algo = algo;
+  key->hash = hash;
+  key->bits = key_len * 8;
+  key->type = type;
+  key->alg = alg;
+  key->usage = usage;
+  key->raw.assign(key_data, key_data + key_len);
+
+  // 잘못된 key 는 importKey 에서 DataError 로 알린다
+  psa_status_t status = ScopedPsaKey(key).status();
+  JSValue obj = status == PSA_SUCCESS ? JS_NewObjectClass(ctx, crypto_key_class_id) : JS_EXCEPTION;
+  if (JS_IsException(obj)) {
+    mbedtls_platform_zeroize(key->raw.data(), key->raw.size());
+    delete key;
+    return status == PSA_SUCCESS ? obj : ThrowPsaError(ctx, status);
+  }
+  JS_SetOpaque(obj, key);
+
+  JSValue algorithm = JS_NewObject(ctx);
+  JS_SetPropertyStr(ctx, algorithm, "name", JS_NewString(ctx, KeyAlgorithmName(algo)));
+  JS_SetPropertyStr(ctx, algorithm, "length", JS_NewUint32(ctx, (uint32_t) key->bits));
+  if (algo == kAlgoHmac) {
+    JSValue hash_obj = JS_NewObject(ctx);
+    JS_SetPropertyStr(ctx, hash_obj, "name", JS_NewString(ctx, HashName(hash)));
+    JS_SetPropertyStr(ctx, algorithm, "hash", hash_obj);
+  }
+  JS_DefinePropertyValueStr(ctx, obj, "type", JS_NewString(ctx, "secret"), JS_PROP_ENUMERABLE);
+  JS_DefinePropertyValueStr(ctx, obj, "extractable", JS_NewBool(ctx, extractable), JS_PROP_ENUMERABLE);
+  JS_DefinePropertyValueStr(ctx, obj, "algorithm", algorithm, JS_PROP_ENUMERABLE);
+  JS_DefinePropertyValueStr(ctx, obj, "usages", JS_DupValue(ctx, argv[4]), JS_PROP_ENUMERABLE);
+  return obj;
+}
+
+//
+// exportKey("raw", key)
+//
+JSValue ExportKey(JSContext* ctx, int argc, JSValueConst* argv) {
+  if (argc < 2) {
+    return JS_ThrowTypeError(ctx, "exportKey(format, key) expected");
+  }
+  const char* format = JS_ToCString(ctx, argv[0]);
+  if (!format) {
+    return JS_EXCEPTION;
+  }
+  bool raw_format = !strcmp(format, "raw");
+  JS_FreeCString(ctx, format);
+  if (!raw_format) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "only raw key format is supported");
+  }
+
+  CryptoKeyData* key = static_cast<CryptoKeyData*>(JS_GetOpaque(argv[1], crypto_key_class_id));
+  if (!key) {
+    return JS_ThrowTypeError(ctx, "CryptoKey expected");
+  }
+  if (!(key->usage & PSA_KEY_USAGE_EXPORT)) {
+    return ThrowCryptoError(ctx, "InvalidAccessError", "key is not extractable");
+  }
+  return NewArrayBuffer(ctx, key->raw, key->raw.size());
+}
+
+//
+// sign(algorithm, key, data) / verify(algorithm, key, signature, data)
+//
+JSValue Sign(JSContext* ctx, int argc, JSValueConst* argv) {
+  if (argc < 3) {
+    return JS_ThrowTypeError(ctx, "sign(algorithm, key, data) expected");
+  }
+  std::string name;
+  if (!GetAlgorithmName(ctx, argv[0], &name)) {
+    return JS_EXCEPTION;
+  }
+  if (KeyAlgorithm(name) != kAlgoHmac) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "only HMAC signing is supported");
+  }
+  CryptoKeyData* key = GetKey(ctx, argv[1], kAlgoHmac);
+  if (!key) {
+    return JS_EXCEPTION;
+  }
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  if (!GetBufferSource(ctx, argv[2], &data, &len)) {
+    return JS_EXCEPTION;
+  }
+
+  uint8_t mac[PSA_MAC_MAX_SIZE];
+  size_t mac_len = 0;
+  ScopedPsaKey psa_key(key);
+  psa_status_t status = psa_key.status();
+  if (status == PSA_SUCCESS) {
+    status = psa_mac_compute(psa_key.id(), PSA_ALG_HMAC(key->hash), data, len, mac, sizeof(mac), &mac_len);
+  }
+  if (status != PSA_SUCCESS) {
+    return ThrowPsaError(ctx, status);
+  }
+  return JS_NewArrayBufferCopy(ctx, mac, mac_len);
+}
+
+JSValue Verify(JSContext* ctx, int argc, JSValueConst* argv) {
+  if (argc < 4) {
+    return JS_ThrowTypeError(ctx, "verify(algorithm, key, signature, data) expected");
+  }
+  std::string name;
+  if (!GetAlgorithmName(ctx, argv[0], &name)) {
+    return JS_EXCEPTION;
+  }
+  if (KeyAlgorithm(name) != kAlgoHmac) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "only HMAC verification is supported");
+  }
+  CryptoKeyData* key = GetKey(ctx, argv[1], kAlgoHmac);
+  if (!key) {
+    return JS_EXCEPTION;
+  }
+  std::vector<uint8_t> signature;
+  const uint8_t* sig_data = nullptr;
+  size_t sig_len = 0;
+  if (!GetBufferSource(ctx, argv[2], &sig_data, &sig_len)) {
+    return JS_EXCEPTION;
+  }
+  // data 의 getter 가 signature buffer 를 바꿀 수 있으므로 복사
+  signature.assign(sig_data, sig_data + sig_len);
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  if (!GetBufferSource(ctx, argv[3], &data, &len)) {
+    return JS_EXCEPTION;
+  }
+
+  ScopedPsaKey psa_key(key);
+  psa_status_t status = psa_key.status();
+  if (status == PSA_SUCCESS) {
+    status = psa_mac_verify(psa_key.id(), PSA_ALG_HMAC(key->hash), data, len, signature.data(), signature.size());
+  }
+  if (status == PSA_ERROR_INVALID_SIGNATURE) {
+    return JS_FALSE;
+  }
+  if (status != PSA_SUCCESS) {
+    return ThrowPsaError(ctx, status);
+  }
+  return JS_TRUE;
+}
+
+// AES-CBC / AES-CTR (multipart 로 IV 지정)
+JSValue AesCipher(JSContext* ctx, CryptoKeyData* key, psa_algorithm_t alg, bool encrypt,
+                  const std::vector<uint8_t>& iv, const uint8_t* data, size_t len) {
+  ScopedPsaKey psa_key(key);
+  psa_cipher_operation_t op = PSA_CIPHER_OPERATION_INIT;
+  psa_status_t status = psa_key.status();
+  if (status == PSA_SUCCESS) {
+    status = encrypt
+      ? psa_cipher_encrypt_setup(&op, psa_key.id(), alg)
+      : psa_cipher_decrypt_setup(&op, psa_key.id(), alg);
+  }
+  if (status == PSA_SUCCESS) {
+    status = psa_cipher_set_iv(&op, iv.data(), iv.size());
+  }
+
+  std::vector<uint8_t> out(len + 16);
+  size_t update_len = 0;
+  size_t finish_len = 0;
+  if (status == PSA_SUCCESS) {
+    status = psa_cipher_update(&op, data, len, out.data(), out.size(), &update_len);
+  }
+  if (status == PSA_SUCCESS) {
+    status = psa_cipher_finish(&op, out.data() + update_len, out.size() - update_len, &finish_len);
+  }
+  psa_cipher_abort(&op);
+
+  if (status == PSA_ERROR_INVALID_PADDING) {
+    return ThrowCryptoError(ctx, "OperationError", "invalid padding");
+  }
+  if (status != PSA_SUCCESS) {
+    return ThrowPsaError(ctx, status);
+  }
+  return NewArrayBuffer(ctx, out, update_len + finish_len);
+}
+
+// PSA CTR 은 128 bit 전체를 증가시키므로 counter 하위 length bit 가 넘치면 결과가 다르다
+bool CtrCounterWraps(const std::vector<uint8_t>& counter, uint32_t length_bits, size_t data_len) {
+  if (length_bits >= 128) {
+    return false;
+  }
+  unsigned __int128 value = 0;
+  for (uint8_t byte : counter) {
+    value = (value << 8) | byte;
+  }
+  unsigned __int128 limit = (unsigned __int128) 1 << length_bits;
+  unsigned __int128 low = value & (limit - 1);
+  unsigned __int128 blocks = (data_len + 15) / 16;
+  return low + blocks > limit;
+}
+
+JSValue AesOperation(JSContext* ctx, int argc, JSValueConst* argv, bool encrypt) {
+  if (argc < 3) {
+    return JS_ThrowTypeError(ctx, encrypt ? "encrypt(algorithm, key, data) expected"
+                                          : "decrypt(algorithm, key, data) expected");
+  }
+  std::string name;
+  if (!GetAlgorithmName(ctx, argv[0], &name)) {
+    return JS_EXCEPTION;
+  }
+  CryptoAlgo algo = KeyAlgorithm(name);
+  if (algo != kAlgoAesCbc && algo != kAlgoAesCtr && algo != kAlgoAesGcm) {
+    return ThrowCryptoError(ctx, "NotSupportedError", "unsupported cipher algorithm");
+  }
+  CryptoKeyData* key = GetKey(ctx, argv[1], algo);
+  if (!key) {
+    return JS_EXCEPTION;
+  }
+
+  JSValueConst params = argv[0];
+  std::vector<uint8_t> iv;
+  std::vector<uint8_t> additional_data;
+  uint32_t tag_bits = 128;
+  uint32_t counter_bits = 0;
+
+  if (algo == kAlgoAesCbc) {
+    if (!GetBufferProperty(ctx, params, "iv", &iv, true)) {
+      return JS_EXCEPTION;
+    }
+    if (iv.size() != 16) {
+      return ThrowCryptoError(ctx, "OperationError", "AES-CBC iv must be 16 bytes");
+    }
+  } else if (algo == kAlgoAesCtr) {
+    if (!GetBufferProperty(ctx, params, "counter", &iv, true) ||
+        !GetUint32Property(ctx, params, "length", &counter_bits)) {
+      return JS_EXCEPTION;
+    }
+    if (iv.size() != 16 || counter_bits == 0 || counter_bits > 128) {
+      return ThrowCryptoError(ctx, "OperationError", "invalid AES-CTR counter or length");
+    }
+  } else {
+    if (!GetBufferProperty(ctx, params, "iv", &iv, true) ||
+        !GetBufferProperty(ctx, params, "additionalData", &additional_data, false) ||
+        !GetUint32Property(ctx, params, "tagLength", &tag_bits)) {
+      return JS_EXCEPTION;
+    }
+    if (iv.empty() || (tag_bits != 32 && tag_bits != 64 && (tag_bits < 96 || tag_bits > 128 || tag_bits % 8))) {
+      return ThrowCryptoError(ctx, "OperationError", "invalid AES-GCM iv or tagLength");
+    }
+  }
+
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  if (!GetBufferSource(ctx, argv[2], &data, &len)) {
+    return JS_EXCEPTION;
+  }
+
+  if (algo == kAlgoAesCbc) {
+    return AesCipher(ctx, key, PSA_ALG_CBC_PKCS7, encrypt, iv, data, len);
+  }
+  if (algo == kAlgoAesCtr) {
+    if (CtrCounterWraps(iv, counter_bits, len)) {
+      return ThrowCryptoError(ctx, "NotSupportedError", "AES-CTR counter wrap is not supported");
+    }
+    return AesCipher(ctx, key, PSA_ALG_CTR, encrypt, iv, data, len);
+  }
+
+  // AES-GCM: 결과는 ciphertext || tag (WebCrypto 와 같은 형식)
+  psa_algorithm_t alg = PSA_ALG_AEAD_WITH_SHORTENED_TAG(PSA_ALG_GCM, tag_bits / 8);
+  std::vector<uint8_t> out(len + tag_bits / 8);
+  size_t out_len = 0;
+  ScopedPsaKey psa_key(key);
+  psa_status_t status = psa_key.status();
+  if (status == PSA_SUCCESS) {
+    status = encrypt
+      ? psa_aead_encrypt(psa_key.id(), alg, iv.data(), iv.size(), additional_data.data(), additional_data.size(),
+                         data, len, out.data(), out.size(), &out_len)
+      : psa_aead_decrypt(psa_key.id(), alg, iv.data(), iv.size(), additional_data.data(), additional_data.size(),
+                         data, len, out.data(), out.size(), &out_len);
+  }
+  if (status == PSA_ERROR_INVALID_SIGNATURE) {
+    return ThrowCryptoError(ctx, "OperationError", "AES-GCM authentication failed");
+  }
+  if (status != PSA_SUCCESS) {
+    return ThrowPsaError(ctx, status);
+  }
+  return NewArrayBuffer(ctx, out, out_len);
+}
+
+enum SubtleMethod {
+  kSubtleDigest = 0,
+  kSubtleImportKey,
+  kSubtleExportKey,
+  kSubtleSign,
+  kSubtleVerify,
+  kSubtleEncrypt,
+  kSubtleDecrypt,
+};
+
+JSValue JsSubtleBinding(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic) {
+  JSValue result;
+  switch (magic) {
+    case kSubtleDigest: result = Digest(ctx, argc, argv); break;
+    case kSubtleImportKey: result = ImportKey(ctx, argc, argv); break;
+    case kSubtleExportKey: result = ExportKey(ctx, argc, argv); break;
+    case kSubtleSign: result = Sign(ctx, argc, argv); break;
+    case kSubtleVerify: result = Verify(ctx, argc, argv); break;
+    case kSubtleEncrypt: result = AesOperation(ctx, argc, argv, true); break;
+    case kSubtleDecrypt: result = AesOperation(ctx, argc, argv, false); break;
+    default: result = JS_ThrowInternalError(ctx, "unknown subtle method"); break;
+  }
+  // WebCrypto 는 인자 오류도 rejected Promise 로 돌려준다
+  return ToPromise(ctx, result);
+}
+
+}  // anonymous
+
+std::mutex& PsaKeyMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+JSValue NewCryptoSubtle(JSContext* ctx) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  // class id 는 모든 runtime 에서 같은 값 (pthread 빌드에서 worker 가 동시에 초기화)
+  std::call_once(crypto_key_class_once, [rt] {
+    JS_NewClassID(rt, &crypto_key_class_id);
+  });
+  if (!JS_IsRegisteredClass(rt, crypto_key_class_id)) {
+    JS_NewClass(rt, crypto_key_class_id, &kCryptoKeyClass);
+  }
+  // prototype 은 context (window) 별
+  JS_SetClassProto(ctx, crypto_key_class_id, JS_NewObject(ctx));
+
+  static const struct {
+    const char* name;
+    int length;
+    SubtleMethod method;
+  } kMethods[] = {
+    {"digest", 2, kSubtleDigest},
+    {"importKey", 5, kSubtleImportKey},
+    {"exportKey", 2, kSubtleExportKey},
+    {"sign", 3, kSubtleSign},
+    {"verify", 4, kSubtleVerify},
+    {"encrypt", 3, kSubtleEncrypt},
+    {"decrypt", 3, kSubtleDecrypt},
+  };
+
+  JSValue subtle = JS_NewObject(ctx);
+  for (const auto& method : kMethods) {
+    JS_SetPropertyStr(ctx, subtle, method.name,
+      JS_NewCFunctionMagic(ctx, JsSubtleBinding, method.name, method.length,
+                           JS_CFUNC_generic_magic, method.method));
+  }
+  return subtle;
+}
+
+}  // namespace request_unraver
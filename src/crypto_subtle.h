@@ -0,0 +1,33 @@
+#ifndef REQUEST_UNRAVER_CRYPTO_SUBTLE_H_
+#define REQUEST_UNRAVER_CRYPTO_SUBTLE_H_
+
+#include <mutex>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// WebCrypto crypto.subtle (PSA / mbedtls)
+//
+//   digest: SHA-1, SHA-256, SHA-384, SHA-512
+//   importKey/exportKey: raw
+//   sign/verify: HMAC
+//   encrypt/decrypt: AES-CBC, AES-CTR, AES-GCM
+//
+// 연산은 동기로 수행하고 결과는 job queue 를 통해 Promise 로 전달한다.
+// (psa_crypto_init 은 runtime_init 에서 호출됨)
+JSValue NewCryptoSubtle(JSContext* ctx);
+
+// PSA key store 잠금
+//
+// mbedtls 는 MBEDTLS_THREADING_C 없이 빌드되므로 -mt 빌드에서 worker 들이 같은
+// key store 를 동시에 건드리면 안 된다. key 를 쓰는 연산(subtle sign/verify/
+// encrypt/decrypt)은 import 부터 destroy 까지, crypto_stream 은 import+setup 과
+// destroy 때 이 lock 을 잡는다. key 없는 hash 연산은 잠그지 않는다.
+std::mutex& PsaKeyMutex();
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_CRYPTO_SUBTLE_H_
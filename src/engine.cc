@@ -1,14 +1,21 @@
 #include "engine.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <map>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "crypto_stream.h"
+#include "crypto_subtle.h"
+#include "html_binding.h"
 #include "util.h"
 #include "wasm_binding.h"
+#include "zlib_stream.h"
 
 extern "C" {
 #include <cutils.h>
@@ -20,15 +27,17 @@ extern "C" {
 
 namespace request_unraver {
 
+static const char kSysfsPrefix[] = "sysfs:///";
+static const size_t kSysfsPrefixLen = sizeof(kSysfsPrefix) - 1;
 
 // QuickJS C 함수 바인딩을 위한 헬퍼
 // Runtime opaque 에 저장된 Engine 인스턴스를 사용하여 멤버 호출
 static JSValue JsConsoleLogBinding(JSContext* ctx, JSValueConst this_val,
-                                   int argc, JSValueConst* argv) {
+                                   int argc, JSValueConst* argv, int magic) {
   JSRuntime* rt = JS_GetRuntime(ctx);
   Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
   if (!eng) return JS_EXCEPTION;
-  return eng->JsConsoleLog(ctx, this_val, argc, argv);
+  return eng->JsConsoleLog(ctx, this_val, argc, argv, magic);
 }
 
 static JSValue JsRequireBinding(JSContext* ctx, JSValueConst this_val,
@@ -39,6 +48,16 @@ static JSValue JsRequireBinding(JSContext* ctx, JSValueConst this_val,
   return eng->JsRequire(ctx, this_val, argc, argv);
 }
 
+// 모듈별 require (func_data[0]: Engine::module_dirs_ index)
+static JSValue JsModuleRequireBinding(JSContext* ctx, JSValueConst this_val,
+                                      int argc, JSValueConst* argv, int magic,
+                                      JSValueConst* func_data) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
+  if (!eng) return JS_EXCEPTION;
+  return eng->JsModuleRequire(ctx, argc, argv, func_data[0]);
+}
+
 static JSValue JsSetTimeoutBinding(JSContext* ctx, JSValueConst this_val,
                                    int argc, JSValueConst* argv, int magic) {
   JSRuntime* rt = JS_GetRuntime(ctx);
@@ -55,13 +74,115 @@ static JSValue JsClearTimeoutBinding(JSContext* ctx, JSValueConst this_val,
   return eng->timer_manager()->ClearTimeoutImpl(ctx, this_val, argc, argv);
 }
 
+static JSValue JsSysHostIoSubmitBinding(JSContext* ctx, JSValueConst this_val,
+                                        int argc, JSValueConst* argv) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
+  if (!eng || !eng->io_manager()) return JS_EXCEPTION;
+  // 호스트 응답은 호출마다 달라질 수 있다
+  eng->NoteNondeterministic();
+  return eng->io_manager()->SubmitImpl(ctx, eng->host_handle(), Engine::HostWindow(ctx), this_val, argc, argv);
+}
+
+static JSValue JsSysHostCoverageHitBinding(JSContext* ctx, JSValueConst this_val,
+                                           int argc, JSValueConst* argv) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
+  if (!eng) return JS_EXCEPTION;
+  uint32_t id = 0;
+  if (argc < 1 || JS_ToUint32(ctx, &id, argv[0])) {
+    return JS_ThrowTypeError(ctx, "coverage_hit(id) expected");
+  }
+  eng->CoverageHit(id);
+  return JS_UNDEFINED;
+}
+
+static JSValue JsSysHostMarkUncacheableBinding(JSContext* ctx, JSValueConst this_val,
+                                               int argc, JSValueConst* argv) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
+  if (!eng) return JS_EXCEPTION;
+  eng->MarkUncacheable();
+  return JS_UNDEFINED;
+}
+
+// Date.now / Math.random wrapper (func_data[0]: 원래 함수)
+static JSValue JsUncacheableCallBinding(JSContext* ctx, JSValueConst this_val,
+                                        int argc, JSValueConst* argv, int magic,
+                                        JSValueConst* func_data) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
+  if (eng) {
+    eng->NoteNondeterministic();
+  }
+  return JS_Call(ctx, func_data[0], this_val, argc, argv);
+}
+
+static void WrapUncacheable(JSContext* ctx, JSValueConst global_obj,
+                            const char* object_name, const char* name) {
+  JSValue obj = JS_GetPropertyStr(ctx, global_obj, object_name);
+  JSValue original = JS_GetPropertyStr(ctx, obj, name);
+  if (JS_IsFunction(ctx, original)) {
+    JS_SetPropertyStr(ctx, obj, name,
+      JS_NewCFunctionData(ctx, JsUncacheableCallBinding, 0, 0, 1, &original));
+  }
+  JS_FreeValue(ctx, original);
+  JS_FreeValue(ctx, obj);
+}
+
+// __sys_host.trace(name, fn): fn 실행을 span 으로 기록. 꺼져 있으면 fn 만 호출
+static JSValue JsSysHostTraceBinding(JSContext* ctx, JSValueConst this_val,
+                                     int argc, JSValueConst* argv) {
+  if (argc < 2 || !JS_IsFunction(ctx, argv[1])) {
+    return JS_ThrowTypeError(ctx, "trace(name, fn) expected");
+  }
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(rt));
+  if (!eng || !eng->tracer()->enabled()) {
+    return JS_Call(ctx, argv[1], this_val, 0, nullptr);
+  }
+  size_t name_len = 0;
+  const char* name = JS_ToCStringLen(ctx, &name_len, argv[0]);
+  if (!name) {
+    return JS_EXCEPTION;
+  }
+  JSValue ret;
+  {
+    TraceScope trace(eng->tracer(), "guest", std::string_view(name, name_len));
+    ret = JS_Call(ctx, argv[1], this_val, 0, nullptr);
+  }
+  JS_FreeCString(ctx, name);
+  return ret;
+}
+
+static JSValue JsSysHostTraceEnabledBinding(JSContext* ctx, JSValueConst this_val,
+                                            int argc, JSValueConst* argv) {
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(JS_GetRuntime(ctx)));
+  return JS_NewBool(ctx, eng && eng->tracer()->enabled());
+}
+
+// 일정 bytecode 수마다 불린다. profiler 가 interval 이 지났을 때만 stack 을 뜬다
+static int ProfilerInterruptHandler(JSRuntime* rt, void* opaque) {
+  Engine* eng = static_cast<Engine*>(opaque);
+  eng->profiler()->MaybeSample(eng->running_context(), ru_get_now());
+  return 0;
+}
+
 static JSValue JsSysHostPerformanceNow(JSContext* ctx, JSValueConst this_val,
                                      int argc, JSValueConst* argv) {
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(JS_GetRuntime(ctx)));
+  if (eng) {
+    eng->NoteNondeterministic();
+  }
   return JS_NewFloat64(ctx, ru_get_now());
 }
 
 static JSValue JsSysHostCryptoGetRandomValues(JSContext* ctx, JSValueConst this_val,
                                      int argc, JSValueConst* argv) {
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(JS_GetRuntime(ctx)));
+  if (eng) {
+    eng->NoteNondeterministic();
+  }
   int typed = JS_GetTypedArrayType(argv[0]);
   if (JS_IsArrayBuffer(argv[0])) {
     size_t size = 0;
@@ -88,7 +209,20 @@ static JSValue JsSysHostCryptoGetRandomValues(JSContext* ctx, JSValueConst this_
 }
 
 
-Engine::Engine() : rt_(nullptr), ctx_(nullptr) {}
+// context 별 상태 (JS_SetContextOpaque)
+struct ContextState {
+  // require() module cache (key: real path atom)
+  std::unordered_map<JSAtom, JSValue> loaded_modules;
+  // window context 만 사용
+  WindowMemory memory;
+  // 호스트 I/O 요청에 실어 보내는 window 식별자 (window 생성 중에는 0)
+  uint64_t host_window = 0;
+};
+
+Engine::Engine() : rt_(nullptr), ctx_(nullptr), running_ctx_(nullptr), mode_(0), host_handle_(0),
+                   uncacheable_(false), eval_script_depth_(0),
+                   gc_headroom_(0), gc_live_after_(0), gc_saved_threshold_(0), request_depth_(0),
+                   gc_deferring_(false), next_pending_window_(0) {}
 
 Engine::~Engine() {
   Shutdown();
@@ -112,29 +246,278 @@ bool Engine::Init(uint32_t mode, std::shared_ptr<VfsManager> vfs_manager) {
     return false;
   }
 
-  RegisterGlobals();
+  io_manager_ = std::make_unique<IoManager>(rt_);
+  handle_table_ = std::make_unique<HandleTable>(rt_, FreeWindowContext);
+
+  mode_ = mode;
+  InitContext(ctx_);
+
+  return true;
+}
+
+void Engine::InitContext(JSContext* ctx) {
+  JS_SetContextOpaque(ctx, new ContextState());
+
+  RegisterGlobals(ctx);
 
   // Issue: https://github.com/quickjs-ng/quickjs/issues/774
   // Eval("Array.prototype.toString = Object.prototype.toString");
 
-  if (mode == ENGINE_MODE_MINI) {
-    Eval("require(\"sysfs:///pseudo-browser-mini.js\");");
-  } else if (mode == ENGINE_MODE_FULL) {
-    Eval("require(\"sysfs:///pseudo-browser-full.js\");");
+  const char* bundle = nullptr;
+  if (mode_ == ENGINE_MODE_MINI) {
+    bundle = "sysfs:///pseudo-browser-mini.js";
+  } else if (mode_ == ENGINE_MODE_FULL) {
+    bundle = "sysfs:///pseudo-browser-full.js";
+  }
+  if (bundle) {
+    JSValue v = LoadCjsModule(ctx, bundle, nullptr);
+    if (JS_IsException(v)) {
+      js_std_dump_error(ctx);
+    }
+    JS_FreeValue(ctx, v);
   }
+}
 
+std::unordered_map<JSAtom, JSValue>* Engine::LoadedModules(JSContext* ctx) {
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  return state ? &state->loaded_modules : nullptr;
+}
+
+void Engine::FreeContextState(JSContext* ctx) {
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  if (!state) {
+    return;
+  }
+  JS_SetContextOpaque(ctx, nullptr);
+  for (auto& item : state->loaded_modules) {
+    JS_FreeAtom(ctx, item.first);
+    JS_FreeValue(ctx, item.second);
+  }
+  delete state;
+}
+
+void Engine::FreeWindowContext(JSContext* ctx) {
+  Engine* eng = static_cast<Engine*>(JS_GetRuntimeOpaque(JS_GetRuntime(ctx)));
+  if (eng) {
+    // 해제된 window 의 콜백이 나중에 실행되지 않도록 한다
+    if (eng->timer_manager_) {
+      eng->timer_manager_->CancelContext(ctx);
+    }
+    if (eng->io_manager_) {
+      eng->io_manager_->CancelContext(ctx);
+    }
+  }
+  FreeContextState(ctx);
+  // 이미 등록된 promise job 등이 realm 참조를 가지고 있으면 그 해제 시점까지 유지된다.
+  // 그 사이 require() 는 LoadedModules 가 nullptr 이므로 예외가 된다
+  JS_FreeContext(ctx);
+}
+
+JSContext* Engine::NewWindowContext() {
+  TraceScope trace(&tracer_, "engine", "newWindowContext");
+  size_t live_before = LiveBytes();
+  double begin = ru_get_now();
+  JSContext* ctx = JS_NewContext(rt_);
+  if (!ctx) {
+    return nullptr;
+  }
+  // 같은 runtime 이므로 atom table 을 공유하고, 모듈은 bytecode_cache_ 에서 읽는다
+  {
+    RunningContextScope running(this, ctx);
+    InitContext(ctx);
+  }
+
+  size_t live_after = LiveBytes();
+  double init_ms = ru_get_now() - begin;
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  state->memory.context_bytes = live_after > live_before ? live_after - live_before : 0;
+  context_stats_.created++;
+  context_stats_.total_init_ms += init_ms;
+  context_stats_.max_init_ms = std::max(context_stats_.max_init_ms, init_ms);
+  context_stats_.total_bytes += state->memory.context_bytes;
+  state->memory.peak_bytes = static_cast<int64_t>(state->memory.context_bytes);
+  if (!leak_tracker_.has_baseline()) {
+    JSValue global = JS_GetGlobalObject(ctx);
+    leak_tracker_.SetBaseline(ctx, global);
+    JS_FreeValue(ctx, global);
+  }
+  return ctx;
+}
+
+size_t Engine::LiveBytes() const {
+  const EngineAllocator::Stats& stats = allocator_->stats();
+  return stats.small_bytes + stats.large_bytes;
+}
+
+void Engine::ChargeContext(JSContext* ctx, size_t live_before) {
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  if (!state) {
+    return;
+  }
+  state->memory.Charge(static_cast<int64_t>(LiveBytes()) - static_cast<int64_t>(live_before));
+}
+
+const WindowMemory* Engine::ContextMemory(JSContext* ctx) {
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  return state ? &state->memory : nullptr;
+}
+
+uint64_t Engine::HostWindow(JSContext* ctx) {
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  return state ? state->host_window : 0;
+}
+
+void Engine::SetHostWindow(JSContext* ctx, uint64_t window) {
+  ContextState* state = static_cast<ContextState*>(JS_GetContextOpaque(ctx));
+  if (state) {
+    state->host_window = window;
+  }
+}
+
+bool Engine::DestroyWindow(uint32_t handle) {
+  JSValue window;
+  JSContext* ctx = nullptr;
+  if (!handle_table_->Lookup(handle, kHandleWindow, &window, &ctx)) {
+    return false;
+  }
+  const WindowMemory* memory = ContextMemory(ctx);
+  JSValue global = JS_GetGlobalObject(ctx);
+  leak_tracker_.Track(ctx_, handle, global, memory ? *memory : WindowMemory());
+  JS_FreeValue(ctx, global);
+
+  // 순환 참조는 다음 GC 에서 회수되므로 여기서는 refcount 로 바로 해제된 양만 보인다
+  size_t live_before = LiveBytes();
+  handle_table_->Release(handle, kHandleWindow);
+  leak_tracker_.SetFreed(static_cast<int64_t>(live_before) - static_cast<int64_t>(LiveBytes()));
   return true;
 }
 
+size_t Engine::ReleaseAllWindows() {
+  size_t count = 0;
+  for (uint32_t handle : handle_table_->Handles(kHandleWindow)) {
+    if (DestroyWindow(handle)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+bool Engine::CollectGarbage(GcMode mode, msgpack::packer<msgpack::sbuffer>* pk) {
+  // 할당이 적은 engine 도 너무 자주 돌지 않도록
+  static constexpr size_t kMinGcBudget = 256 * 1024;
+
+  size_t live_before = LiveBytes();
+  size_t budget = std::max(kMinGcBudget, gc_live_after_ / 4);
+  bool collect = mode == kGcFull || live_before >= gc_live_after_ + budget;
+  double pause_ms = 0;
+  size_t live_after = live_before;
+
+  if (collect) {
+    double begin = ru_get_now();
+    JS_RunGC(rt_);
+    // GC 로 비게 된 chunk 를 malloc 으로 반환
+    allocator_->Trim();
+    pause_ms = ru_get_now() - begin;
+    live_after = LiveBytes();
+    gc_live_after_ = live_after;
+
+    gc_stats_.collections++;
+    gc_stats_.freed_bytes += live_before > live_after ? live_before - live_after : 0;
+    gc_stats_.total_pause_ms += pause_ms;
+    gc_stats_.last_pause_ms = pause_ms;
+    gc_stats_.max_pause_ms = std::max(gc_stats_.max_pause_ms, pause_ms);
+
+    // QuickJS 가 자동 GC 후 하는 것처럼 다음 자동 GC 를 live 의 1.5 배로 미룬다
+    size_t threshold = live_after + std::max(kMinGcBudget, live_after / 2);
+    if (gc_deferring_) {
+      // 요청이 끝날 때 복원될 값
+      gc_saved_threshold_ = threshold;
+    } else {
+      JS_SetGCThreshold(rt_, threshold);
+    }
+  } else {
+    gc_stats_.skipped++;
+  }
+
+  if (pk) {
+    pk->pack_map(4);
+    pk->pack("collected");
+    pk->pack(collect);
+    pk->pack("pauseMs");
+    pk->pack_double(pause_ms);
+    pk->pack("freedBytes");
+    pk->pack_uint64(live_before > live_after ? live_before - live_after : 0);
+    pk->pack("liveBytes");
+    pk->pack_uint64(live_after);
+  }
+  return collect;
+}
+
+void Engine::BeginRequest() {
+  if (request_depth_++ > 0 || gc_headroom_ == 0) {
+    return;
+  }
+  size_t threshold = JS_GetGCThreshold(rt_);
+  size_t raised = LiveBytes() + gc_headroom_;
+  if (raised > threshold) {
+    gc_saved_threshold_ = threshold;
+    gc_deferring_ = true;
+    gc_stats_.deferred_requests++;
+    JS_SetGCThreshold(rt_, raised);
+  }
+}
+
+void Engine::EndRequest() {
+  if (--request_depth_ > 0 || !gc_deferring_) {
+    return;
+  }
+  gc_deferring_ = false;
+  JS_SetGCThreshold(rt_, gc_saved_threshold_);
+}
+
+void Engine::LeakReport(msgpack::packer<msgpack::sbuffer>* pk) {
+  CollectGarbage(kGcFull, nullptr);
+
+  JSMemoryUsage usage;
+  JS_ComputeMemoryUsage(rt_, &usage);
+
+  pk->pack_map(2);
+  pk->pack("heap");
+  pk->pack_map(6);
+  pk->pack("mallocSize");
+  pk->pack_int64(usage.malloc_size);
+  pk->pack("mallocCount");
+  pk->pack_int64(usage.malloc_count);
+  pk->pack("memoryUsedSize");
+  pk->pack_int64(usage.memory_used_size);
+  pk->pack("objCount");
+  pk->pack_int64(usage.obj_count);
+  pk->pack("strCount");
+  pk->pack_int64(usage.str_count);
+  pk->pack("jsFuncCount");
+  pk->pack_int64(usage.js_func_count);
+  pk->pack("windows");
+  leak_tracker_.Report(ctx_, pk);
+}
+
 void Engine::Shutdown() {
-  for (auto iter = loaded_modules_.begin(); iter != loaded_modules_.end(); ) {
-    JS_FreeValue(ctx_, iter->second);
-    iter = loaded_modules_.erase(iter);
+  if (ctx_) {
+    leak_tracker_.Clear(ctx_);
+    FreeContextState(ctx_);
   }
 
   if (rt_) {
+    // 끝나지 않은 streaming window
+    for (auto& item : pending_windows_) {
+      FreePendingWindow(&item.second);
+    }
+    pending_windows_.clear();
+    // 호스트가 해제하지 않은 window 등 정리
+    handle_table_.reset();
     // TimerManager 소멸자가 타이머 정리
     timer_manager_.reset();
+    // 완료되지 않은 I/O 의 resolve 함수 해제
+    io_manager_.reset();
 
     // Runtime opaque 해제
     JS_SetRuntimeOpaque(rt_, nullptr);
@@ -148,10 +531,14 @@ void Engine::Shutdown() {
     JS_FreeRuntime(rt_);
     rt_ = nullptr;
   }
+  // runtime 이 사용한 chunk 를 한꺼번에 반환
+  allocator_.reset();
+  bytecode_cache_.clear();
 }
 
 bool Engine::InitializeRuntime() {
-  rt_ = JS_NewRuntime();
+  allocator_ = std::make_unique<EngineAllocator>();
+  rt_ = JS_NewRuntime2(&EngineAllocator::kMallocFunctions, allocator_.get());
   if (!rt_) {
     fprintf(stderr, "Failed to create QuickJS runtime.\n");
     return false;
@@ -173,67 +560,119 @@ bool Engine::InitializeRuntime() {
   return true;
 }
 
-void Engine::RegisterGlobals() {
-  JSValue global_obj = JS_GetGlobalObject(ctx_);
+void Engine::StartProfile(double interval_ms) {
+  profiler_.Start(ru_get_now(), interval_ms);
+  JS_SetInterruptHandler(rt_, ProfilerInterruptHandler, this);
+}
+
+void Engine::StopProfile(msgpack::packer<msgpack::sbuffer>* pk) {
+  JS_SetInterruptHandler(rt_, nullptr, nullptr);
+  profiler_.Stop(ru_get_now(), pk);
+}
+
+void Engine::RegisterGlobals(JSContext* ctx) {
+  JSValue global_obj = JS_GetGlobalObject(ctx);
   JSValue v;
 
   // setTimeout/setInterval
-  JS_SetPropertyStr(ctx_, global_obj, "setTimeout",
-                    JS_NewCFunctionMagic(ctx_, JsSetTimeoutBinding, "setTimeout", 2,
+  JS_SetPropertyStr(ctx, global_obj, "setTimeout",
+                    JS_NewCFunctionMagic(ctx, JsSetTimeoutBinding, "setTimeout", 2,
                                          JS_CFUNC_generic_magic, 0));
-  JS_SetPropertyStr(ctx_, global_obj, "setInterval",
-                    JS_NewCFunctionMagic(ctx_, JsSetTimeoutBinding, "setInterval", 2,
+  JS_SetPropertyStr(ctx, global_obj, "setInterval",
+                    JS_NewCFunctionMagic(ctx, JsSetTimeoutBinding, "setInterval", 2,
                                          JS_CFUNC_generic_magic, 1));
 
   // clearTimeout/clearInterval
-  JS_SetPropertyStr(ctx_, global_obj, "clearTimeout",
-                    JS_NewCFunction(ctx_, JsClearTimeoutBinding, "clearTimeout",
+  JS_SetPropertyStr(ctx, global_obj, "clearTimeout",
+                    JS_NewCFunction(ctx, JsClearTimeoutBinding, "clearTimeout",
                                     1));
-  JS_SetPropertyStr(ctx_, global_obj, "clearInterval",
-                    JS_NewCFunction(ctx_, JsClearTimeoutBinding, "clearInterval",
+  JS_SetPropertyStr(ctx, global_obj, "clearInterval",
+                    JS_NewCFunction(ctx, JsClearTimeoutBinding, "clearInterval",
                                     1));
 
   // __sys_host
-  JSValue sys_host = JS_NewObject(ctx_);
+  JSValue sys_host = JS_NewObject(ctx);
 
-  JS_SetPropertyStr(ctx_, sys_host, "performance_now",
-    JS_NewCFunction(ctx_, JsSysHostPerformanceNow, "performance_now", 0));
+  JS_SetPropertyStr(ctx, sys_host, "performance_now",
+    JS_NewCFunction(ctx, JsSysHostPerformanceNow, "performance_now", 0));
 
-  JS_SetPropertyStr(ctx_, sys_host, "crypto_getRandomValues",
-    JS_NewCFunction(ctx_, JsSysHostCryptoGetRandomValues, "crypto_getRandomValues", 1));
+  JS_SetPropertyStr(ctx, sys_host, "crypto_getRandomValues",
+    JS_NewCFunction(ctx, JsSysHostCryptoGetRandomValues, "crypto_getRandomValues", 1));
 
-  JS_SetPropertyStr(ctx_, global_obj, "__sys_host", sys_host);
+  // node:crypto createHash/createHmac/createCipheriv
+  RegisterCryptoStream(ctx, sys_host);
 
-  // crypto
-  JSValue crypto_obj = JS_NewObject(ctx_);
-  JS_SetPropertyStr(ctx_, crypto_obj, "getRandomValues",
-    JS_NewCFunction(ctx_, JsSysHostCryptoGetRandomValues, "getRandomValues", 1));
-  JS_SetPropertyStr(ctx_, global_obj, "crypto", crypto_obj);
+  // node:zlib inflate/deflate/gzip
+  RegisterZlibStream(ctx, sys_host);
+
+  // DOMParser / createWindow 용 native HTML parser
+  RegisterHtmlDom(ctx, sys_host);
+
+  JS_SetPropertyStr(ctx, sys_host, "io_submit",
+    JS_NewCFunction(ctx, JsSysHostIoSubmitBinding, "io_submit", 3));
+
+  JS_SetPropertyStr(ctx, sys_host, "coverage_hit",
+    JS_NewCFunction(ctx, JsSysHostCoverageHitBinding, "coverage_hit", 1));
 
-  // console 객체
-  JSValue console_obj = JS_NewObject(ctx_);
-  JS_SetPropertyStr(ctx_, console_obj, "log",
-                    JS_NewCFunction(ctx_, JsConsoleLogBinding, "log", 1));
-  JS_SetPropertyStr(ctx_, global_obj, "console", console_obj);
+  JS_SetPropertyStr(ctx, sys_host, "trace",
+    JS_NewCFunction(ctx, JsSysHostTraceBinding, "trace", 2));
+  JS_SetPropertyStr(ctx, sys_host, "trace_enabled",
+    JS_NewCFunction(ctx, JsSysHostTraceEnabledBinding, "trace_enabled", 0));
 
-  JS_SetPropertyStr(ctx_, global_obj, "require",
-    JS_NewCFunction(ctx_, JsRequireBinding, "require", 1));
+  JS_SetPropertyStr(ctx, sys_host, "mark_uncacheable",
+    JS_NewCFunction(ctx, JsSysHostMarkUncacheableBinding, "mark_uncacheable", 0));
 
-  v = LoadCjsModule(ctx_, "sysfs:///init.js", nullptr, true);
+  JS_SetPropertyStr(ctx, global_obj, "__sys_host", sys_host);
+
+  // crypto
+  JSValue crypto_obj = JS_NewObject(ctx);
+  JS_SetPropertyStr(ctx, crypto_obj, "getRandomValues",
+    JS_NewCFunction(ctx, JsSysHostCryptoGetRandomValues, "getRandomValues", 1));
+  JS_SetPropertyStr(ctx, crypto_obj, "subtle", NewCryptoSubtle(ctx));
+  JS_SetPropertyStr(ctx, global_obj, "crypto", crypto_obj);
+
+  // 결과 캐시: browserEval 스크립트가 시계/난수를 읽으면 캐시하지 않는다 (new Date() 는 제외)
+  WrapUncacheable(ctx, global_obj, "Date", "now");
+  WrapUncacheable(ctx, global_obj, "Math", "random");
+
+  // console 객체 (engine LogBuffer 에 level 과 함께 저장)
+  static const struct {
+    const char* name;
+    LogLevel level;
+  } kConsoleMethods[] = {
+    {"debug", kLogDebug},
+    {"trace", kLogDebug},
+    {"log", kLogInfo},
+    {"info", kLogInfo},
+    {"warn", kLogWarn},
+    {"error", kLogError},
+  };
+  JSValue console_obj = JS_NewObject(ctx);
+  for (const auto& method : kConsoleMethods) {
+    JS_SetPropertyStr(ctx, console_obj, method.name,
+                      JS_NewCFunctionMagic(ctx, JsConsoleLogBinding, method.name, 1,
+                                           JS_CFUNC_generic_magic, (int) method.level));
+  }
+  JS_SetPropertyStr(ctx, global_obj, "console", console_obj);
+
+  JS_SetPropertyStr(ctx, global_obj, "require",
+    JS_NewCFunction(ctx, JsRequireBinding, "require", 1));
+
+  v = LoadCjsModule(ctx, "sysfs:///init.js", nullptr, true);
   if (JS_IsException(v)) {
-    js_std_dump_error(ctx_);
+    js_std_dump_error(ctx);
   }
-  JS_FreeValue(ctx_, v);
+  JS_FreeValue(ctx, v);
 
-  v = LoadCjsModule(ctx_, "node:url", nullptr, true);
+  v = LoadCjsModule(ctx, "node:url", nullptr, true);
   if (JS_IsException(v)) {
-    js_std_dump_error(ctx_);
-    JS_FreeValue(ctx_, v);
+    js_std_dump_error(ctx);
+    JS_FreeValue(ctx, v);
   } else {
-    JS_SetPropertyStr(ctx_, global_obj, "URL", v);
+    JS_SetPropertyStr(ctx, global_obj, "URL", v);
   }
 
-  JS_FreeValue(ctx_, global_obj);
+  JS_FreeValue(ctx, global_obj);
 }
 
 // Helper functions for require()
@@ -560,15 +999,32 @@ JSValue Engine::LoadCjsModule(JSContext* ctx, const char* path, const char* cont
     real_path.append(".js");
   }
 
-  // fprintf(stderr, "LoadCjsModule: %s (%d)\n", real_path.c_str(), loaded_modules_.count(real_path));
-  if (loaded_modules_.count(real_path)) {
-    return JS_DupValue(ctx, loaded_modules_[real_path]);
+  // atom 으로 intern 된 경로를 key 로 사용 (문자열 비교/복사 없음)
+  std::unordered_map<JSAtom, JSValue>* loaded_modules_ptr = LoadedModules(ctx);
+  if (!loaded_modules_ptr) {
+    return JS_ThrowReferenceError(ctx, "Cannot load module '%s': window destroyed", path);
+  }
+  std::unordered_map<JSAtom, JSValue>& loaded_modules = *loaded_modules_ptr;
+  JSAtom module_key = JS_NewAtomLen(ctx, real_path.data(), real_path.length());
+  if (module_key == JS_ATOM_NULL) {
+    return JS_EXCEPTION;
+  }
+  auto loaded = loaded_modules.find(module_key);
+  if (loaded != loaded_modules.end()) {
+    JS_FreeAtom(ctx, module_key);
+    return JS_DupValue(ctx, loaded->second);
   }
+  TraceScope trace(&tracer_, "module", real_path);
 
-  std::unique_ptr<FileBuffer> file_buffer;
-  if (!content) {
+  // content 를 직접 받은 경우는 같은 경로라도 내용이 다를 수 있어 캐시를 쓰지 않는다
+  auto cached = content ? bytecode_cache_.end() : bytecode_cache_.find(real_path);
+
+  bool content_given = content != nullptr;
+  std::shared_ptr<const FileBuffer> file_buffer;
+  if (!content && cached == bytecode_cache_.end()) {
     file_buffer = vfs_manager_->ReadVfsFile(real_path.c_str() + 9);
     if (!file_buffer) {
+      JS_FreeAtom(ctx, module_key);
       return JS_ThrowReferenceError(ctx, "Cannot read module file '%s'", path);
     }
     content = (const char*)&file_buffer->data[0];
@@ -582,24 +1038,41 @@ JSValue Engine::LoadCjsModule(JSContext* ctx, const char* path, const char* cont
 
   // Prepare context for module evaluation
   JSValue global_obj = JS_GetGlobalObject(ctx);
-  JSValue require_func = JS_GetPropertyStr(ctx, global_obj, "require");
+  // standalone 모듈은 전역 require, 그 외는 모듈 디렉토리 기준 require
+  JSValue require_func = standalone
+    ? JS_GetPropertyStr(ctx, global_obj, "require")
+    : NewModuleRequire(ctx, real_path);
 
   do {
-    std::string dirname = Basename(path);
-
-    // Module wrapper function (CommonJS style)
-    std::string script_template;
-    if (standalone) {
-      script_template = "(function (exports, global, require, module, __filename, __dirname) { ";
+    std::string dirname = ModuleDir(real_path);
+
+    JSValue module_func;
+    if (cached != bytecode_cache_.end()) {
+      // 다른 context 에서 컴파일된 wrapper 재사용 (파싱 생략)
+      module_func = JS_ReadObject(ctx, cached->second.data(), cached->second.size(), JS_READ_OBJ_BYTECODE);
+      if (!JS_IsException(module_func)) {
+        module_func = JS_EvalFunction(ctx, module_func);
+      }
     } else {
-      script_template = "(function (exports, global, __orig_require, module, __filename, __dirname) { ";
-      script_template += "const require = globalThis.__sys_wrapped_require(__orig_require, __filename); ";
+      // Module wrapper function (CommonJS style)
+      std::string script_template = "(function (exports, global, require, module, __filename, __dirname) { ";
+      script_template.append(content, content_len);
+      script_template += "\n})";
+
+      module_func = JS_Eval(ctx, script_template.c_str(), script_template.length(),
+                            path, JS_EVAL_FLAG_STRICT | JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+      if (!JS_IsException(module_func)) {
+        size_t bytecode_len = 0;
+        uint8_t* bytecode = JS_WriteObject(ctx, &bytecode_len, module_func, JS_WRITE_OBJ_BYTECODE);
+        if (bytecode) {
+          if (!content_given) {
+            bytecode_cache_.emplace(real_path, std::vector<uint8_t>(bytecode, bytecode + bytecode_len));
+          }
+          js_free(ctx, bytecode);
+        }
+        module_func = JS_EvalFunction(ctx, module_func);
+      }
     }
-    script_template.append(content, content_len);
-    script_template += "\n})";
-
-    JSValue module_func = JS_Eval(ctx, script_template.c_str(), script_template.length(),
-                                  path, JS_EVAL_FLAG_STRICT | JS_EVAL_TYPE_GLOBAL);
 
     if (JS_IsException(module_func)) {
       return_value = JS_EXCEPTION;
@@ -632,12 +1105,16 @@ JSValue Engine::LoadCjsModule(JSContext* ctx, const char* path, const char* cont
     // Get the exports from the module object
     JSValue final_exports = JS_GetPropertyStr(ctx, module_obj, "exports");
 
-    // Cache the module
-    loaded_modules_[real_path] = final_exports;
+    // Cache the module (module_key 소유권 이전)
+    loaded_modules.emplace(module_key, final_exports);
+    module_key = JS_ATOM_NULL;
 
     return_value = JS_DupValue(ctx, final_exports);
   } while (0);
 
+  if (module_key != JS_ATOM_NULL) {
+    JS_FreeAtom(ctx, module_key);
+  }
   JS_FreeValue(ctx, module_obj);
   JS_FreeValue(ctx, exports_obj);
   JS_FreeValue(ctx, global_obj);
@@ -645,8 +1122,89 @@ JSValue Engine::LoadCjsModule(JSContext* ctx, const char* path, const char* cont
   return return_value;
 }
 
-JSValue Engine::CreateWindow(const char* content, const uint8_t *windowOptions_msgp, int windowOptions_len) {
-  JSContext* ctx = ctx_;
+JSValue Engine::NewModuleRequire(JSContext* ctx, const std::string& filename) {
+  std::string dirname = ModuleDir(filename);
+  auto iter = module_dir_index_.find(dirname);
+  int32_t index;
+  if (iter != module_dir_index_.end()) {
+    index = iter->second;
+  } else {
+    index = (int32_t) module_dirs_.size();
+    module_dirs_.push_back(dirname);
+    module_dir_index_.emplace(dirname, index);
+  }
+
+  JSValue data = JS_NewInt32(ctx, index);
+  JSValue func = JS_NewCFunctionData(ctx, JsModuleRequireBinding, 1, 0, 1, &data);
+  JS_FreeValue(ctx, data);
+  return func;
+}
+
+std::string Engine::ModuleDir(const std::string& filename) {
+  // Basename 은 "sysfs:///a.js" 를 "sysfs://" 로 자르므로 scheme 을 떼고 자른다
+  if (!starts_with(filename, kSysfsPrefix)) {
+    return Basename(filename);
+  }
+  size_t slash = filename.rfind('/');
+  if (slash < kSysfsPrefixLen) {
+    return kSysfsPrefix;
+  }
+  return filename.substr(0, slash);
+}
+
+// "./x", "../x" 를 dir 기준으로 정규화 (url.resolve 와 같은 결과)
+//   - scheme 이 없는 dir ("", "." 포함) 은 sysfs root 기준
+std::string Engine::ResolveRelative(const std::string& dir, const char* name, size_t name_len) {
+  std::string prefix = kSysfsPrefix;
+  std::vector<std::string_view> segments;
+
+  std::string_view base(dir);
+  if (starts_with(dir, kSysfsPrefix)) {
+    base.remove_prefix(kSysfsPrefixLen);
+  }
+
+  auto push_segments = [&segments](std::string_view path) {
+    while (!path.empty()) {
+      size_t slash = path.find('/');
+      std::string_view segment = path.substr(0, slash);
+      if (segment == "..") {
+        if (!segments.empty()) {
+          segments.pop_back();
+        }
+      } else if (!segment.empty() && segment != ".") {
+        segments.push_back(segment);
+      }
+      if (slash == std::string_view::npos) {
+        break;
+      }
+      path.remove_prefix(slash + 1);
+    }
+  };
+  push_segments(base);
+  push_segments(std::string_view(name, name_len));
+
+  std::string resolved = prefix;
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (i > 0) {
+      resolved += '/';
+    }
+    resolved.append(segments[i].data(), segments[i].size());
+  }
+  return resolved;
+}
+
+JSValue Engine::CreateWindow(const char* content, size_t content_len, const uint8_t *windowOptions_msgp, int windowOptions_len,
+                             JSContext** out_ctx) {
+  TraceScope trace(&tracer_, "engine", "createWindow");
+  *out_ctx = nullptr;
+
+  // window 마다 별도 global 을 가지도록 새 context 에서 생성
+  JSContext* ctx = NewWindowContext();
+  if (!ctx) {
+    return JS_ThrowOutOfMemory(ctx_);
+  }
+  RunningContextScope running(this, ctx);
+  size_t live_before = LiveBytes();
 
   std::string script_template;
   script_template =  "(function (global, content, windowOptions) {\n";
@@ -657,17 +1215,16 @@ JSValue Engine::CreateWindow(const char* content, const uint8_t *windowOptions_m
                                 "<create-window>", JS_EVAL_FLAG_STRICT | JS_EVAL_TYPE_GLOBAL);
 
   if (JS_IsException(module_func)) {
-    JS_FreeValue(ctx, module_func);
-    return JS_EXCEPTION;
+    return FailWindowContext(ctx);
   }
 
   // Call the module function
   JSValueConst module_args[3] = {
     JS_GetGlobalObject(ctx),
-    JS_NewString(ctx, content ? content : ""),
+    JS_NewStringLen(ctx, content ? content : "", content ? content_len : 0),
     windowOptions_msgp ? JS_NewArrayBufferCopy(ctx, windowOptions_msgp, windowOptions_len) : JS_NULL,
   };
-  JSValue ret_val = JS_Call(ctx, module_func, JS_UNDEFINED, 6, module_args);
+  JSValue ret_val = JS_Call(ctx, module_func, JS_UNDEFINED, 3, module_args);
 
   JS_FreeValue(ctx, module_func);
   JS_FreeValue(ctx, module_args[0]); // global
@@ -675,28 +1232,189 @@ JSValue Engine::CreateWindow(const char* content, const uint8_t *windowOptions_m
   JS_FreeValue(ctx, module_args[2]); // windowOptions
 
   if (JS_IsException(ret_val)) {
-    JS_FreeValue(ctx, ret_val);
-    return JS_EXCEPTION;
+    return FailWindowContext(ctx);
   }
 
+  ChargeContext(ctx, live_before);
+  *out_ctx = ctx;
   return ret_val;
 }
 
+uint32_t Engine::BeginWindow(const uint8_t* windowOptions_msgp, int windowOptions_len, size_t size_hint) {
+  TraceScope trace(&tracer_, "engine", "windowBegin");
+  JSContext* ctx = NewWindowContext();
+  if (!ctx) {
+    JS_ThrowOutOfMemory(ctx_);
+    return 0;
+  }
+  RunningContextScope running(this, ctx);
+  size_t live_before = LiveBytes();
+
+  // options 는 한 번만 해석하고, DOM 종류에 따라 content 를 받는 방법을 정한다
+  static const char kScript[] =
+    "(function (windowOptions) {\n"
+    "const options = windowOptions ? __sys.munpack(windowOptions) : {};\n"
+    "return [options, __sys.windowUsesNativeDom(options)];\n"
+    "})";
+  JSValue func = JS_Eval(ctx, kScript, sizeof(kScript) - 1, "<window-begin>",
+                         JS_EVAL_FLAG_STRICT | JS_EVAL_TYPE_GLOBAL);
+  if (JS_IsException(func)) {
+    FailWindowContext(ctx);
+    return 0;
+  }
+  JSValue arg = windowOptions_msgp ? JS_NewArrayBufferCopy(ctx, windowOptions_msgp, windowOptions_len) : JS_NULL;
+  JSValue ret = JS_Call(ctx, func, JS_UNDEFINED, 1, &arg);
+  JS_FreeValue(ctx, func);
+  JS_FreeValue(ctx, arg);
+  if (JS_IsException(ret)) {
+    FailWindowContext(ctx);
+    return 0;
+  }
+
+  PendingWindow pending;
+  pending.ctx = ctx;
+  pending.options = JS_GetPropertyUint32(ctx, ret, 0);
+  JSValue native_dom = JS_GetPropertyUint32(ctx, ret, 1);
+  if (JS_ToBool(ctx, native_dom)) {
+    pending.parser = std::make_unique<HtmlDocumentParser>(JS_GetRuntime(ctx), size_hint);
+  } else {
+    pending.content.reserve(size_hint);
+  }
+  JS_FreeValue(ctx, native_dom);
+  JS_FreeValue(ctx, ret);
+  ChargeContext(ctx, live_before);
+
+  uint32_t id = ++next_pending_window_;
+  if (id == 0) {
+    id = ++next_pending_window_;
+  }
+  pending_windows_.emplace(id, std::move(pending));
+  return id;
+}
+
+bool Engine::WriteWindow(uint32_t stream_id, const char* data, size_t len) {
+  auto it = pending_windows_.find(stream_id);
+  if (it == pending_windows_.end()) {
+    return false;
+  }
+  PendingWindow& pending = it->second;
+  if (pending.parser) {
+    pending.parser->Feed(data, len);
+  } else {
+    pending.content.append(data, len);
+  }
+  return true;
+}
+
+JSValue Engine::EndWindow(uint32_t stream_id, JSContext** out_ctx) {
+  TraceScope trace(&tracer_, "engine", "windowEnd");
+  *out_ctx = nullptr;
+
+  auto it = pending_windows_.find(stream_id);
+  if (it == pending_windows_.end()) {
+    return JS_ThrowReferenceError(ctx_, "window stream %u not found", stream_id);
+  }
+  PendingWindow pending = std::move(it->second);
+  pending_windows_.erase(it);
+  JSContext* ctx = pending.ctx;
+  RunningContextScope running(this, ctx);
+  size_t live_before = LiveBytes();
+
+  JSValue content;
+  if (pending.parser) {
+    HtmlDocumentPtr doc = pending.parser->Finish();
+    pending.parser.reset();
+    content = doc ? NewHtmlDocumentObject(ctx, std::move(doc)) : JS_ThrowOutOfMemory(ctx);
+  } else {
+    content = JS_NewStringLen(ctx, pending.content.data(), pending.content.size());
+    std::string().swap(pending.content);
+  }
+  if (JS_IsException(content)) {
+    JS_FreeValue(ctx, pending.options);
+    return FailWindowContext(ctx);
+  }
+
+  static const char kScript[] =
+    "(function (content, windowOptions) {\n"
+    "return __sys.createWindow(typeof content === 'string' ? content : __sys.adoptHTMLDocument(content), windowOptions);\n"
+    "})";
+  JSValue func = JS_Eval(ctx, kScript, sizeof(kScript) - 1, "<window-end>",
+                         JS_EVAL_FLAG_STRICT | JS_EVAL_TYPE_GLOBAL);
+  JSValue ret = func;
+  if (!JS_IsException(func)) {
+    JSValueConst args[2] = {
+      content,
+      pending.options,
+    };
+    ret = JS_Call(ctx, func, JS_UNDEFINED, 2, args);
+    JS_FreeValue(ctx, func);
+  }
+  JS_FreeValue(ctx, content);
+  JS_FreeValue(ctx, pending.options);
+
+  if (JS_IsException(ret)) {
+    return FailWindowContext(ctx);
+  }
+
+  ChargeContext(ctx, live_before);
+  *out_ctx = ctx;
+  return ret;
+}
+
+bool Engine::AbortWindow(uint32_t stream_id) {
+  auto it = pending_windows_.find(stream_id);
+  if (it == pending_windows_.end()) {
+    return false;
+  }
+  FreePendingWindow(&it->second);
+  pending_windows_.erase(it);
+  return true;
+}
+
+void Engine::FreePendingWindow(PendingWindow* pending) {
+  // 만들던 문서는 runtime allocator 를 쓰므로 context 보다 먼저 해제
+  pending->parser.reset();
+  JS_FreeValue(pending->ctx, pending->options);
+  FreeWindowContext(pending->ctx);
+}
+
+JSValue Engine::FailWindowContext(JSContext* ctx) {
+  // 예외는 runtime 단위이므로 context 해제 후 engine context 에서 다시 throw
+  JSValue exception = JS_GetException(ctx);
+  FreeWindowContext(ctx);
+  return JS_Throw(ctx_, exception);
+}
+
 JSValue Engine::JsConsoleLog(JSContext* ctx, JSValueConst this_val, int argc,
-                             JSValueConst* argv) {
+                             JSValueConst* argv, int magic) {
+  LogLevel level = static_cast<LogLevel>(magic);
+  // 꺼진 level 은 인자를 문자열로 바꾸지도 않는다
+  if (!log_buffer_.Enabled(level)) {
+    return JS_UNDEFINED;
+  }
+
+  std::string line;
   for (int i = 0; i < argc; i++) {
     if (i > 0) {
-      printf(" ");
+      line += ' ';
     }
 
-    const char* str = JS_ToCString(ctx, argv[i]);
+    size_t len = 0;
+    const char* str = JS_ToCStringLen(ctx, &len, argv[i]);
     if (str) {
-      printf("%s", str);
+      line.append(str, len);
       JS_FreeCString(ctx, str);
+    } else {
+      // toString 에서 throw 된 예외는 console 호출 밖으로 내보내지 않는다.
+      // interrupt (timeout/abort) 같은 uncatchable 예외는 그대로 전파
+      JSValue exception = JS_GetException(ctx);
+      if (JS_IsUncatchableError(ctx, exception)) {
+        return JS_Throw(ctx, exception);
+      }
+      JS_FreeValue(ctx, exception);
     }
   }
-  printf("\n");
-  fflush(stdout);
+  log_buffer_.Append(level, std::move(line));
   return JS_UNDEFINED;
 }
 
@@ -717,10 +1435,40 @@ JSValue Engine::JsRequire(JSContext* ctx, JSValueConst this_val, int argc,
   return m;
 }
 
+JSValue Engine::JsModuleRequire(JSContext* ctx, int argc, JSValueConst* argv,
+                                JSValueConst dir_index) {
+  if (argc < 1) {
+    return JS_ThrowTypeError(ctx, "require() expects module name");
+  }
+
+  int32_t index = 0;
+  if (JS_ToInt32(ctx, &index, dir_index) || index < 0 || (size_t) index >= module_dirs_.size()) {
+    return JS_ThrowInternalError(ctx, "require(): invalid module directory");
+  }
+
+  size_t name_len = 0;
+  const char* module_name = JS_ToCStringLen(ctx, &name_len, argv[0]);
+  if (!module_name) {
+    return JS_EXCEPTION;
+  }
+
+  JSValue m;
+  if (module_name[0] == '.') {
+    std::string resolved = ResolveRelative(module_dirs_[index], module_name, name_len);
+    m = LoadCjsModule(ctx, resolved.c_str(), nullptr);
+  } else {
+    m = LoadCjsModule(ctx, module_name, nullptr);
+  }
+  JS_FreeCString(ctx, module_name);
+
+  return m;
+}
+
 int Engine::LoopStep() {
   if (!ctx_ || !rt_) {
     return 0;
   }
+  TraceScope trace(&tracer_, "engine", "loopStep");
 
   JSContext* ctx1;
   int err;
@@ -744,7 +1492,7 @@ int Engine::LoopStep() {
   }
 
   // 타이머 처리
-  if (timer_manager_->RunTimers(ctx_, &min_delay)) {
+  if (timer_manager_->RunTimers(ctx_, &min_delay, &running_ctx_)) {
     return -1;
   }
 
@@ -759,6 +1507,10 @@ bool Engine::HasPendingJobs() const {
   return rt_ && JS_IsJobPending(rt_);
 }
 
+bool Engine::HasPendingIo() const {
+  return io_manager_ && io_manager_->HasPendingIo();
+}
+
 void Engine::Eval(const char* code) {
   JSValue result = JS_Eval(ctx_, code, strlen(code), "<eval>",
                            JS_EVAL_TYPE_GLOBAL);
@@ -770,4 +1522,31 @@ void Engine::Eval(const char* code) {
   JS_FreeValue(ctx_, result);
 }
 
+// instrument 빌드의 함수 수는 수만 개 수준. 잘못된 id 로 과도하게 할당하지 않도록 제한
+static constexpr uint32_t kMaxCoverageId = 1u << 22;
+
+void Engine::CoverageHit(uint32_t id) {
+  if (id >= kMaxCoverageId) {
+    return;
+  }
+  size_t byte_index = id >> 3;
+  if (byte_index >= coverage_bits_.size()) {
+    coverage_bits_.resize(byte_index + 1, 0);
+  }
+  coverage_bits_[byte_index] |= (uint8_t)(1u << (id & 7));
+}
+
+std::vector<uint32_t> Engine::CoverageHits() const {
+  std::vector<uint32_t> hits;
+  for (size_t i = 0; i < coverage_bits_.size(); i++) {
+    uint8_t bits = coverage_bits_[i];
+    for (uint32_t bit = 0; bits; bit++, bits >>= 1) {
+      if (bits & 1) {
+        hits.push_back((uint32_t)(i << 3) + bit);
+      }
+    }
+  }
+  return hits;
+}
+
 }  // namespace request_unraver
@@ -4,6 +4,9 @@
 #include <cstdint>
 #include <memory>
 #include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <emscripten.h>
 
@@ -11,14 +14,55 @@ extern "C" {
 #include <quickjs.h>
 }
 
+#include "engine_allocator.h"
+#include "handle_table.h"
+#include "html_dom.h"
+#include "io_manager.h"
+#include "log_buffer.h"
+#include "profiler.h"
 #include "timer_manager.h"
+#include "tracer.h"
+#include "transfer_arena.h"
 #include "vfs_manager.h"
+#include "window_memory.h"
 
 namespace request_unraver {
 
 #define ENGINE_MODE_MINI 14587050
 #define ENGINE_MODE_FULL 22448265
 
+// engine_gc mode
+//   - QuickJS 에는 incremental GC 가 없으므로 budget 은 pause 길이가 아니라 빈도를 제한한다
+enum GcMode : uint32_t {
+  // 항상 전체 cycle collection
+  kGcFull = 0,
+  // 마지막 GC 이후 늘어난 양이 budget 을 넘었을 때만 (idle 마다 불러도 싸다)
+  kGcBudget = 1,
+};
+
+// 호스트가 부른 GC (engine_gc, leak report) 와 요청 중 자동 GC 유예 통계
+//   - QuickJS 가 할당 중에 스스로 돌리는 GC 는 hook 이 없어 세지 못한다
+struct GcStats {
+  uint64_t collections = 0;
+  // kGcBudget 에서 budget 미만이라 건너뜀
+  uint64_t skipped = 0;
+  // 자동 GC threshold 를 올려서 실행한 요청
+  uint64_t deferred_requests = 0;
+  uint64_t freed_bytes = 0;
+  double total_pause_ms = 0;
+  double max_pause_ms = 0;
+  double last_pause_ms = 0;
+};
+
+// window context 생성 비용 (NewWindowContext: globals 등록 + pseudo-browser bundle 실행)
+//   - 새 engine 대비 window 당 비용을 보기 위한 값 (bench.ts 의 window phase 와 비교)
+struct ContextStats {
+  uint64_t created = 0;
+  double total_init_ms = 0;
+  double max_init_ms = 0;
+  uint64_t total_bytes = 0;
+};
+
 class Engine {
  public:
   bool Init(uint32_t mode, std::shared_ptr<VfsManager> vfs_manager);
@@ -30,26 +74,108 @@ class Engine {
   // 상태 확인
   bool HasTimers() const;
   bool HasPendingJobs() const;
+  bool HasPendingIo() const;
 
   // JS 실행
   void Eval(const char* code);
 
+  // coverage (instrument 빌드의 __sys_host.coverage_hit)
+  void CoverageHit(uint32_t id);
+  std::vector<uint32_t> CoverageHits() const;
+
+  // 결과 캐시 (host ResultCache)
+  //   - browserEval 스크립트가 실행되는 동안 (EvalScriptScope) 시계, 난수, 호스트 I/O 를 쓰면 설정.
+  //     params 해석, 결과 직렬화, window 생성, event loop 처럼 스크립트 밖에서의 사용은 무시
+  //   - __sys.markUncacheable() 은 언제나 설정
+  //   - Take 는 값을 반환하고 초기화
+  void MarkUncacheable() { uncacheable_ = true; }
+  void NoteNondeterministic() {
+    if (eval_script_depth_ > 0) {
+      uncacheable_ = true;
+    }
+  }
+  void BeginEvalScript() { eval_script_depth_++; }
+  void EndEvalScript() { eval_script_depth_--; }
+  bool TakeUncacheable() {
+    bool uncacheable = uncacheable_;
+    uncacheable_ = false;
+    return uncacheable;
+  }
+
+  // guest JS sampling profiler (profiler.h)
+  //   - 켜져 있는 동안만 runtime interrupt handler 를 건다
+  void StartProfile(double interval_ms);
+  void StopProfile(msgpack::packer<msgpack::sbuffer>* pk);
+
+  // 지금 JS 를 실행 중인 context (profiler 가 stack 을 뜨는 context)
+  //   - 진입점과 타이머 호출에서 RunningContextScope 로 설정한다
+  //   - 실행 전에 realm 을 알 수 없는 promise job 동안은 main context
+  JSContext* running_context() const { return running_ctx_ ? running_ctx_ : ctx_; }
+  JSContext** running_context_slot() { return &running_ctx_; }
+
+  // 호스트 GC. pk 가 있으면 { collected, pauseMs, freedBytes, liveBytes } 를 쓴다
+  bool CollectGarbage(GcMode mode, msgpack::packer<msgpack::sbuffer>* pk);
+  // 요청 동안 자동 GC 를 미룰 여유 bytes (0: 유예 안 함)
+  size_t gc_headroom() const { return gc_headroom_; }
+  void set_gc_headroom(size_t bytes) { gc_headroom_ = bytes; }
+  const GcStats& gc_stats() const { return gc_stats_; }
+  const ContextStats& context_stats() const { return context_stats_; }
+  // GcDeferScope 전용. 중첩 가능
+  void BeginRequest();
+  void EndRequest();
+
+  // window 별 메모리 계정 / 누수 추적 (window_memory.h)
+  size_t LiveBytes() const;
+  // live_before 이후 늘어난 allocator 사용량을 window context 에 청구
+  void ChargeContext(JSContext* ctx, size_t live_before);
+  static const WindowMemory* ContextMemory(JSContext* ctx);
+  // window handle 해제. 해제 직전 global 을 누수 추적에 등록한다
+  bool DestroyWindow(uint32_t handle);
+  // 모든 window 를 DestroyWindow 로 해제하고 해제된 수 반환
+  size_t ReleaseAllWindows();
+  // GC 후 { heap, windows } 를 쓴다
+  void LeakReport(msgpack::packer<msgpack::sbuffer>* pk);
+
   // 접근자 (내부용)
   JSRuntime* runtime() const { return rt_; }
   JSContext* context() const { return ctx_; }
   TimerManager* timer_manager() const { return timer_manager_.get(); }
+  IoManager* io_manager() const { return io_manager_.get(); }
+  HandleTable* handle_table() const { return handle_table_.get(); }
+  TransferArena* transfer_arena() { return &transfer_arena_; }
+  LogBuffer* log_buffer() { return &log_buffer_; }
+  Tracer* tracer() { return &tracer_; }
+  Profiler* profiler() { return &profiler_; }
   VfsManager* vfs_manager() const { return vfs_manager_.get(); }
+  const EngineAllocator* allocator() const { return allocator_.get(); }
+
+  // 호스트 콜백에 전달되는 engine 식별자 (engine_new 의 WL_VALUE)
+  uint64_t host_handle() const { return host_handle_; }
+  void set_host_handle(uint64_t handle) { host_handle_ = handle; }
+  // 호스트 I/O 에 실어 보내는 ctx 의 window 식별자 (engine_create_window 의 WL_VALUE, 없으면 0)
+  static uint64_t HostWindow(JSContext* ctx);
+  static void SetHostWindow(JSContext* ctx, uint64_t window);
 
   Engine();
   ~Engine();
 
   bool InitializeRuntime();
-  void RegisterGlobals();
+  void RegisterGlobals(JSContext* ctx);
+
+  // 같은 runtime 의 window 전용 context 생성 (globals + pseudo-browser 로드)
+  JSContext* NewWindowContext();
+  // handle table 이 window context 를 해제할 때 호출
+  //   - context 의 타이머와 호스트 I/O 를 먼저 취소한다 (realm 을 붙잡지 않도록)
+  static void FreeWindowContext(JSContext* ctx);
 
+  // magic: LogLevel
   JSValue JsConsoleLog(JSContext* ctx, JSValueConst this_val, int argc,
-                       JSValueConst* argv);
+                       JSValueConst* argv, int magic);
   JSValue JsRequire(JSContext* ctx, JSValueConst this_val, int argc,
                     JSValueConst* argv);
+  // 모듈별 require: 상대 경로는 모듈 디렉토리 기준으로 C++ 에서 해석
+  JSValue JsModuleRequire(JSContext* ctx, int argc, JSValueConst* argv,
+                          JSValueConst dir_index);
   // JSModuleDef* ModuleLoader(JSContext* ctx, const char* module_name, void* opaque);
   // void RunSysFile(JSContext* ctx, const char* name);
 
@@ -60,7 +186,19 @@ class Engine {
   static std::string js_to_string(JSContext* ctx, JSValueConst v);
   static std::string js_error_to_string(JSContext *ctx, JSValueConst exception_val);
 
-  JSValue CreateWindow(const char* content, const uint8_t *windowOptions_msgp, int windowOptions_len);
+  // 새 context 에 window 생성. 성공시 *out_ctx 는 window 전용 context (호출자 소유)
+  JSValue CreateWindow(const char* content, size_t content_len, const uint8_t *windowOptions_msgp, int windowOptions_len,
+                       JSContext** out_ctx);
+
+  // content 를 조각으로 받는 CreateWindow (engine_window_begin / write / end)
+  //   - BeginWindow: window context 를 먼저 만들고 stream id 반환. 실패시 0 (예외는 ctx_)
+  //   - native DOM window 는 조각을 바로 HtmlDocumentParser 에 넣고,
+  //     jsdom window 는 문자열이 필요하므로 모아 두었다가 EndWindow 에서 넘긴다
+  //   - size_hint: 예상 content 크기 (모르면 0)
+  uint32_t BeginWindow(const uint8_t* windowOptions_msgp, int windowOptions_len, size_t size_hint);
+  bool WriteWindow(uint32_t stream_id, const char* data, size_t len);
+  JSValue EndWindow(uint32_t stream_id, JSContext** out_ctx);
+  bool AbortWindow(uint32_t stream_id);
 
  private:
   // 헬퍼 함수들
@@ -78,16 +216,125 @@ class Engine {
     bool use_realpath, bool is_main
   );
 
-  std::map<std::string, JSValue> loaded_modules_;
+  struct PendingWindow {
+    JSContext* ctx;
+    // munpack 된 window options (ctx 소유)
+    JSValue options;
+    std::unique_ptr<HtmlDocumentParser> parser;
+    std::string content;
+  };
+
+  void InitContext(JSContext* ctx);
+  JSValue FailWindowContext(JSContext* ctx);
+  static void FreePendingWindow(PendingWindow* pending);
+  // context state 가 이미 해제되었으면 nullptr
+  static std::unordered_map<JSAtom, JSValue>* LoadedModules(JSContext* ctx);
+  static void FreeContextState(JSContext* ctx);
+
+  JSValue NewModuleRequire(JSContext* ctx, const std::string& filename);
+  // module 파일의 디렉토리. scheme 은 남긴다 ("sysfs:///a.js" -> "sysfs:///")
+  static std::string ModuleDir(const std::string& filename);
+  static std::string ResolveRelative(const std::string& dir, const char* name, size_t name_len);
+
+  // 컴파일된 module wrapper (JS_WriteObject). context 간 공유
+  std::unordered_map<std::string, std::vector<uint8_t>> bytecode_cache_;
+  // 모듈 디렉토리 (require 함수의 func_data 는 이 index)
+  std::vector<std::string> module_dirs_;
+  std::unordered_map<std::string, int32_t> module_dir_index_;
 
 private:
 
+ // rt_ 보다 오래 살아야 한다 (Shutdown 에서 JS_FreeRuntime 이후 해제)
+ std::unique_ptr<EngineAllocator> allocator_;
  JSRuntime* rt_;
  JSContext* ctx_;
+ // RunningContextScope 가 설정 (nullptr 이면 ctx_)
+ JSContext* running_ctx_;
+ uint32_t mode_;
  std::unique_ptr<TimerManager> timer_manager_;
+ std::unique_ptr<IoManager> io_manager_;
+ std::unique_ptr<HandleTable> handle_table_;
+ uint64_t host_handle_;
+ TransferArena transfer_arena_;
+ LogBuffer log_buffer_;
+ Tracer tracer_;
+ Profiler profiler_;
+ WindowLeakTracker leak_tracker_;
+ std::vector<uint8_t> coverage_bits_;
+ bool uncacheable_;
+ uint32_t eval_script_depth_;
+ GcStats gc_stats_;
+ ContextStats context_stats_;
+ size_t gc_headroom_;
+ // 마지막 호스트 GC 직후 live bytes (kGcBudget 기준)
+ size_t gc_live_after_;
+ size_t gc_saved_threshold_;
+ uint32_t request_depth_;
+ bool gc_deferring_;
+ std::unordered_map<uint32_t, PendingWindow> pending_windows_;
+ uint32_t next_pending_window_;
  std::shared_ptr<VfsManager> vfs_manager_;
 };
 
+// scope 동안의 allocator 증감을 window context 에 청구 (window 에 대한 eval 등)
+class ContextMemoryScope {
+ public:
+  ContextMemoryScope(Engine* eng, JSContext* ctx)
+    : eng_(eng), ctx_(ctx), live_before_(eng->LiveBytes()) {}
+
+  ~ContextMemoryScope() { eng_->ChargeContext(ctx_, live_before_); }
+
+  ContextMemoryScope(const ContextMemoryScope&) = delete;
+  ContextMemoryScope& operator=(const ContextMemoryScope&) = delete;
+
+ private:
+  Engine* eng_;
+  JSContext* ctx_;
+  size_t live_before_;
+};
+
+// 요청 (eval, window 생성) 동안 live + headroom 까지 자동 GC 를 미룬다
+//   - 미룬 수거는 요청 사이의 engine_gc 가 처리하도록 호스트가 예약한다
+class GcDeferScope {
+ public:
+  explicit GcDeferScope(Engine* eng) : eng_(eng) { eng_->BeginRequest(); }
+  ~GcDeferScope() { eng_->EndRequest(); }
+
+  GcDeferScope(const GcDeferScope&) = delete;
+  GcDeferScope& operator=(const GcDeferScope&) = delete;
+
+ private:
+  Engine* eng_;
+};
+
+// scope 동안 ctx 를 실행 중인 context 로 표시 (중첩되면 나갈 때 이전 값으로 되돌린다)
+class RunningContextScope {
+ public:
+  RunningContextScope(Engine* eng, JSContext* ctx)
+    : slot_(eng->running_context_slot()), prev_(*slot_) { *slot_ = ctx; }
+  ~RunningContextScope() { *slot_ = prev_; }
+
+  RunningContextScope(const RunningContextScope&) = delete;
+  RunningContextScope& operator=(const RunningContextScope&) = delete;
+
+ private:
+  JSContext** slot_;
+  JSContext* prev_;
+};
+
+// browserEval 스크립트 본문을 호출하는 동안 (Engine::NoteNondeterministic 참고)
+class EvalScriptScope {
+ public:
+  explicit EvalScriptScope(Engine* eng) : eng_(eng) { eng_->BeginEvalScript(); }
+  ~EvalScriptScope() { eng_->EndEvalScript(); }
+
+  EvalScriptScope(const EvalScriptScope&) = delete;
+  EvalScriptScope& operator=(const EvalScriptScope&) = delete;
+
+ private:
+  Engine* eng_;
+};
+
 }  // namespace request_unraver
 
 #endif  // REQUEST_UNRAVER_ENGINE_H_
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include "engine_allocator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace request_unraver {
+
+namespace {
+
+// 각 block 앞의 header. payload 는 8 byte 정렬 (JSValue, double)
+struct BlockHeader {
+  uint32_t size_class;
+  // large block: 요청 크기, small block: chunk 시작에서 header 까지의 거리
+  uint32_t size;
+};
+static_assert(sizeof(BlockHeader) == 8, "BlockHeader must be 8 bytes");
+
+constexpr uint32_t kLargeClass = 0xffffffffu;
+constexpr size_t kChunkSize = 256 * 1024;
+// 빈 chunk 가 이만큼, 그리고 전체 chunk 의 1/8 이상 쌓이면 Free 에서 Trim
+// (Trim 은 free list 전체를 훑으므로 반환할 양이 충분할 때만)
+constexpr size_t kTrimMinEmptyChunks = 4;
+
+constexpr uint32_t kSizeClasses[EngineAllocator::kNumSizeClasses] = {
+  8, 16, 24, 32, 48, 64, 80, 96, 112, 128,
+  160, 192, 224, 256, 320, 384, 448, 512,
+  640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+};
+static_assert(kSizeClasses[EngineAllocator::kNumSizeClasses - 1] == EngineAllocator::kMaxSmallSize,
+              "last size class must be kMaxSmallSize");
+
+// (size + 7) / 8 -> size class
+struct SizeClassTable {
+  uint8_t index[EngineAllocator::kMaxSmallSize / 8 + 1];
+
+  SizeClassTable() {
+    uint32_t size_class = 0;
+    for (size_t i = 0; i < sizeof(index); i++) {
+      while (kSizeClasses[size_class] < i * 8) {
+        size_class++;
+      }
+      index[i] = (uint8_t) size_class;
+    }
+  }
+};
+const SizeClassTable kSizeClassTable;
+
+inline BlockHeader* HeaderOf(const void* ptr) {
+  return reinterpret_cast<BlockHeader*>(const_cast<uint8_t*>(static_cast<const uint8_t*>(ptr)) - sizeof(BlockHeader));
+}
+
+void* JsCalloc(void* opaque, size_t count, size_t size) {
+  return static_cast<EngineAllocator*>(opaque)->Calloc(count, size);
+}
+
+void* JsMalloc(void* opaque, size_t size) {
+  return static_cast<EngineAllocator*>(opaque)->Malloc(size);
+}
+
+void JsFree(void* opaque, void* ptr) {
+  static_cast<EngineAllocator*>(opaque)->Free(ptr);
+}
+
+void* JsRealloc(void* opaque, void* ptr, size_t size) {
+  return static_cast<EngineAllocator*>(opaque)->Realloc(ptr, size);
+}
+
+size_t JsMallocUsableSize(const void* ptr) {
+  return EngineAllocator::UsableSize(ptr);
+}
+
+std::mutex registry_mutex;
+EngineAllocator* registry_head = nullptr;
+
+}  // anonymous
+
+// chunk 목록 (chunk 시작 위치에 저장)
+struct EngineAllocator::Chunk {
+  Chunk* next;
+  size_t size;
+  // bump 할당된 크기
+  size_t used;
+  // free list 에 있지 않은 block 수
+  size_t live;
+};
+
+EngineAllocator::Chunk* EngineAllocator::ChunkOf(const void* ptr) {
+  BlockHeader* header = HeaderOf(ptr);
+  return reinterpret_cast<Chunk*>(reinterpret_cast<uint8_t*>(header) - header->size);
+}
+
+const JSMallocFunctions EngineAllocator::kMallocFunctions = {
+  JsCalloc,
+  JsMalloc,
+  JsFree,
+  JsRealloc,
+  JsMallocUsableSize,
+};
+
+EngineAllocator::EngineAllocator()
+    : chunks_(nullptr),
+      current_(nullptr),
+      bump_(nullptr),
+      bump_end_(nullptr),
+      empty_chunks_(0),
+      registry_prev_(nullptr) {
+  memset(free_lists_, 0, sizeof(free_lists_));
+  for (auto& bytes : free_bytes_) {
+    bytes.store(0, std::memory_order_relaxed);
+  }
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  registry_next_ = registry_head;
+  if (registry_head) {
+    registry_head->registry_prev_ = this;
+  }
+  registry_head = this;
+}
+
+EngineAllocator::~EngineAllocator() {
+  Release();
+
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  if (registry_prev_) {
+    registry_prev_->registry_next_ = registry_next_;
+  } else {
+    registry_head = registry_next_;
+  }
+  if (registry_next_) {
+    registry_next_->registry_prev_ = registry_prev_;
+  }
+}
+
+uint32_t EngineAllocator::SizeClassSize(uint32_t size_class) {
+  return kSizeClasses[size_class];
+}
+
+void EngineAllocator::FreeListTotals(size_t totals[kNumSizeClasses]) {
+  memset(totals, 0, sizeof(size_t) * kNumSizeClasses);
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (EngineAllocator* allocator = registry_head; allocator; allocator = allocator->registry_next_) {
+    for (uint32_t i = 0; i < kNumSizeClasses; i++) {
+      totals[i] += allocator->free_list_bytes(i);
+    }
+  }
+}
+
+// 쓰는 쪽은 소유 스레드 하나뿐이므로 read-modify-write 없이 store 한다
+void EngineAllocator::AddFreeBytes(uint32_t size_class, size_t bytes) {
+  free_bytes_[size_class].store(free_bytes_[size_class].load(std::memory_order_relaxed) + bytes,
+                                std::memory_order_relaxed);
+}
+
+void EngineAllocator::SubFreeBytes(uint32_t size_class, size_t bytes) {
+  free_bytes_[size_class].store(free_bytes_[size_class].load(std::memory_order_relaxed) - bytes,
+                                std::memory_order_relaxed);
+}
+
+void* EngineAllocator::Malloc(size_t size) {
+  stats_.alloc_calls++;
+  if (size <= kMaxSmallSize) {
+    return AllocSmall(kSizeClassTable.index[(size + 7) >> 3]);
+  }
+  return AllocLarge(size);
+}
+
+void* EngineAllocator::Calloc(size_t count, size_t size) {
+  if (size && count > SIZE_MAX / size) {
+    return nullptr;
+  }
+  size_t total = count * size;
+  void* ptr = Malloc(total);
+  if (ptr) {
+    memset(ptr, 0, total);
+  }
+  return ptr;
+}
+
+void* EngineAllocator::Realloc(void* ptr, size_t size) {
+  if (!ptr) {
+    return Malloc(size);
+  }
+  if (size == 0) {
+    Free(ptr);
+    return nullptr;
+  }
+
+  BlockHeader* header = HeaderOf(ptr);
+  if (header->size_class != kLargeClass) {
+    size_t old_size = kSizeClasses[header->size_class];
+    // 같은 class 안에서 줄어드는 경우는 그대로 사용
+    if (size <= old_size && kSizeClassTable.index[(size + 7) >> 3] == header->size_class) {
+      return ptr;
+    }
+    void* new_ptr = Malloc(size);
+    if (!new_ptr) {
+      return nullptr;
+    }
+    memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    Free(ptr);
+    return new_ptr;
+  }
+
+  // large -> small 은 chunk 로 옮긴다
+  if (size <= kMaxSmallSize) {
+    void* new_ptr = Malloc(size);
+    if (!new_ptr) {
+      return nullptr;
+    }
+    memcpy(new_ptr, ptr, size);
+    Free(ptr);
+    return new_ptr;
+  }
+
+  if (size > UINT32_MAX - sizeof(BlockHeader)) {
+    return nullptr;
+  }
+  size_t old_size = header->size;
+  BlockHeader* new_header = static_cast<BlockHeader*>(realloc(header, sizeof(BlockHeader) + size));
+  if (!new_header) {
+    return nullptr;
+  }
+  new_header->size = (uint32_t) size;
+  stats_.large_bytes = stats_.large_bytes - old_size + size;
+  UpdatePeak();
+  return new_header + 1;
+}
+
+void EngineAllocator::Free(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  stats_.free_calls++;
+
+  BlockHeader* header = HeaderOf(ptr);
+  if (header->size_class == kLargeClass) {
+    stats_.large_count--;
+    stats_.large_bytes -= header->size;
+    free(header);
+    return;
+  }
+
+  // free list 의 다음 포인터는 payload 에 저장
+  uint32_t size_class = header->size_class;
+  *static_cast<void**>(ptr) = free_lists_[size_class];
+  free_lists_[size_class] = ptr;
+  stats_.small_count--;
+  stats_.small_bytes -= kSizeClasses[size_class];
+  AddFreeBytes(size_class, kSizeClasses[size_class]);
+
+  if (--ChunkOf(ptr)->live == 0) {
+    empty_chunks_++;
+    if (empty_chunks_ >= kTrimMinEmptyChunks && empty_chunks_ * 8 >= stats_.arena_chunks) {
+      Trim();
+    }
+  }
+}
+
+size_t EngineAllocator::UsableSize(const void* ptr) {
+  if (!ptr) {
+    return 0;
+  }
+  const BlockHeader* header = HeaderOf(ptr);
+  if (header->size_class == kLargeClass) {
+    return header->size;
+  }
+  return kSizeClasses[header->size_class];
+}
+
+size_t EngineAllocator::Trim() {
+  if (empty_chunks_ == 0 || (empty_chunks_ == 1 && current_ && current_->live == 0)) {
+    return 0;
+  }
+
+  // 반환할 chunk 의 block 을 free list 에서 뺀다
+  for (uint32_t size_class = 0; size_class < kNumSizeClasses; size_class++) {
+    void** link = &free_lists_[size_class];
+    while (*link) {
+      Chunk* chunk = ChunkOf(*link);
+      if (chunk->live == 0 && chunk != current_) {
+        *link = *static_cast<void**>(*link);
+        SubFreeBytes(size_class, kSizeClasses[size_class]);
+      } else {
+        link = static_cast<void**>(*link);
+      }
+    }
+  }
+
+  size_t released = 0;
+  Chunk** link = &chunks_;
+  while (*link) {
+    Chunk* chunk = *link;
+    if (chunk->live == 0 && chunk != current_) {
+      *link = chunk->next;
+      stats_.arena_chunks--;
+      stats_.arena_chunks_released++;
+      stats_.arena_reserved -= chunk->size;
+      stats_.arena_used -= chunk->used;
+      released += chunk->size;
+      free(chunk);
+    } else {
+      link = &chunk->next;
+    }
+  }
+
+  empty_chunks_ = current_ && current_->live == 0 ? 1 : 0;
+  return released;
+}
+
+void EngineAllocator::Release() {
+  Chunk* chunk = chunks_;
+  while (chunk) {
+    Chunk* next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  chunks_ = nullptr;
+  current_ = nullptr;
+  bump_ = nullptr;
+  bump_end_ = nullptr;
+  empty_chunks_ = 0;
+  memset(free_lists_, 0, sizeof(free_lists_));
+  for (auto& bytes : free_bytes_) {
+    bytes.store(0, std::memory_order_relaxed);
+  }
+
+  // large block 은 runtime 이 모두 해제한다. 남은 값은 누수 확인용으로 유지
+  stats_.arena_chunks = 0;
+  stats_.arena_reserved = 0;
+  stats_.arena_used = 0;
+  stats_.small_count = 0;
+  stats_.small_bytes = 0;
+}
+
+void* EngineAllocator::AllocSmall(uint32_t size_class) {
+  void* ptr = free_lists_[size_class];
+  Chunk* chunk;
+  if (ptr) {
+    free_lists_[size_class] = *static_cast<void**>(ptr);
+    SubFreeBytes(size_class, kSizeClasses[size_class]);
+    chunk = ChunkOf(ptr);
+  } else {
+    size_t block_size = sizeof(BlockHeader) + kSizeClasses[size_class];
+    if ((size_t)(bump_end_ - bump_) < block_size && !NewChunk(block_size)) {
+      return nullptr;
+    }
+    chunk = current_;
+    BlockHeader* header = reinterpret_cast<BlockHeader*>(bump_);
+    header->size_class = size_class;
+    header->size = (uint32_t)(bump_ - reinterpret_cast<uint8_t*>(chunk));
+    bump_ += block_size;
+    chunk->used += block_size;
+    stats_.arena_used += block_size;
+    ptr = header + 1;
+  }
+  if (chunk->live++ == 0) {
+    empty_chunks_--;
+  }
+
+  stats_.small_count++;
+  stats_.small_bytes += kSizeClasses[size_class];
+  UpdatePeak();
+  return ptr;
+}
+
+void* EngineAllocator::AllocLarge(size_t size) {
+  if (size > UINT32_MAX - sizeof(BlockHeader)) {
+    return nullptr;
+  }
+  BlockHeader* header = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + size));
+  if (!header) {
+    return nullptr;
+  }
+  header->size_class = kLargeClass;
+  header->size = (uint32_t) size;
+
+  stats_.large_count++;
+  stats_.large_bytes += size;
+  UpdatePeak();
+  return header + 1;
+}
+
+bool EngineAllocator::NewChunk(size_t min_size) {
+  size_t size = kChunkSize;
+  if (size < sizeof(Chunk) + min_size) {
+    size = sizeof(Chunk) + min_size;
+  }
+  Chunk* chunk = static_cast<Chunk*>(malloc(size));
+  if (!chunk) {
+    return false;
+  }
+  chunk->next = chunks_;
+  chunk->size = size;
+  chunk->used = 0;
+  chunk->live = 0;
+  chunks_ = chunk;
+  current_ = chunk;
+  empty_chunks_++;
+
+  // 이전 chunk 의 남은 공간은 버린다 (block 크기 이하)
+  static_assert(sizeof(Chunk) % 8 == 0, "chunk header must keep 8 byte alignment");
+  bump_ = reinterpret_cast<uint8_t*>(chunk) + sizeof(Chunk);
+  bump_end_ = reinterpret_cast<uint8_t*>(chunk) + size;
+
+  stats_.arena_chunks++;
+  stats_.arena_reserved += size;
+  return true;
+}
+
+void EngineAllocator::UpdatePeak() {
+  size_t in_use = stats_.small_bytes + stats_.large_bytes;
+  if (in_use > stats_.peak_bytes) {
+    stats_.peak_bytes = in_use;
+  }
+}
+
+}  // namespace request_unraver
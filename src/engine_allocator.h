@@ -0,0 +1,110 @@
+#ifndef REQUEST_UNRAVER_ENGINE_ALLOCATOR_H_
+#define REQUEST_UNRAVER_ENGINE_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// Engine 전용 QuickJS allocator (JS_NewRuntime2)
+//
+// 작은 할당은 size class 별 free list 로 재사용하고, 새 block 은 큰 chunk 에서
+// bump 할당한다. 모든 block 이 free 된 chunk 는 Trim() 에서 free list 에서 빼고
+// malloc 으로 반환한다 (빈 chunk 가 쌓이면 Free 에서도 자동으로). 나머지 chunk 는
+// engine 이 끝날 때 한꺼번에 반환되므로 engine 을 반복 생성/해제해도 WASM heap 에
+// 작은 구멍이 남지 않는다. 큰 할당만 malloc 을 직접 사용한다.
+//
+// Engine 은 한 스레드에서만 사용되므로 (pthread 빌드도 스레드별 Engine)
+// allocator 도 lock 없이 스레드 전용으로 동작한다. 다른 스레드가 읽는
+// free list 크기 (FreeListTotals) 만 atomic 으로 기록한다.
+class EngineAllocator {
+ public:
+  struct Stats {
+    size_t arena_chunks = 0;
+    // Trim 으로 반환한 chunk 수
+    size_t arena_chunks_released = 0;
+    // chunk 로 malloc 한 전체 크기
+    size_t arena_reserved = 0;
+    // chunk 에서 bump 할당된 크기 (free list 에 있는 block 포함)
+    size_t arena_used = 0;
+    size_t small_count = 0;
+    size_t small_bytes = 0;
+    size_t large_count = 0;
+    size_t large_bytes = 0;
+    size_t peak_bytes = 0;
+    uint64_t alloc_calls = 0;
+    uint64_t free_calls = 0;
+  };
+
+  // 이보다 큰 할당은 malloc 직접 사용
+  static constexpr size_t kMaxSmallSize = 2048;
+  static constexpr size_t kNumSizeClasses = 26;
+
+  EngineAllocator();
+  ~EngineAllocator();
+
+  EngineAllocator(const EngineAllocator&) = delete;
+  EngineAllocator& operator=(const EngineAllocator&) = delete;
+
+  // JS_NewRuntime2(&EngineAllocator::kMallocFunctions, allocator)
+  static const JSMallocFunctions kMallocFunctions;
+
+  void* Malloc(size_t size);
+  void* Calloc(size_t count, size_t size);
+  void* Realloc(void* ptr, size_t size);
+  void Free(void* ptr);
+  static size_t UsableSize(const void* ptr);
+
+  // 모든 block 이 free 된 chunk 를 반환하고 반환한 크기를 돌려준다 (bump 중인 chunk 제외)
+  size_t Trim();
+
+  // 모든 chunk 반환. runtime 해제 이후에만 호출
+  void Release();
+
+  const Stats& stats() const { return stats_; }
+
+  // size class 별 free list 에 남아 있는 크기 (block payload 기준)
+  size_t free_list_bytes(uint32_t size_class) const {
+    return free_bytes_[size_class].load(std::memory_order_relaxed);
+  }
+  static uint32_t SizeClassSize(uint32_t size_class);
+
+  // 살아 있는 모든 allocator 의 free_list_bytes 합계 (runtime_heap_stats)
+  static void FreeListTotals(size_t totals[kNumSizeClasses]);
+
+ private:
+  struct Chunk;
+
+  // small block 이 속한 chunk
+  static Chunk* ChunkOf(const void* ptr);
+  void* AllocSmall(uint32_t size_class);
+  void* AllocLarge(size_t size);
+  bool NewChunk(size_t min_size);
+  void UpdatePeak();
+  void AddFreeBytes(uint32_t size_class, size_t bytes);
+  void SubFreeBytes(uint32_t size_class, size_t bytes);
+
+  Chunk* chunks_;
+  // bump 중인 chunk
+  Chunk* current_;
+  uint8_t* bump_;
+  uint8_t* bump_end_;
+  // live block 이 없는 chunk 수 (current_ 포함)
+  size_t empty_chunks_;
+  void* free_lists_[kNumSizeClasses];
+  std::atomic<size_t> free_bytes_[kNumSizeClasses];
+  Stats stats_;
+
+  // FreeListTotals 용 목록
+  EngineAllocator* registry_prev_;
+  EngineAllocator* registry_next_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_ENGINE_ALLOCATOR_H_
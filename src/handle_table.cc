@@ -0,0 +1,121 @@
+#include "handle_table.h"
+
+namespace request_unraver {
+
+HandleTable::HandleTable(JSRuntime* rt, ContextFreeFunc free_context)
+    : free_head_(kNoFreeSlot), live_{}, live_total_(0), runtime_(rt), free_context_(free_context) {}
+
+HandleTable::~HandleTable() {
+  for (uint32_t i = 0; i < slots_.size(); i++) {
+    if (slots_[i].kind != kHandleInvalid) {
+      FreeSlot(i);
+    }
+  }
+}
+
+uint32_t HandleTable::Insert(HandleKind kind, JSContext* ctx, JSValue value, bool owns_context) {
+  uint32_t index;
+  if (free_head_ != kNoFreeSlot) {
+    index = free_head_;
+    free_head_ = slots_[index].next_free;
+  } else {
+    if (slots_.size() > kIndexMask) {
+      JS_FreeValueRT(runtime_, value);
+      if (owns_context && free_context_) {
+        free_context_(ctx);
+      }
+      return 0;
+    }
+    index = (uint32_t) slots_.size();
+    Slot slot;
+    slot.generation = 0;
+    slots_.push_back(slot);
+  }
+
+  Slot& slot = slots_[index];
+  // generation 0 은 사용하지 않는다 (handle 0 == invalid)
+  slot.generation = (slot.generation + 1) & kGenerationMask;
+  if (slot.generation == 0) {
+    slot.generation = 1;
+  }
+  slot.value = value;
+  slot.ctx = ctx;
+  slot.kind = kind;
+  slot.owns_context = owns_context;
+  slot.next_free = kNoFreeSlot;
+
+  live_[kind]++;
+  live_total_++;
+
+  return (slot.generation << kIndexBits) | index;
+}
+
+const HandleTable::Slot* HandleTable::Find(uint32_t handle, HandleKind kind) const {
+  uint32_t index = handle & kIndexMask;
+  uint32_t generation = handle >> kIndexBits;
+  if (index >= slots_.size()) {
+    return nullptr;
+  }
+  const Slot& slot = slots_[index];
+  if (slot.kind != kind || slot.generation != generation) {
+    return nullptr;
+  }
+  return &slot;
+}
+
+bool HandleTable::Lookup(uint32_t handle, HandleKind kind, JSValue* out_value,
+                         JSContext** out_ctx) const {
+  const Slot* slot = Find(handle, kind);
+  if (!slot) {
+    return false;
+  }
+  *out_value = slot->value;
+  if (out_ctx) {
+    *out_ctx = slot->ctx;
+  }
+  return true;
+}
+
+void HandleTable::FreeSlot(uint32_t index) {
+  Slot& slot = slots_[index];
+  JSValue value = slot.value;
+  JSContext* ctx = slot.ctx;
+  bool owns_context = slot.owns_context;
+
+  live_[slot.kind]--;
+  live_total_--;
+
+  slot.value = JS_UNDEFINED;
+  slot.ctx = nullptr;
+  slot.kind = kHandleInvalid;
+  slot.owns_context = false;
+  slot.next_free = free_head_;
+  free_head_ = index;
+
+  // finalizer 에서 테이블에 재진입해도 안전하도록 slot 정리 후 해제
+  JS_FreeValueRT(runtime_, value);
+  if (owns_context && free_context_) {
+    free_context_(ctx);
+  }
+}
+
+bool HandleTable::Release(uint32_t handle, HandleKind kind) {
+  if (!Find(handle, kind)) {
+    return false;
+  }
+  FreeSlot(handle & kIndexMask);
+  return true;
+}
+
+std::vector<uint32_t> HandleTable::Handles(HandleKind kind) const {
+  std::vector<uint32_t> handles;
+  handles.reserve(live_[kind]);
+  for (uint32_t i = 0; i < slots_.size(); i++) {
+    if (slots_[i].kind == kind) {
+      handles.push_back((slots_[i].generation << kIndexBits) | i);
+    }
+  }
+  return handles;
+}
+
+}  // namespace request_unraver
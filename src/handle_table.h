@@ -0,0 +1,80 @@
+#ifndef REQUEST_UNRAVER_HANDLE_TABLE_H_
+#define REQUEST_UNRAVER_HANDLE_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+enum HandleKind : uint8_t {
+  kHandleInvalid = 0,
+  kHandleWindow = 1,
+  kHandleKindCount,
+};
+
+// 호스트에 노출되는 게스트 객체(window 등)의 generational handle table
+//
+// handle = (generation << kIndexBits) | index
+//   - O(1) 조회/검증, 해제된 slot 재사용시 generation 증가로 stale handle 거부
+//   - 테이블이 값의 참조를 보유하므로 등록된 객체는 GC root 가 된다
+class HandleTable {
+ public:
+  static constexpr uint32_t kIndexBits = 20;
+  static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+  static constexpr uint32_t kGenerationMask = (1u << (32 - kIndexBits)) - 1;
+
+  // owns_context 로 등록된 slot 해제시 호출 (값 해제 이후)
+  using ContextFreeFunc = void (*)(JSContext* ctx);
+
+  explicit HandleTable(JSRuntime* rt, ContextFreeFunc free_context = nullptr);
+  ~HandleTable();
+
+  HandleTable(const HandleTable&) = delete;
+  HandleTable& operator=(const HandleTable&) = delete;
+
+  // value 의 소유권을 가져가고 handle 반환 (실패시 0)
+  //   - owns_context: ctx 도 slot 이 소유하며 해제시 함께 정리 (window 전용 context)
+  uint32_t Insert(HandleKind kind, JSContext* ctx, JSValue value, bool owns_context = false);
+
+  // 값 조회 (borrowed, 테이블이 계속 소유)
+  bool Lookup(uint32_t handle, HandleKind kind, JSValue* out_value,
+              JSContext** out_ctx = nullptr) const;
+
+  bool Release(uint32_t handle, HandleKind kind);
+  // kind 의 live handle 목록 (해제 중 테이블이 바뀌어도 되도록 복사본)
+  std::vector<uint32_t> Handles(HandleKind kind) const;
+
+  size_t live_count() const { return live_total_; }
+  size_t live_count(HandleKind kind) const { return live_[kind]; }
+
+ private:
+  struct Slot {
+    JSValue value;
+    JSContext* ctx;
+    uint32_t generation;
+    uint32_t next_free;
+    HandleKind kind;
+    bool owns_context;
+  };
+
+  const Slot* Find(uint32_t handle, HandleKind kind) const;
+  void FreeSlot(uint32_t index);
+
+  static constexpr uint32_t kNoFreeSlot = 0xffffffff;
+
+  std::vector<Slot> slots_;
+  uint32_t free_head_;
+  size_t live_[kHandleKindCount];
+  size_t live_total_;
+  JSRuntime* runtime_;
+  ContextFreeFunc free_context_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_HANDLE_TABLE_H_
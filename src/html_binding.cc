@@ -0,0 +1,467 @@
+#include "html_binding.h"
+
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "html_dom.h"
+#include "html_extract.h"
+#include "html_selector.h"
+#include "js_bytes.h"
+
+namespace request_unraver {
+
+namespace {
+
+// document 와 같이 runtime allocator 로 할당한다 (NewHtmlDocumentObject)
+struct NativeHtmlDocument {
+  HtmlDocumentPtr doc;
+  // 같은 selector 로 반복 호출되는 경우가 많으므로 마지막 것을 재사용
+  std::string selector_text;
+  std::unique_ptr<HtmlSelector> selector;
+};
+
+JSClassID html_document_class_id = 0;
+std::once_flag html_document_class_once;
+
+void HtmlDocumentFinalizer(JSRuntime* rt, JSValue val) {
+  NativeHtmlDocument* handle = static_cast<NativeHtmlDocument*>(JS_GetOpaque(val, html_document_class_id));
+  if (handle) {
+    handle->~NativeHtmlDocument();
+    js_free_rt(rt, handle);
+  }
+}
+
+const JSClassDef kHtmlDocumentClass = {
+  "NativeHtmlDocument",
+  HtmlDocumentFinalizer,
+};
+
+NativeHtmlDocument* GetDocument(JSContext* ctx, JSValueConst this_val) {
+  return static_cast<NativeHtmlDocument*>(JS_GetOpaque2(ctx, this_val, html_document_class_id));
+}
+
+JSValue NodeValue(JSContext* ctx, uint32_t id) {
+  return JS_NewInt32(ctx, id == kHtmlNoNode ? -1 : (int32_t) id);
+}
+
+JSValue StringValue(JSContext* ctx, std::string_view value) {
+  return JS_NewStringLen(ctx, value.data(), value.size());
+}
+
+JSValue NodeArray(JSContext* ctx, const std::vector<uint32_t>& ids) {
+  JSValue array = JS_NewArray(ctx);
+  for (size_t i = 0; i < ids.size(); i++) {
+    JS_SetPropertyUint32(ctx, array, (uint32_t) i, JS_NewInt32(ctx, (int32_t) ids[i]));
+  }
+  return array;
+}
+
+// this 와 argv[0] (node id) 를 확인
+bool GetNode(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv,
+             NativeHtmlDocument** out_doc, uint32_t* out_id) {
+  NativeHtmlDocument* handle = GetDocument(ctx, this_val);
+  if (!handle) {
+    return false;
+  }
+  int32_t id = -1;
+  if (argc < 1) {
+    JS_ThrowTypeError(ctx, "node expected");
+    return false;
+  }
+  if (JS_ToInt32(ctx, &id, argv[0])) {
+    return false;
+  }
+  if (id < 0 || !handle->doc->IsValid((uint32_t) id)) {
+    JS_ThrowRangeError(ctx, "invalid node %d", id);
+    return false;
+  }
+  *out_doc = handle;
+  *out_id = (uint32_t) id;
+  return true;
+}
+
+// argv[1] 문자열 (JS_FreeCString 필요)
+const char* GetStringArg(JSContext* ctx, int argc, JSValueConst* argv, size_t* len) {
+  if (argc < 2) {
+    JS_ThrowTypeError(ctx, "string argument expected");
+    return nullptr;
+  }
+  return JS_ToCStringLen(ctx, len, argv[1]);
+}
+
+const HtmlSelector* GetSelector(JSContext* ctx, NativeHtmlDocument* handle, int argc,
+                                JSValueConst* argv) {
+  size_t len = 0;
+  const char* text = GetStringArg(ctx, argc, argv, &len);
+  if (!text) {
+    return nullptr;
+  }
+  std::string_view selector_text(text, len);
+  if (!handle->selector || handle->selector_text != selector_text) {
+    std::string error;
+    std::unique_ptr<HtmlSelector> selector = HtmlSelector::Parse(selector_text, &error);
+    if (!selector) {
+      JS_ThrowSyntaxError(ctx, "'%s' is not a valid selector: %s", text, error.c_str());
+      JS_FreeCString(ctx, text);
+      return nullptr;
+    }
+    handle->selector = std::move(selector);
+    handle->selector_text.assign(selector_text);
+  }
+  JS_FreeCString(ctx, text);
+  return handle->selector.get();
+}
+
+//
+// html_parse(source)
+//
+JSValue JsHtmlParse(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  JsBytes source;
+  if (argc > 0 && !JS_IsUndefined(argv[0]) && !JS_IsNull(argv[0]) && !source.Get(ctx, argv[0])) {
+    return JS_EXCEPTION;
+  }
+  HtmlDocumentPtr doc = HtmlDocument::Parse(
+    JS_GetRuntime(ctx), std::string_view(reinterpret_cast<const char*>(source.data), source.len));
+  source.Free(ctx);
+  if (!doc) {
+    return JS_ThrowOutOfMemory(ctx);
+  }
+  return NewHtmlDocumentObject(ctx, std::move(doc));
+}
+
+JSValue JsDocumentElement(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle = GetDocument(ctx, this_val);
+  return handle ? NodeValue(ctx, handle->doc->document_element()) : JS_EXCEPTION;
+}
+
+JSValue JsHead(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle = GetDocument(ctx, this_val);
+  return handle ? NodeValue(ctx, handle->doc->head()) : JS_EXCEPTION;
+}
+
+JSValue JsBody(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle = GetDocument(ctx, this_val);
+  return handle ? NodeValue(ctx, handle->doc->body()) : JS_EXCEPTION;
+}
+
+JSValue JsNodeType(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  return JS_NewInt32(ctx, handle->doc->node(id).type);
+}
+
+JSValue JsNodeName(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  return StringValue(ctx, handle->doc->Name(id));
+}
+
+// 0: parent, 1: firstChild, 2: lastChild, 3: previousSibling, 4: nextSibling
+JSValue JsRelative(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  const HtmlNode& node = handle->doc->node(id);
+  switch (magic) {
+    case 0: return NodeValue(ctx, node.parent);
+    case 1: return NodeValue(ctx, node.first_child);
+    case 2: return NodeValue(ctx, node.last_child);
+    case 3: return NodeValue(ctx, node.prev_sibling);
+    default: return NodeValue(ctx, node.next_sibling);
+  }
+}
+
+JSValue JsChildNodes(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  std::vector<uint32_t> children;
+  const HtmlDocument& doc = *handle->doc;
+  for (uint32_t child = doc.node(id).first_child; child != kHtmlNoNode; child = doc.node(child).next_sibling) {
+    children.push_back(child);
+  }
+  return NodeArray(ctx, children);
+}
+
+JSValue JsData(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  return StringValue(ctx, handle->doc->Data(id));
+}
+
+//
+// attributes(id)
+//   - [name0, value0, name1, value1, ...]
+//
+JSValue JsAttributes(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  const HtmlDocument& doc = *handle->doc;
+  JSValue array = JS_NewArray(ctx);
+  uint32_t count = doc.node(id).attr_count;
+  for (uint32_t i = 0; i < count; i++) {
+    JS_SetPropertyUint32(ctx, array, i * 2, StringValue(ctx, doc.AttributeName(id, i)));
+    JS_SetPropertyUint32(ctx, array, i * 2 + 1, StringValue(ctx, doc.AttributeValue(id, i)));
+  }
+  return array;
+}
+
+JSValue JsGetAttribute(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  size_t len = 0;
+  const char* name = GetStringArg(ctx, argc, argv, &len);
+  if (!name) {
+    return JS_EXCEPTION;
+  }
+  std::string_view value;
+  bool found = handle->doc->GetAttribute(id, std::string_view(name, len), &value);
+  JS_FreeCString(ctx, name);
+  return found ? StringValue(ctx, value) : JS_NULL;
+}
+
+// 0: textContent, 1: outerHTML, 2: innerHTML
+JSValue JsSerialize(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  std::string out;
+  if (magic == 0) {
+    handle->doc->TextContent(id, &out);
+  } else {
+    handle->doc->Serialize(id, magic == 1, &out);
+  }
+  return StringValue(ctx, out);
+}
+
+JSValue JsGetElementById(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t root;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &root)) {
+    return JS_EXCEPTION;
+  }
+  size_t len = 0;
+  const char* element_id = GetStringArg(ctx, argc, argv, &len);
+  if (!element_id) {
+    return JS_EXCEPTION;
+  }
+  uint32_t found = handle->doc->FindById(root, std::string_view(element_id, len));
+  JS_FreeCString(ctx, element_id);
+  return NodeValue(ctx, found);
+}
+
+// 0: getElementsByTagName, 1: getElementsByClassName
+JSValue JsGetElementsBy(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic) {
+  NativeHtmlDocument* handle;
+  uint32_t root;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &root)) {
+    return JS_EXCEPTION;
+  }
+  size_t len = 0;
+  const char* name = GetStringArg(ctx, argc, argv, &len);
+  if (!name) {
+    return JS_EXCEPTION;
+  }
+  std::vector<uint32_t> found;
+  if (magic == 0) {
+    handle->doc->FindByTagName(root, std::string_view(name, len), &found);
+  } else {
+    handle->doc->FindByClassName(root, std::string_view(name, len), &found);
+  }
+  JS_FreeCString(ctx, name);
+  return NodeArray(ctx, found);
+}
+
+// 0: querySelector, 1: querySelectorAll
+JSValue JsQuerySelector(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv, int magic) {
+  NativeHtmlDocument* handle;
+  uint32_t root;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &root)) {
+    return JS_EXCEPTION;
+  }
+  const HtmlSelector* selector = GetSelector(ctx, handle, argc, argv);
+  if (!selector) {
+    return JS_EXCEPTION;
+  }
+  std::vector<uint32_t> found;
+  selector->Select(*handle->doc, root, magic == 0, &found);
+  if (magic == 0) {
+    return NodeValue(ctx, found.empty() ? kHtmlNoNode : found[0]);
+  }
+  return NodeArray(ctx, found);
+}
+
+JSValue JsMatches(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  NativeHtmlDocument* handle;
+  uint32_t id;
+  if (!GetNode(ctx, this_val, argc, argv, &handle, &id)) {
+    return JS_EXCEPTION;
+  }
+  const HtmlSelector* selector = GetSelector(ctx, handle, argc, argv);
+  if (!selector) {
+    return JS_EXCEPTION;
+  }
+  return JS_NewBool(ctx, selector->Matches(*handle->doc, id));
+}
+
+// options: { title, scripts, forms, meta: bool, attributes: ["a[href]", ...] }
+bool GetExtractOptions(JSContext* ctx, JSValueConst obj, HtmlExtractOptions* options) {
+  static const struct {
+    const char* name;
+    bool HtmlExtractOptions::*field;
+  } kFlags[] = {
+    {"title", &HtmlExtractOptions::title},
+    {"scripts", &HtmlExtractOptions::scripts},
+    {"forms", &HtmlExtractOptions::forms},
+    {"meta", &HtmlExtractOptions::meta},
+  };
+  for (const auto& flag : kFlags) {
+    JSValue value = JS_GetPropertyStr(ctx, obj, flag.name);
+    if (JS_IsException(value)) {
+      return false;
+    }
+    if (!JS_IsUndefined(value)) {
+      options->*flag.field = JS_ToBool(ctx, value);
+    }
+    JS_FreeValue(ctx, value);
+  }
+
+  JSValue attributes = JS_GetPropertyStr(ctx, obj, "attributes");
+  if (JS_IsException(attributes)) {
+    return false;
+  }
+  bool ok = true;
+  if (!JS_IsUndefined(attributes)) {
+    int64_t length = 0;
+    ok = !JS_GetLength(ctx, attributes, &length);
+    for (int64_t i = 0; ok && i < length; i++) {
+      JSValue item = JS_GetPropertyUint32(ctx, attributes, (uint32_t) i);
+      size_t len = 0;
+      const char* spec = JS_ToCStringLen(ctx, &len, item);
+      JS_FreeValue(ctx, item);
+      if (!spec) {
+        ok = false;
+        break;
+      }
+      if (!options->AddAttribute(std::string_view(spec, len))) {
+        JS_ThrowTypeError(ctx, "html_extract: invalid attribute '%s'", spec);
+        ok = false;
+      }
+      JS_FreeCString(ctx, spec);
+    }
+  }
+  JS_FreeValue(ctx, attributes);
+  return ok;
+}
+
+// html_extract(source, options) -> ArrayBuffer (msgpack, html_extract.h)
+JSValue JsHtmlExtract(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  HtmlExtractOptions options;
+  if (argc > 1 && JS_IsObject(argv[1]) && !GetExtractOptions(ctx, argv[1], &options)) {
+    return JS_EXCEPTION;
+  }
+  JsBytes source;
+  if (argc > 0 && !JS_IsUndefined(argv[0]) && !JS_IsNull(argv[0]) && !source.Get(ctx, argv[0])) {
+    return JS_EXCEPTION;
+  }
+  HtmlExtractor extractor(options);
+  extractor.Feed(reinterpret_cast<const char*>(source.data), source.len);
+  extractor.Finish();
+  source.Free(ctx);
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  extractor.Pack(&pk);
+  return JS_NewArrayBufferCopy(ctx, reinterpret_cast<const uint8_t*>(sbuf.data()), sbuf.size());
+}
+
+const JSCFunctionListEntry kHtmlDocumentProto[] = {
+  JS_CFUNC_DEF("documentElement", 0, JsDocumentElement),
+  JS_CFUNC_DEF("head", 0, JsHead),
+  JS_CFUNC_DEF("body", 0, JsBody),
+  JS_CFUNC_DEF("nodeType", 1, JsNodeType),
+  JS_CFUNC_DEF("nodeName", 1, JsNodeName),
+  JS_CFUNC_MAGIC_DEF("parent", 1, JsRelative, 0),
+  JS_CFUNC_MAGIC_DEF("firstChild", 1, JsRelative, 1),
+  JS_CFUNC_MAGIC_DEF("lastChild", 1, JsRelative, 2),
+  JS_CFUNC_MAGIC_DEF("previousSibling", 1, JsRelative, 3),
+  JS_CFUNC_MAGIC_DEF("nextSibling", 1, JsRelative, 4),
+  JS_CFUNC_DEF("childNodes", 1, JsChildNodes),
+  JS_CFUNC_DEF("data", 1, JsData),
+  JS_CFUNC_DEF("attributes", 1, JsAttributes),
+  JS_CFUNC_DEF("getAttribute", 2, JsGetAttribute),
+  JS_CFUNC_MAGIC_DEF("textContent", 1, JsSerialize, 0),
+  JS_CFUNC_MAGIC_DEF("outerHTML", 1, JsSerialize, 1),
+  JS_CFUNC_MAGIC_DEF("innerHTML", 1, JsSerialize, 2),
+  JS_CFUNC_DEF("getElementById", 2, JsGetElementById),
+  JS_CFUNC_MAGIC_DEF("getElementsByTagName", 2, JsGetElementsBy, 0),
+  JS_CFUNC_MAGIC_DEF("getElementsByClassName", 2, JsGetElementsBy, 1),
+  JS_CFUNC_MAGIC_DEF("querySelector", 2, JsQuerySelector, 0),
+  JS_CFUNC_MAGIC_DEF("querySelectorAll", 2, JsQuerySelector, 1),
+  JS_CFUNC_DEF("matches", 2, JsMatches),
+};
+
+}  // anonymous
+
+JSValue NewHtmlDocumentObject(JSContext* ctx, HtmlDocumentPtr doc) {
+  JSValue obj = JS_NewObjectClass(ctx, html_document_class_id);
+  if (JS_IsException(obj)) {
+    return obj;
+  }
+  void* mem = js_malloc(ctx, sizeof(NativeHtmlDocument));
+  if (!mem) {
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+  }
+  NativeHtmlDocument* handle = new (mem) NativeHtmlDocument();
+  handle->doc = std::move(doc);
+  JS_SetOpaque(obj, handle);
+  return obj;
+}
+
+void RegisterHtmlDom(JSContext* ctx, JSValueConst sys_host) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  std::call_once(html_document_class_once, [rt] {
+    JS_NewClassID(rt, &html_document_class_id);
+  });
+  if (!JS_IsRegisteredClass(rt, html_document_class_id)) {
+    JS_NewClass(rt, html_document_class_id, &kHtmlDocumentClass);
+  }
+
+  JSValue proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, kHtmlDocumentProto,
+                             sizeof(kHtmlDocumentProto) / sizeof(kHtmlDocumentProto[0]));
+  JS_SetClassProto(ctx, html_document_class_id, proto);
+
+  JS_SetPropertyStr(ctx, sys_host, "html_parse",
+    JS_NewCFunction(ctx, JsHtmlParse, "html_parse", 1));
+  JS_SetPropertyStr(ctx, sys_host, "html_extract",
+    JS_NewCFunction(ctx, JsHtmlExtract, "html_extract", 2));
+}
+
+}  // namespace request_unraver
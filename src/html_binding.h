@@ -0,0 +1,29 @@
+#ifndef REQUEST_UNRAVER_HTML_BINDING_H_
+#define REQUEST_UNRAVER_HTML_BINDING_H_
+
+#include <memory>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+#include "html_dom.h"
+
+namespace request_unraver {
+
+// HtmlDocument (arena DOM) 를 guest 에 노출
+//
+//   __sys_host.html_parse(source)
+//   __sys_host.html_extract(source, options)
+//
+// 반환된 NativeHtmlDocument 는 node 를 index (정수, 없으면 -1) 로 다루는 읽기 전용
+// 접근자를 가진다. DOM 형태의 wrapper 는 pseudo-browser 의 native-dom.js 가 만든다.
+// html_extract 는 DOM 없이 HtmlExtractor 결과 (msgpack) 를 ArrayBuffer 로 반환한다.
+void RegisterHtmlDom(JSContext* ctx, JSValueConst sys_host);
+
+// 이미 파싱된 문서를 NativeHtmlDocument 객체로 감싼다 (RegisterHtmlDom 이후)
+JSValue NewHtmlDocumentObject(JSContext* ctx, HtmlDocumentPtr doc);
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_HTML_BINDING_H_
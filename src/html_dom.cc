@@ -0,0 +1,794 @@
+#include "html_dom.h"
+
+#include <cstring>
+#include <utility>
+
+#include "html_tokenizer.h"
+
+namespace request_unraver {
+
+namespace {
+
+bool IsOneOf(std::string_view name, std::initializer_list<const char*> names) {
+  for (const char* candidate : names) {
+    if (name == candidate) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsVoidElement(std::string_view name) {
+  return IsOneOf(name, {"area", "base", "br", "col", "embed", "hr", "img", "input", "keygen",
+                        "link", "meta", "param", "source", "track", "wbr"});
+}
+
+bool IsHeadContent(std::string_view name) {
+  return IsOneOf(name, {"base", "basefont", "bgsound", "link", "meta", "noscript", "script",
+                        "style", "template", "title"});
+}
+
+// 열려 있는 <p> 를 닫는 start tag
+bool ClosesParagraph(std::string_view name) {
+  return IsOneOf(name, {"address", "article", "aside", "blockquote", "center", "dd", "details",
+                        "dialog", "dir", "div", "dl", "dt", "fieldset", "figcaption", "figure",
+                        "footer", "form", "h1", "h2", "h3", "h4", "h5", "h6", "header", "hgroup",
+                        "hr", "li", "listing", "main", "menu", "nav", "ol", "p", "plaintext",
+                        "pre", "section", "summary", "table", "ul", "xmp"});
+}
+
+bool IsHeading(std::string_view name) {
+  return name.size() == 2 && name[0] == 'h' && name[1] >= '1' && name[1] <= '6';
+}
+
+// end tag 검색이 넘어가지 않는 scope 경계
+bool IsScopeBoundary(std::string_view name) {
+  return IsOneOf(name, {"applet", "caption", "html", "marquee", "object", "table", "td", "template",
+                        "th"});
+}
+
+bool IsRawTextParent(std::string_view name) {
+  return IsOneOf(name, {"iframe", "noembed", "noframes", "plaintext", "script", "style", "xmp"});
+}
+
+bool IsHtmlWhitespace(std::string_view text) {
+  for (char c : text) {
+    if (c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != '\f') {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AppendEscaped(std::string* out, std::string_view text, bool attribute) {
+  size_t start = 0;
+  for (size_t i = 0; i < text.size(); i++) {
+    const char* replacement = nullptr;
+    size_t skip = 1;
+    char c = text[i];
+    if (c == '&') {
+      replacement = "&amp;";
+    } else if (c == '"' && attribute) {
+      replacement = "&quot;";
+    } else if (c == '<' && !attribute) {
+      replacement = "&lt;";
+    } else if (c == '>' && !attribute) {
+      replacement = "&gt;";
+    } else if (c == '\xc2' && i + 1 < text.size() && text[i + 1] == '\xa0') {
+      replacement = "&nbsp;";
+      skip = 2;
+    }
+    if (replacement) {
+      out->append(text.data() + start, i - start);
+      out->append(replacement);
+      start = i + skip;
+      i += skip - 1;
+    }
+  }
+  out->append(text.data() + start, text.size() - start);
+}
+
+}  // anonymous
+
+// 간소화된 HTML5 tree construction
+//
+// insertion mode 는 before html / before head / in head / after head / in body 만
+// 구분한다. p/li/dd/dt/option/table 행의 암묵적 닫힘과 void element 를 처리하고,
+// foster parenting 과 adoption agency 는 생략한다.
+class HtmlTreeBuilder : public HtmlTokenSink {
+ public:
+  explicit HtmlTreeBuilder(HtmlDocument* doc) : doc_(doc), mode_(kBeforeHtml) {
+    open_.push_back(0);
+  }
+
+  void OnStartTag(const HtmlStartTag& tag) override {
+    if (doc_->out_of_memory_) {
+      return;
+    }
+    const std::string& name = tag.name;
+    if (name == "html") {
+      if (doc_->html_ == kHtmlNoNode) {
+        doc_->html_ = InsertElement(tag, true);
+        mode_ = kBeforeHead;
+      }
+      return;
+    }
+    EnsureHtml();
+    if (name == "head") {
+      if (mode_ == kBeforeHead) {
+        doc_->head_ = InsertElement(tag, true);
+        mode_ = kInHead;
+      }
+      return;
+    }
+    if (name == "body") {
+      if (doc_->body_ == kHtmlNoNode) {
+        EnsureHead();
+        CloseHead();
+        doc_->body_ = InsertElement(tag, true);
+        mode_ = kInBody;
+      }
+      return;
+    }
+
+    if (mode_ != kInBody && !InsideContentElement()) {
+      if (IsHeadContent(name)) {
+        EnsureHead();
+        if (mode_ == kAfterHead) {
+          // after head 의 head content 는 head 에 넣는다
+          open_.push_back(doc_->head_);
+          mode_ = kInHead;
+        }
+      } else {
+        EnsureBody();
+      }
+    }
+
+    ImplicitClose(name);
+    bool push = !IsVoidElement(name) && !(tag.self_closing && InForeignContent(name));
+    InsertElement(tag, push);
+  }
+
+  void OnEndTag(std::string_view name) override {
+    if (doc_->out_of_memory_) {
+      return;
+    }
+    if (name == "head") {
+      if (mode_ == kInHead && open_.back() == doc_->head_) {
+        CloseHead();
+      }
+      return;
+    }
+    if (name == "body" || name == "html") {
+      return;
+    }
+    if (name == "br") {
+      HtmlStartTag br;
+      br.name = "br";
+      OnStartTag(br);
+      return;
+    }
+
+    for (size_t i = open_.size() - 1; i > 0; i--) {
+      uint32_t id = open_[i];
+      std::string_view open_name = doc_->Name(id);
+      if (open_name == name) {
+        if (id == doc_->html_ || id == doc_->body_) {
+          return;
+        }
+        PopTo(i);
+        if (id == doc_->head_) {
+          mode_ = kAfterHead;
+        }
+        return;
+      }
+      if (IsScopeBoundary(open_name) || id == doc_->body_ || id == doc_->head_) {
+        break;
+      }
+    }
+    // 열린 <p> 없이 </p> 가 오면 빈 p 를 만든다
+    if (name == "p" && mode_ == kInBody) {
+      HtmlStartTag p;
+      p.name = "p";
+      InsertElement(p, false);
+    }
+  }
+
+  void OnText(std::string_view text) override {
+    if (doc_->out_of_memory_) {
+      return;
+    }
+    if (mode_ != kInBody && !InsideContentElement()) {
+      if (IsHtmlWhitespace(text)) {
+        if (mode_ == kInHead || mode_ == kAfterHead) {
+          AppendText(open_.back(), text);
+        }
+        return;
+      }
+      if (mode_ < kInHead) {
+        // 앞쪽 공백은 버린다
+        size_t skip = 0;
+        while (IsHtmlWhitespace(text.substr(skip, 1))) {
+          skip++;
+        }
+        text.remove_prefix(skip);
+      }
+      EnsureBody();
+    }
+    AppendText(open_.back(), text);
+  }
+
+  void OnComment(std::string_view data) override {
+    if (doc_->out_of_memory_) {
+      return;
+    }
+    uint32_t id = doc_->NewNode(kHtmlCommentNode, open_.back());
+    HtmlNode& node = doc_->nodes_[id];
+    node.data_offset = doc_->AppendChars(data);
+    node.data_length = (uint32_t) data.size();
+  }
+
+  void OnDoctype(std::string_view data) override {
+    if (mode_ != kBeforeHtml || doc_->out_of_memory_) {
+      return;
+    }
+    uint32_t id = doc_->NewNode(kHtmlDocumentTypeNode, 0);
+    HtmlNode& node = doc_->nodes_[id];
+    node.data_offset = doc_->AppendChars(data);
+    node.data_length = (uint32_t) data.size();
+  }
+
+  void Finish() {
+    if (!doc_->out_of_memory_) {
+      EnsureBody();
+    }
+  }
+
+ private:
+  enum Mode {
+    kBeforeHtml,
+    kBeforeHead,
+    kInHead,
+    kAfterHead,
+    kInBody,
+  };
+
+  uint32_t InsertElement(const HtmlStartTag& tag, bool push) {
+    uint32_t id = doc_->NewNode(kHtmlElementNode, open_.back());
+    uint32_t name = doc_->InternName(tag.name);
+    uint32_t attr_begin = (uint32_t) doc_->attributes_.size();
+    for (size_t i = 0; i < tag.attribute_count; i++) {
+      const HtmlAttribute& attr = tag.attributes[i];
+      HtmlNodeAttribute node_attr;
+      node_attr.name = doc_->InternName(attr.name);
+      node_attr.value_offset = doc_->AppendChars(attr.value);
+      node_attr.value_length = (uint32_t) attr.value.size();
+      doc_->attributes_.push_back(node_attr);
+    }
+    HtmlNode& node = doc_->nodes_[id];
+    node.name = name;
+    node.attr_begin = attr_begin;
+    node.attr_count = (uint32_t) tag.attribute_count;
+    if (push) {
+      open_.push_back(id);
+    }
+    return id;
+  }
+
+  HtmlStartTag Synthetic(const char* name) {
+    HtmlStartTag tag;
+    tag.name = name;
+    return tag;
+  }
+
+  void EnsureHtml() {
+    if (doc_->html_ == kHtmlNoNode) {
+      doc_->html_ = InsertElement(Synthetic("html"), true);
+      mode_ = kBeforeHead;
+    }
+  }
+
+  void EnsureHead() {
+    EnsureHtml();
+    if (doc_->head_ == kHtmlNoNode) {
+      doc_->head_ = InsertElement(Synthetic("head"), true);
+      mode_ = kInHead;
+    }
+  }
+
+  void CloseHead() {
+    for (size_t i = open_.size() - 1; i > 0; i--) {
+      if (open_[i] == doc_->head_) {
+        PopTo(i);
+        break;
+      }
+    }
+    mode_ = kAfterHead;
+  }
+
+  void EnsureBody() {
+    if (doc_->body_ != kHtmlNoNode) {
+      return;
+    }
+    EnsureHead();
+    CloseHead();
+    doc_->body_ = InsertElement(Synthetic("body"), true);
+    mode_ = kInBody;
+  }
+
+  // head 의 title/script 등 안쪽
+  bool InsideContentElement() const {
+    uint32_t current = open_.back();
+    return current != 0 && current != doc_->html_ && current != doc_->head_;
+  }
+
+  bool InForeignContent(std::string_view name) const {
+    if (name == "svg" || name == "math") {
+      return true;
+    }
+    for (size_t i = open_.size() - 1; i > 0; i--) {
+      std::string_view open_name = doc_->Name(open_[i]);
+      if (open_name == "svg" || open_name == "math") {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // open_[index] 와 그 위를 모두 닫는다
+  void PopTo(size_t index) {
+    open_.resize(index);
+  }
+
+  // stack 위에서부터 targets 중 하나를 찾아 닫는다. stops 를 만나면 중단
+  void CloseNearest(std::initializer_list<const char*> targets,
+                    std::initializer_list<const char*> stops) {
+    for (size_t i = open_.size() - 1; i > 0; i--) {
+      uint32_t id = open_[i];
+      std::string_view open_name = doc_->Name(id);
+      if (IsOneOf(open_name, targets)) {
+        PopTo(i);
+        return;
+      }
+      if (IsOneOf(open_name, stops) || id == doc_->body_ || id == doc_->html_) {
+        return;
+      }
+    }
+  }
+
+  void ImplicitClose(std::string_view name) {
+    if (ClosesParagraph(name)) {
+      CloseNearest({"p"}, {"applet", "button", "caption", "marquee", "object", "table", "td", "th"});
+    }
+    if (IsHeading(name) && IsHeading(doc_->Name(open_.back()))) {
+      PopTo(open_.size() - 1);
+    }
+    if (name == "li") {
+      CloseNearest({"li"}, {"ol", "ul", "table", "td", "th"});
+    } else if (name == "dd" || name == "dt") {
+      CloseNearest({"dd", "dt"}, {"dl", "table", "td", "th"});
+    } else if (name == "option" || name == "optgroup") {
+      if (doc_->IsElement(open_.back(), "option")) {
+        PopTo(open_.size() - 1);
+      }
+      if (name == "optgroup" && doc_->IsElement(open_.back(), "optgroup")) {
+        PopTo(open_.size() - 1);
+      }
+    } else if (name == "tr") {
+      CloseNearest({"tr"}, {"table", "thead", "tbody", "tfoot"});
+    } else if (name == "td" || name == "th") {
+      CloseNearest({"td", "th"}, {"tr", "table"});
+    } else if (name == "thead" || name == "tbody" || name == "tfoot") {
+      CloseNearest({"thead", "tbody", "tfoot"}, {"table"});
+    } else if (name == "a") {
+      // 중첩될 수 없는 element
+      CloseNearest({"a"}, {"table", "td", "th"});
+    } else if (name == "button") {
+      CloseNearest({"button"}, {"table", "td", "th"});
+    } else if (name == "form") {
+      CloseNearest({"form"}, {"table", "td", "th"});
+    } else if (name == "select") {
+      CloseNearest({"select"}, {"table", "td", "th"});
+    }
+  }
+
+  void AppendText(uint32_t parent, std::string_view text) {
+    if (text.empty()) {
+      return;
+    }
+    uint32_t last = doc_->nodes_[parent].last_child;
+    if (last != kHtmlNoNode && doc_->nodes_[last].type == kHtmlTextNode) {
+      HtmlNode& node = doc_->nodes_[last];
+      if (node.data_offset + node.data_length == doc_->chars_.size()) {
+        doc_->chars_.append(text.data(), text.size());
+        node.data_length += (uint32_t) text.size();
+        return;
+      }
+    }
+    uint32_t id = doc_->NewNode(kHtmlTextNode, parent);
+    HtmlNode& node = doc_->nodes_[id];
+    node.data_offset = doc_->AppendChars(text);
+    node.data_length = (uint32_t) text.size();
+  }
+
+  HtmlDocument* doc_;
+  Mode mode_;
+  std::vector<uint32_t> open_;
+};
+
+void HtmlDocumentDeleter::operator()(HtmlDocument* doc) const {
+  JSRuntime* rt = doc->runtime();
+  doc->~HtmlDocument();
+  js_free_rt(rt, doc);
+}
+
+HtmlDocumentPtr HtmlDocument::Parse(JSRuntime* rt, std::string_view html) {
+  HtmlDocumentParser parser(rt, html.size());
+  parser.Feed(html.data(), html.size());
+  return parser.Finish();
+}
+
+HtmlDocumentPtr HtmlDocument::Create(JSRuntime* rt) {
+  void* mem = js_malloc_rt(rt, sizeof(HtmlDocument));
+  if (!mem) {
+    return nullptr;
+  }
+  return HtmlDocumentPtr(new (mem) HtmlDocument(rt));
+}
+
+HtmlDocumentParser::HtmlDocumentParser(JSRuntime* rt, size_t size_hint)
+  : doc_(HtmlDocument::Create(rt)) {
+  if (!doc_) {
+    return;
+  }
+  builder_ = std::make_unique<HtmlTreeBuilder>(doc_.get());
+  tokenizer_ = std::make_unique<HtmlTokenizer>(builder_.get());
+  if (size_hint) {
+    // 대략 20 byte 당 node 하나
+    doc_->nodes_.reserve(size_hint / 20 + 8);
+    doc_->chars_.reserve(size_hint / 2);
+  }
+}
+
+HtmlDocumentParser::~HtmlDocumentParser() = default;
+
+void HtmlDocumentParser::Feed(const char* data, size_t len) {
+  if (tokenizer_ && !doc_->out_of_memory_) {
+    tokenizer_->Feed(data, len);
+  }
+}
+
+HtmlDocumentPtr HtmlDocumentParser::Finish() {
+  if (!tokenizer_) {
+    return nullptr;
+  }
+  tokenizer_->Finish();
+  builder_->Finish();
+  tokenizer_.reset();
+  builder_.reset();
+  if (doc_->out_of_memory_) {
+    doc_.reset();
+  }
+  return std::move(doc_);
+}
+
+HtmlDocument::HtmlDocument(JSRuntime* rt)
+  : rt_(rt),
+    out_of_memory_(false),
+    nodes_(HtmlAllocator<HtmlNode>(rt, &out_of_memory_)),
+    attributes_(HtmlAllocator<HtmlNodeAttribute>(rt, &out_of_memory_)),
+    chars_(HtmlAllocator<char>(rt, &out_of_memory_)),
+    names_(HtmlAllocator<HtmlString>(rt, &out_of_memory_)),
+    name_index_(0, HtmlStringHash(), std::equal_to<HtmlString>(),
+                HtmlAllocator<std::pair<const HtmlString, uint32_t>>(rt, &out_of_memory_)),
+    html_(kHtmlNoNode),
+    head_(kHtmlNoNode),
+    body_(kHtmlNoNode) {
+  NewNode(kHtmlDocumentNode, kHtmlNoNode);
+}
+
+uint32_t HtmlDocument::InternName(std::string_view name) {
+  HtmlString key(name, HtmlAllocator<char>(rt_, &out_of_memory_));
+  auto it = name_index_.find(key);
+  if (it != name_index_.end()) {
+    return it->second;
+  }
+  uint32_t id = (uint32_t) names_.size();
+  names_.push_back(key);
+  name_index_.emplace(std::move(key), id);
+  return id;
+}
+
+uint32_t HtmlDocument::AppendChars(std::string_view data) {
+  uint32_t offset = (uint32_t) chars_.size();
+  chars_.append(data.data(), data.size());
+  return offset;
+}
+
+uint32_t HtmlDocument::NewNode(HtmlNodeType type, uint32_t parent) {
+  uint32_t id = (uint32_t) nodes_.size();
+  HtmlNode node;
+  node.type = type;
+  node.parent = parent;
+  node.first_child = kHtmlNoNode;
+  node.last_child = kHtmlNoNode;
+  node.prev_sibling = kHtmlNoNode;
+  node.next_sibling = kHtmlNoNode;
+  node.name = 0;
+  node.data_offset = 0;
+  node.data_length = 0;
+  node.attr_begin = 0;
+  node.attr_count = 0;
+  if (parent != kHtmlNoNode) {
+    HtmlNode& p = nodes_[parent];
+    node.prev_sibling = p.last_child;
+    if (p.last_child != kHtmlNoNode) {
+      nodes_[p.last_child].next_sibling = id;
+    } else {
+      p.first_child = id;
+    }
+    p.last_child = id;
+  }
+  nodes_.push_back(node);
+  return id;
+}
+
+std::string_view HtmlDocument::Name(uint32_t id) const {
+  if (id >= nodes_.size() || nodes_[id].type != kHtmlElementNode) {
+    return std::string_view();
+  }
+  return names_[nodes_[id].name];
+}
+
+std::string_view HtmlDocument::Data(uint32_t id) const {
+  if (id >= nodes_.size()) {
+    return std::string_view();
+  }
+  const HtmlNode& node = nodes_[id];
+  return std::string_view(chars_).substr(node.data_offset, node.data_length);
+}
+
+bool HtmlDocument::IsElement(uint32_t id, std::string_view name) const {
+  return Name(id) == name;
+}
+
+std::string_view HtmlDocument::AttributeName(uint32_t id, uint32_t index) const {
+  const HtmlNode& node = nodes_[id];
+  if (index >= node.attr_count) {
+    return std::string_view();
+  }
+  return names_[attributes_[node.attr_begin + index].name];
+}
+
+std::string_view HtmlDocument::AttributeValue(uint32_t id, uint32_t index) const {
+  const HtmlNode& node = nodes_[id];
+  if (index >= node.attr_count) {
+    return std::string_view();
+  }
+  const HtmlNodeAttribute& attr = attributes_[node.attr_begin + index];
+  return std::string_view(chars_).substr(attr.value_offset, attr.value_length);
+}
+
+bool HtmlDocument::GetAttribute(uint32_t id, std::string_view name, std::string_view* value) const {
+  const HtmlNode& node = nodes_[id];
+  for (uint32_t i = 0; i < node.attr_count; i++) {
+    const HtmlNodeAttribute& attr = attributes_[node.attr_begin + i];
+    if (names_[attr.name] == name) {
+      *value = std::string_view(chars_).substr(attr.value_offset, attr.value_length);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HtmlDocument::HasClass(uint32_t id, std::string_view class_name) const {
+  std::string_view classes;
+  if (!GetAttribute(id, "class", &classes)) {
+    return false;
+  }
+  size_t pos = 0;
+  while (pos < classes.size()) {
+    while (pos < classes.size() && IsHtmlWhitespace(classes.substr(pos, 1))) {
+      pos++;
+    }
+    size_t end = pos;
+    while (end < classes.size() && !IsHtmlWhitespace(classes.substr(end, 1))) {
+      end++;
+    }
+    if (end > pos && classes.substr(pos, end - pos) == class_name) {
+      return true;
+    }
+    pos = end;
+  }
+  return false;
+}
+
+uint32_t HtmlDocument::NextInTree(uint32_t id, uint32_t root) const {
+  const HtmlNode& node = nodes_[id];
+  if (node.first_child != kHtmlNoNode) {
+    return node.first_child;
+  }
+  while (id != root && id != kHtmlNoNode) {
+    if (nodes_[id].next_sibling != kHtmlNoNode) {
+      return nodes_[id].next_sibling;
+    }
+    id = nodes_[id].parent;
+  }
+  return kHtmlNoNode;
+}
+
+void HtmlDocument::TextContent(uint32_t id, std::string* out) const {
+  const HtmlNode& node = nodes_[id];
+  if (node.type == kHtmlTextNode || node.type == kHtmlCommentNode) {
+    out->append(Data(id));
+    return;
+  }
+  for (uint32_t cur = NextInTree(id, id); cur != kHtmlNoNode; cur = NextInTree(cur, id)) {
+    if (nodes_[cur].type == kHtmlTextNode) {
+      out->append(Data(cur));
+    }
+  }
+}
+
+void HtmlDocument::AppendStartTag(uint32_t id, std::string* out) const {
+  const HtmlNode& node = nodes_[id];
+  out->push_back('<');
+  out->append(Name(id));
+  for (uint32_t i = 0; i < node.attr_count; i++) {
+    out->push_back(' ');
+    out->append(AttributeName(id, i));
+    out->append("=\"");
+    AppendEscaped(out, AttributeValue(id, i), true);
+    out->push_back('"');
+  }
+  out->push_back('>');
+}
+
+void HtmlDocument::AppendEndTag(uint32_t id, std::string* out) const {
+  out->append("</");
+  out->append(Name(id));
+  out->push_back('>');
+}
+
+void HtmlDocument::AppendLeaf(uint32_t id, std::string* out) const {
+  const HtmlNode& node = nodes_[id];
+  switch (node.type) {
+    case kHtmlTextNode:
+      if (IsRawTextParent(Name(node.parent))) {
+        out->append(Data(id));
+      } else {
+        AppendEscaped(out, Data(id), false);
+      }
+      break;
+    case kHtmlCommentNode:
+      out->append("<!--");
+      out->append(Data(id));
+      out->append("-->");
+      break;
+    case kHtmlDocumentTypeNode:
+      out->append("<!DOCTYPE ");
+      out->append(Data(id));
+      out->append(">");
+      break;
+    default:
+      break;
+  }
+}
+
+// 깊게 중첩된 문서에서도 stack 을 쓰지 않도록 parent 를 따라 올라가며 닫는다
+void HtmlDocument::Serialize(uint32_t id, bool outer, std::string* out) const {
+  const HtmlNode& root = nodes_[id];
+  if (root.type != kHtmlElementNode && root.type != kHtmlDocumentNode) {
+    AppendLeaf(id, out);
+    return;
+  }
+  bool root_tag = outer && root.type == kHtmlElementNode;
+  if (root_tag) {
+    AppendStartTag(id, out);
+    if (IsVoidElement(Name(id))) {
+      return;
+    }
+  }
+
+  uint32_t cur = root.first_child;
+  while (cur != kHtmlNoNode) {
+    const HtmlNode& node = nodes_[cur];
+    if (node.type == kHtmlElementNode) {
+      AppendStartTag(cur, out);
+      if (!IsVoidElement(Name(cur))) {
+        if (node.first_child != kHtmlNoNode) {
+          cur = node.first_child;
+          continue;
+        }
+        AppendEndTag(cur, out);
+      }
+    } else {
+      AppendLeaf(cur, out);
+    }
+    // 다음 sibling 이 없으면 올라가면서 닫는다
+    while (cur != id && nodes_[cur].next_sibling == kHtmlNoNode) {
+      cur = nodes_[cur].parent;
+      if (cur != id) {
+        AppendEndTag(cur, out);
+      }
+    }
+    cur = cur == id ? kHtmlNoNode : nodes_[cur].next_sibling;
+  }
+
+  if (root_tag) {
+    AppendEndTag(id, out);
+  }
+}
+
+uint32_t HtmlDocument::FindById(uint32_t root, std::string_view id) const {
+  std::string_view value;
+  for (uint32_t cur = NextInTree(root, root); cur != kHtmlNoNode; cur = NextInTree(cur, root)) {
+    if (nodes_[cur].type == kHtmlElementNode && GetAttribute(cur, "id", &value) && value == id) {
+      return cur;
+    }
+  }
+  return kHtmlNoNode;
+}
+
+void HtmlDocument::FindByTagName(uint32_t root, std::string_view name,
+                                 std::vector<uint32_t>* out) const {
+  bool any = name == "*";
+  uint32_t name_id = 0;
+  if (!any) {
+    // 조회용 임시 key: 한도에 걸려도 완성된 문서에는 영향이 없다
+    bool key_out_of_memory = false;
+    auto it = name_index_.find(HtmlString(name, HtmlAllocator<char>(rt_, &key_out_of_memory)));
+    if (it == name_index_.end()) {
+      return;
+    }
+    name_id = it->second;
+  }
+  for (uint32_t cur = NextInTree(root, root); cur != kHtmlNoNode; cur = NextInTree(cur, root)) {
+    const HtmlNode& node = nodes_[cur];
+    if (node.type == kHtmlElementNode && (any || node.name == name_id)) {
+      out->push_back(cur);
+    }
+  }
+}
+
+void HtmlDocument::FindByClassName(uint32_t root, std::string_view names,
+                                   std::vector<uint32_t>* out) const {
+  std::vector<std::string_view> wanted;
+  size_t pos = 0;
+  while (pos < names.size()) {
+    size_t end = names.find(' ', pos);
+    if (end == std::string_view::npos) {
+      end = names.size();
+    }
+    if (end > pos) {
+      wanted.push_back(names.substr(pos, end - pos));
+    }
+    pos = end + 1;
+  }
+  if (wanted.empty()) {
+    return;
+  }
+  for (uint32_t cur = NextInTree(root, root); cur != kHtmlNoNode; cur = NextInTree(cur, root)) {
+    if (nodes_[cur].type != kHtmlElementNode) {
+      continue;
+    }
+    bool match = true;
+    for (std::string_view class_name : wanted) {
+      if (!HasClass(cur, class_name)) {
+        match = false;
+        break;
+      }
+    }
+    if (match) {
+      out->push_back(cur);
+    }
+  }
+}
+
+size_t HtmlDocument::memory_usage() const {
+  return nodes_.capacity() * sizeof(HtmlNode) +
+         attributes_.capacity() * sizeof(HtmlNodeAttribute) +
+         chars_.capacity();
+}
+
+}  // namespace request_unraver
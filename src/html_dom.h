@@ -0,0 +1,242 @@
+#ifndef REQUEST_UNRAVER_HTML_DOM_H_
+#define REQUEST_UNRAVER_HTML_DOM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+class HtmlDocument;
+class HtmlTokenizer;
+class HtmlTreeBuilder;
+
+constexpr uint32_t kHtmlNoNode = 0xffffffff;
+
+// runtime allocator (js_malloc_rt) 로 할당하는 STL allocator
+//
+// document 메모리도 engine allocator 를 거치므로 runtime 메모리 사용량과
+// window 별 메모리 집계에 포함된다.
+//
+// 예외 없이 빌드되므로 bad_alloc 을 던질 수 없고, STL container 에 nullptr 을
+// 돌려줄 수도 없다. runtime 한도에 걸리면 *out_of_memory 를 세우고 malloc 으로
+// 대신 할당한다. tree builder 는 이 표시를 보고 멈추며 parser 는 nullptr 을 반환한다.
+template <typename T>
+class HtmlAllocator {
+ public:
+  using value_type = T;
+
+  HtmlAllocator(JSRuntime* rt, bool* out_of_memory) : rt_(rt), out_of_memory_(out_of_memory) {}
+  template <typename U>
+  HtmlAllocator(const HtmlAllocator<U>& other)
+    : rt_(other.runtime()), out_of_memory_(other.out_of_memory_flag()) {}
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= kHeaderSize, "header must keep payload alignment");
+    size_t size = kHeaderSize + n * sizeof(T);
+    uint8_t* header = static_cast<uint8_t*>(js_malloc_rt(rt_, size));
+    uint8_t tag = kRuntimeBlock;
+    if (!header) {
+      *out_of_memory_ = true;
+      header = static_cast<uint8_t*>(malloc(size));
+      tag = kFallbackBlock;
+      if (!header) {
+        abort();
+      }
+    }
+    header[0] = tag;
+    return reinterpret_cast<T*>(header + kHeaderSize);
+  }
+  void deallocate(T* ptr, size_t) {
+    uint8_t* header = reinterpret_cast<uint8_t*>(ptr) - kHeaderSize;
+    if (header[0] == kFallbackBlock) {
+      free(header);
+    } else {
+      js_free_rt(rt_, header);
+    }
+  }
+
+  JSRuntime* runtime() const { return rt_; }
+  bool* out_of_memory_flag() const { return out_of_memory_; }
+
+  template <typename U>
+  bool operator==(const HtmlAllocator<U>& other) const { return rt_ == other.runtime(); }
+  template <typename U>
+  bool operator!=(const HtmlAllocator<U>& other) const { return rt_ != other.runtime(); }
+
+ private:
+  // 할당 출처 표시 (payload 의 8 byte 정렬 유지)
+  static constexpr size_t kHeaderSize = 8;
+  static constexpr uint8_t kRuntimeBlock = 0;
+  static constexpr uint8_t kFallbackBlock = 1;
+
+  JSRuntime* rt_;
+  bool* out_of_memory_;
+};
+
+template <typename T>
+using HtmlVector = std::vector<T, HtmlAllocator<T>>;
+using HtmlString = std::basic_string<char, std::char_traits<char>, HtmlAllocator<char>>;
+
+struct HtmlStringHash {
+  size_t operator()(const HtmlString& value) const {
+    return std::hash<std::string_view>()(std::string_view(value.data(), value.size()));
+  }
+};
+
+// HtmlDocument 자체도 runtime allocator 로 할당되므로 전용 deleter 로 해제한다
+struct HtmlDocumentDeleter {
+  void operator()(HtmlDocument* doc) const;
+};
+
+using HtmlDocumentPtr = std::unique_ptr<HtmlDocument, HtmlDocumentDeleter>;
+
+// DOM Node.nodeType 값
+enum HtmlNodeType : uint8_t {
+  kHtmlElementNode = 1,
+  kHtmlTextNode = 3,
+  kHtmlCommentNode = 8,
+  kHtmlDocumentNode = 9,
+  kHtmlDocumentTypeNode = 10,
+};
+
+// node 는 index 로 참조하며 모든 문자열은 document 의 chars_ 에 이어 붙인다.
+struct HtmlNode {
+  HtmlNodeType type;
+  uint32_t parent;
+  uint32_t first_child;
+  uint32_t last_child;
+  uint32_t prev_sibling;
+  uint32_t next_sibling;
+  // element: 이름 id (tag), 그 외: 미사용
+  uint32_t name;
+  // text/comment/doctype 의 data
+  uint32_t data_offset;
+  uint32_t data_length;
+  uint32_t attr_begin;
+  uint32_t attr_count;
+};
+
+struct HtmlNodeAttribute {
+  uint32_t name;
+  uint32_t value_offset;
+  uint32_t value_length;
+};
+
+// 읽기 전용 arena DOM
+//
+// Parse() 는 HtmlTokenizer 와 간소화된 HTML5 tree builder 로 html/head/body 를
+// 항상 갖춘 문서를 만든다. index 0 은 document node 이다.
+// node/문자열 버퍼는 rt 의 allocator 로 할당하며 문서는 rt 보다 먼저 해제해야 한다.
+class HtmlDocument {
+ public:
+  // 메모리가 부족하면 nullptr
+  static HtmlDocumentPtr Parse(JSRuntime* rt, std::string_view html);
+
+  HtmlDocument(const HtmlDocument&) = delete;
+  HtmlDocument& operator=(const HtmlDocument&) = delete;
+
+  size_t size() const { return nodes_.size(); }
+  bool IsValid(uint32_t id) const { return id < nodes_.size(); }
+  const HtmlNode& node(uint32_t id) const { return nodes_[id]; }
+
+  uint32_t document_element() const { return html_; }
+  uint32_t head() const { return head_; }
+  uint32_t body() const { return body_; }
+
+  // element 의 tag 이름 (소문자)
+  std::string_view Name(uint32_t id) const;
+  std::string_view Data(uint32_t id) const;
+  bool IsElement(uint32_t id, std::string_view name) const;
+
+  std::string_view AttributeName(uint32_t id, uint32_t index) const;
+  std::string_view AttributeValue(uint32_t id, uint32_t index) const;
+  bool GetAttribute(uint32_t id, std::string_view name, std::string_view* value) const;
+  bool HasClass(uint32_t id, std::string_view class_name) const;
+
+  void TextContent(uint32_t id, std::string* out) const;
+  void Serialize(uint32_t id, bool outer, std::string* out) const;
+
+  // root 의 자손 (root 제외) 을 문서 순서로 검색
+  uint32_t FindById(uint32_t root, std::string_view id) const;
+  void FindByTagName(uint32_t root, std::string_view name, std::vector<uint32_t>* out) const;
+  void FindByClassName(uint32_t root, std::string_view names, std::vector<uint32_t>* out) const;
+
+  // 문서 순서에서 root 하위 다음 node (없으면 kHtmlNoNode)
+  uint32_t NextInTree(uint32_t id, uint32_t root) const;
+
+  size_t memory_usage() const;
+
+  JSRuntime* runtime() const { return rt_; }
+  // runtime 메모리 한도에 걸려 문서가 완성되지 못함
+  bool out_of_memory() const { return out_of_memory_; }
+
+ private:
+  friend class HtmlDocumentParser;
+  friend class HtmlTreeBuilder;
+
+  explicit HtmlDocument(JSRuntime* rt);
+  static HtmlDocumentPtr Create(JSRuntime* rt);
+
+  uint32_t InternName(std::string_view name);
+  uint32_t AppendChars(std::string_view data);
+  uint32_t NewNode(HtmlNodeType type, uint32_t parent);
+
+  // 열기/닫기 tag 와 leaf node (text/comment/doctype)
+  void AppendStartTag(uint32_t id, std::string* out) const;
+  void AppendEndTag(uint32_t id, std::string* out) const;
+  void AppendLeaf(uint32_t id, std::string* out) const;
+
+  JSRuntime* rt_;
+  // container 보다 먼저 초기화되어야 한다 (HtmlAllocator)
+  bool out_of_memory_;
+  HtmlVector<HtmlNode> nodes_;
+  HtmlVector<HtmlNodeAttribute> attributes_;
+  HtmlString chars_;
+  HtmlVector<HtmlString> names_;
+  std::unordered_map<HtmlString, uint32_t, HtmlStringHash, std::equal_to<HtmlString>,
+                     HtmlAllocator<std::pair<const HtmlString, uint32_t>>> name_index_;
+
+  uint32_t html_;
+  uint32_t head_;
+  uint32_t body_;
+};
+
+// HtmlDocument::Parse 의 streaming 버전
+//
+// 조각을 Feed() 로 넣으면 그때까지의 token 으로 tree 를 만들어 두고,
+// Finish() 가 완성된 문서를 반환한다. 전체 입력을 한 문자열로 모으지 않는다.
+class HtmlDocumentParser {
+ public:
+  // size_hint: 예상 입력 크기 (알면 node/문자열 버퍼를 미리 잡는다)
+  explicit HtmlDocumentParser(JSRuntime* rt, size_t size_hint = 0);
+  ~HtmlDocumentParser();
+
+  HtmlDocumentParser(const HtmlDocumentParser&) = delete;
+  HtmlDocumentParser& operator=(const HtmlDocumentParser&) = delete;
+
+  void Feed(const char* data, size_t len);
+  // 이후 Feed/Finish 는 호출하지 않는다.
+  // runtime 메모리가 부족했으면 nullptr (JS_ThrowOutOfMemory 로 알린다)
+  HtmlDocumentPtr Finish();
+
+ private:
+  HtmlDocumentPtr doc_;
+  std::unique_ptr<HtmlTreeBuilder> builder_;
+  std::unique_ptr<HtmlTokenizer> tokenizer_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_HTML_DOM_H_
@@ -0,0 +1,478 @@
+#include "html_extract.h"
+
+#include <algorithm>
+
+#include "html_tokenizer.h"
+
+namespace request_unraver {
+
+namespace {
+
+using AttributeList = std::vector<std::pair<std::string, std::string>>;
+
+struct Field {
+  std::string tag;
+  std::string name;
+  std::string type;
+  std::string value;
+  bool has_checked = false;
+  bool checked = false;
+  // 문서 순서 (form= 로 연결된 field 를 끼워 넣을 때 사용)
+  size_t order = 0;
+  // form="id" 값 (form_fields_ 에 있는 field 만)
+  std::string owner;
+};
+
+struct Form {
+  AttributeList attributes;
+  std::vector<Field> fields;
+};
+
+struct Script {
+  std::string type;
+  std::string text;
+};
+
+struct MatchedAttribute {
+  std::string tag;
+  std::string name;
+  std::string value;
+};
+
+AttributeList CopyAttributes(const HtmlStartTag& tag) {
+  AttributeList attributes;
+  attributes.reserve(tag.attribute_count);
+  for (size_t i = 0; i < tag.attribute_count; i++) {
+    attributes.emplace_back(tag.attributes[i].name, tag.attributes[i].value);
+  }
+  return attributes;
+}
+
+std::string AttributeOr(const HtmlStartTag& tag, std::string_view name, std::string_view fallback) {
+  const HtmlAttribute* attr = tag.Find(name);
+  return std::string(attr ? std::string_view(attr->value) : fallback);
+}
+
+// option text 는 공백을 하나로 줄이고 앞뒤를 자른다 (option.text 와 동일)
+std::string CollapseWhitespace(std::string_view text) {
+  std::string out;
+  bool space = false;
+  for (char c : text) {
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f') {
+      space = !out.empty();
+      continue;
+    }
+    if (space) {
+      out.push_back(' ');
+      space = false;
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+void PackString(msgpack::packer<msgpack::sbuffer>* pk, std::string_view value) {
+  pk->pack_str((uint32_t) value.size());
+  pk->pack_str_body(value.data(), (uint32_t) value.size());
+}
+
+void PackAttributes(msgpack::packer<msgpack::sbuffer>* pk, const AttributeList& attributes) {
+  pk->pack_map((uint32_t) attributes.size());
+  for (const auto& attr : attributes) {
+    PackString(pk, attr.first);
+    PackString(pk, attr.second);
+  }
+}
+
+// HtmlExtractOptions 의 msgpack 표현을 읽는 visitor (예외 없이 실패를 기록)
+class OptionsVisitor : public msgpack::null_visitor {
+ public:
+  explicit OptionsVisitor(HtmlExtractOptions* options) : options_(options) {}
+
+  bool ok() const { return ok_; }
+
+  bool start_map(uint32_t) { depth_++; return true; }
+  bool end_map() { depth_--; return true; }
+  bool start_array(uint32_t) { depth_++; return true; }
+  bool end_array() { depth_--; return true; }
+  bool start_map_key() { in_key_ = true; return true; }
+  bool end_map_key() { in_key_ = false; return true; }
+
+  bool visit_str(const char* v, uint32_t size) {
+    if (depth_ == 1 && in_key_) {
+      key_.assign(v, size);
+    } else if (depth_ == 2 && key_ == "attributes") {
+      ok_ = options_->AddAttribute(std::string_view(v, size)) && ok_;
+    }
+    return true;
+  }
+
+  bool visit_boolean(bool v) {
+    if (depth_ != 1 || in_key_) {
+      return true;
+    }
+    if (key_ == "title") {
+      options_->title = v;
+    } else if (key_ == "scripts") {
+      options_->scripts = v;
+    } else if (key_ == "forms") {
+      options_->forms = v;
+    } else if (key_ == "meta") {
+      options_->meta = v;
+    }
+    return true;
+  }
+
+  void parse_error(size_t, size_t) { ok_ = false; }
+  void insufficient_bytes(size_t, size_t) { ok_ = false; }
+
+ private:
+  HtmlExtractOptions* options_;
+  int depth_ = 0;
+  bool in_key_ = false;
+  bool ok_ = true;
+  std::string key_;
+};
+
+}  // anonymous
+
+bool HtmlExtractOptions::FromMsgpack(const char* data, size_t len) {
+  OptionsVisitor visitor(this);
+  return msgpack::parse(data, len, visitor) && visitor.ok();
+}
+
+bool HtmlExtractOptions::AddAttribute(std::string_view spec) {
+  size_t open = spec.find('[');
+  if (open == std::string_view::npos || spec.empty() || spec.back() != ']' || open + 2 >= spec.size()) {
+    return false;
+  }
+  std::string tag(spec.substr(0, open));
+  std::string name(spec.substr(open + 1, spec.size() - open - 2));
+  for (char& c : tag) {
+    c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+  }
+  for (char& c : name) {
+    c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+  }
+  attributes.emplace_back(tag.empty() ? "*" : tag, name);
+  return true;
+}
+
+class HtmlExtractor::Sink : public HtmlTokenSink {
+ public:
+  explicit Sink(const HtmlExtractOptions& options) : options_(options), tokenizer_(this) {}
+
+  void OnStartTag(const HtmlStartTag& tag) override {
+    const std::string& name = tag.name;
+    MatchAttributes(tag);
+
+    if (name == "script") {
+      // src 가 있으면 본문은 무시되지만 tokenizer 는 여전히 raw text 로 넘겨준다
+      const HtmlAttribute* src = tag.Find("src");
+      if (src) {
+        if (options_.scripts) {
+          script_sources_.push_back(src->value);
+        }
+        text_target_ = nullptr;
+      } else if (options_.scripts) {
+        scripts_.emplace_back();
+        scripts_.back().type = AttributeOr(tag, "type", "");
+        text_target_ = &scripts_.back().text;
+      }
+      return;
+    }
+    if (name == "title") {
+      if (options_.title && !has_title_) {
+        has_title_ = true;
+        text_target_ = &title_;
+      }
+      return;
+    }
+    if (name == "meta") {
+      if (options_.meta) {
+        meta_.push_back(CopyAttributes(tag));
+      }
+      return;
+    }
+    if (!options_.forms) {
+      return;
+    }
+
+    if (name == "form") {
+      forms_.emplace_back();
+      forms_.back().attributes = CopyAttributes(tag);
+      in_form_ = true;
+      return;
+    }
+    bool listed = name == "input" || name == "button" || name == "textarea" || name == "select";
+    if (listed) {
+      // form="id" 가 있으면 바깥 form 이 아니라 그 id 의 form 에 속한다 (Finish 에서 연결)
+      const HtmlAttribute* owner = tag.Find("form");
+      if (owner) {
+        fields_ = &form_fields_;
+        owner_ = owner->value;
+      } else if (in_form_) {
+        fields_ = &forms_.back().fields;
+        owner_.clear();
+      } else {
+        return;
+      }
+    } else if (!in_form_ && select_ == kNoSelect) {
+      return;
+    }
+    if (name == "input" || name == "button") {
+      Field field;
+      field.tag = name;
+      field.name = AttributeOr(tag, "name", "");
+      field.type = AttributeOr(tag, "type", name == "input" ? "text" : "submit");
+      for (char& c : field.type) {
+        c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+      }
+      bool checkable = field.type == "checkbox" || field.type == "radio";
+      field.value = AttributeOr(tag, "value", checkable ? "on" : "");
+      if (checkable) {
+        field.has_checked = true;
+        field.checked = tag.Find("checked") != nullptr;
+      }
+      AddField(std::move(field));
+    } else if (name == "textarea") {
+      Field field;
+      field.tag = name;
+      field.name = AttributeOr(tag, "name", "");
+      field.type = "textarea";
+      AddField(std::move(field));
+      text_target_ = &fields_->back().value;
+    } else if (name == "select") {
+      Field field;
+      field.tag = name;
+      field.name = AttributeOr(tag, "name", "");
+      field.type = tag.Find("multiple") ? "select-multiple" : "select-one";
+      AddField(std::move(field));
+      select_form_ = fields_ == &form_fields_ ? kNoSelect : forms_.size() - 1;
+      select_ = fields_->size() - 1;
+      select_has_value_ = false;
+      select_has_selected_ = false;
+    } else if (name == "option" && select_ != kNoSelect) {
+      FinishOption();
+      const HtmlAttribute* value = tag.Find("value");
+      option_has_value_ = value != nullptr;
+      option_value_ = value ? value->value : std::string();
+      option_selected_ = tag.Find("selected") != nullptr;
+      option_text_.clear();
+      in_option_ = true;
+      text_target_ = &option_text_;
+    }
+  }
+
+  void OnEndTag(std::string_view name) override {
+    if (name == "script" || name == "title" || name == "textarea") {
+      text_target_ = nullptr;
+    } else if (name == "option") {
+      FinishOption();
+    } else if (name == "select") {
+      FinishOption();
+      select_ = kNoSelect;
+    } else if (name == "form") {
+      FinishOption();
+      select_ = kNoSelect;
+      in_form_ = false;
+    }
+  }
+
+  void OnText(std::string_view text) override {
+    if (text_target_) {
+      text_target_->append(text.data(), text.size());
+    }
+  }
+
+  void Finish() {
+    tokenizer_.Finish();
+    FinishOption();
+    ResolveFormOwners();
+  }
+
+  HtmlTokenizer* tokenizer() { return &tokenizer_; }
+
+  void Pack(msgpack::packer<msgpack::sbuffer>* pk) const {
+    uint32_t entries = (options_.title ? 1 : 0) + (options_.scripts ? 2 : 0) +
+                       (options_.forms ? 1 : 0) + (options_.meta ? 1 : 0) +
+                       (options_.attributes.empty() ? 0 : 1);
+    pk->pack_map(entries);
+
+    if (options_.title) {
+      pk->pack("title");
+      PackString(pk, CollapseWhitespace(title_));
+    }
+    if (options_.scripts) {
+      pk->pack("scripts");
+      pk->pack_array((uint32_t) scripts_.size());
+      for (const Script& script : scripts_) {
+        pk->pack_map(2);
+        pk->pack("type");
+        PackString(pk, script.type);
+        pk->pack("text");
+        PackString(pk, script.text);
+      }
+      pk->pack("scriptSources");
+      pk->pack_array((uint32_t) script_sources_.size());
+      for (const std::string& src : script_sources_) {
+        PackString(pk, src);
+      }
+    }
+    if (options_.forms) {
+      pk->pack("forms");
+      pk->pack_array((uint32_t) forms_.size());
+      for (const Form& form : forms_) {
+        pk->pack_map(2);
+        pk->pack("attributes");
+        PackAttributes(pk, form.attributes);
+        pk->pack("fields");
+        pk->pack_array((uint32_t) form.fields.size());
+        for (const Field& field : form.fields) {
+          pk->pack_map(field.has_checked ? 5 : 4);
+          pk->pack("tag");
+          PackString(pk, field.tag);
+          pk->pack("name");
+          PackString(pk, field.name);
+          pk->pack("type");
+          PackString(pk, field.type);
+          pk->pack("value");
+          PackString(pk, field.value);
+          if (field.has_checked) {
+            pk->pack("checked");
+            pk->pack(field.checked);
+          }
+        }
+      }
+    }
+    if (options_.meta) {
+      pk->pack("meta");
+      pk->pack_array((uint32_t) meta_.size());
+      for (const AttributeList& meta : meta_) {
+        PackAttributes(pk, meta);
+      }
+    }
+    if (!options_.attributes.empty()) {
+      pk->pack("attributes");
+      pk->pack_array((uint32_t) attributes_.size());
+      for (const MatchedAttribute& attr : attributes_) {
+        pk->pack_map(3);
+        pk->pack("tag");
+        PackString(pk, attr.tag);
+        pk->pack("name");
+        PackString(pk, attr.name);
+        pk->pack("value");
+        PackString(pk, attr.value);
+      }
+    }
+  }
+
+ private:
+  static constexpr size_t kNoSelect = static_cast<size_t>(-1);
+
+  void MatchAttributes(const HtmlStartTag& tag) {
+    for (const auto& wanted : options_.attributes) {
+      if (wanted.first != "*" && wanted.first != tag.name) {
+        continue;
+      }
+      const HtmlAttribute* attr = tag.Find(wanted.second);
+      if (attr) {
+        attributes_.push_back(MatchedAttribute{tag.name, attr->name, attr->value});
+      }
+    }
+  }
+
+  void AddField(Field field) {
+    field.order = next_order_++;
+    field.owner = owner_;
+    fields_->push_back(std::move(field));
+  }
+
+  // form="id" field 를 같은 id 의 첫 form 에 문서 순서대로 넣는다. 맞는 form 이 없으면 버린다
+  void ResolveFormOwners() {
+    for (Field& field : form_fields_) {
+      for (Form& form : forms_) {
+        auto id = std::find_if(form.attributes.begin(), form.attributes.end(),
+                               [](const auto& attr) { return attr.first == "id"; });
+        if (id != form.attributes.end() && id->second == field.owner) {
+          auto pos = std::upper_bound(form.fields.begin(), form.fields.end(), field.order,
+                                      [](size_t order, const Field& f) { return order < f.order; });
+          form.fields.insert(pos, std::move(field));
+          break;
+        }
+      }
+    }
+    form_fields_.clear();
+  }
+
+  // 현재 option 을 select 값에 반영 (selected 가 없으면 첫 option)
+  void FinishOption() {
+    if (!in_option_) {
+      return;
+    }
+    in_option_ = false;
+    if (text_target_ == &option_text_) {
+      text_target_ = nullptr;
+    }
+    if (select_ == kNoSelect) {
+      return;
+    }
+    bool take = option_selected_ ? !select_has_selected_ : !select_has_value_;
+    if (take) {
+      std::vector<Field>& fields = select_form_ == kNoSelect ? form_fields_ : forms_[select_form_].fields;
+      fields[select_].value =
+        option_has_value_ ? option_value_ : CollapseWhitespace(option_text_);
+      select_has_value_ = true;
+      select_has_selected_ = select_has_selected_ || option_selected_;
+    }
+  }
+
+  const HtmlExtractOptions& options_;
+  HtmlTokenizer tokenizer_;
+
+  std::string* text_target_ = nullptr;
+
+  bool has_title_ = false;
+  std::string title_;
+  std::vector<Script> scripts_;
+  std::vector<std::string> script_sources_;
+  std::vector<AttributeList> meta_;
+  std::vector<MatchedAttribute> attributes_;
+
+  std::vector<Form> forms_;
+  // form="id" 로 소유 form 을 지정한 field (Finish 에서 forms_ 로 옮긴다)
+  std::vector<Field> form_fields_;
+  bool in_form_ = false;
+  // 마지막 field 가 들어간 목록과 그 form= 값
+  std::vector<Field>* fields_ = nullptr;
+  std::string owner_;
+  size_t next_order_ = 0;
+  // 열린 select: forms_ index (form_fields_ 면 kNoSelect) 와 field index
+  size_t select_form_ = kNoSelect;
+  size_t select_ = kNoSelect;
+  bool select_has_value_ = false;
+  bool select_has_selected_ = false;
+  bool in_option_ = false;
+  bool option_has_value_ = false;
+  bool option_selected_ = false;
+  std::string option_value_;
+  std::string option_text_;
+};
+
+HtmlExtractor::HtmlExtractor(const HtmlExtractOptions& options) : sink_(new Sink(options)) {}
+
+HtmlExtractor::~HtmlExtractor() = default;
+
+void HtmlExtractor::Feed(const char* data, size_t len) {
+  sink_->tokenizer()->Feed(data, len);
+}
+
+void HtmlExtractor::Finish() {
+  sink_->Finish();
+}
+
+void HtmlExtractor::Pack(msgpack::packer<msgpack::sbuffer>* pk) const {
+  sink_->Pack(pk);
+}
+
+}  // namespace request_unraver
@@ -0,0 +1,60 @@
+#ifndef REQUEST_UNRAVER_HTML_EXTRACT_H_
+#define REQUEST_UNRAVER_HTML_EXTRACT_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <msgpack.hpp>
+
+namespace request_unraver {
+
+struct HtmlExtractOptions {
+  bool title = true;
+  bool scripts = true;
+  bool forms = true;
+  bool meta = true;
+  // 추가로 수집할 attribute: (tag 또는 "*", attribute 이름). "a[href]" 형태로 지정
+  std::vector<std::pair<std::string, std::string>> attributes;
+
+  // "tag[attr]" / "[attr]" 항목 추가. 형식이 틀리면 false
+  bool AddAttribute(std::string_view spec);
+
+  // { title, scripts, forms, meta: bool, attributes: [string] } (없는 key 는 기본값)
+  bool FromMsgpack(const char* data, size_t len);
+};
+
+// DOM 을 만들지 않고 HtmlTokenizer token 만으로 필요한 정보를 모은다.
+//
+// msgpack map:
+//   title: string
+//   scripts: [{ type, text }]          - src 없는 inline script (문서 순서)
+//   scriptSources: [string]            - src 있는 script
+//   forms: [{ attributes: {..}, fields: [{ tag, name, type, value, checked? }] }]
+//                                      - form="id" field 는 그 id 의 form 에 문서 순서로 들어간다
+//   meta: [{ ..attributes }]
+//   attributes: [{ tag, name, value }] - options.attributes 와 일치한 것
+class HtmlExtractor {
+ public:
+  explicit HtmlExtractor(const HtmlExtractOptions& options);
+  ~HtmlExtractor();
+
+  HtmlExtractor(const HtmlExtractor&) = delete;
+  HtmlExtractor& operator=(const HtmlExtractor&) = delete;
+
+  void Feed(const char* data, size_t len);
+  void Finish();
+
+  void Pack(msgpack::packer<msgpack::sbuffer>* pk) const;
+
+ private:
+  class Sink;
+
+  std::unique_ptr<Sink> sink_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_HTML_EXTRACT_H_
@@ -0,0 +1,550 @@
+#include "html_selector.h"
+
+#include <cstdlib>
+
+#include "html_tokenizer.h"
+
+namespace request_unraver {
+
+namespace {
+
+bool IsSelectorSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+bool IsIdentChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+         c == '-' || c == '_' || static_cast<unsigned char>(c) >= 0x80;
+}
+
+std::string ToLowerAscii(std::string_view in) {
+  std::string out(in);
+  for (char& c : out) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c + ('a' - 'A'));
+    }
+  }
+  return out;
+}
+
+bool EqualsMaybeIgnoreCase(std::string_view a, std::string_view b, bool ignore_case) {
+  return ignore_case ? HtmlEqualsIgnoreCase(a, b) : a == b;
+}
+
+uint32_t PrevElement(const HtmlDocument& doc, uint32_t id) {
+  for (uint32_t cur = doc.node(id).prev_sibling; cur != kHtmlNoNode;
+       cur = doc.node(cur).prev_sibling) {
+    if (doc.node(cur).type == kHtmlElementNode) {
+      return cur;
+    }
+  }
+  return kHtmlNoNode;
+}
+
+uint32_t NextElement(const HtmlDocument& doc, uint32_t id) {
+  for (uint32_t cur = doc.node(id).next_sibling; cur != kHtmlNoNode;
+       cur = doc.node(cur).next_sibling) {
+    if (doc.node(cur).type == kHtmlElementNode) {
+      return cur;
+    }
+  }
+  return kHtmlNoNode;
+}
+
+uint32_t ParentElement(const HtmlDocument& doc, uint32_t id) {
+  uint32_t parent = doc.node(id).parent;
+  if (parent != kHtmlNoNode && doc.node(parent).type == kHtmlElementNode) {
+    return parent;
+  }
+  return kHtmlNoNode;
+}
+
+}  // anonymous
+
+class HtmlSelector::Parser {
+ public:
+  Parser(std::string_view input, std::string* error) : input_(input), pos_(0), error_(error) {}
+
+  bool ParseList(std::vector<Complex>* groups) {
+    while (true) {
+      Complex complex;
+      if (!ParseComplex(&complex)) {
+        return false;
+      }
+      groups->push_back(std::move(complex));
+      SkipSpace();
+      if (AtEnd()) {
+        return true;
+      }
+      if (Peek() != ',') {
+        return Fail("unexpected character");
+      }
+      pos_++;
+    }
+  }
+
+ private:
+  bool AtEnd() const { return pos_ >= input_.size(); }
+  char Peek() const { return AtEnd() ? '\0' : input_[pos_]; }
+
+  bool SkipSpace() {
+    size_t start = pos_;
+    while (!AtEnd() && IsSelectorSpace(input_[pos_])) {
+      pos_++;
+    }
+    return pos_ != start;
+  }
+
+  bool Fail(const char* message) {
+    *error_ = message;
+    return false;
+  }
+
+  bool ParseIdent(std::string* out) {
+    out->clear();
+    while (!AtEnd()) {
+      char c = input_[pos_];
+      if (c == '\\' && pos_ + 1 < input_.size()) {
+        out->push_back(input_[pos_ + 1]);
+        pos_ += 2;
+      } else if (IsIdentChar(c)) {
+        out->push_back(c);
+        pos_++;
+      } else {
+        break;
+      }
+    }
+    return !out->empty();
+  }
+
+  bool ParseComplex(Complex* complex) {
+    SkipSpace();
+    char combinator = 0;
+    while (true) {
+      Compound compound;
+      compound.combinator = combinator;
+      if (!ParseCompound(&compound.conditions)) {
+        return false;
+      }
+      complex->push_back(std::move(compound));
+
+      bool space = SkipSpace();
+      char c = Peek();
+      if (AtEnd() || c == ',' || c == ')') {
+        return true;
+      }
+      if (c == '>' || c == '+' || c == '~') {
+        combinator = c;
+        pos_++;
+        SkipSpace();
+      } else if (space) {
+        combinator = ' ';
+      } else {
+        return Fail("unexpected character");
+      }
+    }
+  }
+
+  bool ParseCompound(std::vector<Condition>* conditions) {
+    std::string ident;
+    if (Peek() == '*') {
+      pos_++;
+    } else if (IsIdentChar(Peek()) || Peek() == '\\') {
+      ParseIdent(&ident);
+      Condition condition;
+      condition.kind = Condition::kTag;
+      condition.name = ToLowerAscii(ident);
+      conditions->push_back(std::move(condition));
+    } else if (Peek() != '#' && Peek() != '.' && Peek() != '[' && Peek() != ':') {
+      return Fail("expected selector");
+    }
+
+    while (!AtEnd()) {
+      char c = Peek();
+      Condition condition;
+      if (c == '#' || c == '.') {
+        pos_++;
+        if (!ParseIdent(&ident)) {
+          return Fail("expected name");
+        }
+        condition.kind = c == '#' ? Condition::kId : Condition::kClass;
+        condition.value = ident;
+      } else if (c == '[') {
+        pos_++;
+        if (!ParseAttribute(&condition)) {
+          return false;
+        }
+      } else if (c == ':') {
+        pos_++;
+        if (!ParsePseudo(&condition)) {
+          return false;
+        }
+      } else {
+        break;
+      }
+      conditions->push_back(std::move(condition));
+    }
+    return true;
+  }
+
+  bool ParseAttribute(Condition* condition) {
+    SkipSpace();
+    std::string ident;
+    if (!ParseIdent(&ident)) {
+      return Fail("expected attribute name");
+    }
+    condition->name = ToLowerAscii(ident);
+    SkipSpace();
+    if (Peek() == ']') {
+      pos_++;
+      condition->kind = Condition::kAttrExists;
+      return true;
+    }
+
+    char op = Peek();
+    if (op == '=') {
+      condition->kind = Condition::kAttrEquals;
+      pos_++;
+    } else {
+      switch (op) {
+        case '~': condition->kind = Condition::kAttrWord; break;
+        case '|': condition->kind = Condition::kAttrDash; break;
+        case '^': condition->kind = Condition::kAttrPrefix; break;
+        case '$': condition->kind = Condition::kAttrSuffix; break;
+        case '*': condition->kind = Condition::kAttrContains; break;
+        default: return Fail("unsupported attribute operator");
+      }
+      pos_++;
+      if (Peek() != '=') {
+        return Fail("unsupported attribute operator");
+      }
+      pos_++;
+    }
+
+    SkipSpace();
+    char quote = Peek();
+    if (quote == '"' || quote == '\'') {
+      size_t end = input_.find(quote, pos_ + 1);
+      if (end == std::string_view::npos) {
+        return Fail("unterminated string");
+      }
+      condition->value = std::string(input_.substr(pos_ + 1, end - pos_ - 1));
+      pos_ = end + 1;
+    } else if (!ParseIdent(&condition->value)) {
+      return Fail("expected attribute value");
+    }
+    SkipSpace();
+    if (Peek() == 'i' || Peek() == 'I') {
+      condition->ignore_case = true;
+      pos_++;
+      SkipSpace();
+    } else if (Peek() == 's' || Peek() == 'S') {
+      pos_++;
+      SkipSpace();
+    }
+    if (Peek() != ']') {
+      return Fail("expected ']'");
+    }
+    pos_++;
+    return true;
+  }
+
+  bool ParsePseudo(Condition* condition) {
+    if (Peek() == ':') {
+      return Fail("pseudo-elements are not supported");
+    }
+    std::string ident;
+    if (!ParseIdent(&ident)) {
+      return Fail("expected pseudo-class");
+    }
+    ident = ToLowerAscii(ident);
+
+    static const struct {
+      const char* name;
+      Condition::Kind kind;
+    } kSimple[] = {
+      {"first-child", Condition::kFirstChild},
+      {"last-child", Condition::kLastChild},
+      {"only-child", Condition::kOnlyChild},
+      {"empty", Condition::kEmpty},
+      {"root", Condition::kRoot},
+      {"checked", Condition::kChecked},
+      {"disabled", Condition::kDisabled},
+      {"enabled", Condition::kEnabled},
+      {"selected", Condition::kSelected},
+    };
+    for (const auto& simple : kSimple) {
+      if (ident == simple.name) {
+        condition->kind = simple.kind;
+        return true;
+      }
+    }
+
+    if (Peek() != '(') {
+      return Fail("unsupported pseudo-class");
+    }
+    pos_++;
+    SkipSpace();
+    if (ident == "not") {
+      condition->kind = Condition::kNot;
+      if (!ParseCompound(&condition->negated) || condition->negated.empty()) {
+        return Fail("invalid :not() argument");
+      }
+    } else if (ident == "nth-child") {
+      condition->kind = Condition::kNthChild;
+      if (!ParseNth(condition)) {
+        return false;
+      }
+    } else {
+      return Fail("unsupported pseudo-class");
+    }
+    SkipSpace();
+    if (Peek() != ')') {
+      return Fail("expected ')'");
+    }
+    pos_++;
+    return true;
+  }
+
+  // an+b, odd, even
+  bool ParseNth(Condition* condition) {
+    size_t end = input_.find(')', pos_);
+    if (end == std::string_view::npos) {
+      return Fail("expected ')'");
+    }
+    std::string expr;
+    for (char c : input_.substr(pos_, end - pos_)) {
+      if (!IsSelectorSpace(c)) {
+        expr.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c);
+      }
+    }
+    pos_ = end;
+
+    if (expr == "odd") {
+      condition->a = 2;
+      condition->b = 1;
+      return true;
+    }
+    if (expr == "even") {
+      condition->a = 2;
+      condition->b = 0;
+      return true;
+    }
+    size_t n = expr.find('n');
+    char* parse_end = nullptr;
+    if (n == std::string::npos) {
+      condition->a = 0;
+      condition->b = (int) strtol(expr.c_str(), &parse_end, 10);
+      return *parse_end == '\0' && !expr.empty() ? true : Fail("invalid :nth-child() argument");
+    }
+    std::string a = expr.substr(0, n);
+    if (a.empty() || a == "+") {
+      condition->a = 1;
+    } else if (a == "-") {
+      condition->a = -1;
+    } else {
+      condition->a = (int) strtol(a.c_str(), &parse_end, 10);
+      if (*parse_end != '\0') {
+        return Fail("invalid :nth-child() argument");
+      }
+    }
+    std::string b = expr.substr(n + 1);
+    condition->b = 0;
+    if (!b.empty()) {
+      condition->b = (int) strtol(b.c_str(), &parse_end, 10);
+      if (*parse_end != '\0' || (b[0] != '+' && b[0] != '-')) {
+        return Fail("invalid :nth-child() argument");
+      }
+    }
+    return true;
+  }
+
+  std::string_view input_;
+  size_t pos_;
+  std::string* error_;
+};
+
+std::unique_ptr<HtmlSelector> HtmlSelector::Parse(std::string_view selector, std::string* error) {
+  std::unique_ptr<HtmlSelector> result(new HtmlSelector());
+  Parser parser(selector, error);
+  if (!parser.ParseList(&result->groups_)) {
+    return nullptr;
+  }
+  return result;
+}
+
+bool HtmlSelector::MatchCondition(const HtmlDocument& doc, uint32_t id,
+                                  const Condition& condition) {
+  std::string_view value;
+  switch (condition.kind) {
+    case Condition::kTag:
+      return doc.Name(id) == condition.name;
+    case Condition::kId:
+      return doc.GetAttribute(id, "id", &value) && value == condition.value;
+    case Condition::kClass:
+      return doc.HasClass(id, condition.value);
+    case Condition::kAttrExists:
+      return doc.GetAttribute(id, condition.name, &value);
+    case Condition::kAttrEquals:
+      return doc.GetAttribute(id, condition.name, &value) &&
+             EqualsMaybeIgnoreCase(value, condition.value, condition.ignore_case);
+    case Condition::kAttrWord: {
+      if (!doc.GetAttribute(id, condition.name, &value) || condition.value.empty()) {
+        return false;
+      }
+      size_t pos = 0;
+      while (pos <= value.size()) {
+        size_t end = pos;
+        while (end < value.size() && !IsSelectorSpace(value[end])) {
+          end++;
+        }
+        if (EqualsMaybeIgnoreCase(value.substr(pos, end - pos), condition.value, condition.ignore_case)) {
+          return true;
+        }
+        pos = end + 1;
+      }
+      return false;
+    }
+    case Condition::kAttrDash:
+      return doc.GetAttribute(id, condition.name, &value) &&
+             (EqualsMaybeIgnoreCase(value, condition.value, condition.ignore_case) ||
+              (value.size() > condition.value.size() && value[condition.value.size()] == '-' &&
+               EqualsMaybeIgnoreCase(value.substr(0, condition.value.size()), condition.value,
+                                     condition.ignore_case)));
+    case Condition::kAttrPrefix:
+      return doc.GetAttribute(id, condition.name, &value) && !condition.value.empty() &&
+             value.size() >= condition.value.size() &&
+             EqualsMaybeIgnoreCase(value.substr(0, condition.value.size()), condition.value,
+                                   condition.ignore_case);
+    case Condition::kAttrSuffix:
+      return doc.GetAttribute(id, condition.name, &value) && !condition.value.empty() &&
+             value.size() >= condition.value.size() &&
+             EqualsMaybeIgnoreCase(value.substr(value.size() - condition.value.size()),
+                                   condition.value, condition.ignore_case);
+    case Condition::kAttrContains: {
+      if (!doc.GetAttribute(id, condition.name, &value) || condition.value.empty()) {
+        return false;
+      }
+      if (!condition.ignore_case) {
+        return value.find(condition.value) != std::string_view::npos;
+      }
+      std::string lower_value = ToLowerAscii(value);
+      return lower_value.find(ToLowerAscii(condition.value)) != std::string::npos;
+    }
+    case Condition::kFirstChild:
+      return PrevElement(doc, id) == kHtmlNoNode;
+    case Condition::kLastChild:
+      return NextElement(doc, id) == kHtmlNoNode;
+    case Condition::kOnlyChild:
+      return PrevElement(doc, id) == kHtmlNoNode && NextElement(doc, id) == kHtmlNoNode;
+    case Condition::kNthChild: {
+      int index = 1;
+      for (uint32_t cur = PrevElement(doc, id); cur != kHtmlNoNode; cur = PrevElement(doc, cur)) {
+        index++;
+      }
+      if (condition.a == 0) {
+        return index == condition.b;
+      }
+      int diff = index - condition.b;
+      return diff % condition.a == 0 && diff / condition.a >= 0;
+    }
+    case Condition::kEmpty:
+      for (uint32_t cur = doc.node(id).first_child; cur != kHtmlNoNode; cur = doc.node(cur).next_sibling) {
+        const HtmlNode& child = doc.node(cur);
+        if (child.type == kHtmlElementNode || (child.type == kHtmlTextNode && child.data_length > 0)) {
+          return false;
+        }
+      }
+      return true;
+    case Condition::kRoot:
+      return id == doc.document_element();
+    case Condition::kChecked:
+      return ((doc.Name(id) == "input") && doc.GetAttribute(id, "checked", &value)) ||
+             (doc.Name(id) == "option" && doc.GetAttribute(id, "selected", &value));
+    case Condition::kSelected:
+      return doc.Name(id) == "option" && doc.GetAttribute(id, "selected", &value);
+    case Condition::kDisabled:
+      return doc.GetAttribute(id, "disabled", &value);
+    case Condition::kEnabled: {
+      std::string_view name = doc.Name(id);
+      return (name == "input" || name == "button" || name == "select" || name == "textarea" ||
+              name == "option" || name == "fieldset") &&
+             !doc.GetAttribute(id, "disabled", &value);
+    }
+    case Condition::kNot:
+      return !MatchCompound(doc, id, condition.negated);
+  }
+  return false;
+}
+
+bool HtmlSelector::MatchCompound(const HtmlDocument& doc, uint32_t id,
+                                 const std::vector<Condition>& conditions) {
+  if (doc.node(id).type != kHtmlElementNode) {
+    return false;
+  }
+  for (const Condition& condition : conditions) {
+    if (!MatchCondition(doc, id, condition)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool HtmlSelector::MatchComplex(const HtmlDocument& doc, uint32_t id, const Complex& complex,
+                                size_t index) {
+  const Compound& compound = complex[index];
+  if (!MatchCompound(doc, id, compound.conditions)) {
+    return false;
+  }
+  if (index == 0) {
+    return true;
+  }
+  switch (compound.combinator) {
+    case '>': {
+      uint32_t parent = ParentElement(doc, id);
+      return parent != kHtmlNoNode && MatchComplex(doc, parent, complex, index - 1);
+    }
+    case '+': {
+      uint32_t prev = PrevElement(doc, id);
+      return prev != kHtmlNoNode && MatchComplex(doc, prev, complex, index - 1);
+    }
+    case '~':
+      for (uint32_t prev = PrevElement(doc, id); prev != kHtmlNoNode; prev = PrevElement(doc, prev)) {
+        if (MatchComplex(doc, prev, complex, index - 1)) {
+          return true;
+        }
+      }
+      return false;
+    default:
+      for (uint32_t parent = ParentElement(doc, id); parent != kHtmlNoNode;
+           parent = ParentElement(doc, parent)) {
+        if (MatchComplex(doc, parent, complex, index - 1)) {
+          return true;
+        }
+      }
+      return false;
+  }
+}
+
+bool HtmlSelector::Matches(const HtmlDocument& doc, uint32_t id) const {
+  for (const Complex& complex : groups_) {
+    if (MatchComplex(doc, id, complex, complex.size() - 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HtmlSelector::Select(const HtmlDocument& doc, uint32_t root, bool first_only,
+                          std::vector<uint32_t>* out) const {
+  for (uint32_t cur = doc.NextInTree(root, root); cur != kHtmlNoNode; cur = doc.NextInTree(cur, root)) {
+    if (doc.node(cur).type == kHtmlElementNode && Matches(doc, cur)) {
+      out->push_back(cur);
+      if (first_only) {
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace request_unraver
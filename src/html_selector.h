@@ -0,0 +1,90 @@
+#ifndef REQUEST_UNRAVER_HTML_SELECTOR_H_
+#define REQUEST_UNRAVER_HTML_SELECTOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "html_dom.h"
+
+namespace request_unraver {
+
+// HtmlDocument 용 CSS selector (querySelector/matches)
+//
+// type/universal, #id, .class, [attr], [attr=|~=|^=|$=|*=||= value i],
+// 결합자 ' ' '>' '+' '~', selector list ',' 와
+// :not() :first-child :last-child :only-child :nth-child() :empty :root
+// :checked :disabled :enabled :selected 를 지원한다.
+class HtmlSelector {
+ public:
+  // 지원하지 않는 문법이면 nullptr 을 반환하고 error 에 이유를 기록
+  static std::unique_ptr<HtmlSelector> Parse(std::string_view selector, std::string* error);
+
+  bool Matches(const HtmlDocument& doc, uint32_t id) const;
+
+  // root 의 자손 중 일치하는 element 를 문서 순서로 추가
+  void Select(const HtmlDocument& doc, uint32_t root, bool first_only,
+              std::vector<uint32_t>* out) const;
+
+ private:
+  struct Condition {
+    enum Kind {
+      kTag,
+      kId,
+      kClass,
+      kAttrExists,
+      kAttrEquals,
+      kAttrWord,
+      kAttrDash,
+      kAttrPrefix,
+      kAttrSuffix,
+      kAttrContains,
+      kFirstChild,
+      kLastChild,
+      kOnlyChild,
+      kNthChild,
+      kEmpty,
+      kRoot,
+      kChecked,
+      kDisabled,
+      kEnabled,
+      kSelected,
+      kNot,
+    };
+    Kind kind;
+    std::string name;
+    std::string value;
+    bool ignore_case = false;
+    // :nth-child(a n + b)
+    int a = 0;
+    int b = 0;
+    // :not(...) 의 compound
+    std::vector<Condition> negated;
+  };
+
+  struct Compound {
+    // 왼쪽 compound 와의 결합자 (' ', '>', '+', '~'), 첫 compound 는 0
+    char combinator = 0;
+    std::vector<Condition> conditions;
+  };
+
+  using Complex = std::vector<Compound>;
+
+  class Parser;
+
+  HtmlSelector() = default;
+
+  static bool MatchCondition(const HtmlDocument& doc, uint32_t id, const Condition& condition);
+  static bool MatchCompound(const HtmlDocument& doc, uint32_t id,
+                            const std::vector<Condition>& conditions);
+  static bool MatchComplex(const HtmlDocument& doc, uint32_t id, const Complex& complex,
+                           size_t index);
+
+  std::vector<Complex> groups_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_HTML_SELECTOR_H_
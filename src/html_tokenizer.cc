@@ -0,0 +1,587 @@
+#include "html_tokenizer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace request_unraver {
+
+namespace {
+
+struct NamedEntity {
+  const char* name;
+  const char* value;
+};
+
+#include "html_entities.inc"
+
+const char* FindNamedEntity(std::string_view name) {
+  const NamedEntity* begin = std::begin(kNamedEntities);
+  const NamedEntity* end = std::end(kNamedEntities);
+  const NamedEntity* it = std::lower_bound(begin, end, name,
+    [](const NamedEntity& entity, std::string_view key) { return key.compare(entity.name) > 0; });
+  if (it != end && name == it->name) {
+    return it->value;
+  }
+  return nullptr;
+}
+
+// name 앞부분과 일치하는 가장 긴 legacy entity 길이 (없으면 0)
+size_t LongestLegacyPrefix(std::string_view name) {
+  size_t longest = 0;
+  for (const char* legacy : kLegacyEntities) {
+    size_t len = strlen(legacy);
+    if (len > longest && name.substr(0, len) == legacy) {
+      longest = len;
+    }
+  }
+  return longest;
+}
+
+bool IsAsciiAlpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool IsAsciiAlnum(char c) {
+  return IsAsciiAlpha(c) || (c >= '0' && c <= '9');
+}
+
+bool IsHtmlSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+char ToLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+void AppendLower(std::string* out, std::string_view in) {
+  for (char c : in) {
+    out->push_back(ToLower(c));
+  }
+}
+
+void AppendUtf8(std::string* out, uint32_t cp) {
+  if (cp == 0 || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+    cp = 0xfffd;
+  }
+  if (cp < 0x80) {
+    out->push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | (cp >> 6)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | (cp >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | (cp >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  }
+}
+
+// in[i] == '&' 에서 entity 하나를 디코딩. 인식하지 못하면 0
+size_t DecodeEntity(std::string_view in, size_t i, std::string* out, bool in_attribute) {
+  size_t p = i + 1;
+  if (p < in.size() && in[p] == '#') {
+    p++;
+    bool hex = p < in.size() && (in[p] == 'x' || in[p] == 'X');
+    if (hex) {
+      p++;
+    }
+    uint32_t cp = 0;
+    size_t digits = 0;
+    for (; p < in.size(); p++, digits++) {
+      char c = in[p];
+      uint32_t v;
+      if (c >= '0' && c <= '9') {
+        v = c - '0';
+      } else if (hex && c >= 'a' && c <= 'f') {
+        v = c - 'a' + 10;
+      } else if (hex && c >= 'A' && c <= 'F') {
+        v = c - 'A' + 10;
+      } else {
+        break;
+      }
+      cp = std::min<uint32_t>(cp * (hex ? 16 : 10) + v, 0x110000);
+    }
+    if (digits == 0) {
+      return 0;
+    }
+    if (p < in.size() && in[p] == ';') {
+      p++;
+    }
+    AppendUtf8(out, cp);
+    return p - i;
+  }
+
+  size_t name_end = p;
+  while (name_end < in.size() && name_end - p < 32 && IsAsciiAlnum(in[name_end])) {
+    name_end++;
+  }
+  std::string_view name = in.substr(p, name_end - p);
+  if (name.empty()) {
+    return 0;
+  }
+  if (name_end < in.size() && in[name_end] == ';') {
+    const char* value = FindNamedEntity(name);
+    if (value) {
+      out->append(value);
+      return name_end + 1 - i;
+    }
+  }
+  // ';' 가 없거나 모르는 이름이면 가장 긴 legacy entity 접두어만 디코딩 (&copy2024, &notit;)
+  size_t legacy_len = LongestLegacyPrefix(name);
+  if (legacy_len == 0) {
+    return 0;
+  }
+  size_t end = p + legacy_len;
+  // attribute 에서는 뒤에 alnum 이나 '=' 가 오면 그대로 둔다 (query string)
+  if (in_attribute && end < in.size() && (IsAsciiAlnum(in[end]) || in[end] == '=')) {
+    return 0;
+  }
+  out->append(FindNamedEntity(name.substr(0, legacy_len)));
+  return end - i;
+}
+
+// 입력 중간에서 text 를 자를 때 끝에 걸친 entity 는 남겨둔다
+size_t EntitySafeEnd(std::string_view buffer, size_t begin, size_t end) {
+  size_t amp = buffer.rfind('&', end - 1);
+  if (amp != std::string_view::npos && amp >= begin && end - amp < 40 &&
+      buffer.substr(amp, end - amp).find(';') == std::string_view::npos) {
+    return amp;
+  }
+  return end;
+}
+
+bool IsRawTextTag(std::string_view name, bool* decode) {
+  static const char* const kRawText[] = {
+    "script", "style", "xmp", "iframe", "noembed", "noframes",
+  };
+  for (const char* raw : kRawText) {
+    if (name == raw) {
+      *decode = false;
+      return true;
+    }
+  }
+  if (name == "textarea" || name == "title") {
+    *decode = true;
+    return true;
+  }
+  return false;
+}
+
+}  // anonymous
+
+const HtmlAttribute* HtmlStartTag::Find(std::string_view attr_name) const {
+  for (size_t i = 0; i < attribute_count; i++) {
+    if (attributes[i].name == attr_name) {
+      return &attributes[i];
+    }
+  }
+  return nullptr;
+}
+
+void DecodeHtmlEntities(std::string_view in, std::string* out, bool in_attribute) {
+  size_t start = 0;
+  size_t amp = in.find('&');
+  while (amp != std::string_view::npos) {
+    out->append(in.data() + start, amp - start);
+    size_t consumed = DecodeEntity(in, amp, out, in_attribute);
+    if (consumed == 0) {
+      out->push_back('&');
+      consumed = 1;
+    }
+    start = amp + consumed;
+    amp = in.find('&', start);
+  }
+  out->append(in.data() + start, in.size() - start);
+}
+
+bool HtmlEqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (ToLower(a[i]) != ToLower(b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+HtmlTokenizer::HtmlTokenizer(HtmlTokenSink* sink)
+    : sink_(sink), pos_(0), stopped_(false), resume_(0), scan_(0), raw_decode_(false) {}
+
+void HtmlTokenizer::Feed(const char* data, size_t len) {
+  // 처리된 앞부분은 버퍼가 절반 이상 찼을 때 한번에 제거
+  if (pos_ > 0 && pos_ * 2 >= buffer_.size()) {
+    buffer_.erase(0, pos_);
+    pos_ = 0;
+  }
+  buffer_.append(data, len);
+  while (!stopped_ && pos_ < buffer_.size() && Step(false)) {
+  }
+}
+
+void HtmlTokenizer::Finish() {
+  while (!stopped_ && pos_ < buffer_.size() && Step(true)) {
+  }
+  buffer_.clear();
+  pos_ = 0;
+}
+
+bool HtmlTokenizer::Step(bool at_end) {
+  size_t begin = pos_;
+  bool done;
+  if (!raw_tag_.empty()) {
+    done = ConsumeRawText(at_end);
+  } else if (buffer_[begin] == '<') {
+    done = ConsumeMarkup(at_end);
+  } else {
+    done = ConsumeText(at_end);
+  }
+  // token 이 끝났으면 이어서 읽던 위치는 버린다
+  if (pos_ != begin) {
+    resume_ = 0;
+    scan_ = 0;
+  }
+  return done;
+}
+
+void HtmlTokenizer::EmitText(std::string_view raw, bool decode) {
+  if (raw.empty()) {
+    return;
+  }
+  if (decode && raw.find('&') != std::string_view::npos) {
+    scratch_.clear();
+    DecodeHtmlEntities(raw, &scratch_, false);
+    sink_->OnText(scratch_);
+  } else {
+    sink_->OnText(raw);
+  }
+}
+
+bool HtmlTokenizer::ConsumeText(bool at_end) {
+  std::string_view buffer(buffer_);
+  size_t lt = buffer.find('<', pos_);
+  if (lt != std::string_view::npos || at_end) {
+    size_t end = lt != std::string_view::npos ? lt : buffer.size();
+    EmitText(buffer.substr(pos_, end - pos_), true);
+    pos_ = end;
+    return true;
+  }
+
+  // 긴 text 는 나눠서 내보낸다
+  size_t end = EntitySafeEnd(buffer, pos_, buffer.size());
+  EmitText(buffer.substr(pos_, end - pos_), true);
+  pos_ = end;
+  return false;
+}
+
+bool HtmlTokenizer::ConsumeRawText(bool at_end) {
+  std::string_view buffer(buffer_);
+  size_t p = pos_;
+  while (true) {
+    size_t lt = buffer.find("</", p);
+    if (lt == std::string_view::npos) {
+      if (at_end) {
+        EmitText(buffer.substr(pos_), raw_decode_);
+        pos_ = buffer.size();
+        raw_tag_.clear();
+        return true;
+      }
+      size_t end = buffer.size() - (buffer.back() == '<' ? 1 : 0);
+      if (raw_decode_) {
+        end = EntitySafeEnd(buffer, pos_, end);
+      }
+      EmitText(buffer.substr(pos_, end - pos_), raw_decode_);
+      pos_ = end;
+      return false;
+    }
+    size_t name_end = lt + 2 + raw_tag_.size();
+    if (name_end >= buffer.size()) {
+      if (at_end) {
+        EmitText(buffer.substr(pos_), raw_decode_);
+        pos_ = buffer.size();
+        raw_tag_.clear();
+        return true;
+      }
+      size_t end = raw_decode_ ? EntitySafeEnd(buffer, pos_, lt) : lt;
+      EmitText(buffer.substr(pos_, end - pos_), raw_decode_);
+      pos_ = end;
+      return false;
+    }
+    char terminator = buffer[name_end];
+    if (HtmlEqualsIgnoreCase(buffer.substr(lt + 2, raw_tag_.size()), raw_tag_) &&
+        (IsHtmlSpace(terminator) || terminator == '/' || terminator == '>')) {
+      EmitText(buffer.substr(pos_, lt - pos_), raw_decode_);
+      pos_ = lt;
+      raw_tag_.clear();
+      return true;
+    }
+    p = lt + 2;
+  }
+}
+
+bool HtmlTokenizer::ConsumeMarkup(bool at_end) {
+  std::string_view buffer(buffer_);
+  size_t begin = pos_;
+  if (begin + 1 >= buffer.size()) {
+    if (!at_end) {
+      return false;
+    }
+    EmitText("<", false);
+    pos_ = buffer.size();
+    return true;
+  }
+
+  char c = buffer[begin + 1];
+  if (IsAsciiAlpha(c)) {
+    return ConsumeTag(begin, at_end);
+  }
+  if (c == '/') {
+    return ConsumeEndTag(begin, at_end);
+  }
+  if (c != '!' && c != '?') {
+    EmitText("<", false);
+    pos_ = begin + 1;
+    return true;
+  }
+
+  if (c == '!') {
+    if (buffer.size() - begin < 9 && !at_end) {
+      return false;
+    }
+    if (buffer.substr(begin, 4) == "<!--") {
+      // 이전 Feed 에서 본 곳은 다시 찾지 않는다 (끝에 걸친 "--" 는 다시 본다)
+      size_t close = buffer.find("-->", scan_ > 4 ? begin + scan_ - 2 : begin + 2);
+      if (close == std::string_view::npos) {
+        if (!at_end) {
+          scan_ = buffer.size() - begin;
+          return false;
+        }
+        sink_->OnComment(buffer.substr(begin + 4));
+        pos_ = buffer.size();
+        return true;
+      }
+      size_t data_begin = std::min(begin + 4, close);
+      sink_->OnComment(buffer.substr(data_begin, close - data_begin));
+      pos_ = close + 3;
+      return true;
+    }
+  }
+
+  // <!doctype ...>, <!...>, <?...> (bogus comment)
+  size_t close = buffer.find('>', std::max(begin + 2, begin + scan_));
+  if (close == std::string_view::npos) {
+    if (!at_end) {
+      scan_ = buffer.size() - begin;
+      return false;
+    }
+    close = buffer.size();
+  }
+  std::string_view data = buffer.substr(begin + 2, close - begin - 2);
+  if (c == '!' && data.size() >= 7 && HtmlEqualsIgnoreCase(data.substr(0, 7), "doctype")) {
+    data.remove_prefix(7);
+    while (!data.empty() && IsHtmlSpace(data.front())) {
+      data.remove_prefix(1);
+    }
+    sink_->OnDoctype(data);
+  } else {
+    sink_->OnComment(data);
+  }
+  pos_ = std::min(close + 1, buffer.size());
+  return true;
+}
+
+bool HtmlTokenizer::ConsumeTag(size_t begin, bool at_end) {
+  std::string_view buffer(buffer_);
+  size_t size = buffer.size();
+  size_t i;
+  bool name_done;
+
+  if (resume_ == 0) {
+    i = begin + 1;
+    size_t name_begin = i;
+    while (i < size && !IsHtmlSpace(buffer[i]) && buffer[i] != '/' && buffer[i] != '>') {
+      i++;
+    }
+    name_done = i < size;
+    tag_.name.clear();
+    AppendLower(&tag_.name, buffer.substr(name_begin, i - name_begin));
+    tag_.attribute_count = 0;
+    tag_.self_closing = false;
+  } else {
+    // 이전 Feed 에서 처리한 이름과 attribute 는 tag_ 에 남아 있다
+    i = begin + resume_;
+    name_done = true;
+  }
+
+  // 입력이 모자라면 마지막으로 끝까지 읽은 항목 다음부터 다시 시작한다
+  size_t unit = i;
+  size_t unit_count = tag_.attribute_count;
+  bool unit_self_closing = tag_.self_closing;
+  bool closed = false;
+  while (i < size) {
+    unit = i;
+    unit_count = tag_.attribute_count;
+    unit_self_closing = tag_.self_closing;
+
+    char c = buffer[i];
+    if (IsHtmlSpace(c)) {
+      i++;
+      continue;
+    }
+    if (c == '>') {
+      closed = true;
+      i++;
+      break;
+    }
+    if (c == '/') {
+      i++;
+      if (i < size && buffer[i] == '>') {
+        tag_.self_closing = true;
+      }
+      continue;
+    }
+
+    size_t attr_name_begin = i;
+    i++;  // 첫 글자는 '=' 여도 이름에 포함
+    while (i < size && !IsHtmlSpace(buffer[i]) && buffer[i] != '/' && buffer[i] != '>' &&
+           buffer[i] != '=') {
+      i++;
+    }
+    size_t attr_name_end = i;
+    while (i < size && IsHtmlSpace(buffer[i])) {
+      i++;
+    }
+
+    size_t value_begin = i;
+    size_t value_end = i;
+    if (i < size && buffer[i] == '=') {
+      i++;
+      while (i < size && IsHtmlSpace(buffer[i])) {
+        i++;
+      }
+      if (i >= size) {
+        break;
+      }
+      // scan_: 이 값에서 종료 문자가 없다고 확인된 위치 (다시 읽는 값은 항상 이 attribute)
+      if (buffer[i] == '"' || buffer[i] == '\'') {
+        size_t quote_end = buffer.find(buffer[i], std::max(i + 1, begin + scan_));
+        if (quote_end == std::string_view::npos) {
+          scan_ = size - begin;
+          i = size;
+          break;
+        }
+        scan_ = 0;
+        value_begin = i + 1;
+        value_end = quote_end;
+        i = quote_end + 1;
+      } else {
+        value_begin = i;
+        i = std::max(i, begin + scan_);
+        while (i < size && !IsHtmlSpace(buffer[i]) && buffer[i] != '>') {
+          i++;
+        }
+        if (i >= size) {
+          scan_ = size - begin;
+          break;
+        }
+        scan_ = 0;
+        value_end = i;
+      }
+    } else if (i >= size) {
+      break;
+    }
+
+    if (tag_.attributes.size() <= tag_.attribute_count) {
+      tag_.attributes.emplace_back();
+    }
+    HtmlAttribute& attr = tag_.attributes[tag_.attribute_count];
+    attr.name.clear();
+    AppendLower(&attr.name, buffer.substr(attr_name_begin, attr_name_end - attr_name_begin));
+    // 중복 attribute 는 처음 것만 유지
+    bool duplicate = false;
+    for (size_t k = 0; k < tag_.attribute_count; k++) {
+      if (tag_.attributes[k].name == attr.name) {
+        duplicate = true;
+        break;
+      }
+    }
+    if (!duplicate) {
+      attr.value.clear();
+      DecodeHtmlEntities(buffer.substr(value_begin, value_end - value_begin), &attr.value, true);
+      tag_.attribute_count++;
+    }
+  }
+
+  if (!closed) {
+    if (!at_end) {
+      // 끝나지 않은 항목은 버리고 다음 Feed 에서 unit 부터 다시 읽는다
+      if (name_done) {
+        resume_ = unit - begin;
+        tag_.attribute_count = unit_count;
+        tag_.self_closing = unit_self_closing;
+      }
+      return false;
+    }
+    // EOF in tag: tag 는 버린다
+    pos_ = size;
+    return true;
+  }
+
+  pos_ = i;
+  sink_->OnStartTag(tag_);
+
+  bool decode = false;
+  if (IsRawTextTag(tag_.name, &decode)) {
+    raw_tag_ = tag_.name;
+    raw_decode_ = decode;
+  }
+  return true;
+}
+
+bool HtmlTokenizer::ConsumeEndTag(size_t begin, bool at_end) {
+  std::string_view buffer(buffer_);
+  size_t size = buffer.size();
+  if (begin + 2 >= size) {
+    if (!at_end) {
+      return false;
+    }
+    EmitText(buffer.substr(begin), false);
+    pos_ = size;
+    return true;
+  }
+
+  size_t close = buffer.find('>', std::max(begin + 2, begin + scan_));
+  if (close == std::string_view::npos) {
+    if (!at_end) {
+      scan_ = size - begin;
+      return false;
+    }
+    pos_ = size;
+    return true;
+  }
+
+  if (IsAsciiAlpha(buffer[begin + 2])) {
+    size_t name_end = begin + 2;
+    while (name_end < close && !IsHtmlSpace(buffer[name_end]) && buffer[name_end] != '/') {
+      name_end++;
+    }
+    end_tag_.clear();
+    AppendLower(&end_tag_, buffer.substr(begin + 2, name_end - begin - 2));
+    pos_ = close + 1;
+    sink_->OnEndTag(end_tag_);
+  } else if (close == begin + 2) {
+    // "</>" 는 무시
+    pos_ = close + 1;
+  } else {
+    pos_ = close + 1;
+    sink_->OnComment(buffer.substr(begin + 2, close - begin - 2));
+  }
+  return true;
+}
+
+}  // namespace request_unraver
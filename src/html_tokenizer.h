@@ -0,0 +1,98 @@
+#ifndef REQUEST_UNRAVER_HTML_TOKENIZER_H_
+#define REQUEST_UNRAVER_HTML_TOKENIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace request_unraver {
+
+struct HtmlAttribute {
+  std::string name;
+  std::string value;
+};
+
+// 재사용되는 start tag token (name/attribute 이름은 소문자)
+struct HtmlStartTag {
+  std::string name;
+  std::vector<HtmlAttribute> attributes;
+  size_t attribute_count = 0;
+  bool self_closing = false;
+
+  const HtmlAttribute* Find(std::string_view attr_name) const;
+};
+
+// token 은 콜백 동안만 유효하다.
+class HtmlTokenSink {
+ public:
+  virtual ~HtmlTokenSink() = default;
+
+  virtual void OnStartTag(const HtmlStartTag& tag) = 0;
+  virtual void OnEndTag(std::string_view name) = 0;
+  // entity 가 디코딩된 text (script/style 등 raw text 는 그대로)
+  virtual void OnText(std::string_view text) = 0;
+  virtual void OnComment(std::string_view data) {}
+  virtual void OnDoctype(std::string_view data) {}
+};
+
+// HTML5 tokenizer (streaming)
+//
+// Feed() 는 완성된 token 만 sink 로 내보내고 나머지는 다음 Feed() 까지 보관한다.
+// script/style/textarea/title 등은 대응하는 end tag 까지 text 로 처리된다.
+// 입력은 UTF-8 로 가정하며 잘못된 markup 은 browser 와 비슷하게 text 로 복구한다.
+class HtmlTokenizer {
+ public:
+  explicit HtmlTokenizer(HtmlTokenSink* sink);
+
+  HtmlTokenizer(const HtmlTokenizer&) = delete;
+  HtmlTokenizer& operator=(const HtmlTokenizer&) = delete;
+
+  void Feed(const char* data, size_t len);
+  // 남은 입력을 모두 내보낸다.
+  void Finish();
+
+  // sink 가 token 처리 중 호출하면 이후 token 을 내보내지 않는다.
+  void Stop() { stopped_ = true; }
+  bool stopped() const { return stopped_; }
+
+ private:
+  // buffer_[pos_..] 에서 token 하나를 처리. 입력이 더 필요하면 false
+  bool Step(bool at_end);
+  bool ConsumeText(bool at_end);
+  bool ConsumeRawText(bool at_end);
+  bool ConsumeMarkup(bool at_end);
+  bool ConsumeTag(size_t begin, bool at_end);
+  bool ConsumeEndTag(size_t begin, bool at_end);
+  void EmitText(std::string_view raw, bool decode);
+
+  HtmlTokenSink* sink_;
+  std::string buffer_;
+  size_t pos_;
+  bool stopped_;
+
+  // 여러 Feed 에 걸친 markup 의 진행 상태 (pos_ 기준 offset, token 이 끝나면 0)
+  //   - resume_: start tag 를 다시 읽을 위치 (그 앞의 이름/attribute 는 tag_ 에 있다)
+  //   - scan_: 종료 문자열이 없다고 확인된 위치
+  size_t resume_;
+  size_t scan_;
+
+  // raw text 상태 (script 등): 닫는 tag 이름과 entity 디코딩 여부
+  std::string raw_tag_;
+  bool raw_decode_;
+
+  HtmlStartTag tag_;
+  std::string end_tag_;
+  std::string scratch_;
+};
+
+// &amp; &#39; &#x27; 및 자주 쓰이는 named entity 를 디코딩해 out 에 추가
+void DecodeHtmlEntities(std::string_view in, std::string* out, bool in_attribute);
+
+// ASCII 소문자 비교
+bool HtmlEqualsIgnoreCase(std::string_view a, std::string_view b);
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_HTML_TOKENIZER_H_
@@ -90,13 +90,3 @@ class URLSearchParams {
 
 globalThis.URLSearchParams = URLSearchParams;
 globalThis.URL = URL;
-
-globalThis.__sys_wrapped_require = function (orig_require, filename) {
-    return function wrapped_require(name) {
-        const u = orig_require('node:url');
-        if (name.startsWith('.')) {
-            name = u.resolve(filename, name);
-        }
-        return orig_require(name);
-    };
-}
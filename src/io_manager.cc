@@ -0,0 +1,235 @@
+#include "io_manager.h"
+
+#include <cstring>
+#include <string>
+
+#include <msgpack.hpp>
+
+#if defined(REQUEST_UNRAVER_THREADS)
+#include <emscripten/threading.h>
+#endif
+
+#include "wasm_binding.h"
+
+namespace request_unraver {
+
+namespace {
+
+JSValue NewIoError(JSContext* ctx, JSValueConst message) {
+  JSValue error = JS_NewError(ctx);
+  JS_SetPropertyStr(ctx, error, "message", JS_ToString(ctx, message));
+  return error;
+}
+
+// reason 으로 reject 하고 reason 을 해제
+JSValue Reject(JSContext* ctx, JSValueConst reject, JSValue reason) {
+  JSValue ret = JS_Call(ctx, reject, JS_UNDEFINED, 1, &reason);
+  JS_FreeValue(ctx, reason);
+  return ret;
+}
+
+}  // anonymous
+
+IoManager::IoManager(JSRuntime* rt) : next_io_id_(1), runtime_(rt) {}
+
+IoManager::~IoManager() {
+  for (auto& item : pending_) {
+    FreePending(item.second);
+  }
+  pending_.clear();
+}
+
+void IoManager::FreePending(PendingIo& io) {
+  JS_FreeValueRT(runtime_, io.resolve);
+  JS_FreeValueRT(runtime_, io.reject);
+  io.resolve = JS_UNDEFINED;
+  io.reject = JS_UNDEFINED;
+}
+
+size_t IoManager::CancelContext(JSContext* ctx) {
+  size_t count = 0;
+  for (auto iter = pending_.begin(); iter != pending_.end();) {
+    if (iter->second.ctx == ctx) {
+      FreePending(iter->second);
+      iter = pending_.erase(iter);
+      count++;
+    } else {
+      ++iter;
+    }
+  }
+  return count;
+}
+
+JSValue IoManager::SubmitImpl(JSContext* ctx, uint64_t host_handle,
+                              uint64_t host_window, JSValueConst this_val,
+                              int argc, JSValueConst* argv) {
+  if (argc < 2) {
+    return JS_ThrowTypeError(ctx, "io_submit(kind, request[, body]) expected");
+  }
+
+  size_t kind_len = 0;
+  size_t request_len = 0;
+  const char* kind = JS_ToCStringLen(ctx, &kind_len, argv[0]);
+  if (!kind) {
+    return JS_EXCEPTION;
+  }
+  const char* request = JS_ToCStringLen(ctx, &request_len, argv[1]);
+  if (!request) {
+    JS_FreeCString(ctx, kind);
+    return JS_EXCEPTION;
+  }
+
+  uint32_t io_id = next_io_id_++;
+  if (next_io_id_ == 0) {
+    next_io_id_ = 1;
+  }
+
+  // { kind, id, request, body } 형태로 호스트에 전달
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  pk.pack_map(4);
+  pk.pack("kind");
+  pk.pack_str(kind_len);
+  pk.pack_str_body(kind, kind_len);
+  pk.pack("id");
+  pk.pack_uint32(io_id);
+  pk.pack("request");
+  pk.pack_str(request_len);
+  pk.pack_str_body(request, request_len);
+  pk.pack("body");
+
+  JS_FreeCString(ctx, kind);
+  JS_FreeCString(ctx, request);
+
+  JSValueConst body = argc > 2 ? argv[2] : JS_UNDEFINED;
+  if (JS_IsUndefined(body) || JS_IsNull(body)) {
+    pk.pack_nil();
+  } else if (JS_IsString(body)) {
+    size_t body_len = 0;
+    const char* body_str = JS_ToCStringLen(ctx, &body_len, body);
+    if (!body_str) {
+      return JS_EXCEPTION;
+    }
+    pk.pack_str(body_len);
+    pk.pack_str_body(body_str, body_len);
+    JS_FreeCString(ctx, body_str);
+  } else {
+    size_t body_len = 0;
+    uint8_t* body_data = JS_GetUint8Array(ctx, &body_len, body);
+    if (!body_data) {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      body_data = JS_GetArrayBuffer(ctx, &body_len, body);
+    }
+    if (!body_data) {
+      return JS_ThrowTypeError(ctx, "io_submit: unsupported body type");
+    }
+    pk.pack_bin(body_len);
+    pk.pack_bin_body((const char*)body_data, body_len);
+  }
+
+  JSValue resolving_funcs[2];
+  JSValue promise = JS_NewPromiseCapability(ctx, resolving_funcs);
+  if (JS_IsException(promise)) {
+    return promise;
+  }
+
+  PendingIo io;
+  io.ctx = ctx;
+  io.resolve = resolving_funcs[0];
+  io.reject = resolving_funcs[1];
+  pending_[io_id] = io;
+
+#if defined(REQUEST_UNRAVER_THREADS)
+  // pool worker 에는 호스트 I/O 핸들러가 없다: { error } 결과로 바로 완료해서 reject 시킨다
+  if (!emscripten_is_main_runtime_thread()) {
+    static const char kNoHostIo[] = "io: async host I/O is not available on pool workers";
+    msgpack::sbuffer error_buf;
+    msgpack::packer<msgpack::sbuffer> error_pk(&error_buf);
+    error_pk.pack_map(1);
+    error_pk.pack("error");
+    error_pk.pack(kNoHostIo);
+    Complete(io_id, (const uint8_t*)error_buf.data(), error_buf.size());
+    return promise;
+  }
+#endif
+
+  ru_io_submit(host_handle, host_window, io_id, (const uint8_t*)sbuf.data(), (int)sbuf.size());
+
+  return promise;
+}
+
+JSValue IoManager::CompleteJob(JSContext* ctx, int argc, JSValueConst* argv) {
+  // argv: [resolve, reject, raw_result]
+  // 어떤 경우에도 promise 가 settle 되도록 실패는 모두 reject 로 전달한다
+  size_t raw_len = 0;
+  if (!JS_GetUint8Array(ctx, &raw_len, argv[2]) || raw_len == 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    JSValue message = JS_NewString(ctx, "io: empty host result");
+    JSValue ret = Reject(ctx, argv[1], NewIoError(ctx, message));
+    JS_FreeValue(ctx, message);
+    return ret;
+  }
+
+  JSValue global_obj = JS_GetGlobalObject(ctx);
+  JSValue sys_obj = JS_GetPropertyStr(ctx, global_obj, "__sys");
+  JSValue munpack_func = JS_GetPropertyStr(ctx, sys_obj, "munpack");
+  JSValue result = JS_Call(ctx, munpack_func, JS_UNDEFINED, 1, &argv[2]);
+  JS_FreeValue(ctx, munpack_func);
+  JS_FreeValue(ctx, sys_obj);
+  JS_FreeValue(ctx, global_obj);
+
+  if (JS_IsException(result)) {
+    JSValue exception = JS_GetException(ctx);
+    if (JS_IsUncatchableError(ctx, exception)) {
+      return JS_Throw(ctx, exception);
+    }
+    return Reject(ctx, argv[1], exception);
+  }
+
+  // 호스트 실패는 { error } 로 온다 (engine.ts dispatchIo)
+  JSValue host_error = JS_IsObject(result) ? JS_GetPropertyStr(ctx, result, "error") : JS_UNDEFINED;
+  if (JS_IsException(host_error)) {
+    JS_FreeValue(ctx, result);
+    return Reject(ctx, argv[1], JS_GetException(ctx));
+  }
+  if (!JS_IsUndefined(host_error) && !JS_IsNull(host_error)) {
+    JS_FreeValue(ctx, result);
+    JSValue ret = Reject(ctx, argv[1], NewIoError(ctx, host_error));
+    JS_FreeValue(ctx, host_error);
+    return ret;
+  }
+
+  JSValue ret = JS_Call(ctx, argv[0], JS_UNDEFINED, 1, &result);
+  JS_FreeValue(ctx, result);
+  return ret;
+}
+
+bool IoManager::Complete(uint32_t io_id, const uint8_t* result_msgp, size_t result_len) {
+  auto iter = pending_.find(io_id);
+  if (iter == pending_.end()) {
+    return false;
+  }
+
+  PendingIo io = iter->second;
+  pending_.erase(iter);
+
+  JSContext* ctx = io.ctx;
+  JSValue raw = JS_NewUint8ArrayCopy(ctx, result_msgp, result_len);
+  if (JS_IsException(raw)) {
+    // 빈 결과로 취급해서 CompleteJob 이 reject 한다
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    raw = JS_UNDEFINED;
+  }
+  JSValueConst args[3] = {
+    io.resolve,
+    io.reject,
+    raw,
+  };
+  int ret = JS_EnqueueJob(ctx, CompleteJob, 3, args);
+  JS_FreeValue(ctx, raw);
+  FreePending(io);
+
+  return ret == 0;
+}
+
+}  // namespace request_unraver
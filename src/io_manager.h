@@ -0,0 +1,56 @@
+#ifndef REQUEST_UNRAVER_IO_MANAGER_H_
+#define REQUEST_UNRAVER_IO_MANAGER_H_
+
+#include <cstdint>
+#include <unordered_map>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// 호스트 비동기 I/O (XHR 등) 관리
+//
+// 게스트는 Submit() 으로 pending handle(io id)과 Promise 를 받고,
+// 호스트는 나중에 engine_complete_io 로 결과를 돌려준다.
+// 완료 처리는 job queue 에 등록되어 Engine::LoopStep 에서 실행된다.
+class IoManager {
+ public:
+  explicit IoManager(JSRuntime* rt);
+  ~IoManager();
+
+  // 요청을 호스트로 전달하고 Promise 반환
+  //   - host_window: 요청한 window 의 식별자 (Engine::HostWindow)
+  JSValue SubmitImpl(JSContext* ctx, uint64_t host_handle, uint64_t host_window,
+                     JSValueConst this_val, int argc, JSValueConst* argv);
+
+  // 호스트가 전달한 결과(msgpack)로 Promise 를 resolve 하는 job 등록
+  bool Complete(uint32_t io_id, const uint8_t* result_msgp, size_t result_len);
+
+  // ctx 에서 시작된 요청을 버린다 (window context 해제 전).
+  // 이후 호스트의 engine_complete_io 는 false 를 받는다
+  size_t CancelContext(JSContext* ctx);
+
+  // 완료되지 않은 요청 확인
+  bool HasPendingIo() const { return !pending_.empty(); }
+  size_t pending_count() const { return pending_.size(); }
+
+ private:
+  struct PendingIo {
+    JSContext* ctx;
+    JSValue resolve;
+    JSValue reject;
+  };
+
+  static JSValue CompleteJob(JSContext* ctx, int argc, JSValueConst* argv);
+  void FreePending(PendingIo& io);
+
+  std::unordered_map<uint32_t, PendingIo> pending_;
+  uint32_t next_io_id_;
+  JSRuntime* runtime_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_IO_MANAGER_H_
@@ -0,0 +1,62 @@
+#ifndef REQUEST_UNRAVER_JS_BYTES_H_
+#define REQUEST_UNRAVER_JS_BYTES_H_
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// native 함수 입력 (string 은 UTF-8, 그 외는 ArrayBuffer/TypedArray 의 backing store)
+//
+// 복사하지 않으므로 data 는 다음 JS 호출 전까지만 유효하다.
+struct JsBytes {
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  const char* str = nullptr;
+
+  // 실패시 pending exception 과 함께 false
+  bool Get(JSContext* ctx, JSValueConst value) {
+    if (JS_IsString(value)) {
+      str = JS_ToCStringLen(ctx, &len, value);
+      data = reinterpret_cast<const uint8_t*>(str);
+      return str != nullptr;
+    }
+    if (JS_IsArrayBuffer(value)) {
+      data = JS_GetArrayBuffer(ctx, &len, value);
+      return data != nullptr || len == 0;
+    }
+    if (JS_GetTypedArrayType(value) >= 0) {
+      size_t offset = 0;
+      size_t unit = 0;
+      JSValue buffer = JS_GetTypedArrayBuffer(ctx, value, &offset, &len, &unit);
+      if (JS_IsException(buffer)) {
+        return false;
+      }
+      size_t size = 0;
+      uint8_t* base = JS_GetArrayBuffer(ctx, &size, buffer);
+      // typed array 가 buffer 를 참조하므로 해제 후에도 유효
+      JS_FreeValue(ctx, buffer);
+      data = base ? base + offset : nullptr;
+      return true;
+    }
+    JS_ThrowTypeError(ctx, "data must be a string, Buffer, TypedArray or ArrayBuffer");
+    return false;
+  }
+
+  void Free(JSContext* ctx) {
+    if (str) {
+      JS_FreeCString(ctx, str);
+      str = nullptr;
+    }
+    data = nullptr;
+    len = 0;
+  }
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_JS_BYTES_H_
@@ -0,0 +1,68 @@
+#include "log_buffer.h"
+
+#include <utility>
+
+namespace request_unraver {
+
+namespace {
+
+// release 빌드는 호스트가 engine_set_log_level 로 켜기 전까지 수집하지 않는다
+#ifdef NDEBUG
+constexpr LogLevel kDefaultMinLevel = kLogOff;
+#else
+constexpr LogLevel kDefaultMinLevel = kLogDebug;
+#endif
+
+}  // anonymous
+
+LogBuffer::LogBuffer(size_t capacity)
+  : lines_(capacity ? capacity : 1), head_(0), size_(0), dropped_(0),
+    min_level_(kDefaultMinLevel) {}
+
+void LogBuffer::Append(LogLevel level, std::string text) {
+  if (!Enabled(level)) {
+    return;
+  }
+  if (text.size() > kMaxLineBytes) {
+    // UTF-8 continuation byte 중간에서 자르지 않도록
+    size_t cut = kMaxLineBytes;
+    while (cut > 0 && (static_cast<uint8_t>(text[cut]) & 0xc0) == 0x80) {
+      cut--;
+    }
+    text.resize(cut);
+  }
+
+  size_t index = (head_ + size_) % lines_.size();
+  if (size_ == lines_.size()) {
+    // 가장 오래된 줄을 덮어쓴다
+    head_ = (head_ + 1) % lines_.size();
+    dropped_++;
+  } else {
+    size_++;
+  }
+  lines_[index].level = level;
+  lines_[index].text = std::move(text);
+}
+
+void LogBuffer::Drain(msgpack::packer<msgpack::sbuffer>* pk) {
+  pk->pack_map(2);
+  pk->pack("dropped");
+  pk->pack_uint64(dropped_);
+  pk->pack("lines");
+  pk->pack_array(static_cast<uint32_t>(size_));
+  for (size_t i = 0; i < size_; i++) {
+    Line& line = lines_[(head_ + i) % lines_.size()];
+    pk->pack_map(2);
+    pk->pack("level");
+    pk->pack_uint32(line.level);
+    pk->pack("text");
+    pk->pack_str(static_cast<uint32_t>(line.text.size()));
+    pk->pack_str_body(line.text.data(), static_cast<uint32_t>(line.text.size()));
+    std::string().swap(line.text);
+  }
+  head_ = 0;
+  size_ = 0;
+  dropped_ = 0;
+}
+
+}  // namespace request_unraver
@@ -0,0 +1,65 @@
+#ifndef REQUEST_UNRAVER_LOG_BUFFER_H_
+#define REQUEST_UNRAVER_LOG_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <msgpack.hpp>
+
+namespace request_unraver {
+
+// console.debug / info (log) / warn / error
+enum LogLevel : uint32_t {
+  kLogDebug = 0,
+  kLogInfo = 1,
+  kLogWarn = 2,
+  kLogError = 3,
+  kLogOff = 4,
+};
+
+// guest console 출력을 모아두는 engine 별 ring buffer
+//
+// console.* 마다 stdout 에 쓰면 줄마다 fd_write 호스트 호출이 생기므로,
+// 여기 쌓아두고 호스트가 engine_drain_logs 로 한 번에 가져간다.
+// 가득 차면 오래된 줄부터 버리고 dropped 로 센다.
+class LogBuffer {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024;
+  // 이보다 긴 줄은 잘라서 저장
+  static constexpr size_t kMaxLineBytes = 16 * 1024;
+
+  explicit LogBuffer(size_t capacity = kDefaultCapacity);
+
+  LogBuffer(const LogBuffer&) = delete;
+  LogBuffer& operator=(const LogBuffer&) = delete;
+
+  // min_level 미만은 console 인자 변환 전에 버린다
+  bool Enabled(LogLevel level) const { return level >= min_level_; }
+  LogLevel min_level() const { return min_level_; }
+  void set_min_level(LogLevel level) { min_level_ = level; }
+
+  void Append(LogLevel level, std::string text);
+
+  // { dropped, lines: [{ level, text }] } 를 쓰고 비운다
+  void Drain(msgpack::packer<msgpack::sbuffer>* pk);
+
+  size_t size() const { return size_; }
+
+ private:
+  struct Line {
+    LogLevel level;
+    std::string text;
+  };
+
+  std::vector<Line> lines_;
+  size_t head_;
+  size_t size_;
+  uint64_t dropped_;
+  LogLevel min_level_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_LOG_BUFFER_H_
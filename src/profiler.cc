@@ -0,0 +1,133 @@
+#include "profiler.h"
+
+#include <vector>
+
+namespace request_unraver {
+
+namespace {
+
+constexpr double kMinIntervalMs = 0.1;
+
+std::string_view Trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\r')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+// "f (file:12:5)" -> "f (file:12)", "file:12:5" -> "file:12"
+// ';' 는 collapsed 형식의 frame 구분자라 ',' 로 바꾼다
+void AppendFrame(std::string_view frame, std::string* out) {
+  size_t end = frame.size();
+  if (end > 0 && frame[end - 1] == ')') {
+    end--;
+  }
+  size_t colon = frame.rfind(':', end);
+  bool has_column = colon != std::string_view::npos && colon + 1 < end &&
+                    colon > 0 && frame.rfind(':', colon - 1) != std::string_view::npos;
+  for (size_t i = colon + 1; has_column && i < end; i++) {
+    has_column = frame[i] >= '0' && frame[i] <= '9';
+  }
+  std::string_view head = has_column ? frame.substr(0, colon) : frame;
+  std::string_view tail = has_column ? frame.substr(end) : std::string_view();
+  for (char c : head) {
+    *out += c == ';' ? ',' : c;
+  }
+  *out += tail;
+}
+
+}  // anonymous
+
+Profiler::Profiler()
+  : samples_(0), interval_ms_(1), start_ms_(0), next_sample_ms_(0), active_(false) {}
+
+void Profiler::Start(double now_ms, double interval_ms) {
+  stacks_.clear();
+  samples_ = 0;
+  interval_ms_ = interval_ms < kMinIntervalMs ? kMinIntervalMs : interval_ms;
+  start_ms_ = now_ms;
+  next_sample_ms_ = now_ms + interval_ms_;
+  active_ = true;
+}
+
+void Profiler::Stop(double now_ms, msgpack::packer<msgpack::sbuffer>* pk) {
+  std::string collapsed;
+  for (const auto& item : stacks_) {
+    collapsed += item.first;
+    collapsed += ' ';
+    collapsed += std::to_string(item.second);
+    collapsed += '\n';
+  }
+
+  pk->pack_map(4);
+  pk->pack("samples");
+  pk->pack_uint64(samples_);
+  pk->pack("intervalMs");
+  pk->pack_double(interval_ms_);
+  pk->pack("durationMs");
+  pk->pack_double(active_ ? now_ms - start_ms_ : 0);
+  pk->pack("stacks");
+  pk->pack(collapsed);
+
+  stacks_.clear();
+  samples_ = 0;
+  active_ = false;
+}
+
+void Profiler::MaybeSample(JSContext* ctx, double now_ms) {
+  if (!active_ || now_ms < next_sample_ms_) {
+    return;
+  }
+  uint64_t weight = 1 + static_cast<uint64_t>((now_ms - next_sample_ms_) / interval_ms_);
+  next_sample_ms_ = now_ms + interval_ms_;
+
+  JSValue backtrace = JS_UNDEFINED;
+  js_std_cmd(/*ErrorBackTrace*/2, ctx, &backtrace);
+  size_t len = 0;
+  const char* str = JS_IsString(backtrace) ? JS_ToCStringLen(ctx, &len, backtrace) : nullptr;
+  JS_FreeValue(ctx, backtrace);
+
+  std::string stack;
+  if (str) {
+    Collapse(std::string_view(str, len), &stack);
+    JS_FreeCString(ctx, str);
+  }
+  if (stack.empty()) {
+    // JS frame 없이 native 코드 (job, timer 처리 등) 에 있을 때
+    stack = "(native)";
+  }
+  stacks_[stack] += weight;
+  samples_ += weight;
+}
+
+void Profiler::Collapse(std::string_view backtrace, std::string* out) {
+  // backtrace 는 leaf 부터 나온다
+  std::vector<std::string_view> frames;
+  size_t pos = 0;
+  while (pos < backtrace.size()) {
+    size_t end = backtrace.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = backtrace.size();
+    }
+    std::string_view line = Trim(backtrace.substr(pos, end - pos));
+    pos = end + 1;
+    if (line.substr(0, 3) == "at ") {
+      line = Trim(line.substr(3));
+    }
+    if (!line.empty()) {
+      frames.push_back(line);
+    }
+  }
+
+  for (size_t i = frames.size(); i-- > 0;) {
+    if (!out->empty()) {
+      *out += ';';
+    }
+    AppendFrame(frames[i], out);
+  }
+}
+
+}  // namespace request_unraver
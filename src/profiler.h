@@ -0,0 +1,54 @@
+#ifndef REQUEST_UNRAVER_PROFILER_H_
+#define REQUEST_UNRAVER_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <msgpack.hpp>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// guest JS sampling profiler
+//
+// QuickJS interrupt handler (일정 bytecode 수마다 호출) 에서 interval 이 지났으면
+// 현재 stack 을 ErrorBackTrace 로 얻어 collapsed stack ("root;...;leaf") 별로 센다.
+// 긴 native 호출 뒤처럼 여러 interval 이 지났으면 그만큼 가중치를 준다.
+class Profiler {
+ public:
+  Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  bool active() const { return active_; }
+
+  // 이전 결과는 버린다
+  void Start(double now_ms, double interval_ms);
+
+  // { samples, intervalMs, durationMs, stacks: "frame;frame N\n..." } 를 쓰고 초기화
+  void Stop(double now_ms, msgpack::packer<msgpack::sbuffer>* pk);
+
+  // interrupt handler 에서 호출
+  void MaybeSample(JSContext* ctx, double now_ms);
+
+ private:
+  // "    at f (file:line:col)" 줄들을 root 부터 ';' 로 잇는다 (column 은 버림)
+  static void Collapse(std::string_view backtrace, std::string* out);
+
+  std::unordered_map<std::string, uint64_t> stacks_;
+  uint64_t samples_;
+  double interval_ms_;
+  double start_ms_;
+  double next_sample_ms_;
+  bool active_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_PROFILER_H_
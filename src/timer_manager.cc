@@ -69,7 +69,7 @@ JsOsTimer* TimerManager::FindTimerById(int64_t timer_id) {
   return nullptr;
 }
 
-int TimerManager::RunTimers(JSContext* ctx, int* min_delay) {
+int TimerManager::RunTimers(JSContext* ctx, int* min_delay, JSContext** running_ctx) {
   if (list_empty(&thread_state_->os_timers)) {
     *min_delay = -1;
     return 0;
@@ -87,12 +87,16 @@ int TimerManager::RunTimers(JSContext* ctx, int* min_delay) {
     } else {
       *min_delay = 0;
       JSValue func = JS_DupValueRT(runtime_, th->func);
+      JSContext* timer_ctx = th->ctx ? th->ctx : ctx;
       if (th->repeats) {
         th->timeout = cur_time + th->delay;
       } else {
         FreeTimer(th);
       }
+      JSContext* prev_running = *running_ctx;
+      *running_ctx = timer_ctx;
       int ret = CallHandler(ctx, func);
+      *running_ctx = prev_running;
       JS_FreeValueRT(runtime_, func);
       return ret;
     }
@@ -134,6 +138,7 @@ JSValue TimerManager::SetTimeoutImpl(JSContext* ctx, JSValueConst this_val,
   th->timeout = static_cast<int64_t>(GetTimeMs()) + delay;
   th->delay = delay;
   th->func = JS_DupValue(ctx, func);
+  th->ctx = ctx;
   list_add_tail(&th->link, &thread_state_->os_timers);
 
   return JS_NewInt64(ctx, th->timer_id);
@@ -158,4 +163,21 @@ bool TimerManager::HasTimers() const {
   return thread_state_ && !list_empty(&thread_state_->os_timers);
 }
 
+size_t TimerManager::CancelContext(JSContext* ctx) {
+  if (!thread_state_) {
+    return 0;
+  }
+  size_t count = 0;
+  struct list_head* el;
+  struct list_head* next;
+  list_for_each_safe(el, next, &thread_state_->os_timers) {
+    JsOsTimer* th = list_entry(el, JsOsTimer, link);
+    if (th->ctx == ctx) {
+      FreeTimer(th);
+      count++;
+    }
+  }
+  return count;
+}
+
 }  // namespace request_unraver
\ No newline at end of file
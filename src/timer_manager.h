@@ -14,6 +14,8 @@ struct JsOsTimer {
   int64_t timeout;
   int64_t delay;
   JSValue func;
+  // 등록한 context (참조를 가지지 않음. context 해제 전에 CancelContext)
+  JSContext* ctx;
 };
 
 struct JsThreadState {
@@ -35,11 +37,15 @@ class TimerManager {
                            JSValueConst* argv);
 
   // 타이머 실행 (min_delay 출력)
-  int RunTimers(JSContext* ctx, int* min_delay);
+  //   - 콜백을 부르는 동안 *running_ctx 를 타이머를 등록한 context 로 바꾼다 (profiler)
+  int RunTimers(JSContext* ctx, int* min_delay, JSContext** running_ctx);
 
   // 활성 타이머 확인
   bool HasTimers() const;
 
+  // ctx 에서 등록된 타이머 모두 해제 (window context 해제 전)
+  size_t CancelContext(JSContext* ctx);
+
   // 초기화된 thread_state 반환 (rt opaque 설정됨)
   JsThreadState* thread_state() const { return thread_state_; }
 
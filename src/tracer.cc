@@ -0,0 +1,51 @@
+#include "tracer.h"
+
+#include "wasm_binding.h"
+
+namespace request_unraver {
+
+Tracer::Tracer() : dropped_(0), request_id_(0), enabled_(false) {}
+
+double Tracer::Now() const {
+  return ru_get_now();
+}
+
+void Tracer::Add(std::string_view category, std::string_view name, double begin_ms, double end_ms) {
+  if (events_.size() >= kMaxEvents) {
+    dropped_++;
+    return;
+  }
+  events_.push_back(Event{
+    std::string(category),
+    std::string(name),
+    begin_ms,
+    end_ms,
+    request_id_,
+  });
+}
+
+void Tracer::Drain(msgpack::packer<msgpack::sbuffer>* pk) {
+  pk->pack_map(2);
+  pk->pack("dropped");
+  pk->pack_uint64(dropped_);
+  pk->pack("events");
+  pk->pack_array(static_cast<uint32_t>(events_.size()));
+  for (const Event& event : events_) {
+    pk->pack_map(5);
+    pk->pack("cat");
+    pk->pack(event.category);
+    pk->pack("name");
+    pk->pack(event.name);
+    pk->pack("ts");
+    pk->pack_double(event.begin_ms * 1000.0);
+    pk->pack("dur");
+    pk->pack_double((event.end_ms - event.begin_ms) * 1000.0);
+    pk->pack("tid");
+    pk->pack_uint32(event.request_id);
+  }
+  // 다음 요청에서 다시 쓰지 않을 수 있으므로 용량도 반환
+  std::vector<Event>().swap(events_);
+  dropped_ = 0;
+}
+
+}  // namespace request_unraver
@@ -0,0 +1,83 @@
+#ifndef REQUEST_UNRAVER_TRACER_H_
+#define REQUEST_UNRAVER_TRACER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <msgpack.hpp>
+
+namespace request_unraver {
+
+// engine 별 span 기록 (Chrome trace-event 의 complete event 로 변환)
+//
+// 호스트가 engine_trace_enable 로 켜기 전에는 TraceScope 가 enabled() 분기
+// 하나만 하고 시계도 읽지 않는다. span 은 호스트가 정한 request id 를 가진다.
+class Tracer {
+ public:
+  // 이보다 많이 쌓이면 이후 span 은 버리고 dropped 로 센다
+  static constexpr size_t kMaxEvents = 64 * 1024;
+
+  Tracer();
+
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  bool enabled() const { return enabled_; }
+  void set_enabled(bool enabled) { enabled_ = enabled; }
+
+  uint32_t request_id() const { return request_id_; }
+  void set_request_id(uint32_t request_id) { request_id_ = request_id; }
+
+  // milliseconds (호스트 performance.now 와 같은 시계)
+  double Now() const;
+
+  void Add(std::string_view category, std::string_view name, double begin_ms, double end_ms);
+
+  // { dropped, events: [{ cat, name, ts, dur, tid }] } (ts/dur: microseconds) 를 쓰고 비운다
+  void Drain(msgpack::packer<msgpack::sbuffer>* pk);
+
+ private:
+  struct Event {
+    std::string category;
+    std::string name;
+    double begin_ms;
+    double end_ms;
+    uint32_t request_id;
+  };
+
+  std::vector<Event> events_;
+  uint64_t dropped_;
+  uint32_t request_id_;
+  bool enabled_;
+};
+
+// scope 동안의 span. name/category 는 scope 보다 오래 살아야 한다
+class TraceScope {
+ public:
+  TraceScope(Tracer* tracer, std::string_view category, std::string_view name)
+    : tracer_(tracer && tracer->enabled() ? tracer : nullptr),
+      category_(category), name_(name),
+      begin_ms_(tracer_ ? tracer_->Now() : 0) {}
+
+  ~TraceScope() {
+    if (tracer_) {
+      tracer_->Add(category_, name_, begin_ms_, tracer_->Now());
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  Tracer* tracer_;
+  std::string_view category_;
+  std::string_view name_;
+  double begin_ms_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_TRACER_H_
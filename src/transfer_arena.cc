@@ -0,0 +1,74 @@
+#include "transfer_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace request_unraver {
+
+namespace {
+
+// 이 크기 이상으로 커진 버퍼는 Trim() 시 해제
+constexpr size_t kRetainCapacity = 4 * 1024 * 1024;
+
+}  // anonymous
+
+TransferArena::TransferArena() : data_(nullptr), capacity_(0), reserved_(0) {}
+
+TransferArena::~TransferArena() {
+  free(data_);
+  data_ = nullptr;
+}
+
+uint8_t* TransferArena::Reserve(size_t payload_len) {
+  size_t required = kHeadRoom + payload_len + kTailRoom;
+  if (required > capacity_) {
+    size_t new_capacity = capacity_ ? capacity_ : 64 * 1024;
+    while (new_capacity < required) {
+      new_capacity *= 2;
+    }
+    // 이전 내용은 보존할 필요가 없으므로 realloc 대신 새로 할당
+    free(data_);
+    data_ = static_cast<uint8_t*>(malloc(new_capacity));
+    if (!data_) {
+      capacity_ = 0;
+      reserved_ = 0;
+      return nullptr;
+    }
+    capacity_ = new_capacity;
+  }
+  reserved_ = payload_len;
+  return data_ + kHeadRoom;
+}
+
+std::string_view TransferArena::Payload(size_t payload_len) const {
+  if (!data_ || payload_len > reserved_) {
+    return std::string_view();
+  }
+  return std::string_view(reinterpret_cast<const char*>(data_ + kHeadRoom), payload_len);
+}
+
+const char* TransferArena::Wrap(size_t payload_len, std::string_view prefix,
+                                std::string_view suffix, size_t* out_len) {
+  if (!data_ || payload_len > reserved_ || prefix.size() > kHeadRoom ||
+      suffix.size() >= kTailRoom) {
+    return nullptr;
+  }
+  uint8_t* begin = data_ + kHeadRoom - prefix.size();
+  uint8_t* end = data_ + kHeadRoom + payload_len;
+  memcpy(begin, prefix.data(), prefix.size());
+  memcpy(end, suffix.data(), suffix.size());
+  end[suffix.size()] = 0;
+  *out_len = prefix.size() + payload_len + suffix.size();
+  return reinterpret_cast<const char*>(begin);
+}
+
+void TransferArena::Trim() {
+  reserved_ = 0;
+  if (capacity_ > kRetainCapacity) {
+    free(data_);
+    data_ = nullptr;
+    capacity_ = 0;
+  }
+}
+
+}  // namespace request_unraver
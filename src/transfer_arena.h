@@ -0,0 +1,52 @@
+#ifndef REQUEST_UNRAVER_TRANSFER_ARENA_H_
+#define REQUEST_UNRAVER_TRANSFER_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace request_unraver {
+
+// 호스트 <-> WASM 문자열 전달용 재사용 버퍼
+//
+// 호스트는 Reserve() 가 반환한 위치에 UTF-8 payload 를 직접 쓰고,
+// C++ 쪽은 Wrap() 으로 payload 앞뒤에 wrapper 코드를 붙여 복사 없이 파싱한다.
+//
+//   [ head room | payload | tail room ]
+//          ^ prefix    ^ suffix + '\0'
+class TransferArena {
+ public:
+  static constexpr size_t kHeadRoom = 512;
+  static constexpr size_t kTailRoom = 64;
+
+  TransferArena();
+  ~TransferArena();
+
+  TransferArena(const TransferArena&) = delete;
+  TransferArena& operator=(const TransferArena&) = delete;
+
+  // payload_len 바이트를 쓸 수 있는 위치 반환 (실패시 nullptr)
+  uint8_t* Reserve(size_t payload_len);
+
+  // 마지막으로 예약된 payload
+  std::string_view Payload(size_t payload_len) const;
+
+  // prefix + payload + suffix 를 null-terminated 연속 버퍼로 구성
+  // prefix 는 kHeadRoom, suffix 는 kTailRoom - 1 이하여야 한다.
+  const char* Wrap(size_t payload_len, std::string_view prefix,
+                   std::string_view suffix, size_t* out_len);
+
+  // 큰 payload 이후 메모리 반환
+  void Trim();
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  uint8_t* data_;
+  size_t capacity_;
+  size_t reserved_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_TRANSFER_ARENA_H_
@@ -53,6 +53,8 @@ bool VfsManager::Init(const unsigned char* data, size_t size) {
 }
 
 void VfsManager::Shutdown() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_cache_.clear();
   if (vfs_) {
     sqfs_destroy(vfs_);
     free(vfs_);
@@ -60,7 +62,22 @@ void VfsManager::Shutdown() {
   }
 }
 
-std::unique_ptr<FileBuffer> VfsManager::ReadVfsFile(const char* path) {
+std::shared_ptr<const FileBuffer> VfsManager::ReadVfsFile(const char* path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto iter = file_cache_.find(path);
+  if (iter != file_cache_.end()) {
+    return iter->second;
+  }
+
+  std::shared_ptr<const FileBuffer> file_buffer = ReadVfsFileLocked(path);
+  if (file_buffer) {
+    file_cache_.emplace(path, file_buffer);
+  }
+  return file_buffer;
+}
+
+std::shared_ptr<const FileBuffer> VfsManager::ReadVfsFileLocked(const char* path) {
   if (!vfs_) {
     return nullptr;
   }
@@ -77,7 +94,7 @@ std::unique_ptr<FileBuffer> VfsManager::ReadVfsFile(const char* path) {
     return nullptr;
   }
 
-  std::unique_ptr<FileBuffer> file_buffer = std::make_unique<FileBuffer>();
+  std::shared_ptr<FileBuffer> file_buffer = std::make_shared<FileBuffer>();
   file_buffer->data.resize(st.st_size);
 
   ssize_t bytes_read = squash_read(vfd, &file_buffer->data[0], st.st_size);
@@ -87,7 +104,7 @@ std::unique_ptr<FileBuffer> VfsManager::ReadVfsFile(const char* path) {
     return nullptr;
   }
 
-  return std::move(file_buffer);
+  return file_buffer;
 }
 
 }  // namespace request_unraver
\ No newline at end of file
@@ -7,6 +7,10 @@ extern "C" {
 #include <squash.h>
 }
 
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace request_unraver {
@@ -23,12 +27,19 @@ class VfsManager {
 
   bool Init(const unsigned char* data, size_t size);
   void Shutdown();
-  std::unique_ptr<FileBuffer> ReadVfsFile(const char* path);
+
+  // 압축 해제된 파일은 캐시되어 모든 Engine (스레드 포함)이 읽기 전용으로 공유한다
+  std::shared_ptr<const FileBuffer> ReadVfsFile(const char* path);
 
   sqfs* vfs() const { return vfs_; }
 
  private:
+  std::shared_ptr<const FileBuffer> ReadVfsFileLocked(const char* path);
+
   sqfs* vfs_;
+  // libsquash 의 fd 테이블은 스레드 안전하지 않으므로 읽기는 직렬화
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const FileBuffer>> file_cache_;
 };
 
 }  // namespace request_unraver
@@ -1,4 +1,7 @@
+#include <malloc.h>
+
 #include <emscripten/emscripten.h>
+#include <emscripten/heap.h>
 
 #include <walink.h>
 #include <msgpack.hpp>
@@ -7,7 +10,11 @@
 #include <jclab_license/license_verifier.h>
 
 #include "engine.h"
+#include "html_extract.h"
 #include "wasm_binding.h"
+#if defined(REQUEST_UNRAVER_THREADS)
+#include "worker_pool.h"
+#endif
 
 #include "static_vfs_data.h"
 
@@ -26,30 +33,43 @@ void mbedtls_entropy_free(mbedtls_entropy_context *ctx);
 
   // 사용자 정의 태그: Engine 인스턴스 식별자
 #define RU_TAG_ENGINE_INSTANCE 0x1000001
-  // 사용자 정의 태그: JS_VALUE 인스턴스 식별자
-#define RU_TAG_JS_VALUE_MASK   0xf000000
-#define RU_TAG_JS_VALUE_BIT    0x2000000
-#define RU_TAG_JS_VALUE_TAG    0x0ffffff
-
-static WL_VALUE js_value_to_wl(JSValue v) {
-  return wl_make(RU_TAG_JS_VALUE_BIT | wl_build_meta((v >> 32) & RU_TAG_JS_VALUE_TAG, false, false, true), v);
-}
+  // 사용자 정의 태그: Engine HandleTable 의 handle (하위 bit 는 HandleKind)
+#define RU_TAG_HANDLE_MASK     0xf000000
+#define RU_TAG_HANDLE_BIT      0x2000000
+#define RU_TAG_HANDLE_KIND     0x0ffffff
 
-static JSValue wl_is_js_value(WL_VALUE v) {
-  return (wl_get_tag(v) & RU_TAG_JS_VALUE_MASK) == RU_TAG_JS_VALUE_BIT;
+static WL_VALUE handle_to_wl(request_unraver::HandleKind kind, uint32_t handle) {
+  return wl_make(RU_TAG_HANDLE_BIT | wl_build_meta(kind & RU_TAG_HANDLE_KIND, false, false, true), handle);
 }
 
-static JSValue js_value_from_wl(WL_VALUE v) {
+static bool handle_from_wl(WL_VALUE v, request_unraver::HandleKind kind, uint32_t* handle) {
   uint32_t meta = wl_get_meta(v);
-  if (!(meta & WL_META_USER_DEFINED) || ((meta & RU_TAG_JS_VALUE_MASK) != RU_TAG_JS_VALUE_BIT)) {
-    throw std::runtime_error("invalid tag");
+  if (!(meta & WL_META_USER_DEFINED) || ((meta & RU_TAG_HANDLE_MASK) != RU_TAG_HANDLE_BIT)) {
+    return false;
   }
-  uint32_t js_tag = wl_get_tag(v) & RU_TAG_JS_VALUE_TAG;
-  if (js_tag & 0x00800000) {
-    js_tag  |= 0xff000000;
+  if ((wl_get_tag(v) & RU_TAG_HANDLE_KIND) != kind) {
+    return false;
+  }
+  *handle = wl_get_payload32(v);
+  return true;
+}
+
+//
+// Helper: WL_VALUE(window handle) 에서 window 객체와 window 전용 context 조회 (borrowed)
+//
+static bool recover_window_from_wl(request_unraver::Engine* eng, WL_VALUE v, JSValue* window_obj, JSContext** window_ctx) {
+  uint32_t handle = 0;
+  if (!eng || !handle_from_wl(v, request_unraver::kHandleWindow, &handle)) {
+    return false;
   }
-  JSValue js_value = (((uint64_t)js_tag) << 32) | wl_get_payload32(v);
-  return js_value;
+  return eng->handle_table()->Lookup(handle, request_unraver::kHandleWindow, window_obj, window_ctx);
+}
+
+static WL_VALUE wl_make_msgpack_uint(uint64_t value) {
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  pk.pack_uint64(value);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
 }
 
   //
@@ -198,6 +218,57 @@ EXPORT WL_VALUE runtime_init(WL_VALUE wl_license) {
   return runtime.Init(license_b64);
 }
 
+//
+// runtime_heap_stats
+//   - 인스턴스 전체 heap 상태 (msgpack map)
+//   - memorySize: WASM linear memory 크기 (줄어들지 않으므로 그대로 high-water mark)
+//   - reserved/used/free: malloc 이 sbrk 한 크기 / 사용 중 / free chunk 합계
+//   - peakUsed: 지금까지 관측된 used 최대값
+//   - allocatorFreeLists: 모든 engine allocator 의 size class 별 free list 크기 [{ size, retained }]
+//   - 호스트 (runtime.ts) 는 이 값으로 인스턴스 교체 시점을 정한다
+//
+EXPORT WL_VALUE runtime_heap_stats() {
+  static size_t peak_used = 0;
+
+  struct mallinfo info = mallinfo();
+  size_t used = (size_t) info.uordblks;
+  if (used > peak_used) {
+    peak_used = used;
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  pk.pack_map(7);
+  pk.pack("memorySize");
+  pk.pack_uint64(emscripten_get_heap_size());
+  pk.pack("reserved");
+  pk.pack_uint64((size_t) info.arena);
+  pk.pack("used");
+  pk.pack_uint64(used);
+  pk.pack("free");
+  pk.pack_uint64((size_t) info.fordblks);
+  // heap top 의 free 크기 (나머지 free 는 중간에 흩어진 chunk)
+  pk.pack("releasable");
+  pk.pack_uint64((size_t) info.keepcost);
+  pk.pack("peakUsed");
+  pk.pack_uint64(peak_used);
+
+  using request_unraver::EngineAllocator;
+  size_t free_lists[EngineAllocator::kNumSizeClasses];
+  EngineAllocator::FreeListTotals(free_lists);
+  pk.pack("allocatorFreeLists");
+  pk.pack_array(EngineAllocator::kNumSizeClasses);
+  for (uint32_t i = 0; i < EngineAllocator::kNumSizeClasses; i++) {
+    pk.pack_map(2);
+    pk.pack("size");
+    pk.pack_uint32(EngineAllocator::SizeClassSize(i));
+    pk.pack("retained");
+    pk.pack_uint64(free_lists[i]);
+  }
+
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
 //
 // engine_new
 //   - Engine 인스턴스 생성 및 초기화 시도
@@ -209,13 +280,17 @@ EXPORT WL_VALUE engine_new(WL_VALUE mode) {
 
   auto* eng = new Engine();
 
+  // 인스턴스 포인터를 반환 (free_flag = false, 생성/소멸은 engine_cleanup으로 관리)
+  WL_VALUE handle = wl_from_address(eng, RU_TAG_ENGINE_INSTANCE, /*free_flag_for_receiver*/ false);
+  // 호스트 I/O 콜백에서 engine 을 식별할 수 있도록 Init 전에 설정
+  eng->set_host_handle(handle);
+
   if (!eng->Init(wl_to_uint32(mode), runtime.GetVfsManager())) {
     delete eng;
     return wl_make_error("engine_new: Init() failed");
   }
 
-  // 인스턴스 포인터를 반환 (free_flag = false, 생성/소멸은 engine_cleanup으로 관리)
-  return wl_from_address(eng, RU_TAG_ENGINE_INSTANCE, /*free_flag_for_receiver*/ false);
+  return handle;
 }
 
 //
@@ -254,6 +329,56 @@ EXPORT WL_VALUE engine_has_pending_jobs(WL_VALUE engine_instance) {
   return wl_from_bool(eng->HasPendingJobs());
 }
 
+//
+// engine_has_pending_io
+//   - 호스트가 아직 완료하지 않은 비동기 I/O 가 있는지 확인
+//
+EXPORT WL_VALUE engine_has_pending_io(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) return wl_from_bool(false);
+  return wl_from_bool(eng->HasPendingIo());
+}
+
+//
+// engine_loop_step
+//   - pending job(완료된 I/O 포함) 및 만료된 타이머 실행
+//   - 성공: bool (즉시 다시 호출할 작업이 남아있으면 true)
+//   - 실패: WL_TAG_ERROR
+//
+EXPORT WL_VALUE engine_loop_step(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_loop_step: invalid engine instance");
+  }
+  int ret = eng->LoopStep();
+  if (ret < 0) {
+    return wl_make_error("engine_loop_step: uncaught exception");
+  }
+  return wl_from_bool(ret > 0);
+}
+
+//
+// engine_complete_io
+//   - io_id: ru_io_submit 으로 전달된 id
+//   - wl_result: msgpack (호스트 결과 객체)
+//   - 완료는 job queue 에 등록되며 다음 engine_loop_step 에서 실행된다
+//
+EXPORT WL_VALUE engine_complete_io(WL_VALUE engine_instance, WL_VALUE io_id, WL_VALUE wl_result) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng || !eng->io_manager()) {
+    return wl_make_error("engine_complete_io: invalid engine instance");
+  }
+
+  request_unraver::TraceScope trace(eng->tracer(), "io", "completeIo");
+  std::string result = wl_result ? wl_to_msgpack(wl_result, true) : "";
+  bool ok = eng->io_manager()->Complete(
+    wl_to_uint32(io_id),
+    (const uint8_t*)result.data(),
+    result.length()
+  );
+  return wl_from_bool(ok);
+}
+
 WL_VALUE js_value_to_msgp_wl(JSContext* ctx, JSValue v) {
   JSValue global_obj = JS_GetGlobalObject(ctx);
   JSValue sys_obj = JS_GetPropertyStr(ctx, global_obj, "__sys");
@@ -312,39 +437,403 @@ EXPORT WL_VALUE engine_js_eval(WL_VALUE engine_instance, WL_VALUE string_code) {
   return js_value_to_msgp_wl(ctx, result);
 }
 
+//
+// window 를 handle table 에 등록하고 handle 반환
+//   - window context 도 handle 이 소유하며 engine_destroy_window 에서 함께 해제
+//
+static WL_VALUE register_window(request_unraver::Engine* eng, JSValue js_window, JSContext* window_ctx) {
+  if (JS_IsException(js_window)) {
+    JSContext* ctx = eng->context();
+    JSValue exception = JS_GetException(ctx);
+    std::string error_msg = eng->js_error_to_string(ctx, exception);
+    JS_FreeValue(ctx, exception);
+    return wl_make_error(error_msg);
+  }
+  uint32_t handle = eng->handle_table()->Insert(request_unraver::kHandleWindow, window_ctx, js_window, true);
+  if (!handle) {
+    return wl_make_error("create_window: handle table full");
+  }
+  WL_VALUE wl_window = handle_to_wl(request_unraver::kHandleWindow, handle);
+  // 이후 이 window 가 보내는 호스트 I/O 는 이 값으로 구분된다
+  request_unraver::Engine::SetHostWindow(window_ctx, wl_window);
+  return wl_window;
+}
+
 EXPORT WL_VALUE engine_create_window(WL_VALUE engine_instance, WL_VALUE wl_content, WL_VALUE wl_windows_options) {
   request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_create_window: invalid engine instance");
+  }
+  request_unraver::GcDeferScope defer_gc(eng);
 
   std::string content = wl_content ? wl_to_string(wl_content, true) : "";
   std::string windows_options = wl_windows_options ? wl_to_msgpack(wl_windows_options, true) : "";
 
+  JSContext* window_ctx = nullptr;
   JSValue js_window = eng->CreateWindow(
     content.empty() ? nullptr : content.c_str(),
+    content.length(),
     windows_options.empty() ? nullptr : (const uint8_t*)windows_options.c_str(),
-    windows_options.length()
+    windows_options.length(),
+    &window_ctx
   );
-  return js_value_to_wl(js_window);
+  return register_window(eng, js_window, window_ctx);
 }
 
+//
+// engine_destroy_window
+//   - 유효하지 않거나 이미 해제된 handle 이면 false
+//
 EXPORT WL_VALUE engine_destroy_window(WL_VALUE engine_instance, WL_VALUE wl_window) {
   request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
-  JSValue window_obj = js_value_from_wl(wl_window);
+  uint32_t handle = 0;
+  if (!eng || !handle_from_wl(wl_window, request_unraver::kHandleWindow, &handle)) {
+    return wl_from_bool(false);
+  }
+
+  return wl_from_bool(eng->DestroyWindow(handle));
+}
+
+//
+// engine_gc
+//   - 호스트 GC (요청 사이 idle 시점에 부르도록). mode: 0 전체, 1 budget (engine.h GcMode)
+//   - 성공: msgpack { collected, pauseMs, freedBytes, liveBytes }
+//
+EXPORT WL_VALUE engine_gc(WL_VALUE engine_instance, WL_VALUE wl_mode) {
+  using namespace request_unraver;
+
+  Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_gc: invalid engine instance");
+  }
+  uint32_t mode = wl_to_uint32(wl_mode);
+  if (mode != kGcFull && mode != kGcBudget) {
+    return wl_make_error("engine_gc: invalid mode");
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  eng->CollectGarbage(static_cast<GcMode>(mode), &pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_gc_headroom
+//   - eval / window 생성 동안 live + headroom bytes 까지 자동 GC 를 미룬다 (0: 끔)
+//   - 이전 값 반환
+//
+EXPORT WL_VALUE engine_gc_headroom(WL_VALUE engine_instance, WL_VALUE headroom) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_gc_headroom: invalid engine instance");
+  }
+  size_t prev = eng->gc_headroom();
+  eng->set_gc_headroom(wl_to_uint32(headroom));
+  return wl_make_msgpack_uint(prev);
+}
+
+//
+// engine_window_memory
+//   - window 가 가진 JS heap (window_memory.h)
+//   - 성공: msgpack { contextBytes, chargedBytes, heldBytes, peakBytes, calls }
+//
+EXPORT WL_VALUE engine_window_memory(WL_VALUE engine_instance, WL_VALUE window) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_window_memory: invalid engine instance");
+  }
+
+  JSValue window_obj;
+  JSContext* ctx = nullptr;
+  if (!recover_window_from_wl(eng, window, &window_obj, &ctx)) {
+    return wl_make_error("engine_window_memory: invalid window handle");
+  }
+  const request_unraver::WindowMemory* memory = request_unraver::Engine::ContextMemory(ctx);
+  if (!memory) {
+    return wl_make_error("engine_window_memory: no context state");
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  memory->Pack(&pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_leak_report
+//   - GC 를 돌린 뒤 engine heap 과 engine_destroy_window 로 해제된 window 의 상태
+//   - 성공: msgpack { heap: { mallocSize, ... }, windows: [{ handle, heldBytes, freedBytes, retained, globals }] }
+//   - retained: 해제 후에도 window global 이 도달 가능. globals 는 page 가 추가한 객체 값 property
+//   - 회수된 window 는 한 번만 보고된다
+//
+EXPORT WL_VALUE engine_leak_report(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_leak_report: invalid engine instance");
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  eng->LeakReport(&pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_release_all_windows
+//   - engine 이 보유한 모든 window 해제
+//   - 성공: msgpack (해제된 window 수)
+//
+EXPORT WL_VALUE engine_release_all_windows(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_release_all_windows: invalid engine instance");
+  }
+  return wl_make_msgpack_uint(eng->ReleaseAllWindows());
+}
+
+//
+// engine_stats
+//   - 모니터링용 engine 상태 (msgpack map)
+//
+EXPORT WL_VALUE engine_stats(WL_VALUE engine_instance) {
+  using namespace request_unraver;
+
+  Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_stats: invalid engine instance");
+  }
+
+  HandleTable* handles = eng->handle_table();
+  const EngineAllocator::Stats& alloc = eng->allocator()->stats();
+  const GcStats& gc = eng->gc_stats();
+  const ContextStats& contexts = eng->context_stats();
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  pk.pack_map(4);
+  pk.pack("handles");
+  pk.pack_map(2);
+  pk.pack("live");
+  pk.pack_uint64(handles->live_count());
+  pk.pack("windows");
+  pk.pack_uint64(handles->live_count(kHandleWindow));
+  pk.pack("allocator");
+  pk.pack_map(11);
+  pk.pack("arenaChunks");
+  pk.pack_uint64(alloc.arena_chunks);
+  pk.pack("arenaChunksReleased");
+  pk.pack_uint64(alloc.arena_chunks_released);
+  pk.pack("arenaReserved");
+  pk.pack_uint64(alloc.arena_reserved);
+  pk.pack("arenaUsed");
+  pk.pack_uint64(alloc.arena_used);
+  pk.pack("smallCount");
+  pk.pack_uint64(alloc.small_count);
+  pk.pack("smallBytes");
+  pk.pack_uint64(alloc.small_bytes);
+  pk.pack("largeCount");
+  pk.pack_uint64(alloc.large_count);
+  pk.pack("largeBytes");
+  pk.pack_uint64(alloc.large_bytes);
+  pk.pack("peakBytes");
+  pk.pack_uint64(alloc.peak_bytes);
+  pk.pack("allocCalls");
+  pk.pack_uint64(alloc.alloc_calls);
+  pk.pack("freeCalls");
+  pk.pack_uint64(alloc.free_calls);
+  pk.pack("gc");
+  pk.pack_map(9);
+  pk.pack("collections");
+  pk.pack_uint64(gc.collections);
+  pk.pack("skipped");
+  pk.pack_uint64(gc.skipped);
+  pk.pack("deferredRequests");
+  pk.pack_uint64(gc.deferred_requests);
+  pk.pack("freedBytes");
+  pk.pack_uint64(gc.freed_bytes);
+  pk.pack("totalPauseMs");
+  pk.pack_double(gc.total_pause_ms);
+  pk.pack("maxPauseMs");
+  pk.pack_double(gc.max_pause_ms);
+  pk.pack("lastPauseMs");
+  pk.pack_double(gc.last_pause_ms);
+  pk.pack("headroom");
+  pk.pack_uint64(eng->gc_headroom());
+  pk.pack("threshold");
+  pk.pack_uint64(JS_GetGCThreshold(eng->runtime()));
+  pk.pack("contexts");
+  pk.pack_map(4);
+  pk.pack("created");
+  pk.pack_uint64(contexts.created);
+  pk.pack("totalInitMs");
+  pk.pack_double(contexts.total_init_ms);
+  pk.pack("maxInitMs");
+  pk.pack_double(contexts.max_init_ms);
+  pk.pack("totalBytes");
+  pk.pack_uint64(contexts.total_bytes);
+
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_coverage_dump
+//   - instrument 빌드에서 실행된 함수 id 목록 (msgpack array)
+//   - node/pseudo-browser/coverage.mjs 의 manifest 로 함수 key 로 변환
+//
+EXPORT WL_VALUE engine_coverage_dump(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_coverage_dump: invalid engine instance");
+  }
+
+  std::vector<uint32_t> hits = eng->CoverageHits();
 
-  JS_FreeValue(eng->context(), window_obj);
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  pk.pack_array((uint32_t)hits.size());
+  for (uint32_t id : hits) {
+    pk.pack_uint32(id);
+  }
 
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_take_uncacheable
+//   - 마지막 호출 이후 browserEval 스크립트 (batch 포함) 가 실행 중에 시계/난수/호스트 I/O 를
+//     썼거나 __sys.markUncacheable() 이 불렸으면 true. 호출하면 초기화된다
+//
+EXPORT WL_VALUE engine_take_uncacheable(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) return wl_from_bool(true);
+  return wl_from_bool(eng->TakeUncacheable());
+}
+
+//
+// engine_trace_enable
+//   - span 기록 on/off (tracer.h). 이전 상태 반환
+//
+EXPORT WL_VALUE engine_trace_enable(WL_VALUE engine_instance, WL_VALUE enabled) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_trace_enable: invalid engine instance");
+  }
+  bool prev = eng->tracer()->enabled();
+  eng->tracer()->set_enabled(wl_to_uint32(enabled) != 0);
+  return wl_from_bool(prev);
+}
+
+//
+// engine_trace_set_request
+//   - 이후 기록되는 span 의 request id (trace-event tid)
+//
+EXPORT WL_VALUE engine_trace_set_request(WL_VALUE engine_instance, WL_VALUE request_id) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_trace_set_request: invalid engine instance");
+  }
+  eng->tracer()->set_request_id(wl_to_uint32(request_id));
   return wl_from_bool(true);
 }
 
-EXPORT WL_VALUE engine_use_jquery(WL_VALUE engine_instance, WL_VALUE window) {
-  JSValue window_obj = js_value_from_wl(window);
+//
+// engine_trace_drain
+//   - 쌓인 span 을 msgpack { dropped, events: [{ cat, name, ts, dur, tid }] } 로 반환하고 비움
+//
+EXPORT WL_VALUE engine_trace_drain(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_trace_drain: invalid engine instance");
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  eng->tracer()->Drain(&pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_profile_start
+//   - guest JS sampling profiler 시작 (profiler.h). interval 은 microseconds (0 이면 1ms)
+//   - 이전 결과는 버린다
+//
+EXPORT WL_VALUE engine_profile_start(WL_VALUE engine_instance, WL_VALUE interval_us) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_profile_start: invalid engine instance");
+  }
+  uint32_t us = wl_to_uint32(interval_us);
+  eng->StartProfile(us == 0 ? 1.0 : us / 1000.0);
+  return wl_from_bool(true);
+}
+
+//
+// engine_profile_stop
+//   - profiler 를 멈추고 msgpack { samples, intervalMs, durationMs, stacks } 반환
+//   - stacks: flamegraph.pl / speedscope 가 읽는 collapsed 형식 ("root;...;leaf count" 줄들)
+//
+EXPORT WL_VALUE engine_profile_stop(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_profile_stop: invalid engine instance");
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  eng->StopProfile(&pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_set_log_level
+//   - console 출력을 LogBuffer 에 쌓을 최소 level (0: debug, 1: info, 2: warn, 3: error, 4: off)
+//   - 이전 level 반환
+//
+EXPORT WL_VALUE engine_set_log_level(WL_VALUE engine_instance, WL_VALUE wl_level) {
+  using namespace request_unraver;
 
+  Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_set_log_level: invalid engine instance");
+  }
+  uint32_t level = wl_to_uint32(wl_level);
+  LogLevel prev = eng->log_buffer()->min_level();
+  eng->log_buffer()->set_min_level(static_cast<LogLevel>(level < kLogOff ? level : kLogOff));
+  return wl_make_msgpack_uint(prev);
+}
+
+//
+// engine_drain_logs
+//   - 쌓인 console 출력을 msgpack { dropped, lines: [{ level, text }] } 로 반환하고 비움
+//
+EXPORT WL_VALUE engine_drain_logs(WL_VALUE engine_instance) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_drain_logs: invalid engine instance");
+  }
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  eng->log_buffer()->Drain(&pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+EXPORT WL_VALUE engine_use_jquery(WL_VALUE engine_instance, WL_VALUE window) {
   request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
   if (!eng) {
     return wl_make_error("engine_js_eval: invalid engine instance");
   }
 
-  JSContext *ctx = eng->context();
+  JSValue window_obj;
+  JSContext* ctx = nullptr;
+  if (!recover_window_from_wl(eng, window, &window_obj, &ctx)) {
+    return wl_make_error("engine_use_jquery: invalid window handle");
+  }
+  request_unraver::ContextMemoryScope charge(eng, ctx);
+  request_unraver::RunningContextScope running(eng, ctx);
+  request_unraver::GcDeferScope defer_gc(eng);
 
+  request_unraver::TraceScope trace(eng->tracer(), "engine", "useJquery");
   std::string script_template = "(function (window) {\n";
   script_template += "return __sys.useJQuery(window);\n";
   script_template += "\n})";
@@ -360,7 +849,9 @@ EXPORT WL_VALUE engine_use_jquery(WL_VALUE engine_instance, WL_VALUE window) {
   }
 
   if (JS_IsException(r)) {
-    std::string error_msg = eng->js_error_to_string(ctx, r);
+    JSValue exception = JS_GetException(ctx);
+    std::string error_msg = eng->js_error_to_string(ctx, exception);
+    JS_FreeValue(ctx, exception);
     return wl_make_error(error_msg);
   }
 
@@ -369,49 +860,82 @@ EXPORT WL_VALUE engine_use_jquery(WL_VALUE engine_instance, WL_VALUE window) {
   return 0;
 }
 
-EXPORT WL_VALUE engine_browser_eval(WL_VALUE engine_instance, WL_VALUE window, WL_VALUE string_code, WL_VALUE wl_params) {
-  JSValue window_obj = js_value_from_wl(window);
-  std::string code = wl_to_string(string_code, true);
-  std::string params = wl_params ? wl_to_msgpack(wl_params, true) : "";
-
-  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
-  if (!eng) {
-    return wl_make_error("engine_js_eval: invalid engine instance");
-  }
+//
+// browser_eval 용 wrapper 스크립트: (global, window, params) 를 받는 함수
+//
+static std::string browser_script_prefix() {
+  return "(function (global, window, params) {"
+         "const document = window.document; const jQuery = window.jQuery; const $ = window.$;";
+}
 
-  JSContext *ctx = eng->context();
+static const char kBrowserScriptSuffix[] = "\n})";
 
-  JSValue global_obj = JS_GetGlobalObject(ctx);
-  std::string script_template = "(function (global, window, _raw_params) {";
-  script_template += "const document = window.document; const jQuery = window.jQuery; const $ = window.$;";
-  script_template += "const params = _raw_params ? __sys.munpack(_raw_params) : null;";
+static std::string build_browser_script(const std::string& code) {
+  std::string script_template = browser_script_prefix();
+  script_template.reserve(script_template.length() + code.length() + sizeof(kBrowserScriptSuffix));
   script_template += code;
-  script_template += "\n})";
+  script_template += kBrowserScriptSuffix;
+  return script_template;
+}
 
-  JSValue js_params_raw = params.empty() ? JS_NULL : JS_NewUint8ArrayCopy(ctx, (const uint8_t*) params.c_str(), params.length());
+// msgpack 바이트를 __sys.munpack 으로 해석 (실패시 JS_EXCEPTION)
+//   - 스크립트 밖에서 해석해서 msgpack 의 시계/난수 사용이 결과 캐시 판정에 섞이지 않게 한다
+static JSValue unpack_browser_params(JSContext* ctx, JSValueConst global_obj, const std::string& data) {
+  JSValue sys_obj = JS_GetPropertyStr(ctx, global_obj, "__sys");
+  JSValue munpack_func = JS_GetPropertyStr(ctx, sys_obj, "munpack");
+  JSValue raw = JS_NewUint8ArrayCopy(ctx, (const uint8_t*) data.c_str(), data.length());
+  JSValue value = JS_Call(ctx, munpack_func, JS_UNDEFINED, 1, &raw);
+  JS_FreeValue(ctx, raw);
+  JS_FreeValue(ctx, munpack_func);
+  JS_FreeValue(ctx, sys_obj);
+  return value;
+}
 
-  JSValue r = JS_Eval(ctx, script_template.c_str(), script_template.length(), "<browser_eval>", JS_EVAL_TYPE_GLOBAL);
+//
+// wrapper 스크립트(script, script_len: null-terminated)를 컴파일하여 window 에서 실행
+//
+static WL_VALUE run_browser_script(request_unraver::Engine* eng, JSContext* ctx, JSValue window_obj,
+                                   const char* script, size_t script_len, const std::string& params) {
+  JSValue global_obj = JS_GetGlobalObject(ctx);
+
+  request_unraver::Tracer* tracer = eng->tracer();
+  JSValue r;
+  {
+    request_unraver::TraceScope trace(tracer, "eval", "compile");
+    r = JS_Eval(ctx, script, script_len, "<browser_eval>", JS_EVAL_TYPE_GLOBAL);
+  }
+  JSValue js_params = JS_NULL;
+  if (!JS_IsException(r) && !params.empty()) {
+    js_params = unpack_browser_params(ctx, global_obj, params);
+    if (JS_IsException(js_params)) {
+      JS_FreeValue(ctx, r);
+      r = JS_EXCEPTION;
+      js_params = JS_NULL;
+    }
+  }
   if (!JS_IsException(r)) {
     JSValueConst args[3] = {
       global_obj,
       window_obj,
-      js_params_raw,
+      js_params,
     };
+    request_unraver::TraceScope trace(tracer, "eval", "script");
+    request_unraver::EvalScriptScope script_scope(eng);
     JSValue ret = JS_Call(ctx, r, window_obj, 3, args);
     JS_FreeValue(ctx, r);
     r = ret;
   }
+  JS_FreeValue(ctx, js_params);
   JS_FreeValue(ctx, global_obj);
 
-  if (js_params_raw != JS_NULL) {
-    JS_FreeValue(ctx, js_params_raw);
-  }
-
   WL_VALUE wl_return;
   if (JS_IsException(r)) {
-    std::string error_msg = eng->js_error_to_string(ctx, r);
+    JSValue exception = JS_GetException(ctx);
+    std::string error_msg = eng->js_error_to_string(ctx, exception);
+    JS_FreeValue(ctx, exception);
     wl_return = wl_make_error(error_msg);
   } else {
+    request_unraver::TraceScope trace(tracer, "eval", "serialize");
     wl_return = js_value_to_msgp_wl(ctx, r);
   }
 
@@ -420,4 +944,604 @@ EXPORT WL_VALUE engine_browser_eval(WL_VALUE engine_instance, WL_VALUE window, W
   return wl_return;
 }
 
+EXPORT WL_VALUE engine_browser_eval(WL_VALUE engine_instance, WL_VALUE window, WL_VALUE string_code, WL_VALUE wl_params) {
+  std::string code = wl_to_string(string_code, true);
+  std::string params = wl_params ? wl_to_msgpack(wl_params, true) : "";
+
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_js_eval: invalid engine instance");
+  }
+
+  JSValue window_obj;
+  JSContext* ctx = nullptr;
+  if (!recover_window_from_wl(eng, window, &window_obj, &ctx)) {
+    return wl_make_error("engine_browser_eval: invalid window handle");
+  }
+  request_unraver::ContextMemoryScope charge(eng, ctx);
+  request_unraver::RunningContextScope running(eng, ctx);
+  request_unraver::GcDeferScope defer_gc(eng);
+
+  std::string script_template = build_browser_script(code);
+  return run_browser_script(eng, ctx, window_obj, script_template.c_str(), script_template.length(), params);
+}
+
+//
+// engine_arena_reserve
+//   - 호스트가 UTF-8 payload 를 직접 쓸 linear memory 위치 반환 (실패시 0)
+//   - 다음 *_arena 호출까지 유효 (메모리 증가시 호스트는 view 를 갱신해야 함)
+//
+EXPORT uint32_t engine_arena_reserve(WL_VALUE engine_instance, uint32_t payload_len) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return 0;
+  }
+  return (uint32_t) reinterpret_cast<uintptr_t>(eng->transfer_arena()->Reserve(payload_len));
+}
+
+//
+// engine_browser_eval_arena
+//   - engine_browser_eval 과 같지만 코드는 arena 에 쓰여진 code_len 바이트
+//   - wrapper 를 arena 의 여유 공간에 붙여 복사 없이 파싱
+//
+EXPORT WL_VALUE engine_browser_eval_arena(WL_VALUE engine_instance, WL_VALUE window, WL_VALUE code_len, WL_VALUE wl_params) {
+  std::string params = wl_params ? wl_to_msgpack(wl_params, true) : "";
+
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_browser_eval_arena: invalid engine instance");
+  }
+
+  JSValue window_obj;
+  JSContext* ctx = nullptr;
+  if (!recover_window_from_wl(eng, window, &window_obj, &ctx)) {
+    return wl_make_error("engine_browser_eval_arena: invalid window handle");
+  }
+  request_unraver::ContextMemoryScope charge(eng, ctx);
+  request_unraver::RunningContextScope running(eng, ctx);
+  request_unraver::GcDeferScope defer_gc(eng);
+
+  request_unraver::TransferArena* arena = eng->transfer_arena();
+  size_t script_len = 0;
+  const char* script = arena->Wrap(wl_to_uint32(code_len), browser_script_prefix(), kBrowserScriptSuffix, &script_len);
+  if (!script) {
+    return wl_make_error("engine_browser_eval_arena: invalid arena payload");
+  }
+
+  WL_VALUE wl_return = run_browser_script(eng, ctx, window_obj, script, script_len, params);
+  arena->Trim();
+  return wl_return;
+}
+
+//
+// engine_create_window_arena
+//   - engine_create_window 과 같지만 content 는 arena 에 쓰여진 content_len 바이트
+//
+EXPORT WL_VALUE engine_create_window_arena(WL_VALUE engine_instance, WL_VALUE content_len, WL_VALUE wl_windows_options) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_create_window_arena: invalid engine instance");
+  }
+  request_unraver::GcDeferScope defer_gc(eng);
+
+  std::string windows_options = wl_windows_options ? wl_to_msgpack(wl_windows_options, true) : "";
+  request_unraver::TransferArena* arena = eng->transfer_arena();
+  std::string_view content = arena->Payload(wl_to_uint32(content_len));
+
+  JSContext* window_ctx = nullptr;
+  JSValue js_window = eng->CreateWindow(
+    content.empty() ? nullptr : content.data(),
+    content.length(),
+    windows_options.empty() ? nullptr : (const uint8_t*)windows_options.c_str(),
+    windows_options.length(),
+    &window_ctx
+  );
+  arena->Trim();
+  return register_window(eng, js_window, window_ctx);
+}
+
+//
+// engine_window_begin
+//   - content 를 조각으로 넘기는 window 생성 시작. 반환값은 stream id (msgpack uint)
+//   - size_hint: 예상 content 크기 (모르면 0)
+//   - 이후 engine_window_write 로 조각을, engine_window_end 로 window handle 을 받는다
+//
+EXPORT WL_VALUE engine_window_begin(WL_VALUE engine_instance, WL_VALUE wl_windows_options, WL_VALUE size_hint) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_window_begin: invalid engine instance");
+  }
+
+  std::string windows_options = wl_windows_options ? wl_to_msgpack(wl_windows_options, true) : "";
+  uint32_t stream_id = eng->BeginWindow(
+    windows_options.empty() ? nullptr : (const uint8_t*)windows_options.c_str(),
+    windows_options.length(),
+    wl_to_uint32(size_hint)
+  );
+  if (!stream_id) {
+    JSContext* ctx = eng->context();
+    JSValue exception = JS_GetException(ctx);
+    std::string error_msg = eng->js_error_to_string(ctx, exception);
+    JS_FreeValue(ctx, exception);
+    return wl_make_error(error_msg);
+  }
+  return wl_make_msgpack_uint(stream_id);
+}
+
+//
+// engine_window_write
+//   - arena 에 쓰여진 chunk_len 바이트를 이어서 넘김 (engine_arena_reserve)
+//   - native DOM window 는 여기서 바로 파싱된다
+//
+EXPORT WL_VALUE engine_window_write(WL_VALUE engine_instance, WL_VALUE stream_id, WL_VALUE chunk_len) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_window_write: invalid engine instance");
+  }
+
+  std::string_view chunk = eng->transfer_arena()->Payload(wl_to_uint32(chunk_len));
+  if (!eng->WriteWindow(wl_to_uint32(stream_id), chunk.data(), chunk.size())) {
+    return wl_make_error("engine_window_write: invalid window stream");
+  }
+  return wl_from_bool(true);
+}
+
+//
+// engine_window_end
+//   - 남은 입력을 마무리하고 window 생성. 반환값은 engine_create_window 과 같다
+//
+EXPORT WL_VALUE engine_window_end(WL_VALUE engine_instance, WL_VALUE stream_id) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_window_end: invalid engine instance");
+  }
+  request_unraver::GcDeferScope defer_gc(eng);
+
+  JSContext* window_ctx = nullptr;
+  JSValue js_window = eng->EndWindow(wl_to_uint32(stream_id), &window_ctx);
+  eng->transfer_arena()->Trim();
+  return register_window(eng, js_window, window_ctx);
+}
+
+//
+// engine_window_abort
+//   - 끝내지 않은 stream 정리 (upstream 실패 등). 없는 stream 이면 false
+//
+EXPORT WL_VALUE engine_window_abort(WL_VALUE engine_instance, WL_VALUE stream_id) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_from_bool(false);
+  }
+  bool aborted = eng->AbortWindow(wl_to_uint32(stream_id));
+  eng->transfer_arena()->Trim();
+  return wl_from_bool(aborted);
+}
+
+//
+// engine_extract_document
+//   - content: arena 에 쓰여진 content_len 바이트 (engine_arena_reserve)
+//   - wl_options: msgpack { title, scripts, forms, meta: bool, attributes: ["a[href]", ...] }
+//   - window/DOM 없이 inline script, form field, meta 등을 msgpack map 으로 반환
+//     (형식은 html_extract.h 참고)
+//
+EXPORT WL_VALUE engine_extract_document(WL_VALUE engine_instance, WL_VALUE content_len, WL_VALUE wl_options) {
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_extract_document: invalid engine instance");
+  }
+
+  request_unraver::HtmlExtractOptions options;
+  if (wl_options) {
+    std::string options_msgp = wl_to_msgpack(wl_options, true);
+    if (!options.FromMsgpack(options_msgp.data(), options_msgp.size())) {
+      return wl_make_error("engine_extract_document: invalid options");
+    }
+  }
+
+  request_unraver::TransferArena* arena = eng->transfer_arena();
+  std::string_view content = arena->Payload(wl_to_uint32(content_len));
+
+  request_unraver::TraceScope trace(eng->tracer(), "engine", "extractDocument");
+  request_unraver::HtmlExtractor extractor(options);
+  extractor.Feed(content.data(), content.size());
+  extractor.Finish();
+  arena->Trim();
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  extractor.Pack(&pk);
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// engine_browser_eval_batch
+//   - 같은 스크립트를 여러 params 로 실행 (한번의 호출, 한번의 컴파일)
+//   - code_len: arena 에 쓰여진 코드 바이트 (engine_browser_eval_arena 와 같음)
+//   - wl_params_list: msgpack array (항목별 params)
+//   - 성공: msgpack array, 항목별 { value } 또는 { error }
+//   - 실패: WL_TAG_ERROR (스크립트 컴파일 실패, params 가 array 가 아님 등 전체 실패)
+//
+EXPORT WL_VALUE engine_browser_eval_batch(WL_VALUE engine_instance, WL_VALUE window, WL_VALUE code_len, WL_VALUE wl_params_list) {
+  std::string params_list = wl_params_list ? wl_to_msgpack(wl_params_list, true) : "";
+
+  request_unraver::Engine* eng = recover_engine_from_wl(engine_instance);
+  if (!eng) {
+    return wl_make_error("engine_browser_eval_batch: invalid engine instance");
+  }
+
+  JSValue window_obj;
+  JSContext* ctx = nullptr;
+  if (!recover_window_from_wl(eng, window, &window_obj, &ctx)) {
+    return wl_make_error("engine_browser_eval_batch: invalid window handle");
+  }
+  request_unraver::ContextMemoryScope charge(eng, ctx);
+  request_unraver::RunningContextScope running(eng, ctx);
+  request_unraver::GcDeferScope defer_gc(eng);
+
+  request_unraver::TransferArena* arena = eng->transfer_arena();
+  size_t script_len = 0;
+  const char* script = arena->Wrap(wl_to_uint32(code_len), browser_script_prefix(), kBrowserScriptSuffix, &script_len);
+  if (!script) {
+    return wl_make_error("engine_browser_eval_batch: invalid arena payload");
+  }
+
+  request_unraver::Tracer* tracer = eng->tracer();
+  JSValue func;
+  {
+    request_unraver::TraceScope trace(tracer, "eval", "compile");
+    func = JS_Eval(ctx, script, script_len, "<browser_eval>", JS_EVAL_TYPE_GLOBAL);
+  }
+  arena->Trim();
+  if (JS_IsException(func)) {
+    JSValue exception = JS_GetException(ctx);
+    std::string error_msg = eng->js_error_to_string(ctx, exception);
+    JS_FreeValue(ctx, exception);
+    return wl_make_error(error_msg);
+  }
+
+  JSValue global_obj = JS_GetGlobalObject(ctx);
+
+  // 입력 버퍼 하나를 한번에 해석
+  JSValue list = params_list.empty() ? JS_UNDEFINED : unpack_browser_params(ctx, global_obj, params_list);
+
+  WL_VALUE wl_return;
+  int64_t count = 0;
+  if (JS_IsException(list)) {
+    JSValue exception = JS_GetException(ctx);
+    wl_return = wl_make_error(eng->js_error_to_string(ctx, exception));
+    JS_FreeValue(ctx, exception);
+  } else if (!JS_IsArray(list) || JS_GetLength(ctx, list, &count) < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    wl_return = wl_make_error("engine_browser_eval_batch: params must be an array");
+  } else {
+    JSValue results = JS_NewArray(ctx);
+    for (int64_t i = 0; i < count; i++) {
+      JSValue item_params = JS_GetPropertyInt64(ctx, list, i);
+      JSValueConst args[3] = {
+        global_obj,
+        window_obj,
+        item_params,
+      };
+      JSValue r;
+      {
+        request_unraver::TraceScope trace(tracer, "eval", "script");
+        request_unraver::EvalScriptScope script_scope(eng);
+        r = JS_Call(ctx, func, window_obj, 3, args);
+      }
+      JS_FreeValue(ctx, item_params);
+
+      JSValue item = JS_NewObject(ctx);
+      if (JS_IsException(r)) {
+        // 항목별 오류는 배치 전체를 중단하지 않는다
+        JSValue exception = JS_GetException(ctx);
+        std::string error_msg = eng->js_error_to_string(ctx, exception);
+        JS_FreeValue(ctx, exception);
+        JS_SetPropertyStr(ctx, item, "error", JS_NewStringLen(ctx, error_msg.c_str(), error_msg.length()));
+      } else {
+        JS_SetPropertyStr(ctx, item, "value", r);
+      }
+      JS_SetPropertyInt64(ctx, results, i, item);
+    }
+
+    // 출력 버퍼 하나로 직렬화
+    request_unraver::TraceScope trace(tracer, "eval", "serialize");
+    wl_return = js_value_to_msgp_wl(ctx, results);
+    JS_FreeValue(ctx, results);
+  }
+
+  JS_FreeValue(ctx, list);
+  JS_FreeValue(ctx, global_obj);
+  JS_FreeValue(ctx, func);
+
+  return wl_return;
+}
+
+#if defined(REQUEST_UNRAVER_THREADS)
+
+  // 사용자 정의 태그: WorkerPool 인스턴스 식별자
+#define RU_TAG_POOL_INSTANCE 0x1000002
+
+// worker 당 최대 처리 중 작업 수
+static const size_t kPoolJobsPerThread = 64;
+// 작업 후 처리할 최대 microtask/0ms 타이머 단계
+static const int kPoolMaxLoopSteps = 1024;
+
+static request_unraver::WorkerPool* recover_pool_from_wl(WL_VALUE v) {
+  if (!wl_is_address(v)) return nullptr;
+  if (wl_get_tag(v) != RU_TAG_POOL_INSTANCE) return nullptr;
+  return reinterpret_cast<request_unraver::WorkerPool*>(wl_get_payload32(v));
+}
+
+//
+// pool 작업: window 생성 -> (jquery) -> 스크립트 실행 -> window 정리
+//   - job (msgpack): { content?, options?, jquery?, script, params? }
+//   - window 는 engine_create_window 와 같이 전용 context 에 만들고 DestroyWindow 로 해제한다
+//
+
+// engine context 에서 [content, options(msgpack)] 추출
+static const char kPoolJobWindowArgs[] =
+  "(function (_raw_job) {\n"
+  "const job = __sys.munpack(_raw_job);\n"
+  "return [String(job.content || ''), job.options ? __sys.mpack(job.options) : null];\n"
+  "})";
+
+// window context 에서 실행
+//   - script 가 thenable 을 반환하면 settle 된 값을 mpack 한 Promise 를 반환 (pool_run_job 이 loop 를 돌려 꺼낸다)
+static const char kPoolJobRunner[] =
+  "(function (global, window, _raw_job, _script_prefix) {\n"
+  "const job = __sys.munpack(_raw_job);\n"
+  "const close = () => { if (typeof window.close === 'function') { window.close(); } };\n"
+  "let result;\n"
+  "try {\n"
+  "  if (job.jquery) { __sys.useJQuery(window); }\n"
+  "  const fn = (0, eval)(_script_prefix + job.script + '\\n})');\n"
+  "  result = fn.call(window, global, window, job.params ?? null);\n"
+  "} catch (e) {\n"
+  "  close();\n"
+  "  throw e;\n"
+  "}\n"
+  "if (result !== null && typeof result === 'object' && typeof result.then === 'function') {\n"
+  "  return Promise.resolve(result).then((value) => __sys.mpack(value)).finally(close);\n"
+  "}\n"
+  "close();\n"
+  "return __sys.mpack(result);\n"
+  "})";
+
+// code 를 ctx 에서 함수로 컴파일해서 args 로 호출 (args 는 해제된다)
+static JSValue pool_call(JSContext* ctx, const char* code, size_t code_len, const char* filename,
+                         int argc, JSValue* args) {
+  JSValue func = JS_Eval(ctx, code, code_len, filename, JS_EVAL_TYPE_GLOBAL);
+  JSValue r = func;
+  if (!JS_IsException(func)) {
+    r = JS_Call(ctx, func, JS_UNDEFINED, argc, args);
+    JS_FreeValue(ctx, func);
+  }
+  for (int i = 0; i < argc; i++) {
+    JS_FreeValue(ctx, args[i]);
+  }
+  return r;
+}
+
+// ctx 의 pending exception 을 *out 에 쓰고 false 반환
+static bool pool_job_error(request_unraver::Engine* eng, JSContext* ctx, std::string* out) {
+  JSValue exception = JS_GetException(ctx);
+  *out = eng->js_error_to_string(ctx, exception);
+  JS_FreeValue(ctx, exception);
+  return false;
+}
+
+static bool pool_run_job(request_unraver::Engine* eng, const std::string& payload, std::string* out) {
+  request_unraver::GcDeferScope defer_gc(eng);
+  JSContext* engine_ctx = eng->context();
+  static const std::string script_prefix = browser_script_prefix();
+
+  JSValue window_args_in[1] = {
+    JS_NewUint8ArrayCopy(engine_ctx, (const uint8_t*)payload.data(), payload.length()),
+  };
+  JSValue window_args = pool_call(engine_ctx, kPoolJobWindowArgs, sizeof(kPoolJobWindowArgs) - 1,
+                                  "<pool_job>", 1, window_args_in);
+  if (JS_IsException(window_args)) {
+    return pool_job_error(eng, engine_ctx, out);
+  }
+  JSValue content_val = JS_GetPropertyUint32(engine_ctx, window_args, 0);
+  JSValue options_val = JS_GetPropertyUint32(engine_ctx, window_args, 1);
+  JS_FreeValue(engine_ctx, window_args);
+
+  size_t content_len = 0;
+  const char* content = JS_ToCStringLen(engine_ctx, &content_len, content_val);
+  size_t options_len = 0;
+  uint8_t* options = JS_IsNull(options_val) ? nullptr : JS_GetUint8Array(engine_ctx, &options_len, options_val);
+  JSContext* window_ctx = nullptr;
+  JSValue js_window = content
+    ? eng->CreateWindow(content, content_len, options, (int)options_len, &window_ctx)
+    : JS_EXCEPTION;
+  if (content) {
+    JS_FreeCString(engine_ctx, content);
+  }
+  JS_FreeValue(engine_ctx, content_val);
+  JS_FreeValue(engine_ctx, options_val);
+  if (JS_IsException(js_window)) {
+    return pool_job_error(eng, engine_ctx, out);
+  }
+
+  uint32_t handle = eng->handle_table()->Insert(request_unraver::kHandleWindow, window_ctx, js_window, true);
+  if (!handle) {
+    *out = "pool_job: handle table full";
+    return false;
+  }
+
+  JSContext* ctx = window_ctx;
+  JSValue runner_args[4] = {
+    JS_GetGlobalObject(ctx),
+    JS_DupValue(ctx, js_window),
+    JS_NewUint8ArrayCopy(ctx, (const uint8_t*)payload.data(), payload.length()),
+    JS_NewStringLen(ctx, script_prefix.c_str(), script_prefix.length()),
+  };
+  JSValue r = pool_call(ctx, kPoolJobRunner, sizeof(kPoolJobRunner) - 1, "<pool_job>", 4, runner_args);
+
+  // 남은 promise job / 0ms 타이머 정리 (지연 타이머는 기다리지 않는다)
+  for (int i = 0; i < kPoolMaxLoopSteps && eng->LoopStep() > 0; i++) {
+  }
+
+  // 비동기 script: settle 된 결과를 꺼낸다
+  if (JS_IsPromise(r)) {
+    JSPromiseStateEnum state = JS_PromiseState(ctx, r);
+    JSValue settled = state == JS_PROMISE_PENDING ? JS_UNDEFINED : JS_PromiseResult(ctx, r);
+    JS_FreeValue(ctx, r);
+    if (state == JS_PROMISE_FULFILLED) {
+      r = settled;
+    } else if (state == JS_PROMISE_REJECTED) {
+      r = JS_Throw(ctx, settled);
+    } else {
+      r = JS_ThrowInternalError(ctx, "pool_job: promise did not settle");
+    }
+  }
+
+  bool ok;
+  if (JS_IsException(r)) {
+    ok = pool_job_error(eng, ctx, out);
+  } else {
+    size_t size = 0;
+    uint8_t* data = JS_GetUint8Array(ctx, &size, r);
+    if (data) {
+      out->assign((const char*)data, size);
+    } else {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      out->assign("\xc0", 1);  // msgpack nil
+    }
+    ok = true;
+  }
+  JS_FreeValue(ctx, r);
+  eng->DestroyWindow(handle);
+
+  return ok;
+}
+
+//
+// pool_new
+//   - 스레드별 Engine 을 가진 worker pool 생성 (runtime_init 이후)
+//   - 성공: WL_VALUE (address, tag = RU_TAG_POOL_INSTANCE)
+//
+EXPORT WL_VALUE pool_new(WL_VALUE mode, WL_VALUE threads) {
+  std::shared_ptr<request_unraver::VfsManager> vfs_manager = runtime.GetVfsManager();
+  if (!vfs_manager) {
+    return wl_make_error("pool_new: runtime not initialized");
+  }
+
+  uint32_t thread_count = wl_to_uint32(threads);
+  if (thread_count == 0) {
+    return wl_make_error("pool_new: threads must be > 0");
+  }
+  // Start() 가 메인 스레드에서 worker 초기화를 기다리므로 새 worker 는 뜰 수 없다:
+  // 미리 생성된 worker 보다 많이 요청하면 deadlock 이 되므로 거절한다
+  int idle_workers = ru_pthread_idle_workers();
+  if (thread_count > (uint32_t)idle_workers) {
+    return wl_make_error("pool_new: threads (" + std::to_string(thread_count) +
+                         ") exceeds idle pthread workers (" + std::to_string(idle_workers) + ")");
+  }
+
+  auto* pool = new request_unraver::WorkerPool(thread_count * kPoolJobsPerThread);
+  if (!pool->Start(wl_to_uint32(mode), vfs_manager, thread_count, pool_run_job)) {
+    delete pool;
+    return wl_make_error("pool_new: Start() failed");
+  }
+
+  return wl_from_address(pool, RU_TAG_POOL_INSTANCE, /*free_flag_for_receiver*/ false);
+}
+
+//
+// pool_cleanup
+//   - 모든 worker 종료 후 해제 (처리 중인 작업은 끝날 때까지 대기)
+//
+EXPORT WL_VALUE pool_cleanup(WL_VALUE pool_instance) {
+  request_unraver::WorkerPool* pool = recover_pool_from_wl(pool_instance);
+  if (!pool) {
+    return wl_from_bool(false);
+  }
+  pool->Stop();
+  delete pool;
+  return wl_from_bool(true);
+}
+
+//
+// pool_submit
+//   - wl_job: msgpack { content?, options?, jquery?, script, params? }
+//   - 성공: uint32 job id, 큐가 가득 차면 0
+//
+EXPORT WL_VALUE pool_submit(WL_VALUE pool_instance, WL_VALUE wl_job) {
+  std::string job = wl_job ? wl_to_msgpack(wl_job, true) : "";
+
+  request_unraver::WorkerPool* pool = recover_pool_from_wl(pool_instance);
+  if (!pool) {
+    return wl_make_error("pool_submit: invalid pool instance");
+  }
+  if (job.empty()) {
+    return wl_make_error("pool_submit: job required");
+  }
+
+  return wl_make_msgpack_uint(pool->Submit(std::move(job)));
+}
+
+//
+// pool_drain
+//   - 완료된 작업 (msgpack array): [{ id, value } | { id, error }]
+//
+EXPORT WL_VALUE pool_drain(WL_VALUE pool_instance) {
+  request_unraver::WorkerPool* pool = recover_pool_from_wl(pool_instance);
+  if (!pool) {
+    return wl_make_error("pool_drain: invalid pool instance");
+  }
+
+  std::vector<request_unraver::PoolResult> results;
+  pool->Drain(&results, SIZE_MAX);
+
+  msgpack::sbuffer sbuf;
+  msgpack::packer<msgpack::sbuffer> pk(&sbuf);
+  pk.pack_array((uint32_t)results.size());
+  for (const auto& result : results) {
+    pk.pack_map(2);
+    pk.pack("id");
+    pk.pack_uint32(result.id);
+    if (result.ok) {
+      pk.pack("value");
+      // 이미 msgpack 으로 직렬화된 값을 그대로 삽입
+      sbuf.write(result.data.data(), result.data.size());
+    } else {
+      pk.pack("error");
+      pk.pack(result.data);
+    }
+  }
+
+  return wl_make_msgpack(std::string_view(sbuf.data(), sbuf.size()), true);
+}
+
+//
+// pool_set_gc
+//   - idle_gc_mode: 큐가 빈 worker 가 돌릴 engine_gc mode (0 전체, 1 budget, 그 외 끔)
+//   - gc_headroom: 작업 동안 자동 GC 를 미룰 여유 bytes (engine_gc_headroom, 0: 끔)
+//
+EXPORT WL_VALUE pool_set_gc(WL_VALUE pool_instance, WL_VALUE idle_gc_mode, WL_VALUE gc_headroom) {
+  request_unraver::WorkerPool* pool = recover_pool_from_wl(pool_instance);
+  if (!pool) {
+    return wl_make_error("pool_set_gc: invalid pool instance");
+  }
+  pool->SetGc(wl_to_uint32(idle_gc_mode), wl_to_uint32(gc_headroom));
+  return wl_from_bool(true);
+}
+
+//
+// pool_completion_counter
+//   - 작업 완료마다 증가하는 uint32 의 linear memory 주소
+//   - 호스트는 Atomics.wait/waitAsync 로 대기 후 pool_drain 호출
+//
+EXPORT uint32_t pool_completion_counter(WL_VALUE pool_instance) {
+  request_unraver::WorkerPool* pool = recover_pool_from_wl(pool_instance);
+  if (!pool) {
+    return 0;
+  }
+  return (uint32_t) reinterpret_cast<uintptr_t>(pool->completion_counter());
+}
+
+#endif  // REQUEST_UNRAVER_THREADS
+
 } // extern "C"
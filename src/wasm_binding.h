@@ -8,4 +8,16 @@ extern "C" {
   // milliseconds
   EM_IMPORT(_ru_get_random) void ru_get_random(uint8_t* buf, int len);
 
+  // 비동기 호스트 I/O 요청 (msgpack: { kind, id, request, body })
+  //   - engine: engine_new 가 반환한 WL_VALUE
+  //   - window: 요청한 window 의 WL_VALUE (engine context 이거나 window 생성 중이면 0)
+  //   - 결과는 engine_complete_io 로 전달
+  EM_IMPORT(_ru_io_submit) void ru_io_submit(uint64_t engine, uint64_t window, uint32_t io_id,
+                                             const uint8_t* request, int request_len);
+
+#if defined(REQUEST_UNRAVER_THREADS)
+  // 미리 생성된 pthread worker (PTHREAD_POOL_SIZE) 중 아직 쓰이지 않은 수
+  EM_IMPORT(_ru_pthread_idle_workers) int ru_pthread_idle_workers();
+#endif
+
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+// request-unraver-wasm-mt 용 host import (emscripten --js-library)
+//
+// STANDALONE_WASM 빌드는 node/request-unraver/src/runtime.ts 가 같은 import 를
+// 직접 제공한다. pthread 빌드는 emscripten glue 가 worker 를 관리하므로
+// import 도 glue 에 포함되어 각 worker 에서 실행된다.
+
+addToLibrary({
+  _ru_get_now__sig: 'd',
+  _ru_get_now: function () {
+    return performance.now();
+  },
+
+  _ru_get_random__sig: 'vpi',
+  _ru_get_random: function (ptr, len) {
+    // getRandomValues 는 SharedArrayBuffer view 를 받지 않는다
+    var tmp = new Uint8Array(len);
+    crypto.getRandomValues(tmp);
+    HEAPU8.set(tmp, ptr);
+  },
+
+  _ru_pthread_idle_workers__deps: ['$PThread'],
+  _ru_pthread_idle_workers__sig: 'i',
+  _ru_pthread_idle_workers: function () {
+    return PThread.unusedWorkers.length;
+  },
+
+  _ru_io_submit__sig: 'vjjipi',
+  _ru_io_submit: function (engine, window, ioId, ptr, len) {
+    var request = HEAPU8.slice(ptr, ptr + len);
+    if (typeof Module['onIoSubmit'] === 'function' && !ENVIRONMENT_IS_PTHREAD) {
+      Module['onIoSubmit'](engine, window, ioId, request);
+    } else {
+      // pool worker 의 요청은 IoManager::SubmitImpl 이 바로 reject 하므로 여기 오지 않는다
+      err('ru_io_submit: async host I/O is not available on pool workers');
+    }
+  },
+});
@@ -0,0 +1,182 @@
+#include "window_memory.h"
+
+#include <vector>
+
+namespace request_unraver {
+
+void WindowMemory::Charge(int64_t delta) {
+  charged_bytes += delta;
+  calls++;
+  if (held_bytes() > peak_bytes) {
+    peak_bytes = held_bytes();
+  }
+}
+
+void WindowMemory::Pack(msgpack::packer<msgpack::sbuffer>* pk) const {
+  pk->pack_map(5);
+  pk->pack("contextBytes");
+  pk->pack_uint64(context_bytes);
+  pk->pack("chargedBytes");
+  pk->pack_int64(charged_bytes);
+  pk->pack("heldBytes");
+  pk->pack_int64(held_bytes());
+  pk->pack("peakBytes");
+  pk->pack_int64(peak_bytes);
+  pk->pack("calls");
+  pk->pack_uint32(calls);
+}
+
+void WindowLeakTracker::SetBaseline(JSContext* ctx, JSValueConst global) {
+  JSPropertyEnum* props = nullptr;
+  uint32_t len = 0;
+  if (JS_GetOwnPropertyNames(ctx, &props, &len, global, JS_GPN_STRING_MASK) < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    return;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    const char* name = JS_AtomToCString(ctx, props[i].atom);
+    if (name) {
+      baseline_.insert(name);
+      JS_FreeCString(ctx, name);
+    }
+  }
+  JS_FreePropertyEnum(ctx, props, len);
+  has_baseline_ = true;
+}
+
+void WindowLeakTracker::Track(JSContext* engine_ctx, uint32_t handle, JSValueConst global,
+                              const WindowMemory& memory) {
+  JSValue global_obj = JS_GetGlobalObject(engine_ctx);
+  JSValue ctor = JS_GetPropertyStr(engine_ctx, global_obj, "WeakRef");
+  JS_FreeValue(engine_ctx, global_obj);
+
+  JSValue weak_ref = JS_UNDEFINED;
+  if (JS_IsFunction(engine_ctx, ctor)) {
+    weak_ref = JS_CallConstructor(engine_ctx, ctor, 1, &global);
+    if (JS_IsException(weak_ref)) {
+      JS_FreeValue(engine_ctx, JS_GetException(engine_ctx));
+      weak_ref = JS_UNDEFINED;
+    }
+  }
+  JS_FreeValue(engine_ctx, ctor);
+
+  if (entries_.size() >= kMaxTracked) {
+    JS_FreeValue(engine_ctx, entries_.front().weak_ref);
+    entries_.pop_front();
+  }
+  entries_.push_back(Entry{handle, memory.held_bytes(), 0, weak_ref});
+}
+
+void WindowLeakTracker::SetFreed(int64_t freed_bytes) {
+  if (!entries_.empty()) {
+    entries_.back().freed_bytes = freed_bytes;
+  }
+}
+
+void WindowLeakTracker::Report(JSContext* engine_ctx, msgpack::packer<msgpack::sbuffer>* pk) {
+  std::deque<Entry> retained;
+
+  pk->pack_array(static_cast<uint32_t>(entries_.size()));
+  for (Entry& entry : entries_) {
+    JSValue target = JS_UNDEFINED;
+    if (JS_IsObject(entry.weak_ref)) {
+      JSValue deref = JS_GetPropertyStr(engine_ctx, entry.weak_ref, "deref");
+      target = JS_Call(engine_ctx, deref, entry.weak_ref, 0, nullptr);
+      JS_FreeValue(engine_ctx, deref);
+      if (JS_IsException(target)) {
+        JS_FreeValue(engine_ctx, JS_GetException(engine_ctx));
+        target = JS_UNDEFINED;
+      }
+    }
+    bool alive = JS_IsObject(target);
+
+    pk->pack_map(5);
+    pk->pack("handle");
+    pk->pack_uint32(entry.handle);
+    pk->pack("heldBytes");
+    pk->pack_int64(entry.held_bytes);
+    pk->pack("freedBytes");
+    pk->pack_int64(entry.freed_bytes);
+    pk->pack("retained");
+    pk->pack(alive);
+    pk->pack("globals");
+    if (alive) {
+      PackGlobals(engine_ctx, target, pk);
+    } else {
+      pk->pack_array(0);
+    }
+    JS_FreeValue(engine_ctx, target);
+
+    if (alive) {
+      retained.push_back(entry);
+    } else {
+      JS_FreeValue(engine_ctx, entry.weak_ref);
+    }
+  }
+  entries_.swap(retained);
+}
+
+void WindowLeakTracker::Clear(JSContext* engine_ctx) {
+  for (Entry& entry : entries_) {
+    JS_FreeValue(engine_ctx, entry.weak_ref);
+  }
+  entries_.clear();
+}
+
+void WindowLeakTracker::PackGlobals(JSContext* ctx, JSValueConst global,
+                                    msgpack::packer<msgpack::sbuffer>* pk) const {
+  struct Found {
+    std::string name;
+    const char* type;
+  };
+  std::vector<Found> found;
+
+  JSPropertyEnum* props = nullptr;
+  uint32_t len = 0;
+  if (JS_GetOwnPropertyNames(ctx, &props, &len, global, JS_GPN_STRING_MASK) < 0) {
+    JS_FreeValue(ctx, JS_GetException(ctx));
+    len = 0;
+  }
+  for (uint32_t i = 0; i < len; i++) {
+    const char* name = JS_AtomToCString(ctx, props[i].atom);
+    if (!name) {
+      JS_FreeValue(ctx, JS_GetException(ctx));
+      continue;
+    }
+    if (baseline_.count(name) == 0) {
+      // getter 를 실행하지 않도록 descriptor 로 읽는다
+      JSPropertyDescriptor desc;
+      int ret = JS_GetOwnProperty(ctx, &desc, global, props[i].atom);
+      if (ret > 0) {
+        if (desc.flags & JS_PROP_GETSET) {
+          found.push_back(Found{name, "accessor"});
+        } else if (JS_IsFunction(ctx, desc.value)) {
+          found.push_back(Found{name, "function"});
+        } else if (JS_IsObject(desc.value)) {
+          found.push_back(Found{name, "object"});
+        }
+        // 원시값은 다른 객체를 붙잡지 않으므로 보고하지 않는다
+        JS_FreeValue(ctx, desc.value);
+        JS_FreeValue(ctx, desc.getter);
+        JS_FreeValue(ctx, desc.setter);
+      } else if (ret < 0) {
+        JS_FreeValue(ctx, JS_GetException(ctx));
+      }
+    }
+    JS_FreeCString(ctx, name);
+  }
+  if (props) {
+    JS_FreePropertyEnum(ctx, props, len);
+  }
+
+  pk->pack_array(static_cast<uint32_t>(found.size()));
+  for (const Found& item : found) {
+    pk->pack_map(2);
+    pk->pack("name");
+    pk->pack(item.name);
+    pk->pack("type");
+    pk->pack(item.type);
+  }
+}
+
+}  // namespace request_unraver
@@ -0,0 +1,85 @@
+#ifndef REQUEST_UNRAVER_WINDOW_MEMORY_H_
+#define REQUEST_UNRAVER_WINDOW_MEMORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_set>
+
+#include <msgpack.hpp>
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// window context 별 JS heap 사용량 (EngineAllocator live bytes 의 차이)
+//
+// QuickJS 는 context 별 할당을 나누지 않으므로, window 전용 context 에서만 실행되는
+// 구간 (context 생성, window 생성, window 에 대한 eval) 의 증감을 그 window 에 청구한다.
+// LoopStep 처럼 여러 window 의 타이머/job 이 섞이는 구간은 청구하지 않는다.
+struct WindowMemory {
+  // context 생성 + pseudo-browser bundle 로드
+  uint64_t context_bytes = 0;
+  // 이후 청구된 증감의 합 (GC 로 음수가 될 수 있다)
+  int64_t charged_bytes = 0;
+  int64_t peak_bytes = 0;
+  uint32_t calls = 0;
+
+  int64_t held_bytes() const { return static_cast<int64_t>(context_bytes) + charged_bytes; }
+  void Charge(int64_t delta);
+  void Pack(msgpack::packer<msgpack::sbuffer>* pk) const;
+};
+
+// 해제된 window 의 global 이 여전히 도달 가능한지 추적
+//
+// destroy 시 engine context 에서 global 에 대한 WeakRef 를 만들어 두고, Report 에서
+// GC 후 deref 가 살아 있으면 그 global 에 page 가 추가한 (bundle 로드 직후에 없던)
+// 객체 값 property 를 나열한다. 회수된 window 는 한 번 보고한 뒤 잊는다.
+class WindowLeakTracker {
+ public:
+  // 이보다 많으면 가장 오래된 항목부터 버린다
+  static constexpr size_t kMaxTracked = 256;
+
+  WindowLeakTracker() = default;
+
+  WindowLeakTracker(const WindowLeakTracker&) = delete;
+  WindowLeakTracker& operator=(const WindowLeakTracker&) = delete;
+
+  bool has_baseline() const { return has_baseline_; }
+  // 새 window context 의 global property 이름 (모든 window context 가 같은 bundle 로 시작)
+  void SetBaseline(JSContext* ctx, JSValueConst global);
+
+  // window handle 해제 직전에 호출. engine_ctx 에 WeakRef 를 만든다
+  void Track(JSContext* engine_ctx, uint32_t handle, JSValueConst global,
+             const WindowMemory& memory);
+  // handle 해제 후 실제로 줄어든 bytes
+  void SetFreed(int64_t freed_bytes);
+
+  // 호출 전에 JS_RunGC 가 끝나 있어야 한다
+  //   [{ handle, heldBytes, freedBytes, retained, globals: [{ name, type }] }]
+  void Report(JSContext* engine_ctx, msgpack::packer<msgpack::sbuffer>* pk);
+
+  void Clear(JSContext* engine_ctx);
+
+ private:
+  struct Entry {
+    uint32_t handle;
+    int64_t held_bytes;
+    int64_t freed_bytes;
+    // engine context 의 WeakRef 객체
+    JSValue weak_ref;
+  };
+
+  void PackGlobals(JSContext* ctx, JSValueConst global, msgpack::packer<msgpack::sbuffer>* pk) const;
+
+  std::deque<Entry> entries_;
+  std::unordered_set<std::string> baseline_;
+  bool has_baseline_ = false;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_WINDOW_MEMORY_H_
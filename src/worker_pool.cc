@@ -0,0 +1,170 @@
+#include "worker_pool.h"
+
+#include <climits>
+#include <cstdio>
+
+#include <emscripten/threading.h>
+
+#include "engine.h"
+
+namespace request_unraver {
+
+WorkerPool::WorkerPool(size_t capacity)
+    : jobs_(capacity),
+      results_(capacity),
+      handler_(nullptr),
+      stopping_(false),
+      next_id_(1),
+      in_flight_(0),
+      queued_(0),
+      completed_(0),
+      ready_(0),
+      failed_(0),
+      idle_gc_mode_(UINT32_MAX),
+      gc_headroom_(0) {}
+
+WorkerPool::~WorkerPool() {
+  Stop();
+}
+
+bool WorkerPool::Start(uint32_t mode, std::shared_ptr<VfsManager> vfs_manager, size_t threads,
+                       PoolJobHandler handler) {
+  if (!threads_.empty() || !handler || threads == 0) {
+    return false;
+  }
+
+  vfs_manager_ = std::move(vfs_manager);
+  handler_ = handler;
+  stopping_.store(false);
+
+  for (size_t i = 0; i < threads; i++) {
+    threads_.emplace_back(&WorkerPool::WorkerMain, this, mode);
+  }
+
+  // 모든 worker 의 Engine 초기화 대기
+  {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    init_cv_.wait(lock, [&] { return ready_.load() + failed_.load() >= threads; });
+  }
+
+  if (failed_.load()) {
+    fprintf(stderr, "WorkerPool: %zu of %zu engines failed to initialize\n", failed_.load(), threads);
+    Stop();
+    return false;
+  }
+  return true;
+}
+
+void WorkerPool::SetGc(uint32_t idle_gc_mode, size_t gc_headroom) {
+  idle_gc_mode_.store(idle_gc_mode, std::memory_order_relaxed);
+  gc_headroom_.store(gc_headroom, std::memory_order_relaxed);
+}
+
+void WorkerPool::Stop() {
+  if (threads_.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    stopping_.store(true);
+  }
+  wake_cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+uint32_t WorkerPool::Submit(std::string payload) {
+  // 결과 큐가 넘치지 않도록 처리 중인 작업 수를 capacity 로 제한
+  size_t in_flight = in_flight_.fetch_add(1);
+  if (in_flight >= jobs_.capacity()) {
+    in_flight_.fetch_sub(1);
+    return 0;
+  }
+
+  uint32_t id = next_id_.fetch_add(1);
+  if (id == 0) {
+    id = next_id_.fetch_add(1);
+  }
+
+  PoolJob job;
+  job.id = id;
+  job.payload = std::move(payload);
+
+  // worker 가 pop 하기 전에 증가해야 queued_ 가 음수가 되지 않는다
+  queued_.fetch_add(1);
+  if (!jobs_.TryPush(std::move(job))) {
+    queued_.fetch_sub(1);
+    in_flight_.fetch_sub(1);
+    return 0;
+  }
+
+  {
+    // wait 의 predicate 확인 이후에 notify 되도록 lock 을 거친다
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+  }
+  wake_cv_.notify_one();
+  return id;
+}
+
+size_t WorkerPool::Drain(std::vector<PoolResult>* out, size_t max) {
+  size_t count = 0;
+  PoolResult result;
+  while (count < max && results_.TryPop(&result)) {
+    out->push_back(std::move(result));
+    in_flight_.fetch_sub(1);
+    count++;
+  }
+  return count;
+}
+
+void WorkerPool::WorkerMain(uint32_t mode) {
+  std::unique_ptr<Engine> eng = std::make_unique<Engine>();
+  bool init_ok = eng->Init(mode, vfs_manager_);
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    (init_ok ? ready_ : failed_).fetch_add(1);
+  }
+  init_cv_.notify_all();
+  if (!init_ok) {
+    return;
+  }
+
+  // 마지막 GC 이후 작업을 실행했는지
+  bool dirty = false;
+  for (;;) {
+    PoolJob job;
+    if (!jobs_.TryPop(&job)) {
+      // 다음 작업을 기다리기 전에 수거해서 pause 가 작업 중에 걸리지 않게 한다
+      uint32_t gc_mode = idle_gc_mode_.load(std::memory_order_relaxed);
+      if (dirty && (gc_mode == kGcFull || gc_mode == kGcBudget)) {
+        dirty = false;
+        eng->CollectGarbage(static_cast<GcMode>(gc_mode), nullptr);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_cv_.wait(lock, [&] { return stopping_.load() || queued_.load() > 0; });
+      if (stopping_.load()) {
+        break;
+      }
+      continue;
+    }
+    queued_.fetch_sub(1);
+    eng->set_gc_headroom(gc_headroom_.load(std::memory_order_relaxed));
+    dirty = true;
+
+    PoolResult result;
+    result.id = job.id;
+    result.ok = handler_(eng.get(), job.payload, &result.data);
+
+    // in_flight 제한으로 결과 큐는 항상 자리가 있다
+    results_.TryPush(std::move(result));
+    completed_.fetch_add(1);
+    emscripten_futex_wake(&completed_, INT_MAX);
+  }
+
+  eng->Shutdown();
+}
+
+}  // namespace request_unraver
@@ -0,0 +1,93 @@
+#ifndef REQUEST_UNRAVER_WORKER_POOL_H_
+#define REQUEST_UNRAVER_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "job_queue.h"
+#include "vfs_manager.h"
+
+namespace request_unraver {
+
+class Engine;
+
+struct PoolJob {
+  uint32_t id = 0;
+  // msgpack (job handler 가 해석)
+  std::string payload;
+};
+
+struct PoolResult {
+  uint32_t id = 0;
+  bool ok = false;
+  // ok: msgpack 값, 실패: 오류 메시지
+  std::string data;
+};
+
+// 작업 하나를 engine 에서 실행. 실패시 false 와 함께 out 에 오류 메시지
+using PoolJobHandler = bool (*)(Engine* eng, const std::string& payload, std::string* out);
+
+// 스레드별 Engine 을 가진 worker pool (-pthread 빌드 전용)
+//
+// 모든 스레드는 같은 VfsManager (읽기 전용 + 공유 파일 캐시)를 사용하고,
+// 각자 자신의 JSRuntime/Engine 을 소유한다. 작업/결과는 lock-free 큐로 전달되며
+// mutex 는 idle worker 를 깨우는 데만 사용한다.
+class WorkerPool {
+ public:
+  explicit WorkerPool(size_t capacity);
+  ~WorkerPool();
+
+  bool Start(uint32_t mode, std::shared_ptr<VfsManager> vfs_manager, size_t threads,
+             PoolJobHandler handler);
+  void Stop();
+
+  // job id 반환, 처리 중인 작업이 capacity 만큼 있으면 0
+  uint32_t Submit(std::string payload);
+
+  // 완료된 결과를 최대 max 개 꺼낸다
+  size_t Drain(std::vector<PoolResult>* out, size_t max);
+
+  // 결과가 push 될 때마다 증가 (호스트는 Atomics.wait 로 대기 가능)
+  const std::atomic<uint32_t>* completion_counter() const { return &completed_; }
+
+  // 큐가 비어 idle 이 되는 worker 가 engine_gc 와 같은 GC 를 돌린다
+  //   - idle_gc_mode: GcMode (engine.h), 그 외 값은 끔
+  //   - gc_headroom: 작업 동안 자동 GC 를 미룰 여유 bytes (engine_gc_headroom)
+  void SetGc(uint32_t idle_gc_mode, size_t gc_headroom);
+
+  size_t in_flight() const { return in_flight_.load(std::memory_order_relaxed); }
+  size_t thread_count() const { return threads_.size(); }
+
+ private:
+  void WorkerMain(uint32_t mode);
+
+  JobQueue<PoolJob> jobs_;
+  JobQueue<PoolResult> results_;
+  std::vector<std::thread> threads_;
+  std::shared_ptr<VfsManager> vfs_manager_;
+  PoolJobHandler handler_;
+
+  std::atomic<bool> stopping_;
+  std::atomic<uint32_t> next_id_;
+  std::atomic<size_t> in_flight_;
+  std::atomic<size_t> queued_;
+  std::atomic<uint32_t> completed_;
+  std::atomic<size_t> ready_;
+  std::atomic<size_t> failed_;
+  std::atomic<uint32_t> idle_gc_mode_;
+  std::atomic<size_t> gc_headroom_;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable init_cv_;
+};
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_WORKER_POOL_H_
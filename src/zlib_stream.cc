@@ -0,0 +1,370 @@
+#include "zlib_stream.h"
+
+#include <cstring>
+#include <mutex>
+
+#include <zlib.h>
+
+#include "js_bytes.h"
+
+namespace request_unraver {
+
+namespace {
+
+// node lib/zlib.js 의 mode
+enum ZlibMode {
+  kModeNone = 0,
+  kModeDeflate,
+  kModeInflate,
+  kModeGzip,
+  kModeGunzip,
+  kModeDeflateRaw,
+  kModeInflateRaw,
+  kModeUnzip,
+};
+
+struct ZlibStream {
+  ZlibMode mode;
+  bool initialized = false;
+  bool ended = false;
+  // process() 한 번의 출력 한도 (maxOutputLength, 0 이면 제한 없음)
+  size_t max_output = 0;
+  z_stream strm;
+  // Unzip 이 gzip 을 읽었는지 판별 (done == 1)
+  gz_header gzip_header;
+};
+
+JSClassID zlib_stream_class_id = 0;
+std::once_flag zlib_stream_class_once;
+
+bool IsDeflateMode(ZlibMode mode) {
+  return mode == kModeDeflate || mode == kModeGzip || mode == kModeDeflateRaw;
+}
+
+void FreeZlibStream(ZlibStream* stream) {
+  if (stream->initialized) {
+    if (IsDeflateMode(stream->mode)) {
+      deflateEnd(&stream->strm);
+    } else {
+      inflateEnd(&stream->strm);
+    }
+  }
+  delete stream;
+}
+
+void ZlibStreamFinalizer(JSRuntime* rt, JSValue val) {
+  ZlibStream* stream = static_cast<ZlibStream*>(JS_GetOpaque(val, zlib_stream_class_id));
+  if (stream) {
+    FreeZlibStream(stream);
+  }
+}
+
+const JSClassDef kZlibStreamClass = {
+  "NativeZlibStream",
+  ZlibStreamFinalizer,
+};
+
+const char* ZlibCode(int ret) {
+  switch (ret) {
+    case Z_NEED_DICT: return "Z_NEED_DICT";
+    case Z_ERRNO: return "Z_ERRNO";
+    case Z_STREAM_ERROR: return "Z_STREAM_ERROR";
+    case Z_DATA_ERROR: return "Z_DATA_ERROR";
+    case Z_MEM_ERROR: return "Z_MEM_ERROR";
+    case Z_BUF_ERROR: return "Z_BUF_ERROR";
+    case Z_VERSION_ERROR: return "Z_VERSION_ERROR";
+    default: return "Z_UNKNOWN_ERROR";
+  }
+}
+
+// node 와 같은 형태의 오류 (message, code, errno)
+JSValue ThrowZlibError(JSContext* ctx, int ret, const char* message) {
+  JSValue error = JS_NewError(ctx);
+  JS_SetPropertyStr(ctx, error, "message", JS_NewString(ctx, message));
+  JS_SetPropertyStr(ctx, error, "code", JS_NewString(ctx, ZlibCode(ret)));
+  JS_SetPropertyStr(ctx, error, "errno", JS_NewInt32(ctx, ret));
+  return JS_Throw(ctx, error);
+}
+
+// node Buffer 한도 초과와 같은 오류 (RangeError, ERR_BUFFER_TOO_LARGE)
+JSValue ThrowOutputTooLarge(JSContext* ctx, size_t max_output) {
+  JS_ThrowRangeError(ctx, "Cannot create a Buffer larger than %zu bytes", max_output);
+  JSValue error = JS_GetException(ctx);
+  JS_SetPropertyStr(ctx, error, "code", JS_NewString(ctx, "ERR_BUFFER_TOO_LARGE"));
+  return JS_Throw(ctx, error);
+}
+
+// node 의 windowBits 범위 오류 (RangeError, ERR_OUT_OF_RANGE)
+JSValue ThrowWindowBitsRange(JSContext* ctx, int32_t window_bits) {
+  JS_ThrowRangeError(ctx, "The value of \"options.windowBits\" is out of range. It must be >= 8 and <= 15. Received %d",
+                     window_bits);
+  JSValue error = JS_GetException(ctx);
+  JS_SetPropertyStr(ctx, error, "code", JS_NewString(ctx, "ERR_OUT_OF_RANGE"));
+  return JS_Throw(ctx, error);
+}
+
+void FreeOutputBuffer(JSRuntime* rt, void* opaque, void* ptr) {
+  js_free_rt(rt, ptr);
+}
+
+// Unzip 은 header 를 보고 gzip 인지 기록한다 (inflateReset 후 다시 등록해야 함)
+void WatchGzipHeader(ZlibStream* stream) {
+  if (stream->mode == kModeUnzip) {
+    memset(&stream->gzip_header, 0, sizeof(stream->gzip_header));
+    inflateGetHeader(&stream->strm, &stream->gzip_header);
+  }
+}
+
+// 연결된 gzip member 를 이어서 읽는 stream 인지 (node 는 Unzip 도 gzip 이면 Gunzip 처럼 처리)
+bool IsGzipInput(const ZlibStream* stream) {
+  return stream->mode == kModeGunzip || (stream->mode == kModeUnzip && stream->gzip_header.done == 1);
+}
+
+//
+// zlib_create(mode, level, windowBits, memLevel, strategy, maxOutputLength?)
+//
+JSValue JsZlibCreate(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  int32_t mode = 0;
+  int32_t level = Z_DEFAULT_COMPRESSION;
+  int32_t window_bits = 15;
+  int32_t mem_level = 8;
+  int32_t strategy = Z_DEFAULT_STRATEGY;
+  if (argc < 5 ||
+      JS_ToInt32(ctx, &mode, argv[0]) || JS_ToInt32(ctx, &level, argv[1]) ||
+      JS_ToInt32(ctx, &window_bits, argv[2]) || JS_ToInt32(ctx, &mem_level, argv[3]) ||
+      JS_ToInt32(ctx, &strategy, argv[4])) {
+    return JS_ThrowTypeError(ctx, "zlib_create(mode, level, windowBits, memLevel, strategy) expected");
+  }
+  // 0 (header 의 window 크기 사용) 은 header 가 있는 Inflate/Gunzip/Unzip 에서만 허용.
+  // raw 에서 0 은 inflateInit2(-0) 이 되어 zlib header 를 기대하게 된다
+  bool header_window = mode == kModeInflate || mode == kModeGunzip || mode == kModeUnzip;
+  if ((window_bits < 8 || window_bits > 15) && !(window_bits == 0 && header_window)) {
+    return ThrowWindowBitsRange(ctx, window_bits);
+  }
+  uint64_t max_output = 0;
+  if (argc > 5 && !JS_IsUndefined(argv[5]) && JS_ToIndex(ctx, &max_output, argv[5])) {
+    return JS_EXCEPTION;
+  }
+
+  ZlibStream* stream = new ZlibStream();
+  stream->mode = static_cast<ZlibMode>(mode);
+  stream->max_output = (size_t) max_output;
+  memset(&stream->strm, 0, sizeof(stream->strm));
+
+  int ret;
+  switch (stream->mode) {
+    case kModeDeflate:
+      ret = deflateInit2(&stream->strm, level, Z_DEFLATED, window_bits, mem_level, strategy);
+      break;
+    case kModeGzip:
+      ret = deflateInit2(&stream->strm, level, Z_DEFLATED, window_bits + 16, mem_level, strategy);
+      break;
+    case kModeDeflateRaw:
+      ret = deflateInit2(&stream->strm, level, Z_DEFLATED, -window_bits, mem_level, strategy);
+      break;
+    case kModeInflate:
+      ret = inflateInit2(&stream->strm, window_bits);
+      break;
+    case kModeGunzip:
+      ret = inflateInit2(&stream->strm, window_bits + 16);
+      break;
+    case kModeInflateRaw:
+      ret = inflateInit2(&stream->strm, -window_bits);
+      break;
+    case kModeUnzip:
+      // zlib/gzip header 자동 판별
+      ret = inflateInit2(&stream->strm, window_bits + 32);
+      break;
+    default:
+      delete stream;
+      return JS_ThrowRangeError(ctx, "zlib_create: invalid mode %d", mode);
+  }
+  if (ret != Z_OK) {
+    delete stream;
+    return ThrowZlibError(ctx, ret, "Init error");
+  }
+  stream->initialized = true;
+  WatchGzipHeader(stream);
+
+  JSValue obj = JS_NewObjectClass(ctx, zlib_stream_class_id);
+  if (JS_IsException(obj)) {
+    FreeZlibStream(stream);
+    return obj;
+  }
+  JS_SetOpaque(obj, stream);
+  return obj;
+}
+
+//
+// process(data, flush)
+//   - data 전체를 소비하고 생성된 출력 (Uint8Array) 반환
+//   - Z_FINISH 에서 입력이 끝나지 않으면 "unexpected end of file"
+//   - 출력이 maxOutputLength 를 넘으면 RangeError (압축 폭탄 방지)
+//
+JSValue JsZlibProcess(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  ZlibStream* stream = static_cast<ZlibStream*>(JS_GetOpaque2(ctx, this_val, zlib_stream_class_id));
+  if (!stream) {
+    return JS_EXCEPTION;
+  }
+  int32_t flush = Z_NO_FLUSH;
+  if (argc > 1 && JS_ToInt32(ctx, &flush, argv[1])) {
+    return JS_EXCEPTION;
+  }
+
+  JsBytes input;
+  if (argc > 0 && !JS_IsUndefined(argv[0]) && !JS_IsNull(argv[0]) && !input.Get(ctx, argv[0])) {
+    return JS_EXCEPTION;
+  }
+
+  z_stream* strm = &stream->strm;
+  strm->next_in = const_cast<Bytef*>(input.data);
+  strm->avail_in = (uInt) input.len;
+
+  bool deflate_mode = IsDeflateMode(stream->mode);
+  size_t cap = deflate_mode ? deflateBound(strm, (uLong) input.len) + 64 : input.len * 4 + 256;
+  // 한도보다 1 byte 더 받아 본다. 출력이 정확히 한도만큼이면 zlib 은 trailer 를
+  // 읽기 전에 Z_OK 로 멈추므로 한도에 닿았다는 것만으로는 초과를 알 수 없다
+  size_t limit = stream->max_output ? stream->max_output + 1 : 0;
+  if (limit && cap > limit) {
+    cap = limit;
+  }
+  size_t out_len = 0;
+  uint8_t* out = static_cast<uint8_t*>(js_malloc(ctx, cap));
+  if (!out) {
+    input.Free(ctx);
+    return JS_EXCEPTION;
+  }
+
+  int ret = Z_OK;
+  while (!stream->ended) {
+    if (out_len == cap) {
+      if (limit && cap >= limit) {
+        break;
+      }
+      size_t new_cap = cap * 2;
+      if (limit && new_cap > limit) {
+        new_cap = limit;
+      }
+      uint8_t* grown = static_cast<uint8_t*>(js_realloc(ctx, out, new_cap));
+      if (!grown) {
+        js_free(ctx, out);
+        input.Free(ctx);
+        return JS_EXCEPTION;
+      }
+      out = grown;
+      cap = new_cap;
+    }
+    strm->next_out = out + out_len;
+    strm->avail_out = (uInt)(cap - out_len);
+
+    ret = deflate_mode ? deflate(strm, flush) : inflate(strm, flush);
+    out_len = cap - strm->avail_out;
+
+    if (ret == Z_STREAM_END) {
+      // 연결된 gzip member 는 이어서 처리 (node 와 동일)
+      if (IsGzipInput(stream) && strm->avail_in > 0 && strm->next_in[0] == 0x1f) {
+        inflateReset(strm);
+        continue;
+      }
+      stream->ended = true;
+      break;
+    }
+    if (ret == Z_BUF_ERROR) {
+      // 더 진행할 수 없음: 입력 소진 또는 출력 공간 부족
+      if (strm->avail_out == 0) {
+        continue;
+      }
+      ret = Z_OK;
+      break;
+    }
+    if (ret != Z_OK) {
+      break;
+    }
+    if (strm->avail_in == 0 && strm->avail_out != 0 && flush != Z_FINISH) {
+      break;
+    }
+  }
+  input.Free(ctx);
+  strm->next_in = nullptr;
+  strm->avail_in = 0;
+
+  if (stream->max_output && out_len > stream->max_output) {
+    js_free(ctx, out);
+    return ThrowOutputTooLarge(ctx, stream->max_output);
+  }
+  if (ret != Z_OK && ret != Z_STREAM_END) {
+    js_free(ctx, out);
+    return ThrowZlibError(ctx, ret, strm->msg ? strm->msg : "zlib error");
+  }
+  if (flush == Z_FINISH && !stream->ended) {
+    js_free(ctx, out);
+    return ThrowZlibError(ctx, Z_BUF_ERROR, "unexpected end of file");
+  }
+  return JS_NewUint8Array(ctx, out, out_len, FreeOutputBuffer, nullptr, false);
+}
+
+//
+// reset()
+//
+JSValue JsZlibReset(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  ZlibStream* stream = static_cast<ZlibStream*>(JS_GetOpaque2(ctx, this_val, zlib_stream_class_id));
+  if (!stream) {
+    return JS_EXCEPTION;
+  }
+  int ret = IsDeflateMode(stream->mode) ? deflateReset(&stream->strm) : inflateReset(&stream->strm);
+  if (ret != Z_OK) {
+    return ThrowZlibError(ctx, ret, "Reset error");
+  }
+  WatchGzipHeader(stream);
+  stream->ended = false;
+  return JS_UNDEFINED;
+}
+
+//
+// close()
+//   - GC 전에 zlib 상태 해제
+//
+JSValue JsZlibClose(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
+  ZlibStream* stream = static_cast<ZlibStream*>(JS_GetOpaque2(ctx, this_val, zlib_stream_class_id));
+  if (!stream) {
+    return JS_EXCEPTION;
+  }
+  if (stream->initialized) {
+    if (IsDeflateMode(stream->mode)) {
+      deflateEnd(&stream->strm);
+    } else {
+      inflateEnd(&stream->strm);
+    }
+    stream->initialized = false;
+  }
+  stream->ended = true;
+  return JS_UNDEFINED;
+}
+
+const JSCFunctionListEntry kZlibStreamProto[] = {
+  JS_CFUNC_DEF("process", 2, JsZlibProcess),
+  JS_CFUNC_DEF("reset", 0, JsZlibReset),
+  JS_CFUNC_DEF("close", 0, JsZlibClose),
+};
+
+}  // anonymous
+
+void RegisterZlibStream(JSContext* ctx, JSValueConst sys_host) {
+  JSRuntime* rt = JS_GetRuntime(ctx);
+  std::call_once(zlib_stream_class_once, [rt] {
+    JS_NewClassID(rt, &zlib_stream_class_id);
+  });
+  if (!JS_IsRegisteredClass(rt, zlib_stream_class_id)) {
+    JS_NewClass(rt, zlib_stream_class_id, &kZlibStreamClass);
+  }
+
+  JSValue proto = JS_NewObject(ctx);
+  JS_SetPropertyFunctionList(ctx, proto, kZlibStreamProto,
+                             sizeof(kZlibStreamProto) / sizeof(kZlibStreamProto[0]));
+  JS_SetClassProto(ctx, zlib_stream_class_id, proto);
+
+  JS_SetPropertyStr(ctx, sys_host, "zlib_create",
+    JS_NewCFunction(ctx, JsZlibCreate, "zlib_create", 5));
+}
+
+}  // namespace request_unraver
@@ -0,0 +1,22 @@
+#ifndef REQUEST_UNRAVER_ZLIB_STREAM_H_
+#define REQUEST_UNRAVER_ZLIB_STREAM_H_
+
+extern "C" {
+#include <quickjs.h>
+}
+
+namespace request_unraver {
+
+// node:zlib 용 native z_stream (zlibstatic)
+//
+//   __sys_host.zlib_create(mode, level, windowBits, memLevel, strategy, maxOutputLength?)
+//
+// mode 는 node 의 binding 값 (DEFLATE=1 ... UNZIP=7). 반환된 객체의
+// process(data, flush) 는 입력을 모두 소비하고 생성된 출력을 Uint8Array 로
+// 반환한다. sync API 는 process(data, Z_FINISH) 한 번으로 처리되므로
+// maxOutputLength 는 process() 한 번의 출력 한도다.
+void RegisterZlibStream(JSContext* ctx, JSValueConst sys_host);
+
+}  // namespace request_unraver
+
+#endif  // REQUEST_UNRAVER_ZLIB_STREAM_H_
@@ -0,0 +1,208 @@
+/**
+ * native crypto 테스트 (crypto_subtle / crypto_stream)
+ * Usage: node --test test/crypto.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { ENGINE_MODE_FULL, withEngine, evalAsync } = require('./helpers');
+
+// engine 안에서 쓰는 공통 함수
+const PRELUDE = `
+    const enc = (s) => new TextEncoder().encode(s);
+    const hex = (buf) => Array.from(new Uint8Array(buf), (b) => b.toString(16).padStart(2, '0')).join('');
+`;
+
+test('subtle.digest matches FIPS 180 vectors', async () => {
+    await withEngine(ENGINE_MODE_FULL, async (engine) => {
+        const result = await evalAsync(engine, `${PRELUDE}
+            return {
+                sha1: hex(await crypto.subtle.digest('SHA-1', enc('abc'))),
+                sha256: hex(await crypto.subtle.digest('SHA-256', enc('abc'))),
+                empty: hex(await crypto.subtle.digest({ name: 'sha-256' }, new Uint8Array(0))),
+            };`);
+        assert.equal(result.sha1, 'a9993e364706816aba3e25717850c26c9cd0d89d');
+        assert.equal(result.sha256, 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad');
+        assert.equal(result.empty, 'e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855');
+    });
+});
+
+test('subtle HMAC sign/verify (RFC 4231 case 2)', async () => {
+    await withEngine(ENGINE_MODE_FULL, async (engine) => {
+        const result = await evalAsync(engine, `${PRELUDE}
+            const key = await crypto.subtle.importKey('raw', enc('Jefe'), { name: 'HMAC', hash: 'SHA-256' }, false, ['sign', 'verify']);
+            const data = enc('what do ya want for nothing?');
+            const mac = await crypto.subtle.sign('HMAC', key, data);
+            const bad = new Uint8Array(mac);
+            bad[0] ^= 1;
+            return {
+                mac: hex(mac),
+                ok: await crypto.subtle.verify('HMAC', key, mac, data),
+                bad: await crypto.subtle.verify('HMAC', key, bad, data),
+            };`);
+        assert.equal(result.mac, '5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843');
+        assert.equal(result.ok, true);
+        assert.equal(result.bad, false);
+    });
+});
+
+test('many live CryptoKeys do not exhaust PSA key slots', async () => {
+    await withEngine(ENGINE_MODE_FULL, async (engine) => {
+        const count = await evalAsync(engine, `${PRELUDE}
+            const keys = [];
+            for (let i = 0; i < 256; i++) {
+                keys.push(await crypto.subtle.importKey('raw', enc('key-' + i), { name: 'HMAC', hash: 'SHA-256' }, false, ['sign']));
+            }
+            const macs = new Set();
+            for (const key of keys) {
+                macs.add(hex(await crypto.subtle.sign('HMAC', key, enc('data'))));
+            }
+            return macs.size;`);
+        assert.equal(count, 256);
+    });
+});
+
+test('subtle AES-GCM roundtrip and tamper detection', async () => {
+    await withEngine(ENGINE_MODE_FULL, async (engine) => {
+        const result = await evalAsync(engine, `${PRELUDE}
+            const key = await crypto.subtle.importKey('raw', new Uint8Array(16).fill(7), 'AES-GCM', false, ['encrypt', 'decrypt']);
+            const params = { name: 'AES-GCM', iv: new Uint8Array(12).fill(1), additionalData: enc('aad') };
+            const sealed = await crypto.subtle.encrypt(params, key, enc('hello gcm'));
+            const opened = new TextDecoder().decode(await crypto.subtle.decrypt(params, key, sealed));
+            const tampered = new Uint8Array(sealed);
+            tampered[0] ^= 1;
+            let error = null;
+            try {
+                await crypto.subtle.decrypt(params, key, tampered);
+            } catch (e) {
+                error = e.name;
+            }
+            return { size: sealed.byteLength, opened, error };`);
+        assert.equal(result.size, 9 + 16);
+        assert.equal(result.opened, 'hello gcm');
+        assert.equal(result.error, 'OperationError');
+    });
+});
+
+test('subtle exportKey honours extractable', async () => {
+    await withEngine(ENGINE_MODE_FULL, async (engine) => {
+        const result = await evalAsync(engine, `${PRELUDE}
+            const raw = new Uint8Array(32).fill(3);
+            const open = await crypto.subtle.importKey('raw', raw, 'AES-CBC', true, ['encrypt']);
+            const closed = await crypto.subtle.importKey('raw', raw, 'AES-CBC', false, ['encrypt']);
+            let error = null;
+            try {
+                await crypto.subtle.exportKey('raw', closed);
+            } catch (e) {
+                error = e.name;
+            }
+            return { exported: hex(await crypto.subtle.exportKey('raw', open)), error };`);
+        assert.equal(result.exported, '03'.repeat(32));
+        assert.equal(result.error, 'InvalidAccessError');
+    });
+});
+
+test('subtle importKey rejects bad AES key sizes', async () => {
+    await withEngine(ENGINE_MODE_FULL, async (engine) => {
+        await assert.rejects(
+            evalAsync(engine, `return crypto.subtle.importKey('raw', new Uint8Array(15), 'AES-GCM', false, ['encrypt']);`),
+            /DataError/,
+        );
+    });
+});
+
+test('createHash / createHmac match known vectors', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = JSON.parse(engine.jsEval(`(() => {
+            const crypto = require('crypto');
+            return JSON.stringify({
+                sha256: crypto.createHash('sha256').update('abc').digest('hex'),
+                sha512: crypto.createHash('SHA512').update('').digest('hex').slice(0, 32),
+                hmac: crypto.createHmac('sha256', 'Jefe').update('what do ya want for nothing?').digest('hex'),
+                empty: crypto.createHmac('sha256', '').update('').digest('hex'),
+            });
+        })()`));
+        assert.equal(result.sha256, 'ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad');
+        assert.equal(result.sha512, 'cf83e1357eefb8bdf1542850d66d8007');
+        assert.equal(result.hmac, '5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843');
+        assert.equal(result.empty, 'b613679a0814d9ec772f95d778c35fc5ff1697c493715653c6c712144292c5ad');
+    });
+});
+
+test('finished createHmac streams release their PSA key', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        // GC 없이 slot 수(기본 32)보다 훨씬 많이 만들어도 실패하지 않아야 한다
+        const count = engine.jsEval(`(() => {
+            const crypto = require('crypto');
+            const kept = [];
+            for (let i = 0; i < 1000; i++) {
+                const hmac = crypto.createHmac('sha256', 'key-' + i);
+                hmac.update('data');
+                hmac.digest();
+                kept.push(hmac);
+            }
+            return kept.length;
+        })()`);
+        assert.equal(count, 1000);
+    });
+});
+
+test('createCipheriv roundtrip and failed final releases the key', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = JSON.parse(engine.jsEval(`(() => {
+            const crypto = require('crypto');
+            const key = Buffer.alloc(32, 1);
+            const iv = Buffer.alloc(16, 2);
+            const cipher = crypto.createCipheriv('aes-256-cbc', key, iv);
+            const sealed = Buffer.concat([cipher.update('hello cipher'), cipher.final()]);
+            const decipher = crypto.createDecipheriv('aes-256-cbc', key, iv);
+            const opened = decipher.update(sealed, undefined, 'utf8') + decipher.final('utf8');
+            let badDecrypt = 0;
+            for (let i = 0; i < 100; i++) {
+                const wrong = crypto.createDecipheriv('aes-256-cbc', Buffer.alloc(32, 9), iv);
+                wrong.update(sealed);
+                try {
+                    wrong.final();
+                } catch (e) {
+                    badDecrypt++;
+                }
+            }
+            const ctr = crypto.createCipheriv('aes-128-ctr', Buffer.alloc(16, 3), iv);
+            return JSON.stringify({
+                size: sealed.length,
+                opened,
+                badDecrypt,
+                ctr: Buffer.concat([ctr.update('abc'), ctr.final()]).length,
+            });
+        })()`));
+        assert.equal(result.size, 16);
+        assert.equal(result.opened, 'hello cipher');
+        // padding 이 우연히 맞을 수 있으므로 대부분만 확인
+        assert.ok(result.badDecrypt > 90);
+        assert.equal(result.ctr, 3);
+    });
+});
+
+test('createCipheriv validates key and iv length up front', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = JSON.parse(engine.jsEval(`(() => {
+            const crypto = require('crypto');
+            const capture = (fn) => {
+                try {
+                    fn();
+                    return null;
+                } catch (e) {
+                    return { name: e.name, code: e.code, message: e.message };
+                }
+            };
+            return JSON.stringify({
+                key: capture(() => crypto.createCipheriv('aes-128-cbc', Buffer.alloc(15), Buffer.alloc(16))),
+                iv: capture(() => crypto.createCipheriv('aes-128-cbc', Buffer.alloc(16), Buffer.alloc(8))),
+                ok: capture(() => crypto.createCipheriv('aes-192-ctr', Buffer.alloc(24), Buffer.alloc(16))),
+            });
+        })()`));
+        assert.deepEqual(result.key, { name: 'RangeError', code: 'ERR_CRYPTO_INVALID_KEYLEN', message: 'Invalid key length' });
+        assert.deepEqual(result.iv, { name: 'TypeError', code: 'ERR_CRYPTO_INVALID_IV', message: 'Invalid initialization vector' });
+        assert.equal(result.ok, null);
+    });
+});
@@ -0,0 +1,103 @@
+/**
+ * HtmlExtractor 테스트 (engine.extractDocument, __sys.extractDocument)
+ * Usage: node --test test/extract.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { ENGINE_MODE_MINI, withEngine } = require('./helpers');
+
+const PAGE = "<html><head><title> Hello \n World </title><meta charset=utf-8><meta name=csrf content='abc&amp;d'>"
+    + "<script src=/a.js></script><script>var a = '<form>';</script><script type=module>b()</script></head><body>"
+    + '<a href=/x>x</a><form id=f action=/login method=POST><input name=user value=u><input type=Checkbox name=c checked>'
+    + '<select name=s><option value=1>one<option selected>  two  x</option></select><textarea name=t>a &lt; b</textarea>'
+    + '<button>go</button></form><input name=outside></body>';
+
+const EXPECTED = {
+    title: 'Hello World',
+    scripts: [
+        { type: '', text: "var a = '<form>';" },
+        { type: 'module', text: 'b()' },
+    ],
+    scriptSources: ['/a.js'],
+    forms: [{
+        attributes: { id: 'f', action: '/login', method: 'POST' },
+        fields: [
+            { tag: 'input', name: 'user', type: 'text', value: 'u' },
+            { tag: 'input', name: 'c', type: 'checkbox', value: 'on', checked: true },
+            { tag: 'select', name: 's', type: 'select-one', value: 'two x' },
+            { tag: 'textarea', name: 't', type: 'textarea', value: 'a < b' },
+            { tag: 'button', name: '', type: 'submit', value: '' },
+        ],
+    }],
+    meta: [{ charset: 'utf-8' }, { name: 'csrf', content: 'abc&d' }],
+    attributes: [
+        { tag: 'a', name: 'href', value: '/x' },
+        { tag: 'form', name: 'id', value: 'f' },
+    ],
+};
+
+test('extractDocument collects title, scripts, forms, meta and attributes', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const result = engine.extractDocument(PAGE, { attributes: ['a[href]', '[ID]'] });
+        assert.deepEqual(result, EXPECTED);
+    });
+});
+
+test('extractDocument omits disabled sections', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const result = engine.extractDocument(PAGE, { title: false, scripts: false, meta: false });
+        assert.deepEqual(Object.keys(result), ['forms']);
+        assert.equal(result.forms[0].fields.length, 5);
+    });
+});
+
+test('select value follows the first selected option, else the first option', async () => {
+    const html = '<form><select name=a><option>  x  <option value=y>Y</select>'
+        + '<select name=b><option>1<option selected value=2>2<option selected>3</select>'
+        + '<select name=c multiple></select></form>';
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const fields = engine.extractDocument(html, { title: false, scripts: false, meta: false }).forms[0].fields;
+        assert.deepEqual(fields.map((f) => [f.name, f.type, f.value]), [
+            ['a', 'select-one', 'x'],
+            ['b', 'select-one', '2'],
+            ['c', 'select-multiple', ''],
+        ]);
+    });
+});
+
+test('empty and unterminated input', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        assert.deepEqual(engine.extractDocument(''), {
+            title: '', scripts: [], scriptSources: [], forms: [], meta: [],
+        });
+        const result = engine.extractDocument('<title>t</title><script>let s = "</scr', null);
+        assert.equal(result.title, 't');
+        assert.deepEqual(result.scripts, [{ type: '', text: 'let s = "</scr' }]);
+    });
+});
+
+test('guest extractDocument returns the same result and rejects bad attribute specs', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const json = engine.jsEval(`JSON.stringify(__sys.extractDocument(${JSON.stringify(PAGE)}, { attributes: ['a[href]', '[ID]'] }))`);
+        assert.deepEqual(JSON.parse(json), EXPECTED);
+
+        const error = engine.jsEval(`(() => { try { __sys.extractDocument('<a>', { attributes: ['a[]'] }); return null; }
+            catch (e) { return e.name + ': ' + e.message; } })()`);
+        assert.equal(error, "TypeError: html_extract: invalid attribute 'a[]'");
+    });
+});
+
+test('form="id" fields join the form with that id in document order', async () => {
+    const html = '<input name=before form=f><form id=f><input name=a>'
+        + '<select name=s form=g><option>x<option selected>y</select><input name=b></form>'
+        + '<textarea name=t form=f>tt</textarea><input name=none form=missing>'
+        + '<form id=g><input name=g1></form><select form=f name=late><option value=v>z</select>';
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const forms = engine.extractDocument(html, { title: false, scripts: false, meta: false }).forms;
+        assert.deepEqual(forms.map((form) => form.fields.map((field) => `${field.name}=${field.value}`)), [
+            ['before=', 'a=', 'b=', 't=tt', 'late=v'],
+            ['s=y', 'g1='],
+        ]);
+    });
+});
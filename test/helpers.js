@@ -0,0 +1,96 @@
+/**
+ * 빌드된 request-unraver 로 engine 을 만드는 테스트 helper
+ *
+ *   REQUEST_UNRAVER_DIST: wasm dist 디렉토리 (기본: cmake-build-debug/dist)
+ *   REQUEST_UNRAVER_LICENSE: runtime_init license (base64)
+ *   REQUEST_UNRAVER_MT_GLUE: pthread 빌드 glue (기본: cmake-build-debug-mt/dist/request-unraver-wasm-debug-mt.js)
+ *
+ * node/request-unraver 를 먼저 빌드해야 한다 (pnpm --dir node/request-unraver build)
+ */
+
+const fs = require('fs');
+const path = require('path');
+const { Runtime, RuntimeMt } = require('../node/request-unraver/dist/index.cjs');
+
+// src/engine.h
+const ENGINE_MODE_MINI = 14587050;
+const ENGINE_MODE_FULL = 22448265;
+
+let runtimePromise = null;
+
+function getRuntime() {
+    if (!runtimePromise) {
+        const dist = process.env.REQUEST_UNRAVER_DIST || path.join(__dirname, '../cmake-build-debug/dist');
+        runtimePromise = Runtime.fromFile(dist, process.env.REQUEST_UNRAVER_LICENSE || '', undefined, false);
+    }
+    return runtimePromise;
+}
+
+let runtimeMtPromise = null;
+
+// pthread 빌드 (REQUEST_UNRAVER_WASM_THREADS=ON) glue 경로, 빌드되지 않았으면 null
+function mtGluePath() {
+    const glue = process.env.REQUEST_UNRAVER_MT_GLUE
+        || path.join(__dirname, '../cmake-build-debug-mt/dist/request-unraver-wasm-debug-mt.js');
+    return fs.existsSync(glue) ? glue : null;
+}
+
+function getRuntimeMt() {
+    if (!runtimeMtPromise) {
+        runtimeMtPromise = RuntimeMt.fromFile(mtGluePath(), process.env.REQUEST_UNRAVER_LICENSE || '');
+    }
+    return runtimeMtPromise;
+}
+
+// engine 을 만들어 fn 에 넘기고 끝나면 정리
+async function withEngine(mode, fn) {
+    const runtime = await getRuntime();
+    const engine = await runtime.newEngine(mode);
+    try {
+        return await fn(engine);
+    } finally {
+        await engine.cleanup();
+    }
+}
+
+// window 하나를 만들어 fn(engine, window) 실행
+function withWindow(mode, content, windowOptions, fn) {
+    return withEngine(mode, async (engine) => {
+        const window = engine.createWindow(content, windowOptions ?? { url: 'https://test.local/' });
+        try {
+            return await fn(engine, window);
+        } finally {
+            engine.destroyWindow(window);
+        }
+    });
+}
+
+// async 함수 본문 code 를 main context 에서 실행하고 job queue 를 비운 뒤 결과를 돌려준다.
+// 결과는 JSON 으로 옮기므로 JSON 직렬화 가능한 값이어야 한다. 실패하면 "Name: message" 로 throw
+async function evalAsync(engine, code) {
+    engine.jsEval(`globalThis.__testResult = undefined;
+        (async () => { ${code} })().then(
+            (value) => { globalThis.__testResult = JSON.stringify({ value }); },
+            (e) => { globalThis.__testResult = JSON.stringify({ error: (e && e.name) + ': ' + (e && e.message) }); });`);
+    await engine.runUntilIdle();
+    const raw = engine.jsEval('globalThis.__testResult');
+    if (raw === undefined) {
+        throw new Error('evalAsync: promise did not settle');
+    }
+    const result = JSON.parse(raw);
+    if ('error' in result) {
+        throw new Error(result.error);
+    }
+    return result.value;
+}
+
+module.exports = {
+    ENGINE_MODE_MINI,
+    ENGINE_MODE_FULL,
+    getRuntime,
+    mtGluePath,
+    getRuntimeMt,
+    withEngine,
+    withWindow,
+    evalAsync,
+};
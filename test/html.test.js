@@ -0,0 +1,118 @@
+/**
+ * native HTML tokenizer / DOM 테스트 (html_tokenizer, html_dom, html_selector)
+ * Usage: node --test test/html.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { ENGINE_MODE_MINI, ENGINE_MODE_FULL, withWindow } = require('./helpers');
+
+const URL_OPTIONS = { url: 'https://test.local/' };
+
+test('named, legacy and numeric character references', async () => {
+    const html = '<p id="a">&copy2024 &notit; &notin; &Ascr; &hearts;&nbsp;&#x1F600;&#65 &unknown;</p>'
+        + '<a id="l" href="/s?x=1&amp=2&lang=en&copy;">link</a>';
+    await withWindow(ENGINE_MODE_MINI, html, URL_OPTIONS, (engine, window) => {
+        const result = engine.browserEval(window, `return {
+            text: document.getElementById('a').textContent,
+            href: document.getElementById('l').getAttribute('href'),
+        };`);
+        assert.equal(result.text, '©2024 ¬it; ∉ \u{1d49c} ♥ \u{1f600}A &unknown;');
+        // attribute 에서는 '=' 나 alnum 이 뒤따르는 legacy entity 를 디코딩하지 않는다
+        assert.equal(result.href, '/s?x=1&amp=2&lang=en©');
+    });
+});
+
+test('serialization escapes text and keeps raw text elements', async () => {
+    const html = '<div id="d" title=\'a"b\'>1 &lt; 2 &amp; 3<br><script>if (a < b) {}</script><!--c--></div>';
+    await withWindow(ENGINE_MODE_MINI, html, URL_OPTIONS, (engine, window) => {
+        const outer = engine.browserEval(window, `return document.getElementById('d').outerHTML`);
+        assert.equal(outer, '<div id="d" title="a&quot;b">1 &lt; 2 &amp; 3<br><script>if (a < b) {}</script><!--c--></div>');
+    });
+});
+
+test('deeply nested documents serialize without recursion', async () => {
+    const depth = 5000;
+    const html = '<div>'.repeat(depth) + 'leaf';
+    await withWindow(ENGINE_MODE_MINI, html, URL_OPTIONS, (engine, window) => {
+        const result = engine.browserEval(window, `const html = document.body.innerHTML;
+            return { length: html.length, head: html.slice(0, 10), tail: html.slice(-16), count: document.getElementsByTagName('div').length };`);
+        assert.equal(result.count, depth);
+        assert.equal(result.length, depth * '<div></div>'.length + 'leaf'.length);
+        assert.equal(result.head, '<div><div>');
+        assert.equal(result.tail, 'leaf</div></div>');
+    });
+});
+
+test('tree builder closes implicit end tags', async () => {
+    const html = '<ul id="u"><li>1<li>2<li>3</ul><p>a<p>b<table><tr><td>x<td>y</table>';
+    await withWindow(ENGINE_MODE_MINI, html, URL_OPTIONS, (engine, window) => {
+        const result = engine.browserEval(window, `return {
+            items: document.querySelectorAll('#u > li').length,
+            paragraphs: document.getElementsByTagName('p').length,
+            cells: document.querySelectorAll('td').length,
+            head: !!document.head,
+        };`);
+        assert.deepEqual(result, { items: 3, paragraphs: 2, cells: 2, head: true });
+    });
+});
+
+test('querySelector supports compound, attribute and structural selectors', async () => {
+    const html = `
+        <form id="f"><input name="q" value="v"><input type="hidden" name="t" value="tok"></form>
+        <ul class="list"><li class="item a">1</li><li class="item b">2</li><li class="item a">3</li></ul>`;
+    await withWindow(ENGINE_MODE_MINI, html, URL_OPTIONS, (engine, window) => {
+        const result = engine.browserEval(window, `return {
+            hidden: document.querySelector('form#f input[type="hidden"]').getAttribute('value'),
+            prefix: document.querySelectorAll('input[name^="q"]').length,
+            notB: document.querySelectorAll('ul.list > li.item:not(.b)').length,
+            first: document.querySelector('li:first-child').textContent,
+            second: document.querySelector('li:nth-child(2)').textContent,
+            sibling: document.querySelectorAll('li.a ~ li').length,
+            matches: document.querySelector('.b').matches('ul > .item'),
+        };`);
+        assert.deepEqual(result, { hidden: 'tok', prefix: 1, notB: 2, first: '1', second: '2', sibling: 2, matches: true });
+    });
+});
+
+test('native document is read-only', async () => {
+    await withWindow(ENGINE_MODE_MINI, '<p>x</p>', URL_OPTIONS, (engine, window) => {
+        const name = engine.browserEval(window, `try { document.createElement('div'); return null; } catch (e) { return e.name; }`);
+        assert.equal(name, 'NotSupportedError');
+    });
+});
+
+test("MINI dom: 'stub' keeps the unparsed placeholder document", async () => {
+    await withWindow(ENGINE_MODE_MINI, '<p id="a">x</p>', { ...URL_OPTIONS, dom: 'stub' }, (engine, window) => {
+        const result = engine.browserEval(window, `document.write('ignored');
+            return { nodeType: document.nodeType, query: typeof document.querySelector };`);
+        assert.deepEqual(result, { nodeType: 9, query: 'undefined' });
+    });
+});
+
+test("FULL dom: 'native' uses the same parser as MINI", async () => {
+    await withWindow(ENGINE_MODE_FULL, '<p class="x">&hellip;</p>', { ...URL_OPTIONS, dom: 'native' }, (engine, window) => {
+        assert.equal(engine.browserEval(window, `return document.querySelector('p.x').textContent`), '…');
+    });
+});
+
+test('markup split across streamed chunks parses like the whole document', async () => {
+    const html = '<!DOCTYPE html><title>a &amp; b</title><div id="d" class="x y" data-v=\'1 > 2\' hidden>'
+        + '<img src=a.png alt = "z" / ><input value=abc&amp;d checked><!-- c -- > --><?pi x?></div>'
+        + `<p title="${'v'.repeat(300)}">${'t'.repeat(300)}</p>`;
+    await withWindow(ENGINE_MODE_MINI, html, URL_OPTIONS, (engine, window) => {
+        const expected = engine.browserEval(window, 'return document.documentElement.outerHTML');
+        for (const size of [1, 3, 7, 64]) {
+            const stream = engine.beginWindow(URL_OPTIONS);
+            for (let i = 0; i < html.length; i += size) {
+                engine.writeWindow(stream, html.slice(i, i + size));
+            }
+            const streamed = engine.endWindow(stream);
+            try {
+                assert.equal(engine.browserEval(streamed, 'return document.documentElement.outerHTML'), expected, `chunk ${size}`);
+            } finally {
+                engine.destroyWindow(streamed);
+            }
+        }
+    });
+});
@@ -0,0 +1,114 @@
+/**
+ * 비동기 호스트 I/O 테스트 (io_manager, XMLHttpRequest, Engine.setIoHandler)
+ * Usage: node --test test/io.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { Recorder } = require('../node/request-unraver/dist/index.cjs');
+const { ENGINE_MODE_MINI, withEngine, withWindow, evalAsync } = require('./helpers');
+
+const XHR_OK = { status: 200, responseType: 'text', contentType: 'text/plain', url: 'https://test.local/data', data: 'pong' };
+
+test('io_submit resolves with the host result through the job queue', async () => {
+    await withEngine(ENGINE_MODE_MINI, async (engine) => {
+        const requests = [];
+        engine.setIoHandler(async (request) => {
+            requests.push(request);
+            return { echo: JSON.parse(request.request), body: request.body };
+        });
+        const value = await evalAsync(engine, `return await __sys_host.io_submit('test', JSON.stringify({ n: 1 }), 'payload');`);
+        assert.deepEqual(value, { echo: { n: 1 }, body: 'payload' });
+        assert.equal(requests.length, 1);
+        assert.equal(requests[0].kind, 'test');
+    });
+});
+
+test('io_submit rejects when the handler fails or is missing', async () => {
+    await withEngine(ENGINE_MODE_MINI, async (engine) => {
+        await assert.rejects(evalAsync(engine, `return await __sys_host.io_submit('test', '{}');`),
+            /^Error: no io handler for test$/);
+
+        engine.setIoHandler(async () => {
+            throw new Error('connection refused');
+        });
+        await assert.rejects(evalAsync(engine, `return await __sys_host.io_submit('test', '{}');`),
+            /^Error: connection refused$/);
+    });
+});
+
+test('io_submit rejects on an empty host result', async () => {
+    await withEngine(ENGINE_MODE_MINI, async (engine) => {
+        engine.setIoHandler(async () => ({}));
+        // 호스트가 결과 없이 완료한 경우 (engine_complete_io 에 wl_result 0)
+        engine.completeIo = function (ioId) {
+            this.fns.completeIo(this.engineHandle, this.walink.toWlUint32(ioId), 0n);
+        };
+        await assert.rejects(evalAsync(engine, `return await __sys_host.io_submit('test', '{}');`),
+            /^Error: io: empty host result$/);
+    });
+});
+
+test('async XMLHttpRequest completes in a window and reports failures through onerror', async () => {
+    await withWindow(ENGINE_MODE_MINI, '<p>x</p>', { url: 'https://test.local/' }, async (engine, window) => {
+        engine.setIoHandler(async (request) => {
+            const { url } = JSON.parse(request.request);
+            if (url.endsWith('/fail')) {
+                throw new Error('bad gateway');
+            }
+            return XHR_OK;
+        });
+        engine.browserEval(window, `
+            window.__log = [];
+            for (const path of ['/data', '/fail']) {
+                const xhr = new window.XMLHttpRequest();
+                xhr.open('GET', 'https://test.local' + path, true);
+                xhr.onerror = (e) => window.__log.push(path + ' error ' + e.message);
+                xhr.onreadystatechange = () => window.__log.push(path + ' ' + xhr.readyState + ' ' + xhr.status + ' ' + (xhr.responseText ?? ''));
+                xhr.send();
+            }
+            return null;`);
+        assert.deepEqual(engine.browserEval(window, 'return window.__log'), []);
+
+        await engine.runUntilIdle();
+        // 두 요청의 완료 순서는 정해져 있지 않다
+        assert.deepEqual(engine.browserEval(window, 'return window.__log').sort(), [
+            '/data 4 200 pong',
+            '/fail 4 0 ',
+            '/fail error bad gateway',
+        ]);
+    });
+});
+
+test('host I/O carries the submitting window and is recorded against it', async () => {
+    await withEngine(ENGINE_MODE_MINI, async (engine) => {
+        const recorder = new Recorder();
+        engine.setRecorder(recorder);
+        const first = engine.createWindow('<p>1</p>', { url: 'https://test.local/' });
+        const second = engine.createWindow('<p>2</p>', { url: 'https://test.local/' });
+        const windows = [];
+        engine.setIoHandler(async (request) => {
+            windows.push([JSON.parse(request.request).url, request.window]);
+            return XHR_OK;
+        });
+        const send = (window, path) => engine.browserEval(window, `
+            const xhr = new window.XMLHttpRequest();
+            xhr.open('GET', 'https://test.local${path}', true);
+            xhr.send();
+            return null;`);
+        // first 의 요청은 second 가 마지막으로 쓰인 뒤에 완료된다
+        send(first, '/first');
+        send(second, '/second');
+        await engine.runUntilIdle();
+
+        assert.deepEqual(windows.sort(), [
+            ['https://test.local/first', first],
+            ['https://test.local/second', second],
+        ]);
+        const [firstJob, secondJob] = recorder.toCorpus().jobs;
+        assert.deepEqual(firstJob.io.map((io) => JSON.parse(io.request).url), ['https://test.local/first']);
+        assert.deepEqual(secondJob.io.map((io) => JSON.parse(io.request).url), ['https://test.local/second']);
+        engine.destroyWindow(first);
+        engine.destroyWindow(second);
+    });
+});
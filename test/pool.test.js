@@ -0,0 +1,85 @@
+/**
+ * worker pool 테스트 (request-unraver-wasm-mt, RuntimeMt / EnginePool)
+ * Usage: node --test test/pool.test.js
+ *
+ * pthread 빌드가 없으면 건너뛴다 (helpers.js REQUEST_UNRAVER_MT_GLUE)
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { pthreadPoolSize } = require('../node/request-unraver/dist/index.cjs');
+const { ENGINE_MODE_MINI, mtGluePath, getRuntimeMt } = require('./helpers');
+
+const skip = mtGluePath() ? false : 'request-unraver-wasm-mt not built';
+
+// pool 을 만들어 fn 에 넘기고 끝나면 정리
+async function withPool(threads, fn) {
+    const runtime = await getRuntimeMt();
+    const pool = runtime.newPool(ENGINE_MODE_MINI, threads);
+    try {
+        return await fn(pool);
+    } finally {
+        await pool.close();
+    }
+}
+
+test('submitted jobs resolve with their results and close drains the pool', { skip }, async () => {
+    await withPool(2, async (pool) => {
+        const jobs = [];
+        for (let n = 0; n < 16; n++) {
+            jobs.push(pool.submit({
+                content: `<p id="n">${n}</p>`,
+                script: 'return { n: params.n * 2, text: document.getElementById("n").textContent };',
+                params: { n },
+            }));
+        }
+        assert.equal(pool.size, 16);
+        const results = await Promise.all(jobs);
+        assert.deepEqual(results, Array.from({ length: 16 }, (_, n) => ({ n: n * 2, text: String(n) })));
+        assert.equal(pool.size, 0);
+
+        await assert.rejects(pool.submit({ script: 'throw new TypeError("job failed");' }), /TypeError: job failed/);
+    });
+});
+
+test('each job runs in its own window context', { skip }, async () => {
+    // worker 하나로 같은 Engine 에서 연달아 실행되게 한다
+    await withPool(1, async (pool) => {
+        const first = await pool.submit({
+            content: '<title>first</title>',
+            script: 'window.__leak = 1; globalThis.__leakGlobal = 1; Array.prototype.__leakProto = 1; return document.title;',
+        });
+        const second = await pool.submit({
+            content: '<title>second</title>',
+            script: 'return [document.title, typeof window.__leak, typeof globalThis.__leakGlobal, typeof [].__leakProto];',
+        });
+        assert.equal(first, 'first');
+        assert.deepEqual(second, ['second', 'undefined', 'undefined', 'undefined']);
+    });
+});
+
+test('async host I/O on a worker rejects instead of hanging', { skip }, async () => {
+    await withPool(1, async (pool) => {
+        const result = await pool.submit({
+            content: '<p>x</p>',
+            options: { url: 'https://test.local/' },
+            script: `return new Promise((resolve) => {
+                const xhr = new window.XMLHttpRequest();
+                xhr.open('GET', 'https://test.local/data', true);
+                xhr.onerror = (e) => resolve('error ' + e.message);
+                xhr.onload = () => resolve('load');
+                xhr.send();
+            });`,
+        });
+        assert.equal(result, 'error io: async host I/O is not available on pool workers');
+
+        // 같은 worker 가 다음 작업을 계속 처리한다
+        assert.equal(await pool.submit({ script: 'return Promise.resolve(42);' }), 42);
+    });
+});
+
+test('newPool rejects more threads than the pthread pool holds', { skip }, async () => {
+    const runtime = await getRuntimeMt();
+    assert.throws(() => runtime.newPool(ENGINE_MODE_MINI, pthreadPoolSize() + 1), RangeError);
+    assert.throws(() => runtime.newPool(ENGINE_MODE_MINI, 0), RangeError);
+});
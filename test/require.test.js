@@ -0,0 +1,36 @@
+/**
+ * native require() 경로 해석 테스트 (Engine::ModuleDir / ResolveRelative)
+ * Usage: node --test test/require.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { ENGINE_MODE_FULL, withEngine, withWindow } = require('./helpers');
+
+// rolldown 이 dir 출력으로 만든 root bundle. 공유 chunk 를 sysfs root 에서
+// require('./<chunk>.js') 로 읽는다
+const ROOT_BUNDLES = ['jsdom', 'jquery', 'dom-parser'];
+
+for (const name of ROOT_BUNDLES) {
+    test(`root bundle pseudo-browser-${name} loads its chunks`, async () => {
+        await withEngine(ENGINE_MODE_FULL, (engine) => {
+            const type = engine.jsEval(`typeof __sys.loadModule(${JSON.stringify(name)})`);
+            assert.equal(type, 'object');
+        });
+    });
+}
+
+test('lazy jsdom window works after loading chunks from the sysfs root', async () => {
+    await withWindow(ENGINE_MODE_FULL, '<p id="a">hello</p>', { url: 'https://test.local/', dom: 'jsdom' }, (engine, window) => {
+        assert.equal(engine.browserEval(window, `return document.getElementById('a').textContent`), 'hello');
+    });
+});
+
+test('missing relative module reports the resolved sysfs path', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        assert.throws(
+            () => engine.jsEval(`require('sysfs:///no-such-dir/missing.js')`),
+            /Cannot read module file 'sysfs:\/\/\/no-such-dir\/missing\.js'/,
+        );
+    });
+});
@@ -0,0 +1,91 @@
+/**
+ * browserEval 결과 캐시 테스트 (ResultCache, Engine.setResultCache)
+ * Usage: node --test test/result-cache.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { ResultCache } = require('../node/request-unraver/dist/index.cjs');
+const { ENGINE_MODE_MINI, withEngine } = require('./helpers');
+
+const PAGE = '<p id="a">cached</p>';
+const OPTIONS = { url: 'https://test.local/' };
+const PURE = { pure: true };
+
+// 캐시를 건 engine 에서 window 를 만들어 fn(window) 실행
+function withCachedWindow(engine, fn) {
+    const window = engine.createWindow(PAGE, OPTIONS);
+    try {
+        return fn(window);
+    } finally {
+        engine.destroyWindow(window);
+    }
+}
+
+test('pure evaluations hit only when the window went through the same steps', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const cache = new ResultCache();
+        engine.setResultCache(cache);
+        const read = (window) => engine.browserEval(window, 'return window.flag ?? null', null, PURE);
+        const write = (window, v) => engine.browserEval(window, 'window.flag = params.v; return null', { v });
+
+        assert.equal(withCachedWindow(engine, (window) => (write(window, 1), read(window))), 1);
+        assert.equal(withCachedWindow(engine, (window) => (write(window, 2), read(window))), 2);
+        assert.equal(withCachedWindow(engine, (window) => read(window)), null);
+        assert.deepEqual([cache.stats().hits, cache.stats().misses], [0, 3]);
+
+        assert.equal(withCachedWindow(engine, (window) => (write(window, 1), read(window))), 1);
+        assert.equal(cache.stats().hits, 1);
+        assert.equal(cache.stats().hitRate, 0.25);
+    });
+});
+
+test('evaluations not marked pure always run', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const cache = new ResultCache();
+        engine.setResultCache(cache);
+        const counts = withCachedWindow(engine, (window) => [1, 2, 3].map(() =>
+            engine.browserEval(window, 'window.n = (window.n || 0) + 1; return window.n')));
+        assert.deepEqual(counts, [1, 2, 3]);
+        assert.equal(cache.stats().entries, 0);
+    });
+});
+
+test('scripts that read the clock or random numbers are not stored', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const cache = new ResultCache();
+        engine.setResultCache(cache);
+        withCachedWindow(engine, (window) => {
+            engine.browserEval(window, 'return Date.now() > 0', null, PURE);
+            engine.browserEval(window, 'return Math.random() < 1', null, PURE);
+            engine.browserEval(window, 'return Date.now() > 0', null, PURE);
+        });
+        assert.deepEqual([cache.stats().hits, cache.stats().uncacheable, cache.stats().entries], [0, 3, 0]);
+    });
+});
+
+test('params are part of the key and unpacking them does not make a run uncacheable', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const cache = new ResultCache();
+        engine.setResultCache(cache);
+        const code = 'return document.getElementById(params.id).textContent + params.suffix';
+        const run = (suffix) => withCachedWindow(engine, (window) => engine.browserEval(window, code, { id: 'a', suffix }, PURE));
+        assert.equal(run('!'), 'cached!');
+        assert.equal(run('?'), 'cached?');
+        assert.equal(run('!'), 'cached!');
+        assert.deepEqual([cache.stats().hits, cache.stats().misses, cache.stats().uncacheable], [1, 2, 0]);
+    });
+});
+
+test('guest code run outside a window step ends caching for existing windows', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const cache = new ResultCache();
+        engine.setResultCache(cache);
+        withCachedWindow(engine, (window) => {
+            engine.browserEval(window, 'return 1', null, PURE);
+            engine.jsEval('1 + 1');
+            engine.browserEval(window, 'return 1', null, PURE);
+        });
+        assert.deepEqual([cache.stats().hits, cache.stats().misses], [0, 1]);
+    });
+});
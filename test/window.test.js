@@ -0,0 +1,130 @@
+/**
+ * window handle / window context 수명 테스트 (handle_table, Engine::DestroyWindow)
+ * 및 조각 단위 window 생성 (Engine::BeginWindow/WriteWindow/EndWindow)
+ * Usage: node --test test/window.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { LogLevel } = require('../node/request-unraver/dist/index.cjs');
+const { ENGINE_MODE_MINI, ENGINE_MODE_FULL, withEngine } = require('./helpers');
+
+const OPTIONS = { url: 'https://test.local/' };
+
+test('a destroyed window handle is rejected even after its slot is reused', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const stale = engine.createWindow('<p>old</p>', OPTIONS);
+        assert.equal(engine.destroyWindow(stale), true);
+        const fresh = engine.createWindow('<p>new</p>', OPTIONS);
+        try {
+            assert.throws(() => engine.browserEval(stale, 'return 1'), /invalid window handle/);
+            assert.throws(() => engine.browserEvalBatch(stale, 'return 1', [null]), /invalid window handle/);
+            assert.throws(() => engine.windowMemory(stale), /invalid window handle/);
+            assert.equal(engine.destroyWindow(stale), false);
+
+            assert.equal(engine.browserEval(fresh, `return document.querySelector('p').textContent`), 'new');
+        } finally {
+            assert.equal(engine.destroyWindow(fresh), true);
+        }
+    });
+});
+
+test('releaseAllWindows invalidates every handle', async () => {
+    await withEngine(ENGINE_MODE_MINI, (engine) => {
+        const windows = [1, 2, 3].map((i) => engine.createWindow(`<p>${i}</p>`, OPTIONS));
+        assert.equal(engine.releaseAllWindows(), 3);
+        for (const window of windows) {
+            assert.throws(() => engine.browserEval(window, 'return 1'), /invalid window handle/);
+        }
+    });
+});
+
+// window 에 timer 와 비동기 XHR 을 걸어 두고, destroy 여부에 따라 콜백이 실행됐는지 로그로 확인
+async function runPendingCallbacks(engine, destroyFirst) {
+    engine.setLogLevel(LogLevel.Info);
+    engine.drainLogs();
+    let requests = 0;
+    engine.setIoHandler(async () => {
+        requests++;
+        return { status: 200, responseType: 'text', contentType: 'text/plain', data: 'x' };
+    });
+
+    const window = engine.createWindow('<p>x</p>', OPTIONS);
+    engine.browserEval(window, `
+        setTimeout(() => console.log('timer fired'), 0);
+        const xhr = new window.XMLHttpRequest();
+        xhr.open('GET', 'https://test.local/data', true);
+        xhr.onreadystatechange = () => console.log('io fired');
+        xhr.send();
+        return null;`);
+    if (destroyFirst) {
+        assert.equal(engine.destroyWindow(window), true);
+    }
+    await engine.runUntilIdle();
+    // 0ms timer 는 다음 loop step 에서 만료된다
+    await new Promise((resolve) => setTimeout(resolve, 5));
+    await engine.runUntilIdle();
+    if (!destroyFirst) {
+        engine.destroyWindow(window);
+    }
+    return { requests, lines: engine.drainLogs().lines.map((line) => line.text).sort() };
+}
+
+test('timers and I/O of a live window fire', async () => {
+    await withEngine(ENGINE_MODE_MINI, async (engine) => {
+        const { requests, lines } = await runPendingCallbacks(engine, false);
+        assert.equal(requests, 1);
+        assert.deepEqual(lines, ['io fired', 'timer fired']);
+    });
+});
+
+test('destroying a window cancels its pending timers and I/O', async () => {
+    await withEngine(ENGINE_MODE_MINI, async (engine) => {
+        const { requests, lines } = await runPendingCallbacks(engine, true);
+        // 요청은 이미 호스트로 나갔지만 완료는 버려진다
+        assert.equal(requests, 1);
+        assert.deepEqual(lines, []);
+        assert.equal(engine.hasTimers(), false);
+        assert.equal(engine.hasPendingJobs(), false);
+    });
+});
+
+// 여러 byte 로 된 UTF-8 문자가 조각 경계에 걸리도록 자른다
+const STREAM_HTML = '<!DOCTYPE html><html><head><title>한글 제목 — ü</title></head><body>'
+    + '<p id="a" title="ß→∑ 😀">가나다라마바사 &amp; 😀😀 é</p>'
+    + `<ul>${Array.from({ length: 20 }, (_, i) => `<li data-i="${i}">항목 ${i} ✓</li>`).join('')}</ul></body></html>`;
+
+for (const [label, mode] of [['MINI', ENGINE_MODE_MINI], ['FULL', ENGINE_MODE_FULL]]) {
+    test(`${label}: streamed UTF-8 chunks split inside characters match createWindow`, async () => {
+        await withEngine(mode, (engine) => {
+            const snapshot = `return {
+                html: document.documentElement.outerHTML,
+                title: document.title,
+                text: document.getElementById('a').textContent,
+                attr: document.getElementById('a').getAttribute('title'),
+            };`;
+            const whole = engine.createWindow(STREAM_HTML, OPTIONS);
+            let expected;
+            try {
+                expected = engine.browserEval(whole, snapshot);
+            } finally {
+                engine.destroyWindow(whole);
+            }
+            assert.equal(expected.text, '가나다라마바사 & 😀😀 é');
+
+            const bytes = new TextEncoder().encode(STREAM_HTML);
+            for (const size of [1, 2, 3, 5, 13, 64]) {
+                const stream = engine.beginWindow(OPTIONS, bytes.length);
+                for (let i = 0; i < bytes.length; i += size) {
+                    engine.writeWindow(stream, bytes.subarray(i, i + size));
+                }
+                const window = engine.endWindow(stream);
+                try {
+                    assert.deepEqual(engine.browserEval(window, snapshot), expected, `chunk ${size}`);
+                } finally {
+                    engine.destroyWindow(window);
+                }
+            }
+        });
+    });
+}
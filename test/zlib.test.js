@@ -0,0 +1,126 @@
+/**
+ * native zlib 테스트 (zlib_stream)
+ * Usage: node --test test/zlib.test.js
+ */
+
+const { test } = require('node:test');
+const assert = require('node:assert/strict');
+const { ENGINE_MODE_FULL, withEngine } = require('./helpers');
+
+// engine 안에서 fn 본문을 실행하고 JSON 으로 결과를 받는다
+function run(engine, body) {
+    return JSON.parse(engine.jsEval(`JSON.stringify((() => {
+        const zlib = require('zlib');
+        const capture = (fn) => {
+            try {
+                return { value: fn() };
+            } catch (e) {
+                return { name: e.name, code: e.code, message: e.message };
+            }
+        };
+        ${body}
+    })())`));
+}
+
+test('sync roundtrips for every format', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const input = 'hello zlib '.repeat(1000);
+            return {
+                deflate: zlib.inflateSync(zlib.deflateSync(input)).toString(),
+                gzip: zlib.gunzipSync(zlib.gzipSync(input)).toString(),
+                raw: zlib.inflateRawSync(zlib.deflateRawSync(input)).toString(),
+                unzipGzip: zlib.unzipSync(zlib.gzipSync(input)).toString(),
+                unzipDeflate: zlib.unzipSync(zlib.deflateSync(input)).toString(),
+                input,
+            };`);
+        for (const key of ['deflate', 'gzip', 'raw', 'unzipGzip', 'unzipDeflate']) {
+            assert.equal(result[key], result.input, key);
+        }
+    });
+});
+
+test('windowBits 0 is passed through instead of defaulting to 15', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const packed = zlib.deflateSync('window bits', { windowBits: 9 });
+            return zlib.inflateSync(packed, { windowBits: 0 }).toString();`);
+        assert.equal(result, 'window bits');
+    });
+});
+
+test('concatenated gzip members are read by gunzip and unzip', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const joined = Buffer.concat([zlib.gzipSync('first,'), zlib.gzipSync('second,'), zlib.gzipSync('third')]);
+            return {
+                gunzip: zlib.gunzipSync(joined).toString(),
+                unzip: zlib.unzipSync(joined).toString(),
+            };`);
+        assert.equal(result.gunzip, 'first,second,third');
+        assert.equal(result.unzip, 'first,second,third');
+    });
+});
+
+test('maxOutputLength stops decompression bombs with a RangeError', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const bomb = zlib.gzipSync(Buffer.alloc(8 * 1024 * 1024));
+            return {
+                packed: bomb.length,
+                limited: capture(() => zlib.gunzipSync(bomb, { maxOutputLength: 64 * 1024 }).length),
+                unzip: capture(() => zlib.unzipSync(bomb, { maxOutputLength: 1024 }).length),
+                exact: capture(() => zlib.gunzipSync(zlib.gzipSync('12345'), { maxOutputLength: 5 }).toString()),
+                invalid: capture(() => zlib.gunzipSync(bomb, { maxOutputLength: 0 })),
+            };`);
+        assert.ok(result.packed < 64 * 1024);
+        assert.equal(result.limited.name, 'RangeError');
+        assert.equal(result.limited.code, 'ERR_BUFFER_TOO_LARGE');
+        assert.equal(result.unzip.code, 'ERR_BUFFER_TOO_LARGE');
+        assert.deepEqual(result.exact, { value: '12345' });
+        assert.equal(result.invalid.code, 'ERR_OUT_OF_RANGE');
+    });
+});
+
+test('truncated input fails with unexpected end of file', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const packed = zlib.gzipSync('truncated '.repeat(100));
+            return capture(() => zlib.gunzipSync(packed.subarray(0, packed.length - 10)));`);
+        assert.equal(result.code, 'Z_BUF_ERROR');
+        assert.equal(result.message, 'unexpected end of file');
+    });
+});
+
+test('DataView input is read through its byte range', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const packed = zlib.deflateSync('data view');
+            const padded = new Uint8Array(packed.length + 8);
+            padded.set(packed, 4);
+            const view = new DataView(padded.buffer, 4, packed.length);
+            return {
+                inflate: zlib.inflateSync(view).toString(),
+                roundtrip: zlib.inflateRawSync(zlib.deflateRawSync(new DataView(new TextEncoder().encode('raw view').buffer))).toString(),
+            };`);
+        assert.deepEqual(result, { inflate: 'data view', roundtrip: 'raw view' });
+    });
+});
+
+test('windowBits 0 is rejected for raw and deflate modes', async () => {
+    await withEngine(ENGINE_MODE_FULL, (engine) => {
+        const result = run(engine, `
+            const packed = zlib.deflateRawSync('raw');
+            return {
+                inflateRaw: capture(() => zlib.inflateRawSync(packed, { windowBits: 0 })),
+                deflateRaw: capture(() => zlib.deflateRawSync('raw', { windowBits: 0 })),
+                deflate: capture(() => zlib.deflateSync('raw', { windowBits: 0 })),
+                unzip: capture(() => zlib.unzipSync(zlib.deflateSync('raw'), { windowBits: 0 }).toString()),
+            };`);
+        for (const key of ['inflateRaw', 'deflateRaw', 'deflate']) {
+            assert.equal(result[key].name, 'RangeError', key);
+            assert.equal(result[key].code, 'ERR_OUT_OF_RANGE', key);
+        }
+        assert.deepEqual(result.unzip, { value: 'raw' });
+    });
+});